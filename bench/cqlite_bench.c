@@ -0,0 +1,1212 @@
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cqlite.h"
+#include "cqlite_arena.h"
+#include "cqlite_cursor.h"
+#include "cqlite_mapping.h"
+#include "cqlite_parallel.h"
+#include "cqlite_pool.h"
+#include "cqlite_stmt_cache.h"
+
+#define BENCH_DEFAULT_MAX_ROW_CNT   ( 10000000 )
+#define BENCH_DEFAULT_DATABASE_FILE ( "cqlite_bench.db" )
+#define BENCH_POPULATE_CHUNK_SIZE   ( 100000 )
+#define BENCH_INSERT_BATCH_SIZE     ( 1000 )
+#define BENCH_CURSOR_BATCH_SIZE     ( 1000 )
+#define BENCH_CACHE_CAPACITY        ( 16 )
+#define BENCH_FIND_MANY_CNT         ( 1000 )
+#define BENCH_ID_COLUMN             ( 0 )
+#define BENCH_THREAD_CNT            ( 4 )
+#define BENCH_ROW_BUDGET            ( 1000000 )
+#define BENCH_MIN_SAMPLE_CNT        ( 5 )
+#define BENCH_MAX_SAMPLE_CNT        ( 10000 )
+#define BENCH_WHOLE_TABLE           ( 0 )
+#define NS_PER_SEC                  ( 1000000000LL )
+#define NS_PER_US                   ( 1000.0 )
+#define NO_CALLBACK                 ( NULL )
+#define NO_CALLBACK_PARAM           ( NULL )
+#define NO_ERROR_MESSAGE            ( NULL )
+
+
+/**********************************************
+Types
+**********************************************/
+
+// Model shaped like the test table of the test suite
+typedef struct
+    {
+    sqlite_int64    id;
+    double          real_field;
+    int             int_field;
+    char *          dynamic_string_field;
+    char            fixed_string_field[4];
+    } bench_model_t;
+
+typedef struct
+    {
+    sqlite3 *               db;             //!< Database connection
+    cqlite_stmt_cache_t *   stmt_cache;     //!< Statement cache of db
+    cqlite_pool_t *         pool;           //!< Connection pool on the same database
+    int                     row_cnt;        //!< Number of rows in the bench table
+    sqlite_uint64           random_state;   //!< State of the random id generator
+    bench_model_t *         insert_models;  //!< Models inserted by the insert benchmarks
+    } bench_context_t;
+
+/**
+* Benchmark function type.
+*
+* Makes a single call to the benchmarked function, timing only the call
+* itself and not any set up or clean up around it.
+*/
+typedef int (*bench_func_t)
+    (
+    bench_context_t *   context,        //!< Benchmark context
+    sqlite_int64 *      elapsed_ns_out, //!< (out) Duration of the call
+    sqlite_int64 *      row_cnt_out     //!< (out) Number of rows read or written by the call
+    );
+
+typedef struct
+    {
+    char const *    api;            //!< Name of the benchmarked function
+    char const *    variant;        //!< What distinguishes this from other benchmarks of the same function
+    int             rows_per_call;  //!< Number of rows each call reads or writes, BENCH_WHOLE_TABLE for the whole table
+    bench_func_t    func;           //!< Benchmark function
+    } bench_t;
+
+
+/**********************************************
+Functions
+**********************************************/
+static int bench_arena_select
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    );
+
+static int bench_count
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    );
+
+static int bench_cursor
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    );
+
+static int bench_find_by_id
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    );
+
+static int bench_find_by_id_cached
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    );
+
+static int bench_find_many_by_ids
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    );
+
+static int bench_insert
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    );
+
+static int bench_insert_many
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    );
+
+static int bench_mapped_select
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    );
+
+static int bench_parallel_select
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    );
+
+static int bench_pool_select
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    );
+
+static int bench_select_counted
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    );
+
+static int bench_select_single_pass
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    );
+
+static int bench_database_open
+    (
+    char const *        path,
+    int                 row_cnt,
+    bench_context_t *   context
+    );
+
+static void bench_database_close
+    (
+    char const *        path,
+    bench_context_t *   context
+    );
+
+static int bench_model_add_to_list
+    (
+    sqlite3_stmt *  query,
+    void *          model_list,
+    int             next_model_list_idx
+    );
+
+static int bench_model_add_to_list_arena
+    (
+    sqlite3_stmt *      query,
+    void *              model_list,
+    int                 next_model_list_idx,
+    cqlite_arena_t *    arena
+    );
+
+static int bench_model_bind
+    (
+    sqlite3_stmt *  query,
+    void const *    model
+    );
+
+static void bench_model_free
+    (
+    void * model
+    );
+
+static int bench_model_from_row_result
+    (
+    sqlite3_stmt *  query,
+    void *          model_out
+    );
+
+static void bench_model_list_free
+    (
+    bench_model_t * model_list,
+    int             model_list_cnt
+    );
+
+static void bench_models_generate
+    (
+    int             first_idx,
+    int             model_cnt,
+    bench_model_t * models
+    );
+
+static sqlite_int64 bench_now_ns
+    (
+    void
+    );
+
+static int bench_populate
+    (
+    bench_context_t * context
+    );
+
+static sqlite_int64 bench_random_id
+    (
+    bench_context_t * context
+    );
+
+static int bench_run
+    (
+    bench_context_t *   context,
+    bench_t const *     bench,
+    int *               is_first_result
+    );
+
+static void bench_result_print
+    (
+    bench_context_t const * context,
+    char const *            api,
+    char const *            variant,
+    sqlite_int64 *          latencies_ns,
+    int                     call_cnt,
+    sqlite_int64            row_cnt,
+    int *                   is_first_result
+    );
+
+static int latency_compare
+    (
+    void const * a,
+    void const * b
+    );
+
+static void remove_database_files
+    (
+    char const * path
+    );
+
+
+/**********************************************
+Variables
+**********************************************/
+static char const * const BENCH_TABLE_CREATE =
+    "CREATE TABLE IF NOT EXISTS bench"
+    "("
+    "id INTEGER PRIMARY KEY"
+    ", real_field REAL"
+    ", int_field INTEGER"
+    ", dynamic_string_field TEXT"
+    ", fixed_string_field TEXT"
+    ");"
+    "CREATE TABLE IF NOT EXISTS bench_insert"
+    "("
+    "id INTEGER PRIMARY KEY"
+    ", real_field REAL"
+    ", int_field INTEGER"
+    ", dynamic_string_field TEXT"
+    ", fixed_string_field TEXT"
+    ");";
+
+static char const * const BENCH_TABLE_INSERT        = "INSERT INTO bench (real_field, int_field, dynamic_string_field, fixed_string_field) VALUES (?, ?, ?, ?);";
+static char const * const BENCH_TABLE_INSERT_OTHER  = "INSERT INTO bench_insert (real_field, int_field, dynamic_string_field, fixed_string_field) VALUES (?, ?, ?, ?);";
+static char const * const BENCH_TABLE_SELECT_ALL    = "SELECT * FROM bench ORDER BY id;";
+static char const * const BENCH_TABLE_COUNT_ALL     = "SELECT COUNT(*) FROM bench;";
+static char const * const BENCH_TABLE_SELECT_BY_ID  = "SELECT * FROM bench WHERE id = ?;";
+static char const * const BENCH_TABLE_SELECT_BY_IDS = "SELECT * FROM bench WHERE id IN ";
+static char const * const BENCH_TABLE_ID_BOUNDS     = "SELECT MIN(id), MAX(id) FROM bench;";
+static char const * const BENCH_TABLE_SELECT_RANGE  = "SELECT * FROM bench WHERE id BETWEEN ?1 AND ?2 ORDER BY id;";
+static char const * const BENCH_TABLE_COUNT_RANGE   = "SELECT COUNT(*) FROM bench WHERE id BETWEEN ?1 AND ?2;";
+
+static cqlite_column_desc_t const BENCH_TABLE_COLUMNS[] =
+    {
+    CQLITE_COLUMN_DESC( 0, bench_model_t, id,                   CQLITE_FIELD_INT64 ),
+    CQLITE_COLUMN_DESC( 1, bench_model_t, real_field,           CQLITE_FIELD_DOUBLE ),
+    CQLITE_COLUMN_DESC( 2, bench_model_t, int_field,            CQLITE_FIELD_INT ),
+    CQLITE_COLUMN_DESC( 3, bench_model_t, dynamic_string_field, CQLITE_FIELD_DYNAMIC_STRING ),
+    CQLITE_COLUMN_DESC( 4, bench_model_t, fixed_string_field,   CQLITE_FIELD_FIXED_STRING ),
+    };
+
+#define BENCH_TABLE_COLUMN_CNT ( sizeof( BENCH_TABLE_COLUMNS ) / sizeof( BENCH_TABLE_COLUMNS[0] ) )
+
+static int const BENCH_ROW_CNTS[] = { 1000, 10000, 100000, 1000000, 10000000 };
+
+#define BENCH_ROW_CNT_CNT ( (int)( sizeof( BENCH_ROW_CNTS ) / sizeof( BENCH_ROW_CNTS[0] ) ) )
+
+static bench_t const BENCHES[] =
+    {
+    { "cqlite_select_query_execute",            "counted",      BENCH_WHOLE_TABLE,          bench_select_counted },
+    { "cqlite_select_query_execute",            "single_pass",  BENCH_WHOLE_TABLE,          bench_select_single_pass },
+    { "cqlite_arena_select_query_execute",      "single_pass",  BENCH_WHOLE_TABLE,          bench_arena_select },
+    { "cqlite_mapping_select_query_execute",    "single_pass",  BENCH_WHOLE_TABLE,          bench_mapped_select },
+    { "cqlite_cursor_next",                     "batched",      BENCH_WHOLE_TABLE,          bench_cursor },
+    { "cqlite_pool_select_query_execute",       "single_pass",  BENCH_WHOLE_TABLE,          bench_pool_select },
+    { "cqlite_parallel_select_query_execute",   "counted",      BENCH_WHOLE_TABLE,          bench_parallel_select },
+    { "cqlite_count_query_execute",             "full_table",   BENCH_WHOLE_TABLE,          bench_count },
+    { "cqlite_find_by_id",                      "random_id",    1,                          bench_find_by_id },
+    { "cqlite_stmt_cache_find_by_id",           "random_id",    1,                          bench_find_by_id_cached },
+    { "cqlite_find_many_by_ids",                "random_ids",   BENCH_FIND_MANY_CNT,        bench_find_many_by_ids },
+    { "cqlite_insert_query_execute",            "autocommit",   1,                          bench_insert },
+    { "cqlite_insert_many",                     "batched",      BENCH_INSERT_BATCH_SIZE,    bench_insert_many },
+    };
+
+#define BENCH_CNT ( (int)( sizeof( BENCHES ) / sizeof( BENCHES[0] ) ) )
+
+
+/**
+* Benchmark arena SELECT query.
+*/
+static int bench_arena_select
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    )
+{
+int                 success;
+sqlite_int64        start_ns;
+bench_model_t *     models;
+int                 model_cnt;
+cqlite_arena_t *    arena;
+
+start_ns = bench_now_ns();
+success = ( CQLITE_SUCCESS == cqlite_arena_select_query_execute( context->db, BENCH_TABLE_SELECT_ALL, NULL, bench_model_add_to_list_arena, sizeof( bench_model_t ), (void**)&models, &model_cnt, &arena ) );
+*elapsed_ns_out = bench_now_ns() - start_ns;
+*row_cnt_out = model_cnt;
+
+// Clean up
+free( models );
+cqlite_arena_free( arena );
+
+return success;
+}
+
+
+/**
+* Benchmark COUNT query.
+*/
+static int bench_count
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    )
+{
+int             success;
+sqlite_int64    start_ns;
+int             count;
+
+start_ns = bench_now_ns();
+success = ( CQLITE_SUCCESS == cqlite_count_query_execute( context->db, BENCH_TABLE_COUNT_ALL, &count ) );
+*elapsed_ns_out = bench_now_ns() - start_ns;
+*row_cnt_out = count;
+
+return success;
+}
+
+
+/**
+* Benchmark reading the whole table through a cursor.
+*/
+static int bench_cursor
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    )
+{
+int                 success;
+sqlite_int64        start_ns;
+cqlite_cursor_t *   cursor = NULL;
+void *              models;
+int                 model_cnt = 1;
+
+*row_cnt_out = 0;
+
+start_ns = bench_now_ns();
+success = ( CQLITE_SUCCESS == cqlite_cursor_open( context->db, BENCH_TABLE_SELECT_ALL, bench_model_from_row_result, bench_model_free, sizeof( bench_model_t ), BENCH_CURSOR_BATCH_SIZE, &cursor ) );
+
+while( success && ( model_cnt > 0 ) )
+    {
+    success = ( CQLITE_SUCCESS == cqlite_cursor_next( cursor, &models, &model_cnt ) );
+    *row_cnt_out += model_cnt;
+    }
+
+cqlite_cursor_close( cursor );
+*elapsed_ns_out = bench_now_ns() - start_ns;
+
+return success;
+}
+
+
+/**
+* Benchmark finding a random model by id.
+*/
+static int bench_find_by_id
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    )
+{
+int             success;
+sqlite_int64    start_ns;
+sqlite_int64    id;
+int             found;
+bench_model_t   model;
+
+id = bench_random_id( context );
+memset( &model, 0, sizeof( model ) );
+
+start_ns = bench_now_ns();
+success = ( CQLITE_SUCCESS == cqlite_find_by_id( context->db, BENCH_TABLE_SELECT_BY_ID, id, bench_model_from_row_result, &found, &model ) );
+*elapsed_ns_out = bench_now_ns() - start_ns;
+*row_cnt_out = found;
+
+// Clean up
+bench_model_free( &model );
+
+return success && found;
+}
+
+
+/**
+* Benchmark finding a random model by id using a statement cache.
+*/
+static int bench_find_by_id_cached
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    )
+{
+int             success;
+sqlite_int64    start_ns;
+sqlite_int64    id;
+int             found;
+bench_model_t   model;
+
+id = bench_random_id( context );
+memset( &model, 0, sizeof( model ) );
+
+start_ns = bench_now_ns();
+success = ( CQLITE_SUCCESS == cqlite_stmt_cache_find_by_id( context->stmt_cache, BENCH_TABLE_SELECT_BY_ID, id, bench_model_from_row_result, &found, &model ) );
+*elapsed_ns_out = bench_now_ns() - start_ns;
+*row_cnt_out = found;
+
+// Clean up
+bench_model_free( &model );
+
+return success && found;
+}
+
+
+/**
+* Benchmark finding many random models by id.
+*/
+static int bench_find_many_by_ids
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    )
+{
+int             success;
+int             i;
+sqlite_int64    start_ns;
+sqlite_int64    ids[BENCH_FIND_MANY_CNT];
+unsigned char   found_bits[CQLITE_FOUND_BITS_SIZE( BENCH_FIND_MANY_CNT )];
+bench_model_t * models;
+
+*row_cnt_out = 0;
+
+for( i = 0; i < BENCH_FIND_MANY_CNT; i++ )
+    {
+    ids[i] = bench_random_id( context );
+    }
+
+models = calloc( BENCH_FIND_MANY_CNT, sizeof( *models ) );
+success = ( NULL != models );
+
+if( success )
+    {
+    start_ns = bench_now_ns();
+    success = ( CQLITE_SUCCESS == cqlite_find_many_by_ids( context->db, BENCH_TABLE_SELECT_BY_IDS, BENCH_ID_COLUMN, ids, BENCH_FIND_MANY_CNT, bench_model_from_row_result, sizeof( *models ), models, found_bits ) );
+    *elapsed_ns_out = bench_now_ns() - start_ns;
+    }
+
+for( i = 0; success && ( i < BENCH_FIND_MANY_CNT ); i++ )
+    {
+    *row_cnt_out += CQLITE_FOUND_BIT_IS_SET( found_bits, i );
+    }
+
+// Clean up
+for( i = 0; ( NULL != models ) && ( i < BENCH_FIND_MANY_CNT ); i++ )
+    {
+    bench_model_free( &models[i] );
+    }
+
+free( models );
+
+return success && ( BENCH_FIND_MANY_CNT == *row_cnt_out );
+}
+
+
+/**
+* Benchmark inserting a single model.
+*
+* Prepares and binds the insert query outside of the timed call, since
+* that is how cqlite_insert_query_execute() is meant to be used.
+*/
+static int bench_insert
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    )
+{
+int             success;
+sqlite_int64    start_ns;
+sqlite_int64    row_id;
+sqlite3_stmt *  insert_query = NULL;
+
+*elapsed_ns_out = 0;
+*row_cnt_out = 0;
+
+success = ( CQLITE_SUCCESS == cqlite_stmt_cache_acquire( context->stmt_cache, BENCH_TABLE_INSERT_OTHER, &insert_query ) ) &&
+          bench_model_bind( insert_query, &context->insert_models[0] );
+
+if( success )
+    {
+    start_ns = bench_now_ns();
+    success = ( CQLITE_SUCCESS == cqlite_insert_query_execute( context->db, insert_query, &row_id ) );
+    *elapsed_ns_out = bench_now_ns() - start_ns;
+    *row_cnt_out = 1;
+    }
+
+// Clean up
+if( NULL != insert_query )
+    {
+    cqlite_stmt_cache_release( context->stmt_cache, insert_query );
+    }
+
+return success;
+}
+
+
+/**
+* Benchmark inserting a batch of models.
+*/
+static int bench_insert_many
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    )
+{
+int             success;
+sqlite_int64    start_ns;
+
+start_ns = bench_now_ns();
+success = ( CQLITE_SUCCESS == cqlite_insert_many( context->db, BENCH_TABLE_INSERT_OTHER, bench_model_bind, context->insert_models, sizeof( bench_model_t ), BENCH_INSERT_BATCH_SIZE, BENCH_INSERT_BATCH_SIZE, NULL ) );
+*elapsed_ns_out = bench_now_ns() - start_ns;
+*row_cnt_out = BENCH_INSERT_BATCH_SIZE;
+
+return success;
+}
+
+
+/**
+* Benchmark SELECT query using column descriptors.
+*/
+static int bench_mapped_select
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    )
+{
+int             success;
+sqlite_int64    start_ns;
+bench_model_t * models;
+int             model_cnt;
+
+start_ns = bench_now_ns();
+success = ( CQLITE_SUCCESS == cqlite_mapping_select_query_execute( context->db, BENCH_TABLE_SELECT_ALL, NULL, BENCH_TABLE_COLUMNS, BENCH_TABLE_COLUMN_CNT, sizeof( bench_model_t ), (void**)&models, &model_cnt ) );
+*elapsed_ns_out = bench_now_ns() - start_ns;
+*row_cnt_out = model_cnt;
+
+// Clean up
+bench_model_list_free( models, model_cnt );
+
+return success;
+}
+
+
+/**
+* Benchmark parallel SELECT query.
+*/
+static int bench_parallel_select
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    )
+{
+int             success;
+sqlite_int64    start_ns;
+bench_model_t * models;
+int             model_cnt;
+
+start_ns = bench_now_ns();
+success = ( CQLITE_SUCCESS == cqlite_parallel_select_query_execute( context->pool, BENCH_TABLE_ID_BOUNDS, BENCH_TABLE_SELECT_RANGE, BENCH_TABLE_COUNT_RANGE, bench_model_add_to_list, sizeof( bench_model_t ), BENCH_THREAD_CNT, (void**)&models, &model_cnt ) );
+*elapsed_ns_out = bench_now_ns() - start_ns;
+*row_cnt_out = model_cnt;
+
+// Clean up
+bench_model_list_free( models, model_cnt );
+
+return success;
+}
+
+
+/**
+* Benchmark SELECT query using a connection pool.
+*/
+static int bench_pool_select
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    )
+{
+int             success;
+sqlite_int64    start_ns;
+bench_model_t * models;
+int             model_cnt;
+
+start_ns = bench_now_ns();
+success = ( CQLITE_SUCCESS == cqlite_pool_select_query_execute( context->pool, BENCH_TABLE_SELECT_ALL, NULL, bench_model_add_to_list, sizeof( bench_model_t ), (void**)&models, &model_cnt ) );
+*elapsed_ns_out = bench_now_ns() - start_ns;
+*row_cnt_out = model_cnt;
+
+// Clean up
+bench_model_list_free( models, model_cnt );
+
+return success;
+}
+
+
+/**
+* Benchmark SELECT query sized by a COUNT query.
+*/
+static int bench_select_counted
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    )
+{
+int             success;
+sqlite_int64    start_ns;
+bench_model_t * models;
+int             model_cnt;
+
+start_ns = bench_now_ns();
+success = ( CQLITE_SUCCESS == cqlite_select_query_execute( context->db, BENCH_TABLE_SELECT_ALL, BENCH_TABLE_COUNT_ALL, bench_model_add_to_list, sizeof( bench_model_t ), (void**)&models, &model_cnt ) );
+*elapsed_ns_out = bench_now_ns() - start_ns;
+*row_cnt_out = model_cnt;
+
+// Clean up
+bench_model_list_free( models, model_cnt );
+
+return success;
+}
+
+
+/**
+* Benchmark SELECT query in a single pass.
+*/
+static int bench_select_single_pass
+    (
+    bench_context_t *   context,
+    sqlite_int64 *      elapsed_ns_out,
+    sqlite_int64 *      row_cnt_out
+    )
+{
+int             success;
+sqlite_int64    start_ns;
+bench_model_t * models;
+int             model_cnt;
+
+start_ns = bench_now_ns();
+success = ( CQLITE_SUCCESS == cqlite_select_query_execute( context->db, BENCH_TABLE_SELECT_ALL, NULL, bench_model_add_to_list, sizeof( bench_model_t ), (void**)&models, &model_cnt ) );
+*elapsed_ns_out = bench_now_ns() - start_ns;
+*row_cnt_out = model_cnt;
+
+// Clean up
+bench_model_list_free( models, model_cnt );
+
+return success;
+}
+
+
+/**
+* Close benchmark database.
+*
+* Closes all connections to the benchmark database and removes it.
+*/
+static void bench_database_close
+    (
+    char const *        path,
+    bench_context_t *   context
+    )
+{
+cqlite_pool_close( context->pool );
+cqlite_stmt_cache_free( context->stmt_cache );
+sqlite3_close( context->db );
+bench_model_list_free( context->insert_models, BENCH_INSERT_BATCH_SIZE );
+
+memset( context, 0, sizeof( *context ) );
+
+remove_database_files( path );
+}
+
+
+/**
+* Open benchmark database.
+*
+* Creates a new database at the provided path holding row_cnt rows, and
+* opens a connection, a statement cache and a connection pool on it.
+*/
+static int bench_database_open
+    (
+    char const *        path,
+    int                 row_cnt,
+    bench_context_t *   context
+    )
+{
+int success;
+
+memset( context, 0, sizeof( *context ) );
+context->row_cnt = row_cnt;
+context->random_state = row_cnt;
+
+remove_database_files( path );
+
+// Synchronous commits would turn the insert benchmarks into fsync benchmarks
+success = ( SQLITE_OK == sqlite3_open( path, &context->db ) ) &&
+          ( SQLITE_OK == sqlite3_exec( context->db, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;", NO_CALLBACK, NO_CALLBACK_PARAM, NO_ERROR_MESSAGE ) ) &&
+          ( SQLITE_OK == sqlite3_exec( context->db, BENCH_TABLE_CREATE, NO_CALLBACK, NO_CALLBACK_PARAM, NO_ERROR_MESSAGE ) ) &&
+          bench_populate( context ) &&
+          ( CQLITE_SUCCESS == cqlite_stmt_cache_create( context->db, BENCH_CACHE_CAPACITY, &context->stmt_cache ) ) &&
+          ( CQLITE_SUCCESS == cqlite_pool_open( path, BENCH_THREAD_CNT, BENCH_CACHE_CAPACITY, &context->pool ) );
+
+if( success )
+    {
+    context->insert_models = calloc( BENCH_INSERT_BATCH_SIZE, sizeof( bench_model_t ) );
+    success = ( NULL != context->insert_models );
+    }
+
+if( success )
+    {
+    bench_models_generate( 0, BENCH_INSERT_BATCH_SIZE, context->insert_models );
+    }
+
+return success;
+}
+
+
+/**
+* Add bench model to list.
+*/
+static int bench_model_add_to_list
+    (
+    sqlite3_stmt *  query,
+    void *          model_list,
+    int             next_model_list_idx
+    )
+{
+return bench_model_from_row_result( query, &( (bench_model_t*)model_list )[next_model_list_idx] );
+}
+
+
+/**
+* Add bench model to list, allocating its string from an arena.
+*/
+static int bench_model_add_to_list_arena
+    (
+    sqlite3_stmt *      query,
+    void *              model_list,
+    int                 next_model_list_idx,
+    cqlite_arena_t *    arena
+    )
+{
+bench_model_t * model;
+
+model = &( (bench_model_t*)model_list )[next_model_list_idx];
+
+model->id = sqlite3_column_int64( query, 0 );
+model->real_field = sqlite3_column_double( query, 1 );
+model->int_field = sqlite3_column_int( query, 2 );
+
+return ( CQLITE_SUCCESS == cqlite_arena_string_read( query, 3, arena, &model->dynamic_string_field ) ) &&
+       ( CQLITE_SUCCESS == cqlite_fixed_length_string_read( query, 4, model->fixed_string_field, sizeof( model->fixed_string_field ) ) );
+}
+
+
+/**
+* Bind bench model to insert query.
+*/
+static int bench_model_bind
+    (
+    sqlite3_stmt *  query,
+    void const *    model
+    )
+{
+bench_model_t const * bench_model;
+
+bench_model = (bench_model_t const*)model;
+
+return ( SQLITE_OK == sqlite3_bind_double( query, 1, bench_model->real_field ) ) &&
+       ( SQLITE_OK == sqlite3_bind_int( query, 2, bench_model->int_field ) ) &&
+       ( SQLITE_OK == sqlite3_bind_text( query, 3, bench_model->dynamic_string_field, -1, SQLITE_STATIC ) ) &&
+       ( SQLITE_OK == sqlite3_bind_text( query, 4, bench_model->fixed_string_field, -1, SQLITE_STATIC ) );
+}
+
+
+/**
+* Free bench model.
+*/
+static void bench_model_free
+    (
+    void * model
+    )
+{
+free( ( (bench_model_t*)model )->dynamic_string_field );
+( (bench_model_t*)model )->dynamic_string_field = NULL;
+}
+
+
+/**
+* Read bench model from row result.
+*/
+static int bench_model_from_row_result
+    (
+    sqlite3_stmt *  query,
+    void *          model_out
+    )
+{
+bench_model_t * model;
+
+model = (bench_model_t*)model_out;
+
+model->id = sqlite3_column_int64( query, 0 );
+model->real_field = sqlite3_column_double( query, 1 );
+model->int_field = sqlite3_column_int( query, 2 );
+
+return ( CQLITE_SUCCESS == cqlite_dynamic_string_read( query, 3, &model->dynamic_string_field ) ) &&
+       ( CQLITE_SUCCESS == cqlite_fixed_length_string_read( query, 4, model->fixed_string_field, sizeof( model->fixed_string_field ) ) );
+}
+
+
+/**
+* Free list of bench models.
+*/
+static void bench_model_list_free
+    (
+    bench_model_t * model_list,
+    int             model_list_cnt
+    )
+{
+int i;
+
+for( i = 0; ( NULL != model_list ) && ( i < model_list_cnt ); i++ )
+    {
+    bench_model_free( &model_list[i] );
+    }
+
+free( model_list );
+}
+
+
+/**
+* Generate bench models.
+*
+* Fills in model_cnt models with synthetic data derived from their
+* index, starting from first_idx.
+*/
+static void bench_models_generate
+    (
+    int             first_idx,
+    int             model_cnt,
+    bench_model_t * models
+    )
+{
+int     i;
+char    string[32];
+
+for( i = 0; i < model_cnt; i++ )
+    {
+    snprintf( string, sizeof( string ), "model %d", first_idx + i );
+
+    models[i].id = 0;
+    models[i].real_field = ( first_idx + i ) * 0.5;
+    models[i].int_field = first_idx + i;
+    models[i].dynamic_string_field = strdup( string );
+    snprintf( models[i].fixed_string_field, sizeof( models[i].fixed_string_field ), "%03u", (unsigned int)( first_idx + i ) % 1000 );
+    }
+}
+
+
+/**
+* Get monotonic time in nanoseconds.
+*/
+static sqlite_int64 bench_now_ns
+    (
+    void
+    )
+{
+struct timespec now;
+
+clock_gettime( CLOCK_MONOTONIC, &now );
+
+return ( (sqlite_int64)now.tv_sec * NS_PER_SEC ) + now.tv_nsec;
+}
+
+
+/**
+* Populate bench table.
+*
+* Inserts row_cnt synthetic rows into the bench table in chunks, so
+* that the largest tables do not have to be held in memory at once.
+*/
+static int bench_populate
+    (
+    bench_context_t * context
+    )
+{
+int             success;
+int             i;
+int             j;
+int             chunk_cnt;
+bench_model_t * models;
+
+models = calloc( BENCH_POPULATE_CHUNK_SIZE, sizeof( bench_model_t ) );
+success = ( NULL != models );
+
+for( i = 0; success && ( i < context->row_cnt ); i += chunk_cnt )
+    {
+    chunk_cnt = ( ( context->row_cnt - i ) < BENCH_POPULATE_CHUNK_SIZE ) ? ( context->row_cnt - i ) : BENCH_POPULATE_CHUNK_SIZE;
+
+    bench_models_generate( i, chunk_cnt, models );
+    success = ( CQLITE_SUCCESS == cqlite_insert_many( context->db, BENCH_TABLE_INSERT, bench_model_bind, models, sizeof( bench_model_t ), chunk_cnt, chunk_cnt, NULL ) );
+
+    for( j = 0; j < chunk_cnt; j++ )
+        {
+        bench_model_free( &models[j] );
+        }
+    }
+
+// Clean up
+free( models );
+
+return success;
+}
+
+
+/**
+* Print benchmark result.
+*
+* Prints the result of a benchmark as a JSON object. Sorts the provided
+* latencies.
+*/
+static void bench_result_print
+    (
+    bench_context_t const * context,
+    char const *            api,
+    char const *            variant,
+    sqlite_int64 *          latencies_ns,
+    int                     call_cnt,
+    sqlite_int64            row_cnt,
+    int *                   is_first_result
+    )
+{
+int             i;
+sqlite_int64    total_ns = 0;
+
+for( i = 0; i < call_cnt; i++ )
+    {
+    total_ns += latencies_ns[i];
+    }
+
+qsort( latencies_ns, call_cnt, sizeof( *latencies_ns ), latency_compare );
+
+printf( "%s\n    {\"table_rows\": %d, \"api\": \"%s\", \"variant\": \"%s\", \"calls\": %d, \"rows\": %lld, \"rows_per_sec\": %.1f, \"p50_us\": %.3f, \"p99_us\": %.3f}",
+        *is_first_result ? "" : ",",
+        context->row_cnt,
+        api,
+        variant,
+        call_cnt,
+        (long long)row_cnt,
+        ( total_ns > 0 ) ? ( (double)row_cnt * NS_PER_SEC / total_ns ) : 0.0,
+        latencies_ns[( ( call_cnt - 1 ) * 50 ) / 100] / NS_PER_US,
+        latencies_ns[( ( call_cnt - 1 ) * 99 ) / 100] / NS_PER_US );
+
+*is_first_result = 0;
+}
+
+
+/**
+* Get random id.
+*
+* Returns a pseudo-random id of the bench table from a linear
+* congruential generator, which is deterministic across runs.
+*/
+static sqlite_int64 bench_random_id
+    (
+    bench_context_t * context
+    )
+{
+context->random_state = ( context->random_state * 6364136223846793005ULL ) + 1442695040888963407ULL;
+
+return 1 + (sqlite_int64)( ( context->random_state >> 33 ) % context->row_cnt );
+}
+
+
+/**
+* Run benchmark.
+*
+* Calls the benchmark function enough times to read or write about
+* BENCH_ROW_BUDGET rows, within BENCH_MIN_SAMPLE_CNT and
+* BENCH_MAX_SAMPLE_CNT calls, and prints the result.
+*/
+static int bench_run
+    (
+    bench_context_t *   context,
+    bench_t const *     bench,
+    int *               is_first_result
+    )
+{
+int             success;
+int             i;
+int             call_cnt;
+int             rows_per_call;
+sqlite_int64    call_row_cnt;
+sqlite_int64    row_cnt = 0;
+sqlite_int64 *  latencies_ns;
+
+rows_per_call = ( BENCH_WHOLE_TABLE == bench->rows_per_call ) ? context->row_cnt : bench->rows_per_call;
+
+call_cnt = BENCH_ROW_BUDGET / rows_per_call;
+call_cnt = ( call_cnt < BENCH_MIN_SAMPLE_CNT ) ? BENCH_MIN_SAMPLE_CNT : call_cnt;
+call_cnt = ( call_cnt > BENCH_MAX_SAMPLE_CNT ) ? BENCH_MAX_SAMPLE_CNT : call_cnt;
+
+latencies_ns = calloc( call_cnt, sizeof( *latencies_ns ) );
+success = ( NULL != latencies_ns );
+
+for( i = 0; success && ( i < call_cnt ); i++ )
+    {
+    success = bench->func( context, &latencies_ns[i], &call_row_cnt );
+    row_cnt += call_row_cnt;
+    }
+
+if( success )
+    {
+    bench_result_print( context, bench->api, bench->variant, latencies_ns, call_cnt, row_cnt, is_first_result );
+    }
+else
+    {
+    fprintf( stderr, "%s (%s) failed on %d rows\n", bench->api, bench->variant, context->row_cnt );
+    }
+
+// Clean up
+free( latencies_ns );
+
+return success;
+}
+
+
+/**
+* Compare latencies for sorting.
+*/
+static int latency_compare
+    (
+    void const * a,
+    void const * b
+    )
+{
+sqlite_int64 latency_a = *(sqlite_int64 const*)a;
+sqlite_int64 latency_b = *(sqlite_int64 const*)b;
+
+return ( latency_a > latency_b ) - ( latency_a < latency_b );
+}
+
+
+/**
+* Remove database files.
+*
+* Removes the database file at the provided path along with any WAL
+* and shared memory files left next to it.
+*/
+static void remove_database_files
+    (
+    char const * path
+    )
+{
+char file_path[256];
+
+unlink( path );
+
+snprintf( file_path, sizeof( file_path ), "%s-wal", path );
+unlink( file_path );
+
+snprintf( file_path, sizeof( file_path ), "%s-shm", path );
+unlink( file_path );
+}
+
+
+/**
+* Benchmark entry-point.
+*
+* Usage: cqlite_bench [max_row_cnt [database_path]]
+*
+* Runs every benchmark against tables of 1K rows up to max_row_cnt rows,
+* by factors of ten, and prints the results to stdout as JSON.
+*/
+int main
+    (
+    int     argc,
+    char ** argv
+    )
+{
+int                 success = 1;
+int                 i;
+int                 j;
+int                 max_row_cnt = BENCH_DEFAULT_MAX_ROW_CNT;
+char const *        path = BENCH_DEFAULT_DATABASE_FILE;
+int                 is_first_result = 1;
+bench_context_t     context;
+
+if( argc > 1 )
+    {
+    max_row_cnt = atoi( argv[1] );
+    }
+
+if( argc > 2 )
+    {
+    path = argv[2];
+    }
+
+printf( "{\n\"sqlite_version\": \"%s\",\n\"results\": [", sqlite3_libversion() );
+
+for( i = 0; success && ( i < BENCH_ROW_CNT_CNT ) && ( BENCH_ROW_CNTS[i] <= max_row_cnt ); i++ )
+    {
+    success = bench_database_open( path, BENCH_ROW_CNTS[i], &context );
+
+    if( !success )
+        {
+        fprintf( stderr, "failed to create database of %d rows: %s\n", BENCH_ROW_CNTS[i], sqlite3_errmsg( context.db ) );
+        }
+
+    for( j = 0; success && ( j < BENCH_CNT ); j++ )
+        {
+        success = bench_run( &context, &BENCHES[j], &is_first_result );
+        }
+
+    bench_database_close( path, &context );
+    }
+
+printf( "\n]\n}\n" );
+
+return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
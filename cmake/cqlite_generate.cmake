@@ -0,0 +1,25 @@
+# Generates the decode, bind, select, insert and find functions of a
+# model from its description file with cqlite_gen. The generated source
+# and header are named after the description file and written to the
+# current binary directory, and their paths are stored in OUTPUT_VAR
+# to be added to a target's sources. For instance:
+#
+#   cqlite_generate_model(${CMAKE_CURRENT_SOURCE_DIR}/race.model RACE_SOURCES)
+#   add_executable(races main.c ${RACE_SOURCES})
+#   target_include_directories(races PRIVATE ${CMAKE_CURRENT_BINARY_DIR})
+#   target_link_libraries(races cqlite sqlite3)
+function(cqlite_generate_model MODEL_FILE OUTPUT_VAR)
+    get_filename_component(MODEL_NAME ${MODEL_FILE} NAME_WE)
+
+    set(GENERATED_SOURCE ${CMAKE_CURRENT_BINARY_DIR}/${MODEL_NAME}.c)
+    set(GENERATED_HEADER ${CMAKE_CURRENT_BINARY_DIR}/${MODEL_NAME}.h)
+
+    add_custom_command(
+        OUTPUT ${GENERATED_SOURCE} ${GENERATED_HEADER}
+        COMMAND cqlite_gen ${MODEL_FILE} ${GENERATED_SOURCE} ${GENERATED_HEADER}
+        DEPENDS cqlite_gen ${MODEL_FILE}
+        COMMENT "Generating model ${MODEL_NAME}"
+        )
+
+    set(${OUTPUT_VAR} ${GENERATED_SOURCE} ${GENERATED_HEADER} PARENT_SCOPE)
+endfunction()
@@ -1,12 +1,116 @@
+#include <limits.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 
 #include "cqlite.h"
+#include "cqlite_private.h"
+
+#define READ_TO_END                 ( -1 )
+#define NO_TAIL                     ( NULL )
+#define MODEL_LIST_INITIAL_CAPACITY ( 16 )
+#define NO_CALLBACK                 ( NULL )
+#define NO_CALLBACK_PARAM           ( NULL )
+#define NO_ERROR_MESSAGE            ( NULL )
+#define FNV_OFFSET_BASIS            ( 2166136261u )
+#define FNV_PRIME                   ( 16777619u )
+
+
+/**********************************************
+Types
+**********************************************/
+typedef struct
+    {
+    cqlite_model_add_to_list_func_t add_to_list_func;
+    } add_to_list_context_t;
+
+typedef struct
+    {
+    cqlite_model_bind_func_t model_bind_func;
+    } bind_context_t;
+
+typedef struct
+    {
+    sqlite_int64    id;
+    int             idx;
+    } id_entry_t;
+
+
+/**********************************************
+Functions
+**********************************************/
+static int add_to_list_row_read
+    (
+    sqlite3_stmt *  query,
+    void *          model_list,
+    int             next_model_list_idx,
+    void *          context
+    );
+
+static int find_many_query_prepare
+    (
+    char const *    find_many_query_prefix,
+    int             chunk_size,
+    void *          context,
+    sqlite3_stmt ** query_out
+    );
+
+static int id_entry_compare
+    (
+    void const *    entry_a,
+    void const *    entry_b
+    );
+
+static int model_bind_row_bind
+    (
+    sqlite3_stmt *  query,
+    void const *    model,
+    void *          context
+    );
+
+static int model_list_grow
+    (
+    void ** model_list,
+    int *   model_list_capacity,
+    size_t  model_size
+    );
+
+
+// Read blob view from query.
+cqlite_rcode_t cqlite_blob_view_read
+    (
+    sqlite3_stmt *          query,      //!< Query result
+    int                     column,     //!< Column of blob to read from query result
+    cqlite_blob_view_t *    blob_out    //!< (out) Blob borrowed from query result
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+int             column_type;
+
+blob_out->data = NULL;
+blob_out->len = 0;
+
+column_type = sqlite3_column_type( query, column );
+success = ( SQLITE_BLOB == column_type ) || ( SQLITE_NULL == column_type );
 
-#define READ_TO_END ( -1 )
-#define NO_TAIL     ( NULL )
+// Read the size after the blob, as recommended by the SQLite documentation.
+if( SQLITE_BLOB == column_type )
+    {
+    blob_out->data = sqlite3_column_blob( query, column );
+    blob_out->len = sqlite3_column_bytes( query, column );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+return rcode;
+}
 
 
 // Execute count query.
@@ -20,10 +124,13 @@ cqlite_rcode_t cqlite_count_query_execute
 cqlite_rcode_t  rcode = CQLITE_ERROR;
 int             success;
 sqlite3_stmt *  count_query = NULL;
+sqlite_int64    prepare_start_ns;
 
 *count_out = 0;
 
+prepare_start_ns = cqlite_stats_prepare_begin();
 success = ( SQLITE_OK == sqlite3_prepare_v2( db, count_query_str, READ_TO_END, &count_query, NO_TAIL ) );
+cqlite_stats_prepare_end( CQLITE_STATS_API_COUNT, prepare_start_ns );
 
 if( success )
     {
@@ -44,20 +151,82 @@ cqlite_rcode_t cqlite_count_query_execute_prepared
     int *           count_out       //!< (out) Returned count
     )
 {
-cqlite_rcode_t rcode = CQLITE_ERROR;
+cqlite_rcode_t      rcode = CQLITE_ERROR;
+cqlite_stats_call_t stats_call;
+sqlite_int64        phase_start_ns;
 
-*count_out = 0;
+cqlite_stats_call_begin( &stats_call, CQLITE_STATS_API_COUNT );
+phase_start_ns = cqlite_stats_clock( &stats_call );
 
-if( SQLITE_ROW == sqlite3_step( count_query ) )
+if( cqlite_count_query_step( count_query, count_out ) )
     {
     rcode = CQLITE_SUCCESS;
-    *count_out = sqlite3_column_int( count_query, 0 );
     }
 
+cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_STEP, phase_start_ns );
+cqlite_stats_call_end( &stats_call, count_query, ( CQLITE_SUCCESS == rcode ) );
+
 return rcode;
 }    
 
 
+// Execute 64-bit count query.
+cqlite_rcode_t cqlite_count_query_execute_int64
+    (
+    sqlite3 *           db,                 //!< Database on which to execute the query
+    char const * const  count_query_str,    //!< Parameter-less COUNT query string
+    sqlite_int64 *      count_out           //!< (out) Returned count
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+sqlite3_stmt *  count_query = NULL;
+sqlite_int64    prepare_start_ns;
+
+*count_out = 0;
+
+prepare_start_ns = cqlite_stats_prepare_begin();
+success = ( SQLITE_OK == sqlite3_prepare_v2( db, count_query_str, READ_TO_END, &count_query, NO_TAIL ) );
+cqlite_stats_prepare_end( CQLITE_STATS_API_COUNT, prepare_start_ns );
+
+if( success )
+    {
+    rcode = cqlite_count_query_execute_prepared_int64( count_query, count_out );
+    }
+
+// Clean up
+sqlite3_finalize( count_query );
+
+return rcode;
+}
+
+
+// Execute prepared 64-bit count query.
+cqlite_rcode_t cqlite_count_query_execute_prepared_int64
+    (
+    sqlite3_stmt *  count_query,    //!< Prepared COUNT query
+    sqlite_int64 *  count_out       //!< (out) Returned count
+    )
+{
+cqlite_rcode_t      rcode = CQLITE_ERROR;
+cqlite_stats_call_t stats_call;
+sqlite_int64        phase_start_ns;
+
+cqlite_stats_call_begin( &stats_call, CQLITE_STATS_API_COUNT );
+phase_start_ns = cqlite_stats_clock( &stats_call );
+
+if( cqlite_count_query_step_int64( count_query, count_out ) )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_STEP, phase_start_ns );
+cqlite_stats_call_end( &stats_call, count_query, ( CQLITE_SUCCESS == rcode ) );
+
+return rcode;
+}
+
+
 // Read dynamically-allocated string from query.
 cqlite_rcode_t cqlite_dynamic_string_read
     (
@@ -79,6 +248,11 @@ if( SQLITE_TEXT == column_type )
     {
     *string_out = strdup( sqlite3_column_text( query, column ) );
     success = ( NULL != *string_out );
+
+    if( success )
+        {
+        cqlite_stats_bytes_add( sqlite3_column_bytes( query, column ) + 1 );
+        }
     }
 
 if( success )
@@ -99,19 +273,27 @@ cqlite_rcode_t cqlite_find
     void *                              model_out               //!< (out) Found model
     )
 {
-cqlite_rcode_t  rcode = CQLITE_ERROR;
-int             success;
-int             sqlite_rcode;
+cqlite_rcode_t      rcode = CQLITE_ERROR;
+int                 success;
+int                 sqlite_rcode;
+cqlite_stats_call_t stats_call;
+sqlite_int64        phase_start_ns;
 
 *found_out = 0;
 
+cqlite_stats_call_begin( &stats_call, CQLITE_STATS_API_FIND );
+phase_start_ns = cqlite_stats_clock( &stats_call );
+
 sqlite_rcode = sqlite3_step( query );
 success = ( SQLITE_ROW == sqlite_rcode ) || ( SQLITE_DONE == sqlite_rcode );
+phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_STEP, phase_start_ns );
 
 if( SQLITE_ROW == sqlite_rcode )
     {
     *found_out = 1;
     success = model_from_result_func( query, model_out );
+    stats_call.rows_read = 1;
+    cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_DECODE, phase_start_ns );
     }
 
 if( success )
@@ -119,6 +301,8 @@ if( success )
     rcode = CQLITE_SUCCESS;
     }
 
+cqlite_stats_call_end( &stats_call, query, success );
+
 return rcode;
 }    
 
@@ -137,11 +321,15 @@ cqlite_rcode_t cqlite_find_by_id
 cqlite_rcode_t  rcode = CQLITE_ERROR;
 int             success;
 sqlite3_stmt *  select_query = NULL;
+sqlite_int64    prepare_start_ns;
 
 *found_out = 0;
 
-success = ( SQLITE_OK == sqlite3_prepare_v2( db, find_by_id_query, READ_TO_END, &select_query, NO_TAIL ) ) &&
-          ( SQLITE_OK == sqlite3_bind_int64( select_query, 1, id ) );
+prepare_start_ns = cqlite_stats_prepare_begin();
+success = ( SQLITE_OK == sqlite3_prepare_v2( db, find_by_id_query, READ_TO_END, &select_query, NO_TAIL ) );
+cqlite_stats_prepare_end( CQLITE_STATS_API_FIND, prepare_start_ns );
+
+success = success && ( SQLITE_OK == sqlite3_bind_int64( select_query, 1, id ) );
 
 if( success )
     {
@@ -155,6 +343,32 @@ return rcode;
 }    
 
 
+// Find many models by id.
+cqlite_rcode_t cqlite_find_many_by_ids
+    (
+    sqlite3 *                           db,                     //!< Database on which to execute the query
+    char const * const                  find_many_query_prefix, //!< SELECT query string ending in "IN "
+    int                                 id_column,              //!< Result column holding the id
+    sqlite_int64 const *                ids,                    //!< Ids to search for
+    int                                 id_cnt,                 //!< Number of ids
+    cqlite_model_from_row_result_func_t model_from_result_func, //!< Function to read a result into a model
+    size_t                              model_size,             //!< Size of the model type
+    void *                              model_list,             //!< (out) Found models in the order of ids
+    unsigned char *                     found_bits              //!< (out) Bit of each id that was found
+    )
+{
+cqlite_rcode_t  rcode;
+sqlite3_stmt *  select_query = NULL;
+
+rcode = cqlite_find_many_rows( find_many_query_prepare, db, find_many_query_prefix, id_column, ids, id_cnt, model_from_result_func, model_size, model_list, found_bits, &select_query );
+
+// Clean up
+sqlite3_finalize( select_query );
+
+return rcode;
+}
+
+
 // Read fixed-length string from query.
 cqlite_rcode_t cqlite_fixed_length_string_read
     (
@@ -191,6 +405,66 @@ return rcode;
 }    
 
 
+// Insert many models.
+cqlite_rcode_t cqlite_insert_many
+    (
+    sqlite3 *                   db,                 //!< Database on which to execute the query
+    char const * const          insert_query_str,   //!< INSERT query string taking the model's parameters
+    cqlite_model_bind_func_t    model_bind_func,    //!< Function to bind a model to the query
+    void const *                model_list,         //!< List of models to insert
+    size_t                      model_size,         //!< Size of the model type
+    int                         model_list_cnt,     //!< Number of models to insert
+    int                         batch_size,         //!< Number of models inserted per transaction
+    sqlite_int64 **             row_ids_out         //!< (out) Generated row id of each model, caller must free, may be NULL
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+sqlite3_stmt *  insert_query = NULL;
+sqlite_int64    prepare_start_ns;
+
+if( NULL != row_ids_out )
+    {
+    *row_ids_out = NULL;
+    }
+
+prepare_start_ns = cqlite_stats_prepare_begin();
+success = ( SQLITE_OK == sqlite3_prepare_v2( db, insert_query_str, READ_TO_END, &insert_query, NO_TAIL ) );
+cqlite_stats_prepare_end( CQLITE_STATS_API_INSERT, prepare_start_ns );
+
+if( success )
+    {
+    rcode = cqlite_insert_many_prepared( db, insert_query, model_bind_func, model_list, model_size, model_list_cnt, batch_size, row_ids_out );
+    }
+
+// Clean up
+sqlite3_finalize( insert_query );
+
+return rcode;
+}
+
+
+// Insert many models using prepared query.
+cqlite_rcode_t cqlite_insert_many_prepared
+    (
+    sqlite3 *                   db,                 //!< Database on which to execute the query
+    sqlite3_stmt *              insert_query,       //!< Prepared INSERT query
+    cqlite_model_bind_func_t    model_bind_func,    //!< Function to bind a model to the query
+    void const *                model_list,         //!< List of models to insert
+    size_t                      model_size,         //!< Size of the model type
+    int                         model_list_cnt,     //!< Number of models to insert
+    int                         batch_size,         //!< Number of models inserted per transaction
+    sqlite_int64 **             row_ids_out         //!< (out) Generated row id of each model, caller must free, may be NULL
+    )
+{
+bind_context_t context;
+
+context.model_bind_func = model_bind_func;
+
+return cqlite_insert_rows( db, insert_query, model_bind_row_bind, &context, model_list, model_size, model_list_cnt, batch_size, row_ids_out );
+}
+
+
 // Execute insert query.
 cqlite_rcode_t cqlite_insert_query_execute
     (
@@ -199,10 +473,16 @@ cqlite_rcode_t cqlite_insert_query_execute
     sqlite_int64 *  new_row_id_out  //!< (out) Generated row id of new record  
     )
 {
-cqlite_rcode_t  rcode = CQLITE_ERROR;
-int             success;
+cqlite_rcode_t      rcode = CQLITE_ERROR;
+int                 success;
+cqlite_stats_call_t stats_call;
+sqlite_int64        phase_start_ns;
+
+cqlite_stats_call_begin( &stats_call, CQLITE_STATS_API_INSERT );
+phase_start_ns = cqlite_stats_clock( &stats_call );
 
 success = ( SQLITE_DONE == sqlite3_step( insert_query ) );
+cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_STEP, phase_start_ns );
 
 if( success )
     {
@@ -214,6 +494,8 @@ if( success )
         }
     }
 
+cqlite_stats_call_end( &stats_call, insert_query, success );
+
 return rcode;
 }
 
@@ -223,7 +505,7 @@ cqlite_rcode_t cqlite_select_query_execute
     (
     sqlite3 *                       db,                 //!< Database on which to execute the query                
     char const * const              select_query_str,   //!< Parameter-less SELECT query string                    
-    char const * const              count_query_str,    //!< Parameter-less COUNT query string                     
+    char const * const              count_query_str,    //!< Parameter-less COUNT query string, NULL to read in a single pass that grows the list
     cqlite_model_add_to_list_func_t add_to_list_func,   //!< Add model to list function pointer                    
     size_t                          model_size,         //!< Size of the model type                                
     void **                         model_list_out,     //!< (out) List of models read from query, caller must free
@@ -234,12 +516,21 @@ cqlite_rcode_t  rcode = CQLITE_ERROR;
 int             success;
 sqlite3_stmt *  select_query = NULL;
 sqlite3_stmt *  count_query = NULL;
+sqlite_int64    prepare_start_ns;
 
 *model_list_out = NULL;
 *model_list_cnt_out = 0;
 
-success = ( SQLITE_OK == sqlite3_prepare_v2( db, select_query_str, READ_TO_END, &select_query, NO_TAIL ) ) &&
-          ( SQLITE_OK == sqlite3_prepare_v2( db, count_query_str, READ_TO_END, &count_query, NO_TAIL ) );
+prepare_start_ns = cqlite_stats_prepare_begin();
+success = ( SQLITE_OK == sqlite3_prepare_v2( db, select_query_str, READ_TO_END, &select_query, NO_TAIL ) );
+
+// The COUNT query is optional, without it the SELECT query is executed in a single pass.
+if( success && ( NULL != count_query_str ) )
+    {
+    success = ( SQLITE_OK == sqlite3_prepare_v2( db, count_query_str, READ_TO_END, &count_query, NO_TAIL ) );
+    }
+
+cqlite_stats_prepare_end( CQLITE_STATS_API_SELECT, prepare_start_ns );
 
 if( success )
     {
@@ -258,50 +549,566 @@ return rcode;
 cqlite_rcode_t cqlite_select_query_execute_prepared
     (
     sqlite3_stmt *                  select_query,       //!< Prepared SELECT query                                 
-    sqlite3_stmt *                  count_query,        //!< Prepared COUNT query                                  
+    sqlite3_stmt *                  count_query,        //!< Prepared COUNT query, NULL for single pass            
     cqlite_model_add_to_list_func_t add_to_list_func,   //!< Add model to list function pointer                    
     size_t                          model_size,         //!< Size of the model type                                
     void **                         model_list_out,     //!< (out) List of models read from query, caller must free
     int *                           model_list_cnt_out  //!< (out) Number of models read from query                
     )
 {
+add_to_list_context_t context;
+
+context.add_to_list_func = add_to_list_func;
+
+return cqlite_select_rows_read( select_query, count_query, add_to_list_row_read, &context, model_size, model_list_out, model_list_cnt_out );
+}
+
+
+// Read string view from query.
+cqlite_rcode_t cqlite_string_view_read
+    (
+    sqlite3_stmt *          query,      //!< Query result
+    int                     column,     //!< Column of string to read from query result
+    cqlite_string_view_t *  string_out  //!< (out) String borrowed from query result
+    )
+{
 cqlite_rcode_t  rcode = CQLITE_ERROR;
 int             success;
-int             model_list_cnt = 0;
-void *          model_list = NULL;
-int             sqlite_rcode = SQLITE_ERROR;
-int             model_idx = 0;
+int             column_type;
+
+string_out->text = NULL;
+string_out->len = 0;
+
+column_type = sqlite3_column_type( query, column );
+success = ( SQLITE_TEXT == column_type ) || ( SQLITE_NULL == column_type );
+
+// The size must be read after the text to get the size of the UTF-8 text.
+if( SQLITE_TEXT == column_type )
+    {
+    string_out->text = (char const *)sqlite3_column_text( query, column );
+    string_out->len = sqlite3_column_bytes( query, column );
+
+    // NULL text for a string result is an out of memory error.
+    success = ( NULL != string_out->text );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+return rcode;
+}
+
+
+/**********************************************
+Internal functions
+**********************************************/
+
+// Step count query.
+int cqlite_count_query_step
+    (
+    sqlite3_stmt *  count_query,    //!< Prepared COUNT query
+    int *           count_out       //!< (out) Returned count
+    )
+{
+int             success;
+sqlite_int64    count;
+
+*count_out = 0;
+
+// Counts that do not fit are errors rather than truncated
+success = cqlite_count_query_step_int64( count_query, &count ) &&
+          ( count <= INT_MAX );
+
+if( success )
+    {
+    *count_out = (int)count;
+    }
+
+return success;
+}
+
+
+// Step 64-bit count query.
+int cqlite_count_query_step_int64
+    (
+    sqlite3_stmt *  count_query,    //!< Prepared COUNT query
+    sqlite_int64 *  count_out       //!< (out) Returned count
+    )
+{
+int success;
+
+*count_out = 0;
+
+success = ( SQLITE_ROW == sqlite3_step( count_query ) );
+
+if( success )
+    {
+    *count_out = sqlite3_column_int64( count_query, 0 );
+    success = ( *count_out >= 0 );
+    }
+
+// Complete the statement within the calling function, rather than
+// whenever the caller next resets or finalizes it.
+sqlite3_reset( count_query );
+
+return success;
+}
+
+
+// Build find many query.
+char * cqlite_find_many_query_build
+    (
+    char const *    find_many_query_prefix, //!< SELECT query string ending in "IN "
+    int             chunk_size              //!< Number of parameters in the IN-list
+    )
+{
+char *  query_str;
+size_t  prefix_len;
+size_t  i;
+
+prefix_len = strlen( find_many_query_prefix );
+
+// Room for "(" and ")" around chunk_size comma-separated parameters, plus NUL.
+query_str = malloc( prefix_len + ( 2 * (size_t)chunk_size ) + 2 );
+
+if( NULL != query_str )
+    {
+    memcpy( query_str, find_many_query_prefix, prefix_len );
+    query_str[prefix_len] = '(';
+
+    for( i = 0; i < (size_t)chunk_size; i++ )
+        {
+        query_str[prefix_len + 1 + ( 2 * i )] = '?';
+        query_str[prefix_len + 2 + ( 2 * i )] = ( ( i + 1 ) < (size_t)chunk_size ) ? ',' : ')';
+        }
+
+    query_str[prefix_len + 1 + ( 2 * (size_t)chunk_size )] = '\0';
+    }
+
+return query_str;
+}
+
+
+// Find many models by id using any prepare function.
+cqlite_rcode_t cqlite_find_many_rows
+    (
+    cqlite_find_many_prepare_func_t     prepare_func,           //!< Function to prepare the query for a chunk size
+    void *                              context,                //!< Context passed to prepare_func
+    char const * const                  find_many_query_prefix, //!< SELECT query string ending in "IN "
+    int                                 id_column,              //!< Result column holding the id
+    sqlite_int64 const *                ids,                    //!< Ids to search for
+    int                                 id_cnt,                 //!< Number of ids
+    cqlite_model_from_row_result_func_t model_from_result_func, //!< Function to read a result into a model
+    size_t                              model_size,             //!< Size of the model type
+    void *                              model_list,             //!< (out) Found models in the order of ids
+    unsigned char *                     found_bits,             //!< (out) Bit of each id that was found
+    sqlite3_stmt **                     select_query_out        //!< (out) Prepared query, caller must clean up regardless of the result
+    )
+{
+cqlite_rcode_t      rcode = CQLITE_ERROR;
+int                 success;
+int                 i;
+int                 unique_cnt = 0;
+int                 chunk_size;
+int                 chunk_start;
+int                 chunk_end;
+int                 param;
+int                 lo;
+int                 hi;
+int                 sqlite_rcode;
+sqlite_int64        id;
+id_entry_t *        entries = NULL;
+sqlite3_stmt *      select_query = NULL;
+cqlite_stats_call_t stats_call;
+sqlite_int64        phase_start_ns;
+
+success = ( id_cnt >= 0 );
+
+if( success )
+    {
+    memset( found_bits, 0, CQLITE_FOUND_BITS_SIZE( id_cnt ) );
+    }
+
+// Sort the ids so that each chunk is a contiguous run of the index
+// and each result can be matched back to its entries by binary search.
+if( success && ( id_cnt > 0 ) )
+    {
+    entries = malloc( id_cnt * sizeof( *entries ) );
+    success = ( NULL != entries );
+    }
+
+for( i = 0; success && ( i < id_cnt ); i++ )
+    {
+    entries[i].id = ids[i];
+    entries[i].idx = i;
+    }
+
+if( success && ( id_cnt > 0 ) )
+    {
+    qsort( entries, id_cnt, sizeof( *entries ), id_entry_compare );
+    }
+
+for( i = 0; success && ( i < id_cnt ); i++ )
+    {
+    if( ( 0 == i ) || ( entries[i].id != entries[i - 1].id ) )
+        {
+        unique_cnt++;
+        }
+    }
+
+// A single query is prepared for all chunks, small batches bind fewer
+// parameters. The prepare function may add parameters to the query,
+// which are padded like the last chunk.
+chunk_size = ( unique_cnt < CQLITE_FIND_MANY_CHUNK_SIZE ) ? unique_cnt : CQLITE_FIND_MANY_CHUNK_SIZE;
+
+if( success && ( chunk_size > 0 ) )
+    {
+    success = prepare_func( find_many_query_prefix, chunk_size, context, &select_query );
+    *select_query_out = select_query;
+    }
+
+if( success && ( chunk_size > 0 ) )
+    {
+    chunk_size = sqlite3_bind_parameter_count( select_query );
+    }
+
+cqlite_stats_call_begin( &stats_call, CQLITE_STATS_API_FIND );
+phase_start_ns = cqlite_stats_clock( &stats_call );
+
+for( chunk_start = 0; success && ( chunk_start < id_cnt ); chunk_start = chunk_end )
+    {
+    // Bind the next chunk of unique ids, padding the last chunk by
+    // repeating its last id.
+    param = 0;
+
+    for( chunk_end = chunk_start; success && ( chunk_end < id_cnt ) && ( param < chunk_size ); chunk_end++ )
+        {
+        if( ( chunk_end == chunk_start ) || ( entries[chunk_end].id != entries[chunk_end - 1].id ) )
+            {
+            param++;
+            success = ( SQLITE_OK == sqlite3_bind_int64( select_query, param, entries[chunk_end].id ) );
+            }
+        }
+
+    // Include the duplicates of the last bound id in the chunk
+    while( ( chunk_end < id_cnt ) && ( entries[chunk_end].id == entries[chunk_end - 1].id ) )
+        {
+        chunk_end++;
+        }
+
+    for( param++; success && ( param <= chunk_size ); param++ )
+        {
+        success = ( SQLITE_OK == sqlite3_bind_int64( select_query, param, entries[chunk_end - 1].id ) );
+        }
+
+    sqlite_rcode = success ? sqlite3_step( select_query ) : SQLITE_ERROR;
+    phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_STEP, phase_start_ns );
+
+    while( success && ( SQLITE_ROW == sqlite_rcode ) )
+        {
+        id = sqlite3_column_int64( select_query, id_column );
+
+        // Find the first entry of the chunk with the result's id
+        lo = chunk_start;
+        hi = chunk_end;
+
+        while( lo < hi )
+            {
+            i = lo + ( hi - lo ) / 2;
+
+            if( entries[i].id < id )
+                {
+                lo = i + 1;
+                }
+            else
+                {
+                hi = i;
+                }
+            }
+
+        // Read the result into every entry with its id that was not already found
+        for( i = lo; success && ( i < chunk_end ) && ( entries[i].id == id ); i++ )
+            {
+            if( !CQLITE_FOUND_BIT_IS_SET( found_bits, entries[i].idx ) )
+                {
+                success = model_from_result_func( select_query, (char*)model_list + ( entries[i].idx * model_size ) );
+                stats_call.rows_read++;
+
+                // A model that failed to decode is not marked as found
+                if( success )
+                    {
+                    found_bits[entries[i].idx / 8] |= ( 1 << ( entries[i].idx % 8 ) );
+                    }
+                }
+            }
+
+        phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_DECODE, phase_start_ns );
+
+        if( success )
+            {
+            sqlite_rcode = sqlite3_step( select_query );
+            phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_STEP, phase_start_ns );
+            }
+        }
+
+    success = success && ( SQLITE_DONE == sqlite_rcode );
+
+    sqlite3_reset( select_query );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+cqlite_stats_call_end( &stats_call, select_query, success );
+
+// Clean up
+free( entries );
+
+return rcode;
+}
+
+
+// Insert models in batches.
+cqlite_rcode_t cqlite_insert_rows
+    (
+    sqlite3 *               db,                 //!< Database on which to execute the query
+    sqlite3_stmt *          insert_query,       //!< Prepared INSERT query
+    cqlite_row_bind_func_t  row_bind_func,      //!< Function to bind a model to the query
+    void *                  context,            //!< Context passed to row_bind_func
+    void const *            model_list,         //!< List of models to insert
+    size_t                  model_size,         //!< Size of the model type
+    int                     model_list_cnt,     //!< Number of models to insert
+    int                     batch_size,         //!< Number of models inserted per transaction
+    sqlite_int64 **         row_ids_out         //!< (out) Generated row id of each model, caller must free, may be NULL
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success = 1;
+int             in_transaction = 0;
+int             batch_cnt = 0;
+int             batch_start_idx = 0;
+int             i;
+sqlite_int64 *  row_ids = NULL;
+void const *    model;
+char const *    begin_str;
+char const *    commit_str;
+char const *    rollback_str;
+
+if( NULL != row_ids_out )
+    {
+    *row_ids_out = NULL;
+
+    row_ids = malloc( ( model_list_cnt > 0 ? model_list_cnt : 1 ) * sizeof( *row_ids ) );
+    success = ( NULL != row_ids );
+
+    for( i = 0; success && ( i < model_list_cnt ); i++ )
+        {
+        row_ids[i] = CQLITE_INVALID_ROW_ID;
+        }
+    }
+
+// Inside a transaction opened by the caller, each batch is a savepoint
+// so that a failed batch is undone without ending the transaction.
+if( sqlite3_get_autocommit( db ) )
+    {
+    begin_str = "BEGIN IMMEDIATE;";
+    commit_str = "COMMIT;";
+    rollback_str = "ROLLBACK;";
+    }
+else
+    {
+    begin_str = "SAVEPOINT cqlite_insert_batch;";
+    commit_str = "RELEASE cqlite_insert_batch;";
+    rollback_str = "ROLLBACK TO cqlite_insert_batch; RELEASE cqlite_insert_batch;";
+    }
+
+for( i = 0; success && ( i < model_list_cnt ); i++ )
+    {
+    if( !in_transaction )
+        {
+        success = ( SQLITE_OK == sqlite3_exec( db, begin_str, NO_CALLBACK, NO_CALLBACK_PARAM, NO_ERROR_MESSAGE ) );
+        in_transaction = success;
+        batch_start_idx = i;
+        batch_cnt = 0;
+        }
+
+    if( success )
+        {
+        model = (char const*)model_list + ( i * model_size );
+
+        sqlite3_reset( insert_query );
+        sqlite3_clear_bindings( insert_query );
+
+        success = row_bind_func( insert_query, model, context ) &&
+                  ( CQLITE_SUCCESS == cqlite_insert_query_execute( db, insert_query, ( NULL != row_ids ) ? &row_ids[i] : NULL ) );
+        batch_cnt++;
+        }
+
+    if( success && in_transaction && ( ( batch_cnt == batch_size ) || ( i == ( model_list_cnt - 1 ) ) ) )
+        {
+        success = ( SQLITE_OK == sqlite3_exec( db, commit_str, NO_CALLBACK, NO_CALLBACK_PARAM, NO_ERROR_MESSAGE ) );
+        in_transaction = !success;
+        }
+    }
+
+// Roll back the batch that failed
+sqlite3_reset( insert_query );
+
+if( in_transaction )
+    {
+    sqlite3_exec( db, rollback_str, NO_CALLBACK, NO_CALLBACK_PARAM, NO_ERROR_MESSAGE );
+
+    for( i = batch_start_idx; ( NULL != row_ids ) && ( i < model_list_cnt ); i++ )
+        {
+        row_ids[i] = CQLITE_INVALID_ROW_ID;
+        }
+    }
+
+// Set the output
+if( NULL != row_ids_out )
+    {
+    *row_ids_out = row_ids;
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+return rcode;
+}
+
+
+// Is the journal mode WAL?
+int cqlite_journal_mode_is_wal
+    (
+    sqlite3 * db    //!< Database to check
+    )
+{
+int             is_wal;
+sqlite3_stmt *  query = NULL;
+char const *    mode;
+
+is_wal = ( SQLITE_OK == sqlite3_prepare_v2( db, "PRAGMA journal_mode;", READ_TO_END, &query, NO_TAIL ) ) &&
+         ( SQLITE_ROW == sqlite3_step( query ) );
+
+if( is_wal )
+    {
+    mode = (char const*)sqlite3_column_text( query, 0 );
+    is_wal = ( NULL != mode ) && ( 0 == strcasecmp( mode, "wal" ) );
+    }
+
+// Clean up
+sqlite3_finalize( query );
+
+return is_wal;
+}
+
+
+// Hash query string.
+unsigned int cqlite_query_str_hash
+    (
+    char const * query_str  //!< Query string to hash
+    )
+{
+unsigned int hash = FNV_OFFSET_BASIS;
+
+while( '\0' != *query_str )
+    {
+    hash ^= (unsigned char)*query_str++;
+    hash *= FNV_PRIME;
+    }
+
+return hash;
+}
+
+
+// Read SELECT query rows into model list.
+cqlite_rcode_t cqlite_select_rows_read
+    (
+    sqlite3_stmt *          select_query,       //!< Prepared SELECT query
+    sqlite3_stmt *          count_query,        //!< Prepared COUNT query, NULL for single pass
+    cqlite_row_read_func_t  row_read_func,      //!< Function to read a row into the model list
+    void *                  context,            //!< Context passed to row_read_func
+    size_t                  model_size,         //!< Size of the model type
+    void **                 model_list_out,     //!< (out) List of models read from query, caller must free
+    int *                   model_list_cnt_out  //!< (out) Number of models read from query
+    )
+{
+cqlite_rcode_t      rcode = CQLITE_ERROR;
+int                 success = 1;
+int                 is_single_pass;
+int                 model_list_cnt = 0;
+int                 model_list_capacity = 0;
+void *              model_list = NULL;
+void *              shrunk_model_list;
+int                 sqlite_rcode = SQLITE_ERROR;
+int                 model_idx = 0;
+cqlite_stats_call_t stats_call;
+sqlite_int64        phase_start_ns;
+
+is_single_pass = ( NULL == count_query );
+
+cqlite_stats_call_begin( &stats_call, CQLITE_STATS_API_SELECT );
+phase_start_ns = cqlite_stats_clock( &stats_call );
 
 // Get the number of expected results
-success = ( CQLITE_SUCCESS == cqlite_count_query_execute_prepared( count_query, &model_list_cnt ) );
+if( !is_single_pass )
+    {
+    success = cqlite_count_query_step( count_query, &model_list_capacity );
+    phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_COUNT, phase_start_ns );
+    }
 
 // Allocate the output list to hold all expected results.
-if( success && ( model_list_cnt > 0 ) )
+if( success && ( model_list_capacity > 0 ) )
     {
-    model_list = calloc( model_list_cnt, model_size );
+    model_list = calloc( model_list_capacity, model_size );
     success = ( NULL != model_list );
+
+    if( success )
+        {
+        cqlite_stats_bytes_add( model_list_capacity * model_size );
+        }
+
+    phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_ALLOC, phase_start_ns );
     }
 
 if( success )
     {
     sqlite_rcode = sqlite3_step( select_query );
+    phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_STEP, phase_start_ns );
     }
 
 // Read each result into the output list
 while( success && ( SQLITE_ROW == sqlite_rcode ) )
     {
-    if( model_idx >= model_list_cnt )
+    if( model_idx >= model_list_capacity )
         {
-        // More results returned than expected.
-        success = 0;
+        // More results returned than expected. This is only
+        // an error if the list was sized by the COUNT query.
+        success = is_single_pass && model_list_grow( &model_list, &model_list_capacity, model_size );
+        phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_ALLOC, phase_start_ns );
         }
-    else
+
+    if( success )
         {
-        success = add_to_list_func( select_query, model_list, model_idx );
+        success = row_read_func( select_query, model_list, model_idx, context );
+        phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_DECODE, phase_start_ns );
+
+        // A model that failed part way through decoding is still
+        // counted, so that the caller frees what it already owns.
+        model_idx++;
+        }
 
+    if( success )
+        {
         // Move to the next result
         sqlite_rcode = sqlite3_step( select_query );
-        model_idx++;
+        phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_STEP, phase_start_ns );
         }
     }
 
@@ -311,6 +1118,27 @@ if( success )
     success = ( SQLITE_DONE == sqlite_rcode );
     }
 
+if( is_single_pass )
+    {
+    // Only the models that were read need to be returned. Release the
+    // unused tail of the list, keeping the larger list if that fails.
+    model_list_cnt = model_idx;
+
+    if( success && ( model_list_cnt < model_list_capacity ) )
+        {
+        shrunk_model_list = realloc( model_list, model_list_cnt * model_size );
+
+        if( NULL != shrunk_model_list )
+            {
+            model_list = shrunk_model_list;
+            }
+        }
+    }
+else
+    {
+    model_list_cnt = model_list_capacity;
+    }
+
 // Set the output
 *model_list_out     = model_list;
 *model_list_cnt_out = model_list_cnt;
@@ -320,5 +1148,150 @@ if( success )
     rcode = CQLITE_SUCCESS;
     }
 
+stats_call.rows_read = model_idx;
+cqlite_stats_call_end( &stats_call, select_query, success );
+
 return rcode;
-}    
\ No newline at end of file
+}
+
+
+/**
+* Add model to list row reader.
+*
+* Adapts a cqlite_model_add_to_list_func_t to cqlite_row_read_func_t.
+*/
+static int add_to_list_row_read
+    (
+    sqlite3_stmt *  query,
+    void *          model_list,
+    int             next_model_list_idx,
+    void *          context
+    )
+{
+return ( (add_to_list_context_t*)context )->add_to_list_func( query, model_list, next_model_list_idx );
+}
+
+
+/**
+* Prepare find many query.
+*
+* Implements cqlite_find_many_prepare_func_t for a database connection.
+*/
+static int find_many_query_prepare
+    (
+    char const *    find_many_query_prefix,
+    int             chunk_size,
+    void *          context,
+    sqlite3_stmt ** query_out
+    )
+{
+int             success;
+char *          query_str;
+sqlite_int64    prepare_start_ns;
+
+query_str = cqlite_find_many_query_build( find_many_query_prefix, chunk_size );
+success = ( NULL != query_str );
+
+if( success )
+    {
+    prepare_start_ns = cqlite_stats_prepare_begin();
+    success = ( SQLITE_OK == sqlite3_prepare_v2( (sqlite3*)context, query_str, READ_TO_END, query_out, NO_TAIL ) );
+    cqlite_stats_prepare_end( CQLITE_STATS_API_FIND, prepare_start_ns );
+    }
+
+// Clean up
+free( query_str );
+
+return success;
+}
+
+
+/**
+* Compare id entries.
+*
+* Orders entries by id, then by their index into the caller's ids.
+*/
+static int id_entry_compare
+    (
+    void const *    entry_a,
+    void const *    entry_b
+    )
+{
+id_entry_t const *  a = entry_a;
+id_entry_t const *  b = entry_b;
+int                 result;
+
+if( a->id != b->id )
+    {
+    result = ( a->id < b->id ) ? -1 : 1;
+    }
+else
+    {
+    result = ( a->idx > b->idx ) - ( a->idx < b->idx );
+    }
+
+return result;
+}
+
+
+/**
+* Model bind row binder.
+*
+* Adapts a cqlite_model_bind_func_t to cqlite_row_bind_func_t.
+*/
+static int model_bind_row_bind
+    (
+    sqlite3_stmt *  query,
+    void const *    model,
+    void *          context
+    )
+{
+return ( (bind_context_t*)context )->model_bind_func( query, model );
+}
+
+
+/**
+* Grow model list.
+*
+* Doubles the capacity of the provided model list, zeroing all of the
+* newly allocated models so that the list is always safe to free. On
+* error, the model list and its capacity are left unmodified.
+*/
+static int model_list_grow
+    (
+    void ** model_list,
+    int *   model_list_capacity,
+    size_t  model_size
+    )
+{
+int     success;
+int     new_capacity;
+void *  new_model_list = NULL;
+
+new_capacity = MODEL_LIST_INITIAL_CAPACITY;
+
+if( *model_list_capacity > 0 )
+    {
+    new_capacity = ( *model_list_capacity <= ( INT_MAX / 2 ) ) ? ( *model_list_capacity * 2 ) : INT_MAX;
+    }
+
+success = ( new_capacity > *model_list_capacity ) &&
+          ( (size_t)new_capacity <= ( SIZE_MAX / model_size ) );
+
+if( success )
+    {
+    new_model_list = realloc( *model_list, new_capacity * model_size );
+    success = ( NULL != new_model_list );
+    }
+
+if( success )
+    {
+    memset( (char*)new_model_list + ( *model_list_capacity * model_size ), 0, ( new_capacity - *model_list_capacity ) * model_size );
+    cqlite_stats_bytes_add( ( new_capacity - *model_list_capacity ) * model_size );
+
+    *model_list = new_model_list;
+    *model_list_capacity = new_capacity;
+    }
+
+return success;
+}
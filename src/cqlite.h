@@ -7,12 +7,46 @@
 
 #define CQLITE_INVALID_ROW_ID ( -1 )
 
+#define CQLITE_FIND_MANY_CHUNK_SIZE ( 500 )    //!< Maximum number of ids bound to each IN-list of cqlite_find_many_by_ids()
+
+/** Size in bytes of the found bits of cqlite_find_many_by_ids() for id_cnt ids. */
+#define CQLITE_FOUND_BITS_SIZE( id_cnt ) ( ( (size_t)( id_cnt ) + 7 ) / 8 )
+
+/** Was the id at index idx found by cqlite_find_many_by_ids()? */
+#define CQLITE_FOUND_BIT_IS_SET( found_bits, idx ) ( 0 != ( ( found_bits )[( idx ) / 8] & ( 1 << ( ( idx ) % 8 ) ) ) )
+
 typedef enum
     {
     CQLITE_SUCCESS,
     CQLITE_ERROR,
     } cqlite_rcode_t;
 
+/**
+* String view.
+*
+* Text borrowed from a query row result without copying it. The text
+* is owned by SQLite and is only valid until the query is stepped,
+* reset, or finalized, or until another conversion of the same column
+* is requested.
+*/
+typedef struct
+    {
+    char const *    text;   //!< UTF-8 text, NUL-terminated by SQLite, NULL for a NULL result
+    size_t          len;    //!< Length of the text in bytes, not counting the NUL terminator
+    } cqlite_string_view_t;
+
+/**
+* Blob view.
+*
+* Blob borrowed from a query row result without copying it. Has the
+* same lifetime as a cqlite_string_view_t.
+*/
+typedef struct
+    {
+    void const *    data;   //!< Blob contents, NULL for a NULL or empty result
+    size_t          len;    //!< Size of the blob in bytes
+    } cqlite_blob_view_t;
+
 /**
 * Add model to result list function type.
 *
@@ -68,6 +102,50 @@ typedef int (*cqlite_model_from_row_result_func_t)
     void *          model_out   //!< (out) Model populated from row result
     );
 
+/**
+* Model free function type.
+*
+* Prototype of functions to free all memory owned by a model, such as
+* dynamically-allocated strings read with cqlite_dynamic_string_read(),
+* without freeing the model itself. These functions must accept a model
+* that is all zeros.
+*/
+typedef void (*cqlite_model_free_func_t)
+    (
+    void *  model   //!< Model whose owned memory is to be freed
+    );
+
+/**
+* Model bind function type.
+*
+* Prototype of functions to bind the fields of the provided model to the
+* parameters of the provided prepared query, typically an INSERT query.
+* The query will already have been reset and had its bindings cleared.
+* These functions should NEVER step the provided query.
+*
+* These types of function should return 1 on success, 0 on error.
+*/
+typedef int (*cqlite_model_bind_func_t)
+    (
+    sqlite3_stmt *  query,  //!< Prepared query to bind the model to
+    void const *    model   //!< Model whose fields are bound
+    );
+
+/**
+* Read blob view from query.
+*
+* Points blob_out at the specified column of the provided query row
+* result without copying it. Returns an error if the column result is
+* neither a blob nor NULL. If the column result is NULL, blob_out is
+* set to a NULL blob of length 0.
+*/
+cqlite_rcode_t cqlite_blob_view_read
+    (
+    sqlite3_stmt *          query,      //!< Query result
+    int                     column,     //!< Column of blob to read from query result
+    cqlite_blob_view_t *    blob_out    //!< (out) Blob borrowed from query result
+    );
+
 /**
 * Execute count query.
 * 
@@ -92,6 +170,31 @@ cqlite_rcode_t cqlite_count_query_execute_prepared
     int *           count_out       //!< (out) Returned count
     );
 
+/**
+* Execute 64-bit count query.
+*
+* Same as cqlite_count_query_execute() for counts that may not fit in
+* an int. The int variant fails on such counts instead of truncating
+* them.
+*/
+cqlite_rcode_t cqlite_count_query_execute_int64
+    (
+    sqlite3 *           db,                 //!< Database on which to execute the query
+    char const * const  count_query_str,    //!< Parameter-less COUNT query string
+    sqlite_int64 *      count_out           //!< (out) Returned count
+    );
+
+/**
+* Execute prepared 64-bit count query.
+*
+* @see cqlite_count_query_execute_int64()
+*/
+cqlite_rcode_t cqlite_count_query_execute_prepared_int64
+    (
+    sqlite3_stmt *  count_query,    //!< Prepared COUNT query
+    sqlite_int64 *  count_out       //!< (out) Returned count
+    );
+
 /**
 * Read dynamically-allocated string from query.
 *
@@ -144,6 +247,36 @@ cqlite_rcode_t cqlite_find_by_id
     void *                              model_out               //!< (out) Found model
     );
 
+/**
+* Find many models by id.
+*
+* Finds the models with each of the id_cnt ids in a single pass rather
+* than executing a query per id. The ids are sorted and bound in chunks
+* of up to CQLITE_FIND_MANY_CHUNK_SIZE to a single prepared query made
+* of find_many_query_prefix followed by an IN-list of parameters, such
+* as "SELECT * FROM my_model WHERE id IN ". The id of each result is
+* read from its id_column result column.
+*
+* The model with ids[i] is read into entry i of model_list, which the
+* caller must allocate to hold id_cnt models, and bit i of found_bits,
+* which the caller must allocate to CQLITE_FOUND_BITS_SIZE( id_cnt )
+* bytes, is set. Entries of ids that were not found are unmodified.
+* Duplicate ids are read into each of their entries. On error, the bits
+* are only set for the entries that were read successfully.
+*/
+cqlite_rcode_t cqlite_find_many_by_ids
+    (
+    sqlite3 *                           db,                     //!< Database on which to execute the query
+    char const * const                  find_many_query_prefix, //!< SELECT query string ending in "IN "
+    int                                 id_column,              //!< Result column holding the id
+    sqlite_int64 const *                ids,                    //!< Ids to search for
+    int                                 id_cnt,                 //!< Number of ids
+    cqlite_model_from_row_result_func_t model_from_result_func, //!< Function to read a result into a model
+    size_t                              model_size,             //!< Size of the model type
+    void *                              model_list,             //!< (out) Found models in the order of ids
+    unsigned char *                     found_bits              //!< (out) Bit of each id that was found
+    );
+
 /**
 * Read fixed-length string from query.
 *
@@ -161,6 +294,56 @@ cqlite_rcode_t cqlite_fixed_length_string_read
     size_t          string_size     //!< Size of the string buffer
     );
 
+/**
+* Insert many models.
+*
+* Prepares the provided INSERT query once and executes it for each of
+* the model_list_cnt models in model_list, using model_bind_func to bind
+* each model to the query. The models are inserted inside transactions
+* that are committed every batch_size models, or once for all models
+* if batch_size is not positive. If the caller already has a transaction
+* open on the database, each batch is a savepoint released into that
+* transaction instead. If an error occurs, the batch holding the failed
+* model is rolled back, but earlier batches remain committed or, inside
+* the caller's transaction, remain part of it.
+*
+* If row_ids_out is not NULL, it is set to a list of the generated row
+* id of each model allocated using malloc(), which the caller must
+* free() regardless of whether the function executes successfully. The
+* row ids of models that were not inserted are CQLITE_INVALID_ROW_ID.
+*/
+cqlite_rcode_t cqlite_insert_many
+    (
+    sqlite3 *                   db,                 //!< Database on which to execute the query
+    char const * const          insert_query_str,   //!< INSERT query string taking the model's parameters
+    cqlite_model_bind_func_t    model_bind_func,    //!< Function to bind a model to the query
+    void const *                model_list,         //!< List of models to insert
+    size_t                      model_size,         //!< Size of the model type
+    int                         model_list_cnt,     //!< Number of models to insert
+    int                         batch_size,         //!< Number of models inserted per transaction
+    sqlite_int64 **             row_ids_out         //!< (out) Generated row id of each model, caller must free, may be NULL
+    );
+
+/**
+* Insert many models using prepared query.
+*
+* The insert query is reset and has its bindings cleared before each
+* model is bound to it.
+*
+* @see cqlite_insert_many()
+*/
+cqlite_rcode_t cqlite_insert_many_prepared
+    (
+    sqlite3 *                   db,                 //!< Database on which to execute the query
+    sqlite3_stmt *              insert_query,       //!< Prepared INSERT query
+    cqlite_model_bind_func_t    model_bind_func,    //!< Function to bind a model to the query
+    void const *                model_list,         //!< List of models to insert
+    size_t                      model_size,         //!< Size of the model type
+    int                         model_list_cnt,     //!< Number of models to insert
+    int                         batch_size,         //!< Number of models inserted per transaction
+    sqlite_int64 **             row_ids_out         //!< (out) Generated row id of each model, caller must free, may be NULL
+    );
+
 /**
 * Execute insert query.
 * 
@@ -198,12 +381,18 @@ cqlite_rcode_t cqlite_insert_query_execute
 * Then the COUNT query string should be:
 * 
 *         "SELECT COUNT(*) FROM my_table WHERE my_column = 7;"
+*
+* The COUNT query string may also be NULL, in which case the SELECT
+* query is executed in a single pass and model_list_out is grown as
+* results are read. This avoids scanning the same data twice and
+* allows rows to be inserted concurrently between the two queries,
+* at the cost of a few reallocations of the model list.
 */
 cqlite_rcode_t cqlite_select_query_execute
     (
     sqlite3 *                       db,                 //!< Database on which to execute the query                
     char const * const              select_query_str,   //!< Parameter-less SELECT query string                    
-    char const * const              count_query_str,    //!< Parameter-less COUNT query string                     
+    char const * const              count_query_str,    //!< Parameter-less COUNT query string, NULL to read in a single pass that grows the list
     cqlite_model_add_to_list_func_t add_to_list_func,   //!< Add model to list function pointer                    
     size_t                          model_size,         //!< Size of the model type                                
     void **                         model_list_out,     //!< (out) List of models read from query, caller must free
@@ -212,17 +401,37 @@ cqlite_rcode_t cqlite_select_query_execute
 
 /**
 * Execute prepared SELECT query.
-
+*
+* The count_query may be NULL to execute the SELECT query in a single pass.
+*
 * @see cqlite_select_query_execute()
 */
 cqlite_rcode_t cqlite_select_query_execute_prepared
     (
     sqlite3_stmt *                  select_query,       //!< Prepared SELECT query                                 
-    sqlite3_stmt *                  count_query,        //!< Prepared COUNT query                                  
+    sqlite3_stmt *                  count_query,        //!< Prepared COUNT query, NULL for single pass            
     cqlite_model_add_to_list_func_t add_to_list_func,   //!< Add model to list function pointer                    
     size_t                          model_size,         //!< Size of the model type                                
     void **                         model_list_out,     //!< (out) List of models read from query, caller must free
     int *                           model_list_cnt_out  //!< (out) Number of models read from query                
     );
 
+/**
+* Read string view from query.
+*
+* Points string_out at the specified column of the provided query row
+* result without copying it or scanning it for its length, unlike
+* cqlite_dynamic_string_read() and cqlite_fixed_length_string_read().
+* Row read functions that only hash or compare strings can use it to
+* avoid allocating anything per row. Returns an error if the column
+* result is neither a string nor NULL. If the column result is NULL,
+* string_out is set to a NULL string of length 0.
+*/
+cqlite_rcode_t cqlite_string_view_read
+    (
+    sqlite3_stmt *          query,      //!< Query result
+    int                     column,     //!< Column of string to read from query result
+    cqlite_string_view_t *  string_out  //!< (out) String borrowed from query result
+    );
+
 #endif
\ No newline at end of file
@@ -0,0 +1,320 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cqlite_arena.h"
+#include "cqlite_private.h"
+
+#define READ_TO_END     ( -1 )
+#define NO_TAIL         ( NULL )
+#define NO_ALIGNMENT    ( 1 )
+#define MAX_ALIGNMENT   ( _Alignof( max_align_t ) )
+
+
+/**********************************************
+Types
+**********************************************/
+typedef struct arena_block_s
+    {
+    struct arena_block_s *  next;   //!< Next block, older blocks last
+    size_t                  size;   //!< Number of usable bytes in the block
+    size_t                  used;   //!< Number of bytes allocated from the block
+    max_align_t             data[]; //!< Block memory
+    } arena_block_t;
+
+struct cqlite_arena_s
+    {
+    size_t          block_size; //!< Size of regular blocks
+    arena_block_t * blocks;     //!< All blocks, allocations are made from the first
+    };
+
+typedef struct
+    {
+    cqlite_model_add_to_list_arena_func_t   add_to_list_func;
+    cqlite_arena_t *                        arena;
+    } arena_add_to_list_context_t;
+
+
+/**********************************************
+Functions
+**********************************************/
+static void * arena_alloc_aligned
+    (
+    cqlite_arena_t *    arena,
+    size_t              size,
+    size_t              alignment
+    );
+
+static int arena_add_to_list_row_read
+    (
+    sqlite3_stmt *  query,
+    void *          model_list,
+    int             next_model_list_idx,
+    void *          context
+    );
+
+
+// Allocate memory from arena.
+void * cqlite_arena_alloc
+    (
+    cqlite_arena_t *    arena,  //!< Arena to allocate from
+    size_t              size    //!< Number of bytes to allocate
+    )
+{
+return arena_alloc_aligned( arena, size, MAX_ALIGNMENT );
+}
+
+
+// Create arena.
+cqlite_rcode_t cqlite_arena_create
+    (
+    size_t              block_size, //!< Size of each block, e.g. CQLITE_ARENA_DEFAULT_BLOCK_SIZE
+    cqlite_arena_t **   arena_out   //!< (out) Arena, caller must free
+    )
+{
+cqlite_rcode_t      rcode = CQLITE_ERROR;
+cqlite_arena_t *    arena;
+
+*arena_out = NULL;
+
+arena = calloc( 1, sizeof( *arena ) );
+
+if( ( NULL != arena ) && ( block_size > 0 ) )
+    {
+    rcode = CQLITE_SUCCESS;
+
+    // Blocks are allocated lazily so that empty results cost nothing.
+    arena->block_size = block_size;
+    *arena_out = arena;
+    }
+else
+    {
+    free( arena );
+    }
+
+return rcode;
+}
+
+
+// Free arena.
+void cqlite_arena_free
+    (
+    cqlite_arena_t * arena  //!< Arena to free
+    )
+{
+arena_block_t * block;
+
+if( NULL != arena )
+    {
+    while( NULL != arena->blocks )
+        {
+        block = arena->blocks;
+        arena->blocks = block->next;
+        free( block );
+        }
+
+    free( arena );
+    }
+}
+
+
+// Execute SELECT query using arena.
+cqlite_rcode_t cqlite_arena_select_query_execute
+    (
+    sqlite3 *                               db,                 //!< Database on which to execute the query
+    char const * const                      select_query_str,   //!< Parameter-less SELECT query string
+    char const * const                      count_query_str,    //!< Parameter-less COUNT query string, NULL for single pass
+    cqlite_model_add_to_list_arena_func_t   add_to_list_func,   //!< Add model to list function pointer
+    size_t                                  model_size,         //!< Size of the model type
+    void **                                 model_list_out,     //!< (out) List of models read from query, caller must free
+    int *                                   model_list_cnt_out, //!< (out) Number of models read from query
+    cqlite_arena_t **                       arena_out           //!< (out) Arena owning the models' memory, caller must free
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+sqlite3_stmt *  select_query = NULL;
+sqlite3_stmt *  count_query = NULL;
+sqlite_int64    prepare_start_ns;
+
+*model_list_out = NULL;
+*model_list_cnt_out = 0;
+*arena_out = NULL;
+
+prepare_start_ns = cqlite_stats_prepare_begin();
+success = ( SQLITE_OK == sqlite3_prepare_v2( db, select_query_str, READ_TO_END, &select_query, NO_TAIL ) );
+
+if( success && ( NULL != count_query_str ) )
+    {
+    success = ( SQLITE_OK == sqlite3_prepare_v2( db, count_query_str, READ_TO_END, &count_query, NO_TAIL ) );
+    }
+
+cqlite_stats_prepare_end( CQLITE_STATS_API_SELECT, prepare_start_ns );
+
+if( success )
+    {
+    rcode = cqlite_arena_select_query_execute_prepared( select_query, count_query, add_to_list_func, model_size, model_list_out, model_list_cnt_out, arena_out );
+    }
+
+// Clean up
+sqlite3_finalize( select_query );
+sqlite3_finalize( count_query );
+
+return rcode;
+}
+
+
+// Execute prepared SELECT query using arena.
+cqlite_rcode_t cqlite_arena_select_query_execute_prepared
+    (
+    sqlite3_stmt *                          select_query,       //!< Prepared SELECT query
+    sqlite3_stmt *                          count_query,        //!< Prepared COUNT query, NULL for single pass
+    cqlite_model_add_to_list_arena_func_t   add_to_list_func,   //!< Add model to list function pointer
+    size_t                                  model_size,         //!< Size of the model type
+    void **                                 model_list_out,     //!< (out) List of models read from query, caller must free
+    int *                                   model_list_cnt_out, //!< (out) Number of models read from query
+    cqlite_arena_t **                       arena_out           //!< (out) Arena owning the models' memory, caller must free
+    )
+{
+cqlite_rcode_t              rcode = CQLITE_ERROR;
+arena_add_to_list_context_t context;
+
+*model_list_out = NULL;
+*model_list_cnt_out = 0;
+
+if( CQLITE_SUCCESS == cqlite_arena_create( CQLITE_ARENA_DEFAULT_BLOCK_SIZE, arena_out ) )
+    {
+    context.add_to_list_func = add_to_list_func;
+    context.arena = *arena_out;
+
+    rcode = cqlite_select_rows_read( select_query, count_query, arena_add_to_list_row_read, &context, model_size, model_list_out, model_list_cnt_out );
+    }
+
+return rcode;
+}
+
+
+// Read arena-allocated string from query.
+cqlite_rcode_t cqlite_arena_string_read
+    (
+    sqlite3_stmt *      query,      //!< Query result
+    int                 column,     //!< Column of string to read from query result
+    cqlite_arena_t *    arena,      //!< Arena from which the string is allocated
+    char **             string_out  //!< (out) String read from query, owned by the arena
+    )
+{
+cqlite_rcode_t          rcode = CQLITE_ERROR;
+int                     success;
+int                     column_type;
+unsigned char const *   text;
+int                     text_size;
+
+*string_out = NULL;
+
+column_type = sqlite3_column_type( query, column );
+success = ( SQLITE_TEXT == column_type ) || ( SQLITE_NULL == column_type );
+
+if( SQLITE_TEXT == column_type )
+    {
+    // The size must be read after the text to get the size of the UTF-8 text.
+    text = sqlite3_column_text( query, column );
+    text_size = sqlite3_column_bytes( query, column );
+
+    *string_out = arena_alloc_aligned( arena, text_size + 1, NO_ALIGNMENT );
+    success = ( NULL != text ) && ( NULL != *string_out );
+
+    if( success )
+        {
+        memcpy( *string_out, text, text_size + 1 );
+        }
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+return rcode;
+}
+
+
+/**
+* Allocate aligned memory from arena.
+*
+* Bump-allocates from the current block, starting a new block once it is
+* exhausted. Allocations that would waste a large part of a block get a
+* dedicated block behind the current one so it can still be filled.
+*/
+static void * arena_alloc_aligned
+    (
+    cqlite_arena_t *    arena,
+    size_t              size,
+    size_t              alignment
+    )
+{
+void *          memory = NULL;
+arena_block_t * block;
+size_t          offset = 0;
+size_t          block_size;
+
+block = arena->blocks;
+
+if( NULL != block )
+    {
+    offset = ( block->used + alignment - 1 ) & ~( alignment - 1 );
+    }
+
+if( ( NULL == block ) || ( offset > block->size ) || ( size > ( block->size - offset ) ) )
+    {
+    block_size = ( size > ( arena->block_size / 4 ) ) ? size : arena->block_size;
+    block = malloc( sizeof( *block ) + block_size );
+    offset = 0;
+
+    if( NULL != block )
+        {
+        cqlite_stats_bytes_add( sizeof( *block ) + block_size );
+        block->size = block_size;
+        block->used = 0;
+
+        if( ( block_size == size ) && ( NULL != arena->blocks ) )
+            {
+            block->next = arena->blocks->next;
+            arena->blocks->next = block;
+            }
+        else
+            {
+            block->next = arena->blocks;
+            arena->blocks = block;
+            }
+        }
+    }
+
+if( NULL != block )
+    {
+    memory = (char*)block->data + offset;
+    block->used = offset + size;
+    }
+
+return memory;
+}
+
+
+/**
+* Add model to list using arena row reader.
+*
+* Adapts a cqlite_model_add_to_list_arena_func_t to cqlite_row_read_func_t.
+*/
+static int arena_add_to_list_row_read
+    (
+    sqlite3_stmt *  query,
+    void *          model_list,
+    int             next_model_list_idx,
+    void *          context
+    )
+{
+arena_add_to_list_context_t * arena_context;
+
+arena_context = (arena_add_to_list_context_t*)context;
+
+return arena_context->add_to_list_func( query, model_list, next_model_list_idx, arena_context->arena );
+}
@@ -0,0 +1,123 @@
+/** @file */
+
+#ifndef _CQLITE_ARENA_H
+#define _CQLITE_ARENA_H
+
+#include <stddef.h>
+#include <sqlite3.h>
+
+#include "cqlite.h"
+
+#define CQLITE_ARENA_DEFAULT_BLOCK_SIZE ( 64 * 1024 )
+
+/**
+* Arena allocator.
+*
+* Bump-allocates memory out of large blocks so that all of the memory
+* owned by the results of a query can be released with a single call to
+* cqlite_arena_free() instead of one call to free() per string.
+*/
+typedef struct cqlite_arena_s cqlite_arena_t;
+
+/**
+* Add model to result list using arena function type.
+*
+* Same as cqlite_model_add_to_list_func_t, except that any memory owned
+* by the model, such as strings read with cqlite_arena_string_read(),
+* must be allocated from the provided arena.
+*/
+typedef int (*cqlite_model_add_to_list_arena_func_t)
+    (
+    sqlite3_stmt *      query,                  //!< Query pointing at row result
+    void *              model_list,             //!< List of all models returned so far
+    int                 next_model_list_idx,    //!< Index into the model list into which the query row result should be read
+    cqlite_arena_t *    arena                   //!< Arena from which the model's memory is to be allocated
+    );
+
+/**
+* Allocate memory from arena.
+*
+* Returns a pointer to size bytes suitably aligned for any type, or NULL
+* on error. The memory is released by cqlite_arena_free().
+*/
+void * cqlite_arena_alloc
+    (
+    cqlite_arena_t *    arena,  //!< Arena to allocate from
+    size_t              size    //!< Number of bytes to allocate
+    );
+
+/**
+* Create arena.
+*
+* Creates an arena that allocates memory in blocks of block_size bytes.
+* Allocations larger than the block size are given their own block. The
+* caller must call cqlite_arena_free() on arena_out.
+*/
+cqlite_rcode_t cqlite_arena_create
+    (
+    size_t              block_size, //!< Size of each block, e.g. CQLITE_ARENA_DEFAULT_BLOCK_SIZE
+    cqlite_arena_t **   arena_out   //!< (out) Arena, caller must free
+    );
+
+/**
+* Free arena.
+*
+* Releases the arena along with all memory allocated from it.
+*/
+void cqlite_arena_free
+    (
+    cqlite_arena_t * arena  //!< Arena to free
+    );
+
+/**
+* Execute SELECT query using arena.
+*
+* Same as cqlite_select_query_execute(), except that all memory owned by
+* the models is allocated from a new arena returned in arena_out. The
+* caller must call free() on model_list_out and cqlite_arena_free() on
+* arena_out regardless of whether the function executes successfully,
+* and must not free the memory owned by individual models.
+*/
+cqlite_rcode_t cqlite_arena_select_query_execute
+    (
+    sqlite3 *                               db,                 //!< Database on which to execute the query
+    char const * const                      select_query_str,   //!< Parameter-less SELECT query string
+    char const * const                      count_query_str,    //!< Parameter-less COUNT query string, NULL for single pass
+    cqlite_model_add_to_list_arena_func_t   add_to_list_func,   //!< Add model to list function pointer
+    size_t                                  model_size,         //!< Size of the model type
+    void **                                 model_list_out,     //!< (out) List of models read from query, caller must free
+    int *                                   model_list_cnt_out, //!< (out) Number of models read from query
+    cqlite_arena_t **                       arena_out           //!< (out) Arena owning the models' memory, caller must free
+    );
+
+/**
+* Execute prepared SELECT query using arena.
+*
+* @see cqlite_arena_select_query_execute()
+*/
+cqlite_rcode_t cqlite_arena_select_query_execute_prepared
+    (
+    sqlite3_stmt *                          select_query,       //!< Prepared SELECT query
+    sqlite3_stmt *                          count_query,        //!< Prepared COUNT query, NULL for single pass
+    cqlite_model_add_to_list_arena_func_t   add_to_list_func,   //!< Add model to list function pointer
+    size_t                                  model_size,         //!< Size of the model type
+    void **                                 model_list_out,     //!< (out) List of models read from query, caller must free
+    int *                                   model_list_cnt_out, //!< (out) Number of models read from query
+    cqlite_arena_t **                       arena_out           //!< (out) Arena owning the models' memory, caller must free
+    );
+
+/**
+* Read arena-allocated string from query.
+*
+* Same as cqlite_dynamic_string_read(), except that the string is
+* allocated from the provided arena rather than with malloc().
+*/
+cqlite_rcode_t cqlite_arena_string_read
+    (
+    sqlite3_stmt *      query,      //!< Query result
+    int                 column,     //!< Column of string to read from query result
+    cqlite_arena_t *    arena,      //!< Arena from which the string is allocated
+    char **             string_out  //!< (out) String read from query, owned by the arena
+    );
+
+#endif
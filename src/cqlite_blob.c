@@ -0,0 +1,481 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "cqlite_blob.h"
+
+#define MAIN_DB         ( "main" )
+#define READ_ONLY       ( 0 )
+#define READ_WRITE      ( 1 )
+
+
+/**********************************************
+Types
+**********************************************/
+struct cqlite_blob_reader_s
+    {
+    sqlite3_blob *  blob;   //!< Open blob handle
+    int             size;   //!< Size of the blob in bytes
+    int             offset; //!< Offset of the next chunk
+    };
+
+struct cqlite_blob_writer_s
+    {
+    sqlite3_blob *  blob;   //!< Open blob handle
+    int             size;   //!< Size of the blob in bytes
+    int             offset; //!< Offset of the next chunk
+    };
+
+
+/**********************************************
+Functions
+**********************************************/
+static int fd_read
+    (
+    int     fd,
+    void *  buffer,
+    int     size,
+    int *   read_cnt_out
+    );
+
+static int fd_write
+    (
+    int             fd,
+    void const *    data,
+    int             size
+    );
+
+
+// Insert row with zeroblob.
+cqlite_rcode_t cqlite_blob_insert
+    (
+    sqlite3 *                   db,             //!< Database on which to execute the query
+    sqlite3_stmt *              insert_query,   //!< Prepared INSERT query
+    int                         blob_param,     //!< Index of the blob parameter of the query
+    int                         blob_size,      //!< Size of the blob in bytes
+    char const *                table,          //!< Table the query inserts into
+    char const *                column,         //!< Column the blob parameter is stored in
+    cqlite_blob_writer_t **     writer_out,     //!< (out) Writer of the new blob, caller must close
+    sqlite_int64 *              new_row_id_out  //!< (out) Generated row id of new record, may be NULL
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+sqlite_int64    row_id = CQLITE_INVALID_ROW_ID;
+
+*writer_out = NULL;
+
+if( NULL != new_row_id_out )
+    {
+    *new_row_id_out = CQLITE_INVALID_ROW_ID;
+    }
+
+// The zeroblob only reserves the space, none of it is allocated here
+success = ( blob_size >= 0 ) &&
+          ( SQLITE_OK == sqlite3_bind_zeroblob( insert_query, blob_param, blob_size ) ) &&
+          ( CQLITE_SUCCESS == cqlite_insert_query_execute( db, insert_query, &row_id ) );
+
+// The row id is returned even if the writer cannot be opened, so that
+// the caller can find the row it inserted.
+if( success && ( NULL != new_row_id_out ) )
+    {
+    *new_row_id_out = row_id;
+    }
+
+if( success )
+    {
+    success = ( CQLITE_SUCCESS == cqlite_blob_writer_open( db, table, column, row_id, writer_out ) );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+return rcode;
+}
+
+
+// Close blob reader.
+void cqlite_blob_reader_close
+    (
+    cqlite_blob_reader_t *  reader  //!< Blob reader to close, may be NULL
+    )
+{
+if( NULL != reader )
+    {
+    sqlite3_blob_close( reader->blob );
+    free( reader );
+    }
+}
+
+
+// Open blob reader.
+cqlite_rcode_t cqlite_blob_reader_open
+    (
+    sqlite3 *                   db,         //!< Database containing the blob
+    char const *                table,      //!< Table containing the blob
+    char const *                column,     //!< Column containing the blob
+    sqlite_int64                row_id,     //!< Row id of the row containing the blob
+    cqlite_blob_reader_t **     reader_out  //!< (out) Blob reader, caller must close
+    )
+{
+cqlite_rcode_t          rcode = CQLITE_ERROR;
+int                     success;
+cqlite_blob_reader_t *  reader;
+
+*reader_out = NULL;
+
+reader = calloc( 1, sizeof( *reader ) );
+success = ( NULL != reader );
+
+if( success )
+    {
+    success = ( SQLITE_OK == sqlite3_blob_open( db, MAIN_DB, table, column, row_id, READ_ONLY, &reader->blob ) );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+
+    reader->size = sqlite3_blob_bytes( reader->blob );
+    *reader_out = reader;
+    }
+else
+    {
+    cqlite_blob_reader_close( reader );
+    }
+
+return rcode;
+}
+
+
+// Read chunk from blob reader.
+cqlite_rcode_t cqlite_blob_reader_read
+    (
+    cqlite_blob_reader_t *  reader,         //!< Blob reader
+    void *                  buffer,         //!< (out) Buffer to read the chunk into
+    int                     buffer_size,    //!< Size of the buffer in bytes
+    int *                   read_cnt_out    //!< (out) Number of bytes read
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+int             read_cnt;
+
+*read_cnt_out = 0;
+
+read_cnt = reader->size - reader->offset;
+read_cnt = ( read_cnt < buffer_size ) ? read_cnt : buffer_size;
+
+success = ( buffer_size >= 0 );
+
+if( success && ( read_cnt > 0 ) )
+    {
+    success = ( SQLITE_OK == sqlite3_blob_read( reader->blob, buffer, read_cnt, reader->offset ) );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+
+    reader->offset += read_cnt;
+    *read_cnt_out = read_cnt;
+    }
+
+return rcode;
+}
+
+
+// Read blob into file descriptor.
+cqlite_rcode_t cqlite_blob_reader_read_to_fd
+    (
+    cqlite_blob_reader_t *  reader,     //!< Blob reader
+    int                     fd,         //!< File descriptor to write the blob to
+    int                     chunk_size  //!< Size of the chunks in bytes
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+int             read_cnt = 0;
+void *          chunk = NULL;
+
+success = ( chunk_size > 0 );
+
+if( success )
+    {
+    chunk = malloc( chunk_size );
+    success = ( NULL != chunk );
+    }
+
+do
+    {
+    if( success )
+        {
+        success = ( CQLITE_SUCCESS == cqlite_blob_reader_read( reader, chunk, chunk_size, &read_cnt ) ) &&
+                  fd_write( fd, chunk, read_cnt );
+        }
+    } while( success && ( read_cnt > 0 ) );
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+// Clean up
+free( chunk );
+
+return rcode;
+}
+
+
+// Move blob reader to another row.
+cqlite_rcode_t cqlite_blob_reader_reopen
+    (
+    cqlite_blob_reader_t *  reader, //!< Blob reader
+    sqlite_int64            row_id  //!< Row id of the row containing the blob
+    )
+{
+cqlite_rcode_t rcode = CQLITE_ERROR;
+
+reader->size = 0;
+reader->offset = 0;
+
+if( SQLITE_OK == sqlite3_blob_reopen( reader->blob, row_id ) )
+    {
+    rcode = CQLITE_SUCCESS;
+    reader->size = sqlite3_blob_bytes( reader->blob );
+    }
+
+return rcode;
+}
+
+
+// Get size of blob being read.
+int cqlite_blob_reader_size
+    (
+    cqlite_blob_reader_t const *    reader  //!< Blob reader
+    )
+{
+return reader->size;
+}
+
+
+// Close blob writer.
+cqlite_rcode_t cqlite_blob_writer_close
+    (
+    cqlite_blob_writer_t *  writer  //!< Blob writer to close, may be NULL
+    )
+{
+cqlite_rcode_t rcode = CQLITE_SUCCESS;
+
+if( NULL != writer )
+    {
+    if( SQLITE_OK != sqlite3_blob_close( writer->blob ) )
+        {
+        rcode = CQLITE_ERROR;
+        }
+
+    free( writer );
+    }
+
+return rcode;
+}
+
+
+// Open blob writer.
+cqlite_rcode_t cqlite_blob_writer_open
+    (
+    sqlite3 *                   db,         //!< Database containing the blob
+    char const *                table,      //!< Table containing the blob
+    char const *                column,     //!< Column containing the blob
+    sqlite_int64                row_id,     //!< Row id of the row containing the blob
+    cqlite_blob_writer_t **     writer_out  //!< (out) Blob writer, caller must close
+    )
+{
+cqlite_rcode_t          rcode = CQLITE_ERROR;
+int                     success;
+cqlite_blob_writer_t *  writer;
+
+*writer_out = NULL;
+
+writer = calloc( 1, sizeof( *writer ) );
+success = ( NULL != writer );
+
+if( success )
+    {
+    success = ( SQLITE_OK == sqlite3_blob_open( db, MAIN_DB, table, column, row_id, READ_WRITE, &writer->blob ) );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+
+    writer->size = sqlite3_blob_bytes( writer->blob );
+    *writer_out = writer;
+    }
+else
+    {
+    cqlite_blob_writer_close( writer );
+    }
+
+return rcode;
+}
+
+
+// Get size of blob being written.
+int cqlite_blob_writer_size
+    (
+    cqlite_blob_writer_t const *    writer  //!< Blob writer
+    )
+{
+return writer->size;
+}
+
+
+// Write chunk to blob writer.
+cqlite_rcode_t cqlite_blob_writer_write
+    (
+    cqlite_blob_writer_t *  writer, //!< Blob writer
+    void const *            data,   //!< Data to write
+    int                     size    //!< Size of the data in bytes
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+
+success = ( size >= 0 ) && ( size <= ( writer->size - writer->offset ) );
+
+if( success && ( size > 0 ) )
+    {
+    success = ( SQLITE_OK == sqlite3_blob_write( writer->blob, data, size, writer->offset ) );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    writer->offset += size;
+    }
+
+return rcode;
+}
+
+
+// Write blob from file descriptor.
+cqlite_rcode_t cqlite_blob_writer_write_from_fd
+    (
+    cqlite_blob_writer_t *  writer,     //!< Blob writer
+    int                     fd,         //!< File descriptor to read the blob from
+    int                     chunk_size  //!< Size of the chunks in bytes
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+int             want_cnt;
+int             read_cnt;
+void *          chunk = NULL;
+
+success = ( chunk_size > 0 );
+
+if( success )
+    {
+    chunk = malloc( chunk_size );
+    success = ( NULL != chunk );
+    }
+
+// Never read past the end of the blob, so that the rest of the file
+// is left for the caller.
+while( success && ( writer->offset < writer->size ) )
+    {
+    want_cnt = writer->size - writer->offset;
+    want_cnt = ( want_cnt < chunk_size ) ? want_cnt : chunk_size;
+
+    success = fd_read( fd, chunk, want_cnt, &read_cnt ) &&
+              ( read_cnt == want_cnt ) &&
+              ( CQLITE_SUCCESS == cqlite_blob_writer_write( writer, chunk, read_cnt ) );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+// Clean up
+free( chunk );
+
+return rcode;
+}
+
+
+/**
+* Read from file descriptor.
+*
+* Reads until size bytes were read or the file ends, retrying reads
+* that are interrupted or cut short. Returns 1 on success, 0 on error.
+*/
+static int fd_read
+    (
+    int     fd,
+    void *  buffer,
+    int     size,
+    int *   read_cnt_out
+    )
+{
+int     success = 1;
+int     is_end = 0;
+ssize_t read_cnt;
+
+*read_cnt_out = 0;
+
+while( success && !is_end && ( *read_cnt_out < size ) )
+    {
+    read_cnt = read( fd, (char*)buffer + *read_cnt_out, size - *read_cnt_out );
+
+    if( read_cnt > 0 )
+        {
+        *read_cnt_out += (int)read_cnt;
+        }
+    else
+        {
+        is_end = ( 0 == read_cnt );
+        success = is_end || ( EINTR == errno );
+        }
+    }
+
+return success;
+}
+
+
+/**
+* Write to file descriptor.
+*
+* Writes all size bytes, retrying writes that are interrupted or cut
+* short. Returns 1 on success, 0 on error.
+*/
+static int fd_write
+    (
+    int             fd,
+    void const *    data,
+    int             size
+    )
+{
+int     success = 1;
+int     written_cnt = 0;
+ssize_t write_cnt;
+
+while( success && ( written_cnt < size ) )
+    {
+    write_cnt = write( fd, (char const*)data + written_cnt, size - written_cnt );
+
+    if( write_cnt > 0 )
+        {
+        written_cnt += (int)write_cnt;
+        }
+    else
+        {
+        success = ( write_cnt < 0 ) && ( EINTR == errno );
+        }
+    }
+
+return success;
+}
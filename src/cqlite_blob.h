@@ -0,0 +1,200 @@
+/** @file */
+
+#ifndef _CQLITE_BLOB_H
+#define _CQLITE_BLOB_H
+
+#include <sqlite3.h>
+
+#include "cqlite.h"
+
+#define CQLITE_BLOB_CHUNK_SIZE  ( 64 * 1024 )   //!< Suggested chunk size for streaming blobs to and from files
+
+/**
+* Blob reader.
+*
+* Reads the blob stored in one column of one row in fixed-size chunks
+* with sqlite3_blob_read(), straight into the caller's buffers, so that
+* a large blob never has to be held in memory at once as it does with
+* sqlite3_column_blob(). Chunks are read in order from the start of
+* the blob.
+*
+* Any change to the row, including through the same connection,
+* invalidates the reader, after which reading fails.
+*/
+typedef struct cqlite_blob_reader_s cqlite_blob_reader_t;
+
+/**
+* Blob writer.
+*
+* Writes the blob stored in one column of one row in fixed-size chunks
+* with sqlite3_blob_write(). A blob writer cannot change the size of a
+* blob, so the blob is typically inserted as a zeroblob of its final
+* size first, for instance with cqlite_blob_insert(), and then filled
+* in order from its start.
+*/
+typedef struct cqlite_blob_writer_s cqlite_blob_writer_t;
+
+/**
+* Insert row with zeroblob.
+*
+* Binds a zeroblob of blob_size bytes to parameter blob_param of the
+* provided INSERT query, whose other parameters must already be bound,
+* executes it, and opens a blob writer on the blob of the new row. The
+* blob is then filled with the writer without ever being held in memory
+* whole. The caller must call cqlite_blob_writer_close() on writer_out.
+*
+* If the row is inserted but the writer cannot be opened, an error is
+* returned and new_row_id_out is still set to the row id of the new row,
+* which the caller is responsible for deleting if it is not wanted.
+*/
+cqlite_rcode_t cqlite_blob_insert
+    (
+    sqlite3 *                   db,             //!< Database on which to execute the query
+    sqlite3_stmt *              insert_query,   //!< Prepared INSERT query
+    int                         blob_param,     //!< Index of the blob parameter of the query
+    int                         blob_size,      //!< Size of the blob in bytes
+    char const *                table,          //!< Table the query inserts into
+    char const *                column,         //!< Column the blob parameter is stored in
+    cqlite_blob_writer_t **     writer_out,     //!< (out) Writer of the new blob, caller must close
+    sqlite_int64 *              new_row_id_out  //!< (out) Generated row id of new record, may be NULL
+    );
+
+/**
+* Close blob reader.
+*/
+void cqlite_blob_reader_close
+    (
+    cqlite_blob_reader_t *  reader  //!< Blob reader to close, may be NULL
+    );
+
+/**
+* Open blob reader.
+*
+* Opens the blob in the provided column of the row with the provided
+* row id of a table of the main database. The caller must call
+* cqlite_blob_reader_close() on reader_out.
+*/
+cqlite_rcode_t cqlite_blob_reader_open
+    (
+    sqlite3 *                   db,         //!< Database containing the blob
+    char const *                table,      //!< Table containing the blob
+    char const *                column,     //!< Column containing the blob
+    sqlite_int64                row_id,     //!< Row id of the row containing the blob
+    cqlite_blob_reader_t **     reader_out  //!< (out) Blob reader, caller must close
+    );
+
+/**
+* Read chunk from blob reader.
+*
+* Reads up to buffer_size bytes that follow the last chunk read into
+* the provided buffer. Sets read_cnt_out to the number of bytes read,
+* which is only less than buffer_size for the last chunk of the blob,
+* and 0 once the whole blob has been read.
+*/
+cqlite_rcode_t cqlite_blob_reader_read
+    (
+    cqlite_blob_reader_t *  reader,         //!< Blob reader
+    void *                  buffer,         //!< (out) Buffer to read the chunk into
+    int                     buffer_size,    //!< Size of the buffer in bytes
+    int *                   read_cnt_out    //!< (out) Number of bytes read
+    );
+
+/**
+* Read blob into file descriptor.
+*
+* Reads the rest of the blob in chunks of chunk_size bytes and writes
+* each one to the provided file descriptor, so that only a single chunk
+* is ever held in memory.
+*/
+cqlite_rcode_t cqlite_blob_reader_read_to_fd
+    (
+    cqlite_blob_reader_t *  reader,     //!< Blob reader
+    int                     fd,         //!< File descriptor to write the blob to
+    int                     chunk_size  //!< Size of the chunks in bytes
+    );
+
+/**
+* Move blob reader to another row.
+*
+* Opens the blob in the same column of another row, which is faster
+* than opening a new reader, and reads it from its start.
+*/
+cqlite_rcode_t cqlite_blob_reader_reopen
+    (
+    cqlite_blob_reader_t *  reader, //!< Blob reader
+    sqlite_int64            row_id  //!< Row id of the row containing the blob
+    );
+
+/**
+* Get size of blob being read.
+*/
+int cqlite_blob_reader_size
+    (
+    cqlite_blob_reader_t const *    reader  //!< Blob reader
+    );
+
+/**
+* Close blob writer.
+*
+* Returns CQLITE_ERROR if the blob could not be closed cleanly, in
+* which case earlier writes may not have been saved.
+*/
+cqlite_rcode_t cqlite_blob_writer_close
+    (
+    cqlite_blob_writer_t *  writer  //!< Blob writer to close, may be NULL
+    );
+
+/**
+* Open blob writer.
+*
+* Opens the blob in the provided column of the row with the provided
+* row id of a table of the main database for writing. The caller must
+* call cqlite_blob_writer_close() on writer_out.
+*/
+cqlite_rcode_t cqlite_blob_writer_open
+    (
+    sqlite3 *                   db,         //!< Database containing the blob
+    char const *                table,      //!< Table containing the blob
+    char const *                column,     //!< Column containing the blob
+    sqlite_int64                row_id,     //!< Row id of the row containing the blob
+    cqlite_blob_writer_t **     writer_out  //!< (out) Blob writer, caller must close
+    );
+
+/**
+* Get size of blob being written.
+*/
+int cqlite_blob_writer_size
+    (
+    cqlite_blob_writer_t const *    writer  //!< Blob writer
+    );
+
+/**
+* Write chunk to blob writer.
+*
+* Writes the provided data right after the last chunk written. Fails
+* without writing anything if the data does not fit in the rest of the
+* blob.
+*/
+cqlite_rcode_t cqlite_blob_writer_write
+    (
+    cqlite_blob_writer_t *  writer, //!< Blob writer
+    void const *            data,   //!< Data to write
+    int                     size    //!< Size of the data in bytes
+    );
+
+/**
+* Write blob from file descriptor.
+*
+* Fills the rest of the blob with data read from the provided file
+* descriptor in chunks of chunk_size bytes, so that only a single chunk
+* is ever held in memory. Reading stops once the blob is full. Fails if
+* the file ends first.
+*/
+cqlite_rcode_t cqlite_blob_writer_write_from_fd
+    (
+    cqlite_blob_writer_t *  writer,     //!< Blob writer
+    int                     fd,         //!< File descriptor to read the blob from
+    int                     chunk_size  //!< Size of the chunks in bytes
+    );
+
+#endif
@@ -0,0 +1,494 @@
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cqlite_columnar.h"
+#include "cqlite_private.h"
+
+#define READ_TO_END                 ( -1 )
+#define NO_TAIL                     ( NULL )
+#define ROW_INITIAL_CAPACITY        ( 64 )
+#define TEXT_INITIAL_CAPACITY       ( 1024 )
+#define NULL_BITS_PER_WORD          ( 64 )
+
+
+/**********************************************
+Functions
+**********************************************/
+static int aligned_array_resize
+    (
+    void ** array,
+    size_t  size,
+    size_t  new_size
+    );
+
+static int column_null_set
+    (
+    cqlite_columnar_column_t *  column,
+    int                         row,
+    int                         row_capacity
+    );
+
+static int column_value_read
+    (
+    cqlite_columnar_column_t *  column,
+    sqlite3_stmt *              query,
+    int                         query_column,
+    int                         row,
+    int                         row_capacity,
+    size_t *                    text_capacity
+    );
+
+static int columns_grow
+    (
+    cqlite_columnar_result_t *  result,
+    int                         row_capacity,
+    int                         new_row_capacity
+    );
+
+static size_t null_bits_size
+    (
+    int row_capacity
+    );
+
+
+// Free columnar result.
+void cqlite_columnar_result_free
+    (
+    cqlite_columnar_result_t * result   //!< Result to free
+    )
+{
+int i;
+
+for( i = 0; ( NULL != result->columns ) && ( i < result->column_cnt ); i++ )
+    {
+    free( result->columns[i].int64_values );
+    free( result->columns[i].double_values );
+    free( result->columns[i].text_offsets );
+    free( result->columns[i].text_data );
+    free( result->columns[i].null_bits );
+    }
+
+free( result->columns );
+
+memset( result, 0, sizeof( *result ) );
+}
+
+
+// Execute SELECT query into columns.
+cqlite_rcode_t cqlite_columnar_select_query_execute
+    (
+    sqlite3 *                       db,                 //!< Database on which to execute the query
+    char const * const              select_query_str,   //!< Parameter-less SELECT query string
+    char const * const              count_query_str,    //!< Parameter-less COUNT query string, NULL for single pass
+    cqlite_columnar_type_t const *  column_types,       //!< Type of each result column to read
+    int                             column_cnt,         //!< Number of result columns to read
+    cqlite_columnar_result_t *      result_out          //!< (out) Columns read from query, caller must free
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+sqlite3_stmt *  select_query = NULL;
+sqlite3_stmt *  count_query = NULL;
+sqlite_int64    prepare_start_ns;
+
+memset( result_out, 0, sizeof( *result_out ) );
+
+prepare_start_ns = cqlite_stats_prepare_begin();
+success = ( SQLITE_OK == sqlite3_prepare_v2( db, select_query_str, READ_TO_END, &select_query, NO_TAIL ) );
+
+if( success && ( NULL != count_query_str ) )
+    {
+    success = ( SQLITE_OK == sqlite3_prepare_v2( db, count_query_str, READ_TO_END, &count_query, NO_TAIL ) );
+    }
+
+cqlite_stats_prepare_end( CQLITE_STATS_API_SELECT, prepare_start_ns );
+
+if( success )
+    {
+    rcode = cqlite_columnar_select_query_execute_prepared( select_query, count_query, column_types, column_cnt, result_out );
+    }
+
+// Clean up
+sqlite3_finalize( select_query );
+sqlite3_finalize( count_query );
+
+return rcode;
+}
+
+
+// Execute prepared SELECT query into columns.
+cqlite_rcode_t cqlite_columnar_select_query_execute_prepared
+    (
+    sqlite3_stmt *                  select_query,       //!< Prepared SELECT query
+    sqlite3_stmt *                  count_query,        //!< Prepared COUNT query, NULL for single pass
+    cqlite_columnar_type_t const *  column_types,       //!< Type of each result column to read
+    int                             column_cnt,         //!< Number of result columns to read
+    cqlite_columnar_result_t *      result_out          //!< (out) Columns read from query, caller must free
+    )
+{
+cqlite_rcode_t      rcode = CQLITE_ERROR;
+int                 success;
+int                 is_single_pass;
+int                 i;
+int                 row = 0;
+int                 row_capacity = 0;
+int                 new_row_capacity = 0;
+int                 sqlite_rcode = SQLITE_ERROR;
+size_t *            text_capacities = NULL;
+cqlite_stats_call_t stats_call;
+sqlite_int64        phase_start_ns;
+
+memset( result_out, 0, sizeof( *result_out ) );
+
+is_single_pass = ( NULL == count_query );
+
+cqlite_stats_call_begin( &stats_call, CQLITE_STATS_API_SELECT );
+phase_start_ns = cqlite_stats_clock( &stats_call );
+
+success = ( column_cnt > 0 ) && ( column_cnt <= sqlite3_column_count( select_query ) );
+
+for( i = 0; success && ( i < column_cnt ); i++ )
+    {
+    success = ( CQLITE_COLUMNAR_INT64 == column_types[i] ) ||
+              ( CQLITE_COLUMNAR_DOUBLE == column_types[i] ) ||
+              ( CQLITE_COLUMNAR_TEXT == column_types[i] );
+    }
+
+if( success )
+    {
+    result_out->columns = calloc( column_cnt, sizeof( *result_out->columns ) );
+    text_capacities = calloc( column_cnt, sizeof( *text_capacities ) );
+    success = ( NULL != result_out->columns ) && ( NULL != text_capacities );
+    }
+
+if( success )
+    {
+    result_out->column_cnt = column_cnt;
+
+    for( i = 0; i < column_cnt; i++ )
+        {
+        result_out->columns[i].type = column_types[i];
+        }
+    }
+
+// Get the number of expected results
+if( success && !is_single_pass )
+    {
+    success = cqlite_count_query_step( count_query, &new_row_capacity ) && ( new_row_capacity >= 0 );
+    phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_COUNT, phase_start_ns );
+    }
+
+// Allocate the arrays to hold all expected results. Text offsets
+// always need at least one entry even if there are no results.
+if( success )
+    {
+    success = columns_grow( result_out, row_capacity, new_row_capacity );
+    row_capacity = new_row_capacity;
+    phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_ALLOC, phase_start_ns );
+    }
+
+if( success )
+    {
+    sqlite_rcode = sqlite3_step( select_query );
+    phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_STEP, phase_start_ns );
+    }
+
+// Read each result into the arrays
+while( success && ( SQLITE_ROW == sqlite_rcode ) )
+    {
+    if( row >= row_capacity )
+        {
+        // More results returned than expected. This is only
+        // an error if the arrays were sized by the COUNT query.
+        new_row_capacity = ( row_capacity < ROW_INITIAL_CAPACITY ) ? ROW_INITIAL_CAPACITY : ( ( row_capacity <= ( INT_MAX / 4 ) ) ? ( row_capacity * 2 ) : ( INT_MAX / 2 ) );
+        success = is_single_pass &&
+                  ( new_row_capacity > row_capacity ) &&
+                  columns_grow( result_out, row_capacity, new_row_capacity );
+
+        if( success )
+            {
+            row_capacity = new_row_capacity;
+            }
+
+        phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_ALLOC, phase_start_ns );
+        }
+
+    for( i = 0; success && ( i < column_cnt ); i++ )
+        {
+        success = column_value_read( &result_out->columns[i], select_query, i, row, row_capacity, &text_capacities[i] );
+        }
+
+    if( success )
+        {
+        phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_DECODE, phase_start_ns );
+
+        // Move to the next result
+        row++;
+        sqlite_rcode = sqlite3_step( select_query );
+        phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_STEP, phase_start_ns );
+        }
+    }
+
+// Ensure all results were successfully read
+if( success )
+    {
+    success = ( SQLITE_DONE == sqlite_rcode ) &&
+              ( is_single_pass || ( row == row_capacity ) );
+    }
+
+// Set the output
+result_out->row_cnt = row;
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+// Clean up
+free( text_capacities );
+
+stats_call.rows_read = row;
+cqlite_stats_call_end( &stats_call, select_query, success );
+
+return rcode;
+}
+
+
+// Get text of columnar row.
+char const * cqlite_columnar_text_get
+    (
+    cqlite_columnar_column_t const *    column, //!< TEXT column
+    int                                 row     //!< Row index
+    )
+{
+return &column->text_data[column->text_offsets[row]];
+}
+
+
+/**
+* Resize aligned array.
+*
+* Moves the array to a new CQLITE_COLUMNAR_ALIGNMENT aligned and padded
+* allocation of new_size bytes, zeroing the bytes past the old size. The
+* array is left unmodified on error.
+*/
+static int aligned_array_resize
+    (
+    void ** array,
+    size_t  size,
+    size_t  new_size
+    )
+{
+int     success;
+void *  new_array;
+size_t  padded_size;
+
+// aligned_alloc() requires the size to be a multiple of the alignment
+padded_size = ( new_size + CQLITE_COLUMNAR_ALIGNMENT - 1 ) & ~(size_t)( CQLITE_COLUMNAR_ALIGNMENT - 1 );
+padded_size = ( padded_size > 0 ) ? padded_size : CQLITE_COLUMNAR_ALIGNMENT;
+
+new_array = aligned_alloc( CQLITE_COLUMNAR_ALIGNMENT, padded_size );
+success = ( NULL != new_array ) && ( padded_size >= new_size );
+
+if( success )
+    {
+    cqlite_stats_bytes_add( padded_size );
+
+    // Nothing to copy on the first allocation, whatever its old size
+    size = ( NULL == *array ) ? 0 : size;
+    size = ( size < new_size ) ? size : new_size;
+
+    if( size > 0 )
+        {
+        memcpy( new_array, *array, size );
+        }
+
+    memset( (char*)new_array + size, 0, padded_size - size );
+
+    free( *array );
+    *array = new_array;
+    }
+else
+    {
+    free( new_array );
+    }
+
+return success;
+}
+
+
+/**
+* Mark columnar row as NULL.
+*
+* Allocates the column's NULL bits the first time one of its rows is
+* NULL.
+*/
+static int column_null_set
+    (
+    cqlite_columnar_column_t *  column,
+    int                         row,
+    int                         row_capacity
+    )
+{
+int success = 1;
+
+if( NULL == column->null_bits )
+    {
+    success = aligned_array_resize( (void**)&column->null_bits, 0, null_bits_size( row_capacity ) );
+    }
+
+if( success )
+    {
+    column->null_bits[row / NULL_BITS_PER_WORD] |= ( (sqlite_uint64)1 << ( row % NULL_BITS_PER_WORD ) );
+    }
+
+return success;
+}
+
+
+/**
+* Read result column into columnar row.
+*/
+static int column_value_read
+    (
+    cqlite_columnar_column_t *  column,
+    sqlite3_stmt *              query,
+    int                         query_column,
+    int                         row,
+    int                         row_capacity,
+    size_t *                    text_capacity
+    )
+{
+int                     success = 1;
+int                     is_null;
+unsigned char const *   text = NULL;
+size_t                  text_size = 0;
+size_t                  text_offset;
+size_t                  new_text_capacity;
+
+is_null = ( SQLITE_NULL == sqlite3_column_type( query, query_column ) );
+
+if( is_null )
+    {
+    success = column_null_set( column, row, row_capacity );
+    }
+
+switch( column->type )
+    {
+    case CQLITE_COLUMNAR_INT64:
+        column->int64_values[row] = sqlite3_column_int64( query, query_column );
+        break;
+
+    case CQLITE_COLUMNAR_DOUBLE:
+        column->double_values[row] = sqlite3_column_double( query, query_column );
+        break;
+
+    case CQLITE_COLUMNAR_TEXT:
+        // The size must be read after the text to get the size of the UTF-8 text.
+        if( !is_null )
+            {
+            text = sqlite3_column_text( query, query_column );
+            text_size = sqlite3_column_bytes( query, query_column );
+
+            // NULL text for a non-NULL result is an out of memory error.
+            success = success && ( NULL != text );
+            }
+
+        text_offset = column->text_offsets[row];
+        new_text_capacity = ( *text_capacity > 0 ) ? *text_capacity : TEXT_INITIAL_CAPACITY;
+
+        while( new_text_capacity < ( text_offset + text_size + 1 ) )
+            {
+            new_text_capacity *= 2;
+            }
+
+        if( success && ( new_text_capacity > *text_capacity ) )
+            {
+            success = aligned_array_resize( (void**)&column->text_data, *text_capacity, new_text_capacity );
+            *text_capacity = success ? new_text_capacity : *text_capacity;
+            }
+
+        if( success )
+            {
+            if( NULL != text )
+                {
+                memcpy( &column->text_data[text_offset], text, text_size );
+                }
+
+            column->text_data[text_offset + text_size] = '\0';
+            column->text_offsets[row + 1] = text_offset + text_size + 1;
+            }
+        break;
+
+    default:
+        success = 0;
+        break;
+    }
+
+return success;
+}
+
+
+/**
+* Grow columnar arrays.
+*
+* Grows every array of every column from holding row_capacity rows to
+* holding new_row_capacity rows.
+*/
+static int columns_grow
+    (
+    cqlite_columnar_result_t *  result,
+    int                         row_capacity,
+    int                         new_row_capacity
+    )
+{
+int                         success = 1;
+int                         i;
+cqlite_columnar_column_t *  column;
+
+for( i = 0; success && ( i < result->column_cnt ); i++ )
+    {
+    column = &result->columns[i];
+
+    switch( column->type )
+        {
+        case CQLITE_COLUMNAR_INT64:
+            success = aligned_array_resize( (void**)&column->int64_values, row_capacity * sizeof( *column->int64_values ), new_row_capacity * sizeof( *column->int64_values ) );
+            break;
+
+        case CQLITE_COLUMNAR_DOUBLE:
+            success = aligned_array_resize( (void**)&column->double_values, row_capacity * sizeof( *column->double_values ), new_row_capacity * sizeof( *column->double_values ) );
+            break;
+
+        case CQLITE_COLUMNAR_TEXT:
+            success = aligned_array_resize( (void**)&column->text_offsets, ( row_capacity + 1 ) * sizeof( *column->text_offsets ), ( new_row_capacity + 1 ) * sizeof( *column->text_offsets ) );
+            break;
+
+        default:
+            success = 0;
+            break;
+        }
+
+    if( success && ( NULL != column->null_bits ) )
+        {
+        success = aligned_array_resize( (void**)&column->null_bits, null_bits_size( row_capacity ), null_bits_size( new_row_capacity ) );
+        }
+    }
+
+return success;
+}
+
+
+/**
+* Get size of NULL bits.
+*/
+static size_t null_bits_size
+    (
+    int row_capacity
+    )
+{
+return ( ( row_capacity + NULL_BITS_PER_WORD - 1 ) / NULL_BITS_PER_WORD ) * sizeof( sqlite_uint64 );
+}
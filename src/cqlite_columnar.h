@@ -0,0 +1,115 @@
+/** @file */
+
+#ifndef _CQLITE_COLUMNAR_H
+#define _CQLITE_COLUMNAR_H
+
+#include <sqlite3.h>
+
+#include "cqlite.h"
+
+#define CQLITE_COLUMNAR_ALIGNMENT ( 64 )
+
+/**
+* Columnar column type.
+*
+* Type of the array a result column is read into.
+*/
+typedef enum
+    {
+    CQLITE_COLUMNAR_INT64,  //!< sqlite_int64 values, 0 for NULL results
+    CQLITE_COLUMNAR_DOUBLE, //!< double values, 0.0 for NULL results
+    CQLITE_COLUMNAR_TEXT,   //!< Offsets into a buffer of NUL-terminated UTF-8 text, empty for NULL results
+    } cqlite_columnar_type_t;
+
+/**
+* Columnar column.
+*
+* Holds one result column of every row in a single contiguous array.
+* Only the arrays of the column's type are set. Every array starts on a
+* CQLITE_COLUMNAR_ALIGNMENT byte boundary and is padded to a multiple of
+* CQLITE_COLUMNAR_ALIGNMENT bytes, so that loops over the values can be
+* vectorized without peeling.
+*
+* The text of row i of a TEXT column starts at text_data[text_offsets[i]]
+* and is text_offsets[i + 1] - text_offsets[i] - 1 bytes long, not
+* counting its NUL terminator.
+*/
+typedef struct
+    {
+    cqlite_columnar_type_t  type;           //!< Type of the column
+    sqlite_int64 *          int64_values;   //!< Value of each row of an INT64 column
+    double *                double_values;  //!< Value of each row of a DOUBLE column
+    sqlite_int64 *          text_offsets;   //!< Offset of each row's text in text_data, followed by the total size, of a TEXT column
+    char *                  text_data;      //!< Text of all rows of a TEXT column
+    sqlite_uint64 *         null_bits;      //!< Bit i % 64 of word i / 64 is set if row i is NULL, NULL if no row is NULL
+    } cqlite_columnar_column_t;
+
+/**
+* Columnar result.
+*/
+typedef struct
+    {
+    int                         row_cnt;    //!< Number of rows
+    int                         column_cnt; //!< Number of columns
+    cqlite_columnar_column_t *  columns;    //!< Columns in the order of the SELECT query's result columns
+    } cqlite_columnar_result_t;
+
+/**
+* Free columnar result.
+*
+* Frees all arrays of the result, which may be partially filled in.
+*/
+void cqlite_columnar_result_free
+    (
+    cqlite_columnar_result_t * result   //!< Result to free
+    );
+
+/**
+* Execute SELECT query into columns.
+*
+* Executes the SELECT query and reads its first column_cnt result
+* columns into one array per column rather than into a list of models,
+* so that scans touching only some of the columns read only their
+* memory. Result column i is read as column_types[i].
+*
+* Like cqlite_select_query_execute(), the COUNT query sizes the arrays
+* up front, or may be NULL to read the results in a single pass while
+* growing them. The caller must call cqlite_columnar_result_free() on
+* result_out regardless of whether the function executes successfully.
+*/
+cqlite_rcode_t cqlite_columnar_select_query_execute
+    (
+    sqlite3 *                       db,                 //!< Database on which to execute the query
+    char const * const              select_query_str,   //!< Parameter-less SELECT query string
+    char const * const              count_query_str,    //!< Parameter-less COUNT query string, NULL for single pass
+    cqlite_columnar_type_t const *  column_types,       //!< Type of each result column to read
+    int                             column_cnt,         //!< Number of result columns to read
+    cqlite_columnar_result_t *      result_out          //!< (out) Columns read from query, caller must free
+    );
+
+/**
+* Execute prepared SELECT query into columns.
+*
+* @see cqlite_columnar_select_query_execute()
+*/
+cqlite_rcode_t cqlite_columnar_select_query_execute_prepared
+    (
+    sqlite3_stmt *                  select_query,       //!< Prepared SELECT query
+    sqlite3_stmt *                  count_query,        //!< Prepared COUNT query, NULL for single pass
+    cqlite_columnar_type_t const *  column_types,       //!< Type of each result column to read
+    int                             column_cnt,         //!< Number of result columns to read
+    cqlite_columnar_result_t *      result_out          //!< (out) Columns read from query, caller must free
+    );
+
+/**
+* Get text of columnar row.
+*
+* Returns the NUL-terminated text of a row of a TEXT column.
+*/
+char const * cqlite_columnar_text_get
+    (
+    cqlite_columnar_column_t const *    column, //!< TEXT column
+    int                                 row     //!< Row index
+    );
+
+#endif
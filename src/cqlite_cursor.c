@@ -0,0 +1,218 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cqlite_cursor.h"
+
+#define READ_TO_END ( -1 )
+#define NO_TAIL     ( NULL )
+
+
+/**********************************************
+Types
+**********************************************/
+struct cqlite_cursor_s
+    {
+    sqlite3_stmt *                      select_query;           //!< Query whose results are read
+    int                                 owns_select_query;      //!< Must the query be finalized on close?
+    cqlite_model_from_row_result_func_t model_from_result_func; //!< Function to read a result into a model
+    cqlite_model_free_func_t            model_free_func;        //!< Function to free a model's memory, may be NULL
+    size_t                              model_size;             //!< Size of the model type
+    int                                 batch_size;             //!< Capacity of the batch buffer
+    int                                 batch_cnt;              //!< Number of models in the batch buffer that may own memory
+    void *                              batch;                  //!< Batch buffer reused for every batch
+    int                                 is_done;                //!< Have all results been read?
+    };
+
+
+/**********************************************
+Functions
+**********************************************/
+static void cursor_batch_clear
+    (
+    cqlite_cursor_t * cursor
+    );
+
+
+// Close cursor.
+void cqlite_cursor_close
+    (
+    cqlite_cursor_t * cursor    //!< Cursor to close
+    )
+{
+if( NULL != cursor )
+    {
+    cursor_batch_clear( cursor );
+
+    if( cursor->owns_select_query )
+        {
+        sqlite3_finalize( cursor->select_query );
+        }
+    else
+        {
+        sqlite3_reset( cursor->select_query );
+        }
+
+    free( cursor->batch );
+    free( cursor );
+    }
+}
+
+
+// Read next batch from cursor.
+cqlite_rcode_t cqlite_cursor_next
+    (
+    cqlite_cursor_t *   cursor,             //!< Cursor to read from
+    void **             model_list_out,     //!< (out) Models read from query, owned by the cursor
+    int *               model_list_cnt_out  //!< (out) Number of models read, 0 when done
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success = 1;
+int             sqlite_rcode;
+void *          model;
+
+*model_list_out = cursor->batch;
+*model_list_cnt_out = 0;
+
+// Release the previous batch before reusing its buffer
+cursor_batch_clear( cursor );
+
+while( success && ( !cursor->is_done ) && ( cursor->batch_cnt < cursor->batch_size ) )
+    {
+    sqlite_rcode = sqlite3_step( cursor->select_query );
+
+    if( SQLITE_ROW == sqlite_rcode )
+        {
+        model = (char*)cursor->batch + ( cursor->batch_cnt * cursor->model_size );
+        cursor->batch_cnt++;
+
+        success = cursor->model_from_result_func( cursor->select_query, model );
+        }
+    else
+        {
+        cursor->is_done = 1;
+        success = ( SQLITE_DONE == sqlite_rcode );
+        }
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    *model_list_cnt_out = cursor->batch_cnt;
+    }
+else
+    {
+    // Do not read past an error
+    cursor->is_done = 1;
+    }
+
+return rcode;
+}
+
+
+// Open cursor.
+cqlite_rcode_t cqlite_cursor_open
+    (
+    sqlite3 *                           db,                     //!< Database on which to execute the query
+    char const * const                  select_query_str,       //!< Parameter-less SELECT query string
+    cqlite_model_from_row_result_func_t model_from_result_func, //!< Function to read a result into a model
+    cqlite_model_free_func_t            model_free_func,        //!< Function to free a model's memory, may be NULL
+    size_t                              model_size,             //!< Size of the model type
+    int                                 batch_size,             //!< Maximum number of models per batch
+    cqlite_cursor_t **                  cursor_out              //!< (out) Cursor, caller must close
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+sqlite3_stmt *  select_query = NULL;
+
+*cursor_out = NULL;
+
+success = ( SQLITE_OK == sqlite3_prepare_v2( db, select_query_str, READ_TO_END, &select_query, NO_TAIL ) ) &&
+          ( CQLITE_SUCCESS == cqlite_cursor_open_prepared( select_query, model_from_result_func, model_free_func, model_size, batch_size, cursor_out ) );
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    ( *cursor_out )->owns_select_query = 1;
+    }
+else
+    {
+    sqlite3_finalize( select_query );
+    }
+
+return rcode;
+}
+
+
+// Open cursor over prepared query.
+cqlite_rcode_t cqlite_cursor_open_prepared
+    (
+    sqlite3_stmt *                      select_query,           //!< Prepared SELECT query
+    cqlite_model_from_row_result_func_t model_from_result_func, //!< Function to read a result into a model
+    cqlite_model_free_func_t            model_free_func,        //!< Function to free a model's memory, may be NULL
+    size_t                              model_size,             //!< Size of the model type
+    int                                 batch_size,             //!< Maximum number of models per batch
+    cqlite_cursor_t **                  cursor_out              //!< (out) Cursor, caller must close
+    )
+{
+cqlite_rcode_t      rcode = CQLITE_ERROR;
+int                 success;
+cqlite_cursor_t *   cursor;
+
+*cursor_out = NULL;
+
+cursor = calloc( 1, sizeof( *cursor ) );
+success = ( NULL != cursor ) && ( batch_size > 0 );
+
+if( success )
+    {
+    cursor->select_query = select_query;
+    cursor->model_from_result_func = model_from_result_func;
+    cursor->model_free_func = model_free_func;
+    cursor->model_size = model_size;
+    cursor->batch_size = batch_size;
+
+    cursor->batch = calloc( batch_size, model_size );
+    success = ( NULL != cursor->batch );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    *cursor_out = cursor;
+    }
+else
+    {
+    free( cursor );
+    }
+
+return rcode;
+}
+
+
+/**
+* Clear cursor batch.
+*
+* Frees the memory owned by every model of the current batch and
+* zeroes the batch buffer so it can be reused.
+*/
+static void cursor_batch_clear
+    (
+    cqlite_cursor_t * cursor
+    )
+{
+int i;
+
+if( NULL != cursor->model_free_func )
+    {
+    for( i = 0; i < cursor->batch_cnt; i++ )
+        {
+        cursor->model_free_func( (char*)cursor->batch + ( i * cursor->model_size ) );
+        }
+    }
+
+memset( cursor->batch, 0, cursor->batch_cnt * cursor->model_size );
+cursor->batch_cnt = 0;
+}
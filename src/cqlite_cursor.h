@@ -0,0 +1,86 @@
+/** @file */
+
+#ifndef _CQLITE_CURSOR_H
+#define _CQLITE_CURSOR_H
+
+#include <sqlite3.h>
+
+#include "cqlite.h"
+
+/**
+* SELECT query cursor.
+*
+* Reads the results of a SELECT query in batches of at most a fixed
+* number of models. Each batch is decoded into the same buffer, so
+* memory use is independent of the number of results and the first
+* results are available as soon as the first batch has been read.
+*/
+typedef struct cqlite_cursor_s cqlite_cursor_t;
+
+/**
+* Close cursor.
+*
+* Frees the models of the last batch as well as the cursor itself. If
+* the cursor was opened with cqlite_cursor_open(), the SELECT query is
+* also finalized. Otherwise, it is reset.
+*/
+void cqlite_cursor_close
+    (
+    cqlite_cursor_t * cursor    //!< Cursor to close
+    );
+
+/**
+* Read next batch from cursor.
+*
+* Reads up to the cursor's batch size results into a buffer owned by
+* the cursor and returns it in model_list_out. The returned models are
+* only valid until the next call to cqlite_cursor_next() or
+* cqlite_cursor_close(), at which point they are passed to the cursor's
+* model_free_func. Sets model_list_cnt_out to 0 once all results have
+* been read.
+*/
+cqlite_rcode_t cqlite_cursor_next
+    (
+    cqlite_cursor_t *   cursor,             //!< Cursor to read from
+    void **             model_list_out,     //!< (out) Models read from query, owned by the cursor
+    int *               model_list_cnt_out  //!< (out) Number of models read, 0 when done
+    );
+
+/**
+* Open cursor.
+*
+* Prepares the provided parameter-less SELECT query and opens a cursor
+* over its results that reads batch_size models at a time using the
+* provided model_from_result_func. If model_free_func is not NULL, it is
+* called on every model of a batch once the batch is no longer needed.
+* The caller must call cqlite_cursor_close() on cursor_out.
+*/
+cqlite_rcode_t cqlite_cursor_open
+    (
+    sqlite3 *                           db,                     //!< Database on which to execute the query
+    char const * const                  select_query_str,       //!< Parameter-less SELECT query string
+    cqlite_model_from_row_result_func_t model_from_result_func, //!< Function to read a result into a model
+    cqlite_model_free_func_t            model_free_func,        //!< Function to free a model's memory, may be NULL
+    size_t                              model_size,             //!< Size of the model type
+    int                                 batch_size,             //!< Maximum number of models per batch
+    cqlite_cursor_t **                  cursor_out              //!< (out) Cursor, caller must close
+    );
+
+/**
+* Open cursor over prepared query.
+*
+* The cursor does not take ownership of the SELECT query.
+*
+* @see cqlite_cursor_open()
+*/
+cqlite_rcode_t cqlite_cursor_open_prepared
+    (
+    sqlite3_stmt *                      select_query,           //!< Prepared SELECT query
+    cqlite_model_from_row_result_func_t model_from_result_func, //!< Function to read a result into a model
+    cqlite_model_free_func_t            model_free_func,        //!< Function to free a model's memory, may be NULL
+    size_t                              model_size,             //!< Size of the model type
+    int                                 batch_size,             //!< Maximum number of models per batch
+    cqlite_cursor_t **                  cursor_out              //!< (out) Cursor, caller must close
+    );
+
+#endif
@@ -0,0 +1,94 @@
+#include <stddef.h>
+
+#include "cqlite_fold.h"
+#include "cqlite_private.h"
+
+#define READ_TO_END         ( -1 )
+#define NO_TAIL             ( NULL )
+
+
+/**********************************************
+Functions
+**********************************************/
+
+// Execute SELECT query as a fold.
+cqlite_rcode_t cqlite_fold_query_execute
+    (
+    sqlite3 *           db,                 //!< Database on which to execute the query
+    char const * const  select_query_str,   //!< Parameter-less SELECT query string
+    cqlite_fold_func_t  fold_func,          //!< Function to fold a row result into the accumulator
+    void *              accumulator         //!< (in/out) Accumulator of the fold
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+sqlite3_stmt *  select_query = NULL;
+sqlite_int64    prepare_start_ns;
+
+prepare_start_ns = cqlite_stats_prepare_begin();
+success = ( SQLITE_OK == sqlite3_prepare_v2( db, select_query_str, READ_TO_END, &select_query, NO_TAIL ) );
+cqlite_stats_prepare_end( CQLITE_STATS_API_SELECT, prepare_start_ns );
+
+if( success )
+    {
+    rcode = cqlite_fold_query_execute_prepared( select_query, fold_func, accumulator );
+    }
+
+// Clean up
+sqlite3_finalize( select_query );
+
+return rcode;
+}
+
+
+// Execute prepared SELECT query as a fold.
+cqlite_rcode_t cqlite_fold_query_execute_prepared
+    (
+    sqlite3_stmt *      select_query,       //!< Prepared SELECT query
+    cqlite_fold_func_t  fold_func,          //!< Function to fold a row result into the accumulator
+    void *              accumulator         //!< (in/out) Accumulator of the fold
+    )
+{
+cqlite_rcode_t      rcode = CQLITE_ERROR;
+int                 success = 1;
+int                 sqlite_rcode;
+sqlite_int64        row_cnt = 0;
+cqlite_stats_call_t stats_call;
+sqlite_int64        phase_start_ns;
+
+cqlite_stats_call_begin( &stats_call, CQLITE_STATS_API_SELECT );
+phase_start_ns = cqlite_stats_clock( &stats_call );
+
+sqlite_rcode = sqlite3_step( select_query );
+phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_STEP, phase_start_ns );
+
+while( success && ( SQLITE_ROW == sqlite_rcode ) )
+    {
+    success = fold_func( select_query, accumulator );
+    phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_DECODE, phase_start_ns );
+
+    if( success )
+        {
+        row_cnt++;
+
+        sqlite_rcode = sqlite3_step( select_query );
+        phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_STEP, phase_start_ns );
+        }
+    }
+
+// Ensure all results were successfully folded
+if( success )
+    {
+    success = ( SQLITE_DONE == sqlite_rcode );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+stats_call.rows_read = row_cnt;
+cqlite_stats_call_end( &stats_call, select_query, success );
+
+return rcode;
+}
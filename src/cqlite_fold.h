@@ -0,0 +1,69 @@
+/** @file */
+
+#ifndef _CQLITE_FOLD_H
+#define _CQLITE_FOLD_H
+
+#include <sqlite3.h>
+
+#include "cqlite.h"
+
+/**
+* Fold row function type.
+*
+* Combines the current row result of the query, read with the
+* sqlite3_column_*() functions, into the accumulator. Values read from
+* the query are only valid until the next row, so anything kept in the
+* accumulator must be copied. Returns 1 on success, 0 on error, which
+* stops the fold.
+*/
+typedef int (*cqlite_fold_func_t)
+    (
+    sqlite3_stmt *  query,          //!< Query positioned on a row result
+    void *          accumulator     //!< Accumulator of the fold
+    );
+
+/**
+* Fold merge function type.
+*
+* Combines the accumulator of a partition of a parallel fold into the
+* caller's accumulator. Returns 1 on success, 0 on error.
+*/
+typedef int (*cqlite_fold_merge_func_t)
+    (
+    void *          accumulator,            //!< Caller's accumulator
+    void const *    partition_accumulator   //!< Accumulator of a partition
+    );
+
+/**
+* Execute SELECT query as a fold.
+*
+* Executes the provided SELECT query string that takes no parameters in
+* a single pass, calling fold_func with each row result and the caller's
+* accumulator, which must be initialized beforehand. Sums, histograms
+* and top-N lists are computed this way without reading the results
+* into models, so no COUNT query or model list is needed and memory use
+* does not grow with the number of rows.
+*
+* On error, the accumulator holds the rows folded so far.
+*/
+cqlite_rcode_t cqlite_fold_query_execute
+    (
+    sqlite3 *           db,                 //!< Database on which to execute the query
+    char const * const  select_query_str,   //!< Parameter-less SELECT query string
+    cqlite_fold_func_t  fold_func,          //!< Function to fold a row result into the accumulator
+    void *              accumulator         //!< (in/out) Accumulator of the fold
+    );
+
+/**
+* Execute prepared SELECT query as a fold.
+*
+* @see cqlite_fold_query_execute()
+*/
+cqlite_rcode_t cqlite_fold_query_execute_prepared
+    (
+    sqlite3_stmt *      select_query,       //!< Prepared SELECT query
+    cqlite_fold_func_t  fold_func,          //!< Function to fold a row result into the accumulator
+    void *              accumulator         //!< (in/out) Accumulator of the fold
+    );
+
+#endif
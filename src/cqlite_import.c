@@ -0,0 +1,863 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cqlite_import.h"
+#include "cqlite_private.h"
+
+#define READ_TO_END             ( -1 )
+#define NO_TAIL                 ( NULL )
+#define NO_CALLBACK             ( NULL )
+#define NO_CALLBACK_PARAM       ( NULL )
+#define NO_ERROR_MESSAGE        ( NULL )
+#define IMPORT_CHUNK_ROW_CNT    ( 1024 )
+#define IMPORT_CHUNK_CNT        ( 4 )
+#define NUMBER_BUFFER_SIZE      ( 64 )
+#define CSV_DELIMITER           ( ',' )
+#define CSV_QUOTE               ( '"' )
+
+
+/**********************************************
+Types
+**********************************************/
+typedef struct import_s import_t;
+
+// Field of a parsed row, text points into the file mapping
+typedef struct
+    {
+    int             is_null;        //!< Is the field NULL?
+    sqlite_int64    int64_value;    //!< Value of an integer field
+    double          double_value;   //!< Value of a real field
+    char const *    text;           //!< Text of a text field, not NUL-terminated
+    int             text_len;       //!< Length of the text in bytes
+    } import_value_t;
+
+typedef struct
+    {
+    import_value_t *    values;     //!< field_cnt values of each row
+    int                 row_cnt;    //!< Number of rows parsed into the chunk
+    int                 is_last;    //!< Is this the last chunk of the file?
+    int                 failed;     //!< Did parsing the chunk fail?
+    } import_chunk_t;
+
+/**
+* Row parse function type.
+*
+* Parses the row at the import's position into values and moves the
+* position past it. Sets is_end_out instead if there are no more rows.
+* Returns 1 on success, 0 on a malformed row.
+*/
+typedef int (*import_row_parse_func_t)
+    (
+    import_t *          import,     //!< Import in progress
+    import_value_t *    values,     //!< (out) Values of the row's fields
+    int *               is_end_out  //!< (out) Was the end of the file reached?
+    );
+
+struct import_s
+    {
+    char *                          data;           //!< Private mapping of the file
+    size_t                          size;           //!< Size of the file
+    size_t                          pos;            //!< Offset of the next row, only used by the parsing thread
+    cqlite_import_field_t const *   fields;         //!< Fields of each row
+    int                             field_cnt;      //!< Number of fields
+    size_t                          record_size;    //!< Size of each binary record
+    import_row_parse_func_t         row_parse_func; //!< Function parsing a row of the file's format
+    import_chunk_t                  chunks[IMPORT_CHUNK_CNT];   //!< Ring of parsed chunks
+    pthread_mutex_t                 mutex;          //!< Protects handing chunks between threads
+    pthread_cond_t                  cond;           //!< Signaled when a chunk is filled or emptied
+    int                             filled_cnt;     //!< Number of chunks parsed but not yet inserted
+    int                             is_cancelled;   //!< Has inserting failed?
+    };
+
+
+/**********************************************
+Functions
+**********************************************/
+static int binary_row_parse
+    (
+    import_t *          import,
+    import_value_t *    values,
+    int *               is_end_out
+    );
+
+static void chunk_parse
+    (
+    import_t *          import,
+    import_chunk_t *    chunk
+    );
+
+static int csv_row_parse
+    (
+    import_t *          import,
+    import_value_t *    values,
+    int *               is_end_out
+    );
+
+static int csv_value_parse
+    (
+    cqlite_import_type_t    type,
+    char const *            text,
+    size_t                  text_len,
+    int                     is_quoted,
+    import_value_t *        value
+    );
+
+static cqlite_rcode_t import_run
+    (
+    sqlite3 *           db,
+    char const *        path,
+    char const *        insert_query_str,
+    import_t *          import,
+    int                 has_header,
+    int                 batch_size,
+    int                 use_parse_thread,
+    sqlite_int64 *      row_cnt_out
+    );
+
+static int integer_parse
+    (
+    char const *    text,
+    size_t          text_len,
+    sqlite_int64 *  value_out
+    );
+
+static void * parse_thread
+    (
+    void * args
+    );
+
+static int row_insert
+    (
+    sqlite3 *               db,
+    sqlite3_stmt *          insert_query,
+    import_t const *        import,
+    import_value_t const *  values
+    );
+
+
+// Import binary file.
+cqlite_rcode_t cqlite_import_binary
+    (
+    sqlite3 *                       db,                 //!< Database on which to execute the query
+    char const * const              path,               //!< Path of the file to import
+    char const * const              insert_query_str,   //!< INSERT query string taking the fields as parameters
+    cqlite_import_field_t const *   fields,             //!< Fields of each record
+    int                             field_cnt,          //!< Number of fields
+    size_t                          record_size,        //!< Size of each record
+    int                             batch_size,         //!< Number of records inserted per transaction
+    int                             use_parse_thread,   //!< Parse records on a separate thread?
+    sqlite_int64 *                  row_cnt_out         //!< (out) Number of records committed
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+int             i;
+size_t          type_size;
+import_t        import;
+
+*row_cnt_out = 0;
+
+memset( &import, 0, sizeof( import ) );
+import.fields = fields;
+import.field_cnt = field_cnt;
+import.record_size = record_size;
+import.row_parse_func = binary_row_parse;
+
+// Every field must lie within the record
+success = ( field_cnt > 0 ) && ( record_size > 0 );
+
+for( i = 0; success && ( i < field_cnt ); i++ )
+    {
+    switch( fields[i].type )
+        {
+        case CQLITE_IMPORT_SKIP:
+        case CQLITE_IMPORT_TEXT:
+            type_size = fields[i].size;
+            break;
+
+        case CQLITE_IMPORT_INT32:
+            type_size = sizeof( int32_t );
+            break;
+
+        case CQLITE_IMPORT_INT64:
+            type_size = sizeof( int64_t );
+            break;
+
+        case CQLITE_IMPORT_DOUBLE:
+            type_size = sizeof( double );
+            break;
+
+        default:
+            type_size = 0;
+            success = 0;
+            break;
+        }
+
+    success = success &&
+              ( type_size == fields[i].size ) &&
+              ( fields[i].offset <= record_size ) &&
+              ( fields[i].size <= ( record_size - fields[i].offset ) );
+    }
+
+if( success )
+    {
+    rcode = import_run( db, path, insert_query_str, &import, 0, batch_size, use_parse_thread, row_cnt_out );
+    }
+
+return rcode;
+}
+
+
+// Import CSV file.
+cqlite_rcode_t cqlite_import_csv
+    (
+    sqlite3 *                       db,                 //!< Database on which to execute the query
+    char const * const              path,               //!< Path of the file to import
+    char const * const              insert_query_str,   //!< INSERT query string taking the fields as parameters
+    cqlite_import_field_t const *   fields,             //!< Fields of each line
+    int                             field_cnt,          //!< Number of fields
+    int                             has_header,         //!< Skip the first line?
+    int                             batch_size,         //!< Number of lines inserted per transaction
+    int                             use_parse_thread,   //!< Parse lines on a separate thread?
+    sqlite_int64 *                  row_cnt_out         //!< (out) Number of lines committed
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+int             i;
+import_t        import;
+
+*row_cnt_out = 0;
+
+memset( &import, 0, sizeof( import ) );
+import.fields = fields;
+import.field_cnt = field_cnt;
+import.row_parse_func = csv_row_parse;
+
+success = ( field_cnt > 0 );
+
+for( i = 0; success && ( i < field_cnt ); i++ )
+    {
+    success = ( CQLITE_IMPORT_SKIP <= fields[i].type ) && ( CQLITE_IMPORT_TEXT >= fields[i].type );
+    }
+
+if( success )
+    {
+    rcode = import_run( db, path, insert_query_str, &import, has_header, batch_size, use_parse_thread, row_cnt_out );
+    }
+
+return rcode;
+}
+
+
+/**
+* Parse binary record.
+*
+* Numbers are copied out of the record since records need not be
+* aligned, text is bound from the mapping up to its first NUL.
+*/
+static int binary_row_parse
+    (
+    import_t *          import,
+    import_value_t *    values,
+    int *               is_end_out
+    )
+{
+int                 success;
+int                 i;
+int32_t             int32_value;
+char const *        field;
+char const *        nul;
+
+*is_end_out = ( import->pos == import->size );
+
+// A partial record at the end of the file is an error
+success = *is_end_out || ( import->record_size <= ( import->size - import->pos ) );
+
+for( i = 0; success && !*is_end_out && ( i < import->field_cnt ); i++ )
+    {
+    field = import->data + import->pos + import->fields[i].offset;
+    values[i].is_null = 0;
+
+    switch( import->fields[i].type )
+        {
+        case CQLITE_IMPORT_INT32:
+            memcpy( &int32_value, field, sizeof( int32_value ) );
+            values[i].int64_value = int32_value;
+            break;
+
+        case CQLITE_IMPORT_INT64:
+            memcpy( &values[i].int64_value, field, sizeof( values[i].int64_value ) );
+            break;
+
+        case CQLITE_IMPORT_DOUBLE:
+            memcpy( &values[i].double_value, field, sizeof( values[i].double_value ) );
+            break;
+
+        case CQLITE_IMPORT_TEXT:
+            nul = memchr( field, '\0', import->fields[i].size );
+            values[i].text = field;
+            values[i].text_len = ( NULL != nul ) ? ( nul - field ) : (int)import->fields[i].size;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+if( success && !*is_end_out )
+    {
+    import->pos += import->record_size;
+    }
+
+return success;
+}
+
+
+/**
+* Parse chunk of rows.
+*
+* Fills the chunk with up to IMPORT_CHUNK_ROW_CNT rows, marking it as
+* the last chunk at the end of the file or on an error.
+*/
+static void chunk_parse
+    (
+    import_t *          import,
+    import_chunk_t *    chunk
+    )
+{
+int success = 1;
+int is_end = 0;
+
+chunk->row_cnt = 0;
+
+while( success && !is_end && ( chunk->row_cnt < IMPORT_CHUNK_ROW_CNT ) )
+    {
+    success = import->row_parse_func( import, &chunk->values[chunk->row_cnt * import->field_cnt], &is_end );
+
+    if( success && !is_end )
+        {
+        chunk->row_cnt++;
+        }
+    }
+
+chunk->failed = !success;
+chunk->is_last = is_end || !success;
+}
+
+
+/**
+* Parse CSV line.
+*/
+static int csv_row_parse
+    (
+    import_t *          import,
+    import_value_t *    values,
+    int *               is_end_out
+    )
+{
+int     success = 1;
+int     i;
+int     is_quoted;
+char *  data;
+size_t  size;
+size_t  pos;
+size_t  start;
+size_t  write_pos;
+
+data = import->data;
+size = import->size;
+pos = import->pos;
+
+// Skip blank lines
+while( ( pos < size ) && ( ( '\n' == data[pos] ) || ( '\r' == data[pos] ) ) )
+    {
+    pos++;
+    }
+
+*is_end_out = ( pos == size );
+
+for( i = 0; success && !*is_end_out && ( i < import->field_cnt ); i++ )
+    {
+    is_quoted = ( pos < size ) && ( CSV_QUOTE == data[pos] );
+
+    if( is_quoted )
+        {
+        // Collapse doubled quotes in place, only writing to the
+        // mapping once the text has actually shifted.
+        pos++;
+        start = pos;
+        write_pos = pos;
+        success = 0;
+
+        while( !success && ( pos < size ) )
+            {
+            if( CSV_QUOTE != data[pos] )
+                {
+                if( write_pos != pos )
+                    {
+                    data[write_pos] = data[pos];
+                    }
+
+                write_pos++;
+                pos++;
+                }
+            else if( ( ( pos + 1 ) < size ) && ( CSV_QUOTE == data[pos + 1] ) )
+                {
+                if( write_pos != pos )
+                    {
+                    data[write_pos] = CSV_QUOTE;
+                    }
+
+                write_pos++;
+                pos += 2;
+                }
+            else
+                {
+                // Closing quote
+                pos++;
+                success = 1;
+                }
+            }
+        }
+    else
+        {
+        start = pos;
+
+        while( ( pos < size ) && ( CSV_DELIMITER != data[pos] ) && ( '\n' != data[pos] ) && ( '\r' != data[pos] ) )
+            {
+            pos++;
+            }
+
+        write_pos = pos;
+        }
+
+    success = success && csv_value_parse( import->fields[i].type, &data[start], write_pos - start, is_quoted, &values[i] );
+
+    // Fields are followed by a delimiter, the last one by the end of the line
+    if( success && ( i < ( import->field_cnt - 1 ) ) )
+        {
+        success = ( pos < size ) && ( CSV_DELIMITER == data[pos] );
+        pos++;
+        }
+    else if( success )
+        {
+        success = ( pos == size ) || ( '\n' == data[pos] ) || ( '\r' == data[pos] );
+        }
+    }
+
+import->pos = pos;
+
+return success;
+}
+
+
+/**
+* Parse CSV field.
+*/
+static int csv_value_parse
+    (
+    cqlite_import_type_t    type,
+    char const *            text,
+    size_t                  text_len,
+    int                     is_quoted,
+    import_value_t *        value
+    )
+{
+int     success = 1;
+char    buffer[NUMBER_BUFFER_SIZE];
+char *  end;
+
+value->is_null = ( !is_quoted && ( 0 == text_len ) );
+
+if( !value->is_null )
+    {
+    switch( type )
+        {
+        case CQLITE_IMPORT_INT32:
+        case CQLITE_IMPORT_INT64:
+            success = integer_parse( text, text_len, &value->int64_value );
+            break;
+
+        case CQLITE_IMPORT_DOUBLE:
+            // strtod() needs a NUL-terminated copy, which numbers are short enough for.
+            success = ( text_len < sizeof( buffer ) );
+
+            if( success )
+                {
+                memcpy( buffer, text, text_len );
+                buffer[text_len] = '\0';
+                value->double_value = strtod( buffer, &end );
+                success = ( text_len > 0 ) && ( end == &buffer[text_len] );
+                }
+            break;
+
+        case CQLITE_IMPORT_TEXT:
+            success = ( text_len <= INT32_MAX );
+            value->text = text;
+            value->text_len = (int)text_len;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+return success;
+}
+
+
+/**
+* Run import.
+*
+* Maps the file, then inserts the chunks of rows parsed either inline
+* or by the parse thread in batches of transactions.
+*/
+static cqlite_rcode_t import_run
+    (
+    sqlite3 *           db,
+    char const *        path,
+    char const *        insert_query_str,
+    import_t *          import,
+    int                 has_header,
+    int                 batch_size,
+    int                 use_parse_thread,
+    sqlite_int64 *      row_cnt_out
+    )
+{
+cqlite_rcode_t      rcode = CQLITE_ERROR;
+int                 success;
+int                 fd;
+int                 i;
+int                 is_thread_started = 0;
+int                 is_done = 0;
+int                 in_transaction = 0;
+int                 batch_cnt = 0;
+int                 chunk_idx = 0;
+sqlite_int64        row_cnt = 0;
+sqlite_int64        committed_cnt = 0;
+char const *        begin_str;
+char const *        commit_str;
+char const *        rollback_str;
+struct stat         file_stat;
+sqlite3_stmt *      insert_query = NULL;
+import_chunk_t *    chunk;
+pthread_t           thread;
+sqlite_int64        prepare_start_ns;
+
+pthread_mutex_init( &import->mutex, NULL );
+pthread_cond_init( &import->cond, NULL );
+
+fd = open( path, O_RDONLY );
+success = ( fd >= 0 ) && ( 0 == fstat( fd, &file_stat ) );
+
+// The mapping is private and writable so that quoted CSV fields can be
+// unescaped in place without modifying the file.
+if( success && ( file_stat.st_size > 0 ) )
+    {
+    import->size = file_stat.st_size;
+    import->data = mmap( NULL, import->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+    success = ( MAP_FAILED != import->data );
+    import->data = success ? import->data : NULL;
+    }
+
+if( success && ( NULL != import->data ) )
+    {
+    madvise( import->data, import->size, MADV_SEQUENTIAL );
+    }
+
+if( success && has_header )
+    {
+    while( ( import->pos < import->size ) && ( '\n' != import->data[import->pos] ) )
+        {
+        import->pos++;
+        }
+    }
+
+for( i = 0; success && ( i < IMPORT_CHUNK_CNT ); i++ )
+    {
+    import->chunks[i].values = malloc( IMPORT_CHUNK_ROW_CNT * import->field_cnt * sizeof( import_value_t ) );
+    success = ( NULL != import->chunks[i].values );
+    }
+
+if( success )
+    {
+    prepare_start_ns = cqlite_stats_prepare_begin();
+    success = ( SQLITE_OK == sqlite3_prepare_v2( db, insert_query_str, READ_TO_END, &insert_query, NO_TAIL ) );
+    cqlite_stats_prepare_end( CQLITE_STATS_API_INSERT, prepare_start_ns );
+    }
+
+// Parse inline if the thread cannot be created
+if( success && use_parse_thread )
+    {
+    is_thread_started = ( 0 == pthread_create( &thread, NULL, parse_thread, import ) );
+    }
+
+// Inside a transaction opened by the caller, each batch is a savepoint
+// so that a failed batch is undone without ending the transaction.
+if( sqlite3_get_autocommit( db ) )
+    {
+    begin_str = "BEGIN IMMEDIATE;";
+    commit_str = "COMMIT;";
+    rollback_str = "ROLLBACK;";
+    }
+else
+    {
+    begin_str = "SAVEPOINT cqlite_import_batch;";
+    commit_str = "RELEASE cqlite_import_batch;";
+    rollback_str = "ROLLBACK TO cqlite_import_batch; RELEASE cqlite_import_batch;";
+    }
+
+while( success && !is_done )
+    {
+    chunk = &import->chunks[chunk_idx % IMPORT_CHUNK_CNT];
+
+    if( is_thread_started )
+        {
+        pthread_mutex_lock( &import->mutex );
+
+        while( 0 == import->filled_cnt )
+            {
+            pthread_cond_wait( &import->cond, &import->mutex );
+            }
+
+        pthread_mutex_unlock( &import->mutex );
+        }
+    else
+        {
+        chunk_parse( import, chunk );
+        }
+
+    for( i = 0; success && ( i < chunk->row_cnt ); i++ )
+        {
+        if( !in_transaction )
+            {
+            success = ( SQLITE_OK == sqlite3_exec( db, begin_str, NO_CALLBACK, NO_CALLBACK_PARAM, NO_ERROR_MESSAGE ) );
+            in_transaction = success;
+            batch_cnt = 0;
+            }
+
+        success = success && row_insert( db, insert_query, import, &chunk->values[i * import->field_cnt] );
+
+        if( success )
+            {
+            row_cnt++;
+            batch_cnt++;
+            }
+
+        if( success && in_transaction && ( batch_cnt == batch_size ) )
+            {
+            success = ( SQLITE_OK == sqlite3_exec( db, commit_str, NO_CALLBACK, NO_CALLBACK_PARAM, NO_ERROR_MESSAGE ) );
+            in_transaction = !success;
+            committed_cnt = success ? row_cnt : committed_cnt;
+            }
+        }
+
+    success = success && !chunk->failed;
+    is_done = chunk->is_last;
+    chunk_idx++;
+
+    // Hand the chunk back to the parse thread
+    if( is_thread_started )
+        {
+        pthread_mutex_lock( &import->mutex );
+        import->filled_cnt--;
+        pthread_cond_signal( &import->cond );
+        pthread_mutex_unlock( &import->mutex );
+        }
+    }
+
+if( success && in_transaction )
+    {
+    success = ( SQLITE_OK == sqlite3_exec( db, commit_str, NO_CALLBACK, NO_CALLBACK_PARAM, NO_ERROR_MESSAGE ) );
+    in_transaction = !success;
+    committed_cnt = success ? row_cnt : committed_cnt;
+    }
+
+sqlite3_finalize( insert_query );
+
+// Roll back the batch that failed
+if( in_transaction )
+    {
+    sqlite3_exec( db, rollback_str, NO_CALLBACK, NO_CALLBACK_PARAM, NO_ERROR_MESSAGE );
+    }
+
+*row_cnt_out = committed_cnt;
+
+// Stop the parse thread if inserting failed before the last chunk
+if( is_thread_started )
+    {
+    pthread_mutex_lock( &import->mutex );
+    import->is_cancelled = 1;
+    pthread_cond_signal( &import->cond );
+    pthread_mutex_unlock( &import->mutex );
+
+    pthread_join( thread, NULL );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+// Clean up
+for( i = 0; i < IMPORT_CHUNK_CNT; i++ )
+    {
+    free( import->chunks[i].values );
+    }
+
+if( NULL != import->data )
+    {
+    munmap( import->data, import->size );
+    }
+
+if( fd >= 0 )
+    {
+    close( fd );
+    }
+
+pthread_mutex_destroy( &import->mutex );
+pthread_cond_destroy( &import->cond );
+
+return rcode;
+}
+
+
+/**
+* Parse integer.
+*
+* Parses an optionally signed decimal integer that must span the whole
+* text, failing on overflow.
+*/
+static int integer_parse
+    (
+    char const *    text,
+    size_t          text_len,
+    sqlite_int64 *  value_out
+    )
+{
+int             success;
+int             is_negative;
+size_t          i;
+sqlite_uint64   value = 0;
+sqlite_uint64   limit;
+
+is_negative = ( text_len > 0 ) && ( '-' == text[0] );
+i = ( ( text_len > 0 ) && ( ( '-' == text[0] ) || ( '+' == text[0] ) ) ) ? 1 : 0;
+limit = is_negative ? ( (sqlite_uint64)INT64_MAX + 1 ) : (sqlite_uint64)INT64_MAX;
+
+success = ( i < text_len );
+
+for( ; success && ( i < text_len ); i++ )
+    {
+    success = ( text[i] >= '0' ) && ( text[i] <= '9' ) &&
+              ( value <= ( ( limit - ( text[i] - '0' ) ) / 10 ) );
+    value = ( value * 10 ) + ( text[i] - '0' );
+    }
+
+*value_out = is_negative ? (sqlite_int64)( 0 - value ) : (sqlite_int64)value;
+
+return success;
+}
+
+
+/**
+* Parse thread.
+*
+* Parses chunks into the ring ahead of the inserting thread until the
+* last chunk or until inserting fails.
+*/
+static void * parse_thread
+    (
+    void * args
+    )
+{
+import_t *  import;
+int         chunk_idx = 0;
+int         is_done = 0;
+
+import = (import_t*)args;
+
+while( !is_done )
+    {
+    pthread_mutex_lock( &import->mutex );
+
+    while( ( IMPORT_CHUNK_CNT == import->filled_cnt ) && !import->is_cancelled )
+        {
+        pthread_cond_wait( &import->cond, &import->mutex );
+        }
+
+    is_done = import->is_cancelled;
+
+    pthread_mutex_unlock( &import->mutex );
+
+    if( !is_done )
+        {
+        chunk_parse( import, &import->chunks[chunk_idx % IMPORT_CHUNK_CNT] );
+        is_done = import->chunks[chunk_idx % IMPORT_CHUNK_CNT].is_last;
+        chunk_idx++;
+
+        pthread_mutex_lock( &import->mutex );
+        import->filled_cnt++;
+        pthread_cond_signal( &import->cond );
+        pthread_mutex_unlock( &import->mutex );
+        }
+    }
+
+return NULL;
+}
+
+
+/**
+* Insert parsed row.
+*
+* Text is bound with SQLITE_STATIC since the mapping outlives the query.
+*/
+static int row_insert
+    (
+    sqlite3 *               db,
+    sqlite3_stmt *          insert_query,
+    import_t const *        import,
+    import_value_t const *  values
+    )
+{
+int success = 1;
+int i;
+int param = 0;
+
+sqlite3_reset( insert_query );
+
+for( i = 0; success && ( i < import->field_cnt ); i++ )
+    {
+    if( CQLITE_IMPORT_SKIP != import->fields[i].type )
+        {
+        param++;
+
+        if( values[i].is_null )
+            {
+            success = ( SQLITE_OK == sqlite3_bind_null( insert_query, param ) );
+            }
+        else if( CQLITE_IMPORT_DOUBLE == import->fields[i].type )
+            {
+            success = ( SQLITE_OK == sqlite3_bind_double( insert_query, param, values[i].double_value ) );
+            }
+        else if( CQLITE_IMPORT_TEXT == import->fields[i].type )
+            {
+            success = ( SQLITE_OK == sqlite3_bind_text( insert_query, param, values[i].text, values[i].text_len, SQLITE_STATIC ) );
+            }
+        else
+            {
+            success = ( SQLITE_OK == sqlite3_bind_int64( insert_query, param, values[i].int64_value ) );
+            }
+        }
+    }
+
+return success && ( CQLITE_SUCCESS == cqlite_insert_query_execute( db, insert_query, NULL ) );
+}
@@ -0,0 +1,120 @@
+/** @file */
+
+#ifndef _CQLITE_IMPORT_H
+#define _CQLITE_IMPORT_H
+
+#include <stddef.h>
+#include <sqlite3.h>
+
+#include "cqlite.h"
+
+/**
+* CSV import field initializer.
+*
+* Describes a field of a CSV line. The offset and size are unused.
+*/
+#define CQLITE_IMPORT_CSV_FIELD( field_type ) \
+    { ( field_type ), 0, 0 }
+
+/**
+* Binary import field initializer.
+*
+* Describes a field of a fixed-layout binary record, taking its offset
+* and size from the record type. For instance:
+*
+*       static cqlite_import_field_t const MY_RECORD_FIELDS[] =
+*           {
+*           CQLITE_IMPORT_BINARY_FIELD( my_record_t, id,   CQLITE_IMPORT_INT64 ),
+*           CQLITE_IMPORT_BINARY_FIELD( my_record_t, name, CQLITE_IMPORT_TEXT ),
+*           };
+*/
+#define CQLITE_IMPORT_BINARY_FIELD( record_type, field, field_type ) \
+    { ( field_type ), offsetof( record_type, field ), sizeof( ( (record_type*)0 )->field ) }
+
+/**
+* Import field types.
+*/
+typedef enum
+    {
+    CQLITE_IMPORT_SKIP,     //!< Field is not bound to the query
+    CQLITE_IMPORT_INT32,    //!< Integer, a native int32_t in binary records
+    CQLITE_IMPORT_INT64,    //!< Integer, a native int64_t in binary records
+    CQLITE_IMPORT_DOUBLE,   //!< Real number, a native double in binary records
+    CQLITE_IMPORT_TEXT,     //!< Text, a NUL-padded char[size] in binary records
+    } cqlite_import_type_t;
+
+/**
+* Import field.
+*
+* Describes how a single field of each imported row is bound to the
+* INSERT query. Fields that are not skipped are bound to consecutive
+* query parameters starting from the first.
+*/
+typedef struct
+    {
+    cqlite_import_type_t    type;   //!< Type of the field
+    size_t                  offset; //!< Offset of the field within a binary record
+    size_t                  size;   //!< Size of the field within a binary record
+    } cqlite_import_field_t;
+
+/**
+* Import binary file.
+*
+* Inserts every record of a file of back-to-back record_size byte
+* records with the provided INSERT query. The file is memory-mapped and
+* the text fields are bound directly from the mapping, without being
+* copied, to a single prepared query.
+*
+* The records are inserted inside transactions that are committed every
+* batch_size records, or once for all records if batch_size is not
+* positive. If the caller already has a transaction open on the
+* database, each batch is a savepoint released into that transaction
+* instead. If an error occurs, the batch holding the failed record is
+* rolled back, but earlier batches remain committed or, inside the
+* caller's transaction, remain part of it.
+*
+* If use_parse_thread is set, records are parsed on a separate thread
+* while the calling thread inserts the records parsed before them.
+*/
+cqlite_rcode_t cqlite_import_binary
+    (
+    sqlite3 *                       db,                 //!< Database on which to execute the query
+    char const * const              path,               //!< Path of the file to import
+    char const * const              insert_query_str,   //!< INSERT query string taking the fields as parameters
+    cqlite_import_field_t const *   fields,             //!< Fields of each record
+    int                             field_cnt,          //!< Number of fields
+    size_t                          record_size,        //!< Size of each record
+    int                             batch_size,         //!< Number of records inserted per transaction
+    int                             use_parse_thread,   //!< Parse records on a separate thread?
+    sqlite_int64 *                  row_cnt_out         //!< (out) Number of records committed
+    );
+
+/**
+* Import CSV file.
+*
+* Inserts every line of a comma-separated file with the provided INSERT
+* query, after skipping the first line if has_header is set. Each line
+* must have exactly field_cnt fields. Fields may be quoted, with quotes
+* inside quoted fields doubled. Empty unquoted fields are bound as NULL.
+* Blank lines are skipped.
+*
+* The file is memory-mapped privately and parsed in place: text fields
+* are bound directly from the mapping, and only the pages of quoted
+* fields containing doubled quotes are modified, never the file itself.
+*
+* @see cqlite_import_binary() for transactions and the parse thread.
+*/
+cqlite_rcode_t cqlite_import_csv
+    (
+    sqlite3 *                       db,                 //!< Database on which to execute the query
+    char const * const              path,               //!< Path of the file to import
+    char const * const              insert_query_str,   //!< INSERT query string taking the fields as parameters
+    cqlite_import_field_t const *   fields,             //!< Fields of each line
+    int                             field_cnt,          //!< Number of fields
+    int                             has_header,         //!< Skip the first line?
+    int                             batch_size,         //!< Number of lines inserted per transaction
+    int                             use_parse_thread,   //!< Parse lines on a separate thread?
+    sqlite_int64 *                  row_cnt_out         //!< (out) Number of lines committed
+    );
+
+#endif
@@ -0,0 +1,546 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "cqlite_mapping.h"
+#include "cqlite_private.h"
+
+#define READ_TO_END ( -1 )
+#define NO_TAIL     ( NULL )
+
+
+/**********************************************
+Types
+**********************************************/
+typedef enum
+    {
+    AFFINITY_NONE,
+    AFFINITY_INTEGER,
+    AFFINITY_NUMERIC,
+    AFFINITY_REAL,
+    AFFINITY_TEXT,
+    } affinity_t;
+
+typedef struct
+    {
+    cqlite_column_desc_t const *    columns;
+    int                             column_cnt;
+    size_t                          model_size;
+    } mapping_context_t;
+
+typedef struct
+    {
+    cqlite_param_desc_t const *     params;
+    int                             param_cnt;
+    } params_context_t;
+
+
+/**********************************************
+Functions
+**********************************************/
+static affinity_t decltype_affinity
+    (
+    char const * decltype
+    );
+
+static int mapping_row_bind
+    (
+    sqlite3_stmt *  query,
+    void const *    model,
+    void *          context
+    );
+
+static int mapping_row_read
+    (
+    sqlite3_stmt *  query,
+    void *          model_list,
+    int             next_model_list_idx,
+    void *          context
+    );
+
+static int type_contains
+    (
+    char const * decltype,
+    char const * name
+    );
+
+
+// Check column descriptors against query.
+cqlite_rcode_t cqlite_mapping_columns_check
+    (
+    sqlite3_stmt *                  query,      //!< Prepared query
+    cqlite_column_desc_t const *    columns,    //!< Column descriptors
+    int                             column_cnt  //!< Number of column descriptors
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success = 1;
+int             i;
+int             result_column_cnt;
+affinity_t      affinity;
+
+result_column_cnt = sqlite3_column_count( query );
+
+for( i = 0; success && ( i < column_cnt ); i++ )
+    {
+    success = ( columns[i].column >= 0 ) && ( columns[i].column < result_column_cnt );
+
+    if( success )
+        {
+        affinity = decltype_affinity( sqlite3_column_decltype( query, columns[i].column ) );
+
+        switch( columns[i].type )
+            {
+            case CQLITE_FIELD_INT:
+            case CQLITE_FIELD_INT64:
+            case CQLITE_FIELD_DOUBLE:
+                success = ( AFFINITY_TEXT != affinity );
+                break;
+
+            case CQLITE_FIELD_DYNAMIC_STRING:
+                break;
+
+            case CQLITE_FIELD_FIXED_STRING:
+                success = ( columns[i].size > 0 );
+                break;
+
+            default:
+                success = 0;
+                break;
+            }
+        }
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+return rcode;
+}
+
+
+// Insert many models using parameter descriptors.
+cqlite_rcode_t cqlite_mapping_insert_many
+    (
+    sqlite3 *                   db,                 //!< Database on which to execute the query
+    char const * const          insert_query_str,   //!< INSERT query string taking the model's parameters
+    cqlite_param_desc_t const * params,             //!< Parameter descriptors
+    int                         param_cnt,          //!< Number of parameter descriptors
+    void const *                model_list,         //!< List of models to insert
+    size_t                      model_size,         //!< Size of the model type
+    int                         model_list_cnt,     //!< Number of models to insert
+    int                         batch_size,         //!< Number of models inserted per transaction
+    sqlite_int64 **             row_ids_out         //!< (out) Generated row id of each model, caller must free, may be NULL
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+sqlite3_stmt *  insert_query = NULL;
+sqlite_int64    prepare_start_ns;
+
+if( NULL != row_ids_out )
+    {
+    *row_ids_out = NULL;
+    }
+
+prepare_start_ns = cqlite_stats_prepare_begin();
+success = ( SQLITE_OK == sqlite3_prepare_v2( db, insert_query_str, READ_TO_END, &insert_query, NO_TAIL ) );
+cqlite_stats_prepare_end( CQLITE_STATS_API_INSERT, prepare_start_ns );
+
+if( success )
+    {
+    rcode = cqlite_mapping_insert_many_prepared( db, insert_query, params, param_cnt, model_list, model_size, model_list_cnt, batch_size, row_ids_out );
+    }
+
+// Clean up
+sqlite3_finalize( insert_query );
+
+return rcode;
+}
+
+
+// Insert many models using prepared query and parameter descriptors.
+cqlite_rcode_t cqlite_mapping_insert_many_prepared
+    (
+    sqlite3 *                   db,                 //!< Database on which to execute the query
+    sqlite3_stmt *              insert_query,       //!< Prepared INSERT query
+    cqlite_param_desc_t const * params,             //!< Parameter descriptors
+    int                         param_cnt,          //!< Number of parameter descriptors
+    void const *                model_list,         //!< List of models to insert
+    size_t                      model_size,         //!< Size of the model type
+    int                         model_list_cnt,     //!< Number of models to insert
+    int                         batch_size,         //!< Number of models inserted per transaction
+    sqlite_int64 **             row_ids_out         //!< (out) Generated row id of each model, caller must free, may be NULL
+    )
+{
+cqlite_rcode_t      rcode;
+params_context_t    context;
+
+context.params = params;
+context.param_cnt = param_cnt;
+
+rcode = cqlite_insert_rows( db, insert_query, mapping_row_bind, &context, model_list, model_size, model_list_cnt, batch_size, row_ids_out );
+
+// The last model's strings are still bound in place
+sqlite3_clear_bindings( insert_query );
+
+return rcode;
+}
+
+
+// Free model using column descriptors.
+void cqlite_mapping_model_free
+    (
+    cqlite_column_desc_t const *    columns,    //!< Column descriptors
+    int                             column_cnt, //!< Number of column descriptors
+    void *                          model       //!< Model whose memory is freed
+    )
+{
+int     i;
+char ** string;
+
+for( i = 0; i < column_cnt; i++ )
+    {
+    if( CQLITE_FIELD_DYNAMIC_STRING == columns[i].type )
+        {
+        string = (char**)( (char*)model + columns[i].offset );
+
+        free( *string );
+        *string = NULL;
+        }
+    }
+}
+
+
+// Bind model using parameter descriptors.
+cqlite_rcode_t cqlite_mapping_params_bind
+    (
+    sqlite3_stmt *              query,      //!< Prepared query
+    cqlite_param_desc_t const * params,     //!< Parameter descriptors
+    int                         param_cnt,  //!< Number of parameter descriptors
+    cqlite_bind_mode_t          bind_mode,  //!< How strings are bound
+    void const *                model       //!< Model whose fields are bound
+    )
+{
+cqlite_rcode_t          rcode = CQLITE_ERROR;
+int                     success = 1;
+int                     i;
+char const *            field;
+sqlite3_destructor_type destructor;
+
+destructor = ( CQLITE_BIND_STATIC == bind_mode ) ? SQLITE_STATIC : SQLITE_TRANSIENT;
+
+for( i = 0; success && ( i < param_cnt ); i++ )
+    {
+    field = (char const*)model + params[i].offset;
+
+    switch( params[i].type )
+        {
+        case CQLITE_FIELD_INT:
+            success = ( SQLITE_OK == sqlite3_bind_int( query, params[i].param, *(int const*)field ) );
+            break;
+
+        case CQLITE_FIELD_INT64:
+            success = ( SQLITE_OK == sqlite3_bind_int64( query, params[i].param, *(sqlite_int64 const*)field ) );
+            break;
+
+        case CQLITE_FIELD_DOUBLE:
+            success = ( SQLITE_OK == sqlite3_bind_double( query, params[i].param, *(double const*)field ) );
+            break;
+
+        // SQLite binds a NULL string as NULL
+        case CQLITE_FIELD_DYNAMIC_STRING:
+            success = ( SQLITE_OK == sqlite3_bind_text( query, params[i].param, *(char * const*)field, READ_TO_END, destructor ) );
+            break;
+
+        // A full fixed string may have no terminator
+        case CQLITE_FIELD_FIXED_STRING:
+            success = ( SQLITE_OK == sqlite3_bind_text( query, params[i].param, field, (int)strnlen( field, params[i].size ), destructor ) );
+            break;
+
+        default:
+            success = 0;
+            break;
+        }
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+return rcode;
+}
+
+
+// Read model from row result using column descriptors.
+cqlite_rcode_t cqlite_mapping_row_read
+    (
+    sqlite3_stmt *                  query,      //!< Query pointing at row result
+    cqlite_column_desc_t const *    columns,    //!< Column descriptors
+    int                             column_cnt, //!< Number of column descriptors
+    void *                          model_out   //!< (out) Model populated from row result
+    )
+{
+cqlite_rcode_t          rcode = CQLITE_ERROR;
+int                     success = 1;
+int                     i;
+char *                  field;
+unsigned char const *   text;
+int                     text_size;
+
+for( i = 0; success && ( i < column_cnt ); i++ )
+    {
+    field = (char*)model_out + columns[i].offset;
+
+    switch( columns[i].type )
+        {
+        case CQLITE_FIELD_INT:
+            *(int*)field = sqlite3_column_int( query, columns[i].column );
+            break;
+
+        case CQLITE_FIELD_INT64:
+            *(sqlite_int64*)field = sqlite3_column_int64( query, columns[i].column );
+            break;
+
+        case CQLITE_FIELD_DOUBLE:
+            *(double*)field = sqlite3_column_double( query, columns[i].column );
+            break;
+
+        case CQLITE_FIELD_DYNAMIC_STRING:
+        case CQLITE_FIELD_FIXED_STRING:
+            // The size must be read after the text to get the size of the UTF-8 text.
+            text = sqlite3_column_text( query, columns[i].column );
+            text_size = sqlite3_column_bytes( query, columns[i].column );
+
+            // NULL text is either a NULL result or an out of memory error.
+            success = ( NULL != text ) || ( SQLITE_NULL == sqlite3_column_type( query, columns[i].column ) );
+
+            if( success && ( CQLITE_FIELD_DYNAMIC_STRING == columns[i].type ) && ( NULL != text ) )
+                {
+                *(char**)field = malloc( text_size + 1 );
+                success = ( NULL != *(char**)field );
+
+                if( success )
+                    {
+                    cqlite_stats_bytes_add( text_size + 1 );
+                    memcpy( *(char**)field, text, text_size + 1 );
+                    }
+                }
+            else if( success && ( CQLITE_FIELD_FIXED_STRING == columns[i].type ) )
+                {
+                success = ( (size_t)text_size < columns[i].size );
+
+                if( success && ( NULL != text ) )
+                    {
+                    memcpy( field, text, text_size + 1 );
+                    }
+                else if( success )
+                    {
+                    memset( field, 0, columns[i].size );
+                    }
+                }
+            break;
+
+        default:
+            success = 0;
+            break;
+        }
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+return rcode;
+}
+
+
+// Execute SELECT query using column descriptors.
+cqlite_rcode_t cqlite_mapping_select_query_execute
+    (
+    sqlite3 *                       db,                 //!< Database on which to execute the query
+    char const * const              select_query_str,   //!< Parameter-less SELECT query string
+    char const * const              count_query_str,    //!< Parameter-less COUNT query string, NULL for single pass
+    cqlite_column_desc_t const *    columns,            //!< Column descriptors
+    int                             column_cnt,         //!< Number of column descriptors
+    size_t                          model_size,         //!< Size of the model type
+    void **                         model_list_out,     //!< (out) List of models read from query, caller must free
+    int *                           model_list_cnt_out  //!< (out) Number of models read from query
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+sqlite3_stmt *  select_query = NULL;
+sqlite3_stmt *  count_query = NULL;
+sqlite_int64    prepare_start_ns;
+
+*model_list_out = NULL;
+*model_list_cnt_out = 0;
+
+prepare_start_ns = cqlite_stats_prepare_begin();
+success = ( SQLITE_OK == sqlite3_prepare_v2( db, select_query_str, READ_TO_END, &select_query, NO_TAIL ) );
+
+if( success && ( NULL != count_query_str ) )
+    {
+    success = ( SQLITE_OK == sqlite3_prepare_v2( db, count_query_str, READ_TO_END, &count_query, NO_TAIL ) );
+    }
+
+cqlite_stats_prepare_end( CQLITE_STATS_API_SELECT, prepare_start_ns );
+
+if( success )
+    {
+    rcode = cqlite_mapping_select_query_execute_prepared( select_query, count_query, columns, column_cnt, model_size, model_list_out, model_list_cnt_out );
+    }
+
+// Clean up
+sqlite3_finalize( select_query );
+sqlite3_finalize( count_query );
+
+return rcode;
+}
+
+
+// Execute prepared SELECT query using column descriptors.
+cqlite_rcode_t cqlite_mapping_select_query_execute_prepared
+    (
+    sqlite3_stmt *                  select_query,       //!< Prepared SELECT query
+    sqlite3_stmt *                  count_query,        //!< Prepared COUNT query, NULL for single pass
+    cqlite_column_desc_t const *    columns,            //!< Column descriptors
+    int                             column_cnt,         //!< Number of column descriptors
+    size_t                          model_size,         //!< Size of the model type
+    void **                         model_list_out,     //!< (out) List of models read from query, caller must free
+    int *                           model_list_cnt_out  //!< (out) Number of models read from query
+    )
+{
+cqlite_rcode_t      rcode = CQLITE_ERROR;
+mapping_context_t   context;
+
+*model_list_out = NULL;
+*model_list_cnt_out = 0;
+
+// Check the columns once up front rather than checking the type of every result.
+if( CQLITE_SUCCESS == cqlite_mapping_columns_check( select_query, columns, column_cnt ) )
+    {
+    context.columns = columns;
+    context.column_cnt = column_cnt;
+    context.model_size = model_size;
+
+    rcode = cqlite_select_rows_read( select_query, count_query, mapping_row_read, &context, model_size, model_list_out, model_list_cnt_out );
+    }
+
+return rcode;
+}
+
+
+/**
+* Get affinity of declared type.
+*
+* Determines the affinity of a column from its declared type using the
+* rules of section 3.1 of the SQLite data type documentation.
+*/
+static affinity_t decltype_affinity
+    (
+    char const * decltype
+    )
+{
+affinity_t affinity;
+
+if( NULL == decltype )
+    {
+    affinity = AFFINITY_NONE;
+    }
+else if( type_contains( decltype, "INT" ) )
+    {
+    affinity = AFFINITY_INTEGER;
+    }
+else if( type_contains( decltype, "CHAR" ) || type_contains( decltype, "CLOB" ) || type_contains( decltype, "TEXT" ) )
+    {
+    affinity = AFFINITY_TEXT;
+    }
+else if( ( '\0' == decltype[0] ) || type_contains( decltype, "BLOB" ) )
+    {
+    affinity = AFFINITY_NONE;
+    }
+else if( type_contains( decltype, "REAL" ) || type_contains( decltype, "FLOA" ) || type_contains( decltype, "DOUB" ) )
+    {
+    affinity = AFFINITY_REAL;
+    }
+else
+    {
+    affinity = AFFINITY_NUMERIC;
+    }
+
+return affinity;
+}
+
+
+/**
+* Bind model using parameter descriptors.
+*
+* Implements cqlite_row_bind_func_t for parameter descriptors. Every
+* model outlives its own execution, so strings are bound in place.
+*/
+static int mapping_row_bind
+    (
+    sqlite3_stmt *  query,
+    void const *    model,
+    void *          context
+    )
+{
+params_context_t * params_context;
+
+params_context = (params_context_t*)context;
+
+return ( CQLITE_SUCCESS == cqlite_mapping_params_bind( query, params_context->params, params_context->param_cnt, CQLITE_BIND_STATIC, model ) );
+}
+
+
+/**
+* Read model into list using column descriptors.
+*
+* Implements cqlite_row_read_func_t for column descriptors.
+*/
+static int mapping_row_read
+    (
+    sqlite3_stmt *  query,
+    void *          model_list,
+    int             next_model_list_idx,
+    void *          context
+    )
+{
+mapping_context_t * mapping_context;
+
+mapping_context = (mapping_context_t*)context;
+
+return ( CQLITE_SUCCESS == cqlite_mapping_row_read( query, mapping_context->columns, mapping_context->column_cnt, (char*)model_list + ( next_model_list_idx * mapping_context->model_size ) ) );
+}
+
+
+/**
+* Does declared type contain name?
+*
+* Case-insensitively searches the declared type for the provided
+* upper-case type name.
+*/
+static int type_contains
+    (
+    char const * decltype,
+    char const * name
+    )
+{
+size_t  name_len;
+int     contains = 0;
+
+name_len = strlen( name );
+
+for( ; ( !contains ) && ( '\0' != *decltype ); decltype++ )
+    {
+    contains = ( 0 == strncasecmp( decltype, name, name_len ) );
+    }
+
+return contains;
+}
@@ -0,0 +1,238 @@
+/** @file */
+
+#ifndef _CQLITE_MAPPING_H
+#define _CQLITE_MAPPING_H
+
+#include <stddef.h>
+#include <sqlite3.h>
+
+#include "cqlite.h"
+
+/**
+* Column descriptor initializer.
+*
+* Describes reading the specified result column into the specified field
+* of a model type, taking the field's offset and size from the model
+* type. For instance:
+*
+*       static cqlite_column_desc_t const MY_MODEL_COLUMNS[] =
+*           {
+*           CQLITE_COLUMN_DESC( 0, my_model_t, id,   CQLITE_FIELD_INT64 ),
+*           CQLITE_COLUMN_DESC( 1, my_model_t, name, CQLITE_FIELD_DYNAMIC_STRING ),
+*           };
+*/
+#define CQLITE_COLUMN_DESC( column, model_type, field, field_type ) \
+    { ( column ), offsetof( model_type, field ), ( field_type ), sizeof( ( (model_type*)0 )->field ) }
+
+/**
+* Parameter descriptor initializer.
+*
+* Describes binding the specified field of a model type to the specified
+* query parameter, starting at 1, taking the field's offset and size
+* from the model type. For instance:
+*
+*       static cqlite_param_desc_t const MY_MODEL_PARAMS[] =
+*           {
+*           CQLITE_PARAM_DESC( 1, my_model_t, name, CQLITE_FIELD_DYNAMIC_STRING ),
+*           CQLITE_PARAM_DESC( 2, my_model_t, id,   CQLITE_FIELD_INT64 ),
+*           };
+*/
+#define CQLITE_PARAM_DESC( param, model_type, field, field_type ) \
+    { ( param ), offsetof( model_type, field ), ( field_type ), sizeof( ( (model_type*)0 )->field ) }
+
+/**
+* Model field types.
+*/
+typedef enum
+    {
+    CQLITE_FIELD_INT,               //!< int
+    CQLITE_FIELD_INT64,             //!< sqlite_int64
+    CQLITE_FIELD_DOUBLE,            //!< double
+    CQLITE_FIELD_DYNAMIC_STRING,    //!< char *, allocated with malloc() and NULL for NULL results
+    CQLITE_FIELD_FIXED_STRING,      //!< char[size], empty for NULL results
+    } cqlite_field_type_t;
+
+/**
+* Column descriptor.
+*
+* Describes how a single result column is read into a model field.
+* Usually initialized with CQLITE_COLUMN_DESC().
+*/
+typedef struct
+    {
+    int                 column; //!< Index of the result column
+    size_t              offset; //!< Offset of the field within the model, from offsetof()
+    cqlite_field_type_t type;   //!< Type of the field
+    size_t              size;   //!< Size of the field, only used by CQLITE_FIELD_FIXED_STRING
+    } cqlite_column_desc_t;
+
+/**
+* String binding modes.
+*/
+typedef enum
+    {
+    CQLITE_BIND_TRANSIENT,  //!< Strings are copied by SQLite when bound
+    CQLITE_BIND_STATIC,     //!< Strings are bound in place, and must not change until the query is reset and rebound or finalized
+    } cqlite_bind_mode_t;
+
+/**
+* Parameter descriptor.
+*
+* Describes how a single model field is bound to a query parameter.
+* Usually initialized with CQLITE_PARAM_DESC().
+*/
+typedef struct
+    {
+    int                 param;  //!< Index of the query parameter, starting at 1
+    size_t              offset; //!< Offset of the field within the model, from offsetof()
+    cqlite_field_type_t type;   //!< Type of the field
+    size_t              size;   //!< Size of the field, only used by CQLITE_FIELD_FIXED_STRING
+    } cqlite_param_desc_t;
+
+/**
+* Check column descriptors against query.
+*
+* Ensures every described column exists in the results of the provided
+* query and that the declared type of each column, if any, can be read
+* into the described field type without losing data, e.g. that a TEXT
+* column is not read into an integer field. Columns that are expressions
+* rather than table columns have no declared type and always pass.
+*/
+cqlite_rcode_t cqlite_mapping_columns_check
+    (
+    sqlite3_stmt *                  query,      //!< Prepared query
+    cqlite_column_desc_t const *    columns,    //!< Column descriptors
+    int                             column_cnt  //!< Number of column descriptors
+    );
+
+/**
+* Insert many models using parameter descriptors.
+*
+* Same as cqlite_insert_many(), except that each model is bound to the
+* INSERT query using the provided parameter descriptors rather than a
+* bind function. Since every model outlives its own execution, strings
+* are always bound in place without being copied.
+*/
+cqlite_rcode_t cqlite_mapping_insert_many
+    (
+    sqlite3 *                   db,                 //!< Database on which to execute the query
+    char const * const          insert_query_str,   //!< INSERT query string taking the model's parameters
+    cqlite_param_desc_t const * params,             //!< Parameter descriptors
+    int                         param_cnt,          //!< Number of parameter descriptors
+    void const *                model_list,         //!< List of models to insert
+    size_t                      model_size,         //!< Size of the model type
+    int                         model_list_cnt,     //!< Number of models to insert
+    int                         batch_size,         //!< Number of models inserted per transaction
+    sqlite_int64 **             row_ids_out         //!< (out) Generated row id of each model, caller must free, may be NULL
+    );
+
+/**
+* Insert many models using prepared query and parameter descriptors.
+*
+* The bindings of the query are cleared afterwards so that it holds no
+* pointers to the models.
+*
+* @see cqlite_mapping_insert_many()
+*/
+cqlite_rcode_t cqlite_mapping_insert_many_prepared
+    (
+    sqlite3 *                   db,                 //!< Database on which to execute the query
+    sqlite3_stmt *              insert_query,       //!< Prepared INSERT query
+    cqlite_param_desc_t const * params,             //!< Parameter descriptors
+    int                         param_cnt,          //!< Number of parameter descriptors
+    void const *                model_list,         //!< List of models to insert
+    size_t                      model_size,         //!< Size of the model type
+    int                         model_list_cnt,     //!< Number of models to insert
+    int                         batch_size,         //!< Number of models inserted per transaction
+    sqlite_int64 **             row_ids_out         //!< (out) Generated row id of each model, caller must free, may be NULL
+    );
+
+/**
+* Free model using column descriptors.
+*
+* Frees the dynamic strings of the provided model described by the
+* column descriptors without freeing the model itself.
+*/
+void cqlite_mapping_model_free
+    (
+    cqlite_column_desc_t const *    columns,    //!< Column descriptors
+    int                             column_cnt, //!< Number of column descriptors
+    void *                          model       //!< Model whose memory is freed
+    );
+
+/**
+* Bind model using parameter descriptors.
+*
+* Binds the described fields of the provided model to the parameters
+* of a prepared INSERT, UPDATE or lookup query in a single call.
+* Dynamic strings that are NULL are bound as NULL, and fixed strings
+* are bound up to their terminator or the end of the field.
+*
+* With CQLITE_BIND_STATIC, strings are bound without being copied, so
+* the caller must keep the model's strings unchanged until the query is
+* reset and rebound or finalized. Use CQLITE_BIND_TRANSIENT otherwise.
+*/
+cqlite_rcode_t cqlite_mapping_params_bind
+    (
+    sqlite3_stmt *              query,      //!< Prepared query
+    cqlite_param_desc_t const * params,     //!< Parameter descriptors
+    int                         param_cnt,  //!< Number of parameter descriptors
+    cqlite_bind_mode_t          bind_mode,  //!< How strings are bound
+    void const *                model       //!< Model whose fields are bound
+    );
+
+/**
+* Read model from row result using column descriptors.
+*
+* Reads the current row result of the provided query into model_out,
+* which must be all zeros. Unlike cqlite_dynamic_string_read() and
+* cqlite_fixed_length_string_read(), string fields accept results of any
+* type using SQLite's conversion to text, so that the type of each
+* result does not need to be checked. Use cqlite_mapping_columns_check()
+* once per query to guard against mismatched columns instead.
+*/
+cqlite_rcode_t cqlite_mapping_row_read
+    (
+    sqlite3_stmt *                  query,      //!< Query pointing at row result
+    cqlite_column_desc_t const *    columns,    //!< Column descriptors
+    int                             column_cnt, //!< Number of column descriptors
+    void *                          model_out   //!< (out) Model populated from row result
+    );
+
+/**
+* Execute SELECT query using column descriptors.
+*
+* Same as cqlite_select_query_execute(), except that each result is read
+* into a model using the provided column descriptors rather than an add
+* to list function. The columns are checked once with
+* cqlite_mapping_columns_check() before any result is read.
+*/
+cqlite_rcode_t cqlite_mapping_select_query_execute
+    (
+    sqlite3 *                       db,                 //!< Database on which to execute the query
+    char const * const              select_query_str,   //!< Parameter-less SELECT query string
+    char const * const              count_query_str,    //!< Parameter-less COUNT query string, NULL for single pass
+    cqlite_column_desc_t const *    columns,            //!< Column descriptors
+    int                             column_cnt,         //!< Number of column descriptors
+    size_t                          model_size,         //!< Size of the model type
+    void **                         model_list_out,     //!< (out) List of models read from query, caller must free
+    int *                           model_list_cnt_out  //!< (out) Number of models read from query
+    );
+
+/**
+* Execute prepared SELECT query using column descriptors.
+*
+* @see cqlite_mapping_select_query_execute()
+*/
+cqlite_rcode_t cqlite_mapping_select_query_execute_prepared
+    (
+    sqlite3_stmt *                  select_query,       //!< Prepared SELECT query
+    sqlite3_stmt *                  count_query,        //!< Prepared COUNT query, NULL for single pass
+    cqlite_column_desc_t const *    columns,            //!< Column descriptors
+    int                             column_cnt,         //!< Number of column descriptors
+    size_t                          model_size,         //!< Size of the model type
+    void **                         model_list_out,     //!< (out) List of models read from query, caller must free
+    int *                           model_list_cnt_out  //!< (out) Number of models read from query
+    );
+
+#endif
@@ -0,0 +1,336 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "cqlite_open.h"
+#include "cqlite_private.h"
+
+#define READ_TO_END                 ( -1 )
+#define NO_TAIL                     ( NULL )
+#define NO_CALLBACK                 ( NULL )
+#define NO_CALLBACK_PARAM           ( NULL )
+#define NO_ERROR_MESSAGE            ( NULL )
+#define NO_VFS                      ( NULL )
+#define ALL_DATABASES               ( NULL )
+#define NO_FRAME_COUNTS             ( NULL )
+#define BUSY_TIMEOUT_MS             ( 5000 )
+#define CHECKPOINT_BUSY_TIMEOUT_MS  ( 100 )
+#define NS_PER_SEC                  ( 1000000000L )
+#define NS_PER_MS                   ( 1000000L )
+
+
+/**********************************************
+Types
+**********************************************/
+struct cqlite_checkpointer_s
+    {
+    sqlite3 *                   db;                 //!< Checkpointer's connection
+    sqlite3_stmt *              data_version_query; //!< Query returning the database's data version
+    char const *                wal_path;           //!< Path of the WAL file, owned by the connection
+    cqlite_checkpoint_config_t  config;             //!< Checkpointer configuration
+    pthread_t                   thread;             //!< Checkpointer's thread
+    int                         is_thread_started;  //!< Was the checkpointer's thread created?
+    int                         is_closing;         //!< Is the checkpointer being closed?
+    pthread_mutex_t             mutex;              //!< Protects is_closing
+    pthread_cond_t              cond;               //!< Signaled when the checkpointer is closing
+    };
+
+
+/**********************************************
+Variables
+**********************************************/
+
+// Pragmas of each profile. The page size must be set before switching
+// to WAL mode for it to apply to a new database.
+static char const * const PROFILE_PRAGMAS[CQLITE_PROFILE_CNT] =
+    {
+    [CQLITE_PROFILE_READ_HEAVY] =
+        "PRAGMA page_size=4096;"
+        "PRAGMA journal_mode=WAL;"
+        "PRAGMA synchronous=NORMAL;"
+        "PRAGMA mmap_size=268435456;"
+        "PRAGMA cache_size=-65536;"
+        "PRAGMA temp_store=MEMORY;"
+        "PRAGMA wal_autocheckpoint=1000;",
+
+    [CQLITE_PROFILE_WRITE_HEAVY] =
+        "PRAGMA page_size=4096;"
+        "PRAGMA journal_mode=WAL;"
+        "PRAGMA synchronous=NORMAL;"
+        "PRAGMA mmap_size=268435456;"
+        "PRAGMA cache_size=-32768;"
+        "PRAGMA temp_store=MEMORY;"
+        "PRAGMA wal_autocheckpoint=0;",
+
+    // Index builds after a bulk load sort more than fits in memory
+    [CQLITE_PROFILE_DURABLE_BULK_LOAD] =
+        "PRAGMA page_size=8192;"
+        "PRAGMA journal_mode=WAL;"
+        "PRAGMA synchronous=FULL;"
+        "PRAGMA mmap_size=268435456;"
+        "PRAGMA cache_size=-131072;"
+        "PRAGMA temp_store=FILE;"
+        "PRAGMA wal_autocheckpoint=0;",
+    };
+
+
+/**********************************************
+Functions
+**********************************************/
+static void * checkpointer_thread
+    (
+    void * args
+    );
+
+static int checkpointer_wait
+    (
+    cqlite_checkpointer_t * checkpointer
+    );
+
+static sqlite_int64 now_ns
+    (
+    void
+    );
+
+
+// Close checkpointer.
+void cqlite_checkpointer_close
+    (
+    cqlite_checkpointer_t * checkpointer    //!< Checkpointer to close
+    )
+{
+if( NULL != checkpointer )
+    {
+    if( checkpointer->is_thread_started )
+        {
+        pthread_mutex_lock( &checkpointer->mutex );
+        checkpointer->is_closing = 1;
+        pthread_cond_signal( &checkpointer->cond );
+        pthread_mutex_unlock( &checkpointer->mutex );
+
+        pthread_join( checkpointer->thread, NULL );
+        }
+
+    sqlite3_finalize( checkpointer->data_version_query );
+    sqlite3_close( checkpointer->db );
+
+    pthread_mutex_destroy( &checkpointer->mutex );
+    pthread_cond_destroy( &checkpointer->cond );
+
+    free( checkpointer );
+    }
+}
+
+
+// Open checkpointer.
+cqlite_rcode_t cqlite_checkpointer_open
+    (
+    char const * const                  path,               //!< Path of the database file
+    cqlite_checkpoint_config_t const *  config,             //!< Checkpointer configuration
+    cqlite_checkpointer_t **            checkpointer_out    //!< (out) Checkpointer, caller must close
+    )
+{
+cqlite_rcode_t          rcode = CQLITE_ERROR;
+int                     success;
+cqlite_checkpointer_t * checkpointer;
+
+*checkpointer_out = NULL;
+
+checkpointer = calloc( 1, sizeof( *checkpointer ) );
+success = ( NULL != checkpointer ) && ( config->poll_interval_ms > 0 );
+
+if( NULL != checkpointer )
+    {
+    pthread_mutex_init( &checkpointer->mutex, NULL );
+    pthread_cond_init( &checkpointer->cond, NULL );
+    }
+
+// Only the checkpointer's thread uses the connection after this, so
+// it is opened without SQLite's per-connection mutex.
+if( success )
+    {
+    checkpointer->config = *config;
+
+    success = ( SQLITE_OK == sqlite3_open_v2( path, &checkpointer->db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, NO_VFS ) ) &&
+              ( SQLITE_OK == sqlite3_busy_timeout( checkpointer->db, CHECKPOINT_BUSY_TIMEOUT_MS ) ) &&
+              ( SQLITE_OK == sqlite3_prepare_v2( checkpointer->db, "PRAGMA data_version;", READ_TO_END, &checkpointer->data_version_query, NO_TAIL ) );
+    }
+
+if( success )
+    {
+    checkpointer->wal_path = sqlite3_filename_wal( sqlite3_db_filename( checkpointer->db, "main" ) );
+    success = ( NULL != checkpointer->wal_path );
+    }
+
+if( success )
+    {
+    success = ( 0 == pthread_create( &checkpointer->thread, NULL, checkpointer_thread, checkpointer ) );
+    checkpointer->is_thread_started = success;
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    *checkpointer_out = checkpointer;
+    }
+else
+    {
+    cqlite_checkpointer_close( checkpointer );
+    }
+
+return rcode;
+}
+
+
+// Open database with profile.
+cqlite_rcode_t cqlite_open
+    (
+    char const * const  path,       //!< Path of the database file
+    cqlite_profile_t    profile,    //!< Profile to configure the connection for
+    sqlite3 **          db_out      //!< (out) Database handle, caller must close
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+sqlite3 *       db = NULL;
+
+*db_out = NULL;
+
+success = ( profile >= 0 ) && ( profile < CQLITE_PROFILE_CNT ) &&
+          ( SQLITE_OK == sqlite3_open_v2( path, &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NO_VFS ) ) &&
+          ( SQLITE_OK == sqlite3_busy_timeout( db, BUSY_TIMEOUT_MS ) ) &&
+          ( SQLITE_OK == sqlite3_exec( db, PROFILE_PRAGMAS[profile], NO_CALLBACK, NO_CALLBACK_PARAM, NO_ERROR_MESSAGE ) ) &&
+          cqlite_journal_mode_is_wal( db );
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    *db_out = db;
+    }
+else
+    {
+    sqlite3_close( db );
+    }
+
+return rcode;
+}
+
+
+/**
+* Checkpointer's thread.
+*
+* Tracks commits through the data version, which changes whenever
+* another connection commits, and checkpoints the WAL accordingly until
+* the checkpointer is closed.
+*/
+static void * checkpointer_thread
+    (
+    void * args
+    )
+{
+cqlite_checkpointer_t * checkpointer;
+int                     is_dirty = 0;
+sqlite_int64            data_version;
+sqlite_int64            last_version = -1;
+sqlite_int64            checkpointed_version = -1;
+sqlite_int64            last_commit_ns = 0;
+sqlite_int64            current_ns;
+struct stat             wal_stat;
+
+checkpointer = (cqlite_checkpointer_t*)args;
+
+// The first look always counts as a commit so that a WAL left behind
+// by earlier connections is truncated once the database is idle.
+while( checkpointer_wait( checkpointer ) )
+    {
+    current_ns = now_ns();
+
+    if( SQLITE_ROW == sqlite3_step( checkpointer->data_version_query ) )
+        {
+        data_version = sqlite3_column_int64( checkpointer->data_version_query, 0 );
+
+        if( data_version != last_version )
+            {
+            last_version = data_version;
+            last_commit_ns = current_ns;
+            is_dirty = 1;
+            }
+        }
+
+    sqlite3_reset( checkpointer->data_version_query );
+
+    if( is_dirty && ( ( current_ns - last_commit_ns ) >= ( checkpointer->config.idle_ms * NS_PER_MS ) ) )
+        {
+        // Stay dirty if readers or a writer kept the WAL from being reset
+        is_dirty = ( SQLITE_OK != sqlite3_wal_checkpoint_v2( checkpointer->db, ALL_DATABASES, SQLITE_CHECKPOINT_TRUNCATE, NO_FRAME_COUNTS, NO_FRAME_COUNTS ) );
+        }
+    else if( is_dirty &&
+             ( checkpointed_version != last_version ) &&
+             ( 0 == stat( checkpointer->wal_path, &wal_stat ) ) &&
+             ( wal_stat.st_size > checkpointer->config.wal_size_limit ) )
+        {
+        sqlite3_wal_checkpoint_v2( checkpointer->db, ALL_DATABASES, SQLITE_CHECKPOINT_PASSIVE, NO_FRAME_COUNTS, NO_FRAME_COUNTS );
+        checkpointed_version = last_version;
+        }
+    }
+
+return NULL;
+}
+
+
+/**
+* Wait for next poll.
+*
+* Blocks the checkpointer's thread for the poll interval. Returns 0 if
+* the checkpointer is closing, 1 otherwise.
+*/
+static int checkpointer_wait
+    (
+    cqlite_checkpointer_t * checkpointer
+    )
+{
+int             rc = 0;
+int             is_closing;
+struct timespec deadline;
+
+clock_gettime( CLOCK_REALTIME, &deadline );
+deadline.tv_sec += checkpointer->config.poll_interval_ms / 1000;
+deadline.tv_nsec += ( checkpointer->config.poll_interval_ms % 1000 ) * NS_PER_MS;
+
+if( deadline.tv_nsec >= NS_PER_SEC )
+    {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= NS_PER_SEC;
+    }
+
+pthread_mutex_lock( &checkpointer->mutex );
+
+while( !checkpointer->is_closing && ( ETIMEDOUT != rc ) )
+    {
+    rc = pthread_cond_timedwait( &checkpointer->cond, &checkpointer->mutex, &deadline );
+    }
+
+is_closing = checkpointer->is_closing;
+
+pthread_mutex_unlock( &checkpointer->mutex );
+
+return !is_closing;
+}
+
+
+/**
+* Get monotonic time in nanoseconds.
+*/
+static sqlite_int64 now_ns
+    (
+    void
+    )
+{
+struct timespec now;
+
+clock_gettime( CLOCK_MONOTONIC, &now );
+
+return ( (sqlite_int64)now.tv_sec * NS_PER_SEC ) + now.tv_nsec;
+}
@@ -0,0 +1,107 @@
+/** @file */
+
+#ifndef _CQLITE_OPEN_H
+#define _CQLITE_OPEN_H
+
+#include <sqlite3.h>
+
+#include "cqlite.h"
+
+/**
+* Connection profile.
+*
+* Selects the pragmas applied by cqlite_open(). Every profile puts the
+* database in WAL mode. The page size only takes effect on a new
+* database.
+*/
+typedef enum
+    {
+    CQLITE_PROFILE_READ_HEAVY,          //!< Large cache and memory map, synchronous=NORMAL, automatic checkpoints on commit
+    CQLITE_PROFILE_WRITE_HEAVY,         //!< synchronous=NORMAL, no automatic checkpoints
+    CQLITE_PROFILE_DURABLE_BULK_LOAD,   //!< Larger pages and cache, synchronous=FULL, no automatic checkpoints
+
+    CQLITE_PROFILE_CNT
+    } cqlite_profile_t;
+
+/**
+* Checkpointer.
+*
+* Owns a connection to one database file in WAL mode and a thread that
+* checkpoints the WAL in the background, so that commits on other
+* connections never pay for a checkpoint. Meant for databases opened
+* with profiles that turn off automatic checkpoints.
+*/
+typedef struct cqlite_checkpointer_s cqlite_checkpointer_t;
+
+/**
+* Checkpointer configuration.
+*/
+typedef struct
+    {
+    int             poll_interval_ms;   //!< Time between looks at the database
+    int             idle_ms;            //!< Time without commits after which the WAL is checkpointed and truncated
+    sqlite_int64    wal_size_limit;     //!< WAL file size in bytes above which new commits are checkpointed passively
+    } cqlite_checkpoint_config_t;
+
+/**
+* Close checkpointer.
+*
+* Stops the checkpointer's thread, closes its connection, and frees the
+* checkpointer.
+*/
+void cqlite_checkpointer_close
+    (
+    cqlite_checkpointer_t * checkpointer    //!< Checkpointer to close
+    );
+
+/**
+* Open checkpointer.
+*
+* Opens a connection to the database file at the provided path and
+* starts the checkpointer's thread. Every poll interval, the thread
+* checks whether other connections have committed since it last looked.
+*
+* Once the database has had no commits for idle_ms, the WAL is
+* checkpointed into the database and truncated. Such a TRUNCATE
+* checkpoint briefly blocks writers, which is why it waits for the
+* database to go idle, and it is retried later if readers are still
+* using the WAL.
+*
+* While commits keep coming and the WAL file is larger than
+* wal_size_limit, the WAL is checkpointed passively after each poll
+* that saw new commits. PASSIVE checkpoints never block readers or
+* writers, but cannot shrink the WAL file.
+*
+* The caller must call cqlite_checkpointer_close() on checkpointer_out.
+*/
+cqlite_rcode_t cqlite_checkpointer_open
+    (
+    char const * const                  path,               //!< Path of the database file
+    cqlite_checkpoint_config_t const *  config,             //!< Checkpointer configuration
+    cqlite_checkpointer_t **            checkpointer_out    //!< (out) Checkpointer, caller must close
+    );
+
+/**
+* Open database with profile.
+*
+* Opens the database file at the provided path, creating it if needed,
+* and configures the connection for the provided profile. The
+* journal_mode, synchronous, mmap_size, cache_size, temp_store,
+* page_size and wal_autocheckpoint pragmas are set, along with a busy
+* timeout. The caller must call sqlite3_close() on db_out.
+*
+* Fails if the database cannot be put in WAL mode, as for in-memory
+* databases or on file systems without shared memory support.
+*
+* Profiles without automatic checkpoints should be paired with a
+* cqlite_checkpointer_t on the same file, or the WAL grows without
+* bound.
+*/
+cqlite_rcode_t cqlite_open
+    (
+    char const * const  path,       //!< Path of the database file
+    cqlite_profile_t    profile,    //!< Profile to configure the connection for
+    sqlite3 **          db_out      //!< (out) Database handle, caller must close
+    );
+
+#endif
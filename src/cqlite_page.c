@@ -0,0 +1,270 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "cqlite_page.h"
+#include "cqlite_private.h"
+
+#define READ_TO_END         ( -1 )
+#define NO_TAIL             ( NULL )
+#define PAGE_SIZE_PARAM     ( 1 )
+#define LAST_KEY_PARAM      ( 2 )
+
+
+/**********************************************
+Types
+**********************************************/
+struct cqlite_page_token_s
+    {
+    sqlite3_value * last_key;   //!< Key of the last row of the page
+    };
+
+struct cqlite_page_s
+    {
+    sqlite3_stmt *  first_query;    //!< Query reading the first page
+    sqlite3_stmt *  next_query;     //!< Query reading the page after a key
+    int             key_column;     //!< Index of the key column in the results
+    int             page_size;      //!< Maximum number of models per page
+    };
+
+typedef struct
+    {
+    cqlite_model_add_to_list_func_t add_to_list_func;   //!< Caller's add model to list function
+    int                             key_column;         //!< Index of the key column in the results
+    int                             last_idx;           //!< Index of the last row of a full page
+    sqlite3_value *                 last_key;           //!< Key of the last row of a full page
+    } page_read_context_t;
+
+
+/**********************************************
+Functions
+**********************************************/
+static int page_row_read
+    (
+    sqlite3_stmt *  query,
+    void *          model_list,
+    int             next_model_list_idx,
+    void *          context
+    );
+
+
+// Create keyset pager.
+cqlite_rcode_t cqlite_page_create
+    (
+    sqlite3 *           db,                 //!< Database on which to execute the queries
+    char const * const  base_query_str,     //!< Parameter-less SELECT query string
+    char const * const  key_column_name,    //!< Name of the unique key column of the results
+    int                 is_descending,      //!< Order pages by descending keys?
+    int                 page_size,          //!< Maximum number of models per page
+    cqlite_page_t **    page_out            //!< (out) Keyset pager, caller must free
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+int             base_len;
+int             column_cnt;
+int             i;
+char *          first_query_str = NULL;
+char *          next_query_str = NULL;
+char const *    direction;
+char const *    comparison;
+cqlite_page_t * page;
+sqlite_int64    prepare_start_ns;
+
+*page_out = NULL;
+
+page = calloc( 1, sizeof( *page ) );
+success = ( NULL != page ) && ( page_size > 0 );
+
+// The base query is wrapped in a subquery that SQLite flattens into
+// it, so the key comparison still seeks the key's index.
+if( success )
+    {
+    page->page_size = page_size;
+    page->key_column = -1;
+
+    base_len = (int)strlen( base_query_str );
+
+    while( ( base_len > 0 ) && ( ( ';' == base_query_str[base_len - 1] ) || isspace( (unsigned char)base_query_str[base_len - 1] ) ) )
+        {
+        base_len--;
+        }
+
+    direction = is_descending ? "DESC" : "ASC";
+    comparison = is_descending ? "<" : ">";
+
+    first_query_str = sqlite3_mprintf( "SELECT * FROM ( %.*s ) ORDER BY \"%w\" %s LIMIT ?%d;",
+                                       base_len, base_query_str, key_column_name, direction, PAGE_SIZE_PARAM );
+    next_query_str = sqlite3_mprintf( "SELECT * FROM ( %.*s ) WHERE \"%w\" %s ?%d ORDER BY \"%w\" %s LIMIT ?%d;",
+                                      base_len, base_query_str, key_column_name, comparison, LAST_KEY_PARAM, key_column_name, direction, PAGE_SIZE_PARAM );
+    success = ( NULL != first_query_str ) && ( NULL != next_query_str );
+    }
+
+if( success )
+    {
+    prepare_start_ns = cqlite_stats_prepare_begin();
+    success = ( SQLITE_OK == sqlite3_prepare_v3( db, first_query_str, READ_TO_END, SQLITE_PREPARE_PERSISTENT, &page->first_query, NO_TAIL ) ) &&
+              ( SQLITE_OK == sqlite3_prepare_v3( db, next_query_str, READ_TO_END, SQLITE_PREPARE_PERSISTENT, &page->next_query, NO_TAIL ) );
+    cqlite_stats_prepare_end( CQLITE_STATS_API_SELECT, prepare_start_ns );
+    }
+
+// Find the key among the result columns
+if( success )
+    {
+    column_cnt = sqlite3_column_count( page->first_query );
+
+    for( i = 0; ( i < column_cnt ) && ( -1 == page->key_column ); i++ )
+        {
+        if( 0 == strcasecmp( key_column_name, sqlite3_column_name( page->first_query, i ) ) )
+            {
+            page->key_column = i;
+            }
+        }
+
+    success = ( -1 != page->key_column );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    *page_out = page;
+    }
+else
+    {
+    cqlite_page_free( page );
+    }
+
+// Clean up
+sqlite3_free( first_query_str );
+sqlite3_free( next_query_str );
+
+return rcode;
+}
+
+
+// Free keyset pager.
+void cqlite_page_free
+    (
+    cqlite_page_t * page    //!< Keyset pager to free, may be NULL
+    )
+{
+if( NULL != page )
+    {
+    sqlite3_finalize( page->first_query );
+    sqlite3_finalize( page->next_query );
+    free( page );
+    }
+}
+
+
+// Read page.
+cqlite_rcode_t cqlite_page_read
+    (
+    cqlite_page_t *                 page,               //!< Keyset pager
+    cqlite_page_token_t const *     token,              //!< Token of the previous page, NULL for the first page
+    cqlite_model_add_to_list_func_t add_to_list_func,   //!< Add model to list function pointer
+    size_t                          model_size,         //!< Size of the model type
+    void **                         model_list_out,     //!< (out) List of models read from the page, caller must free
+    int *                           model_list_cnt_out, //!< (out) Number of models read from the page
+    cqlite_page_token_t **          token_out           //!< (out) Token of the next page, NULL after the last page
+    )
+{
+cqlite_rcode_t          rcode = CQLITE_ERROR;
+int                     success;
+sqlite3_stmt *          query;
+cqlite_page_token_t *   next_token = NULL;
+page_read_context_t     context;
+
+*model_list_out = NULL;
+*model_list_cnt_out = 0;
+*token_out = NULL;
+
+context.add_to_list_func = add_to_list_func;
+context.key_column = page->key_column;
+context.last_idx = page->page_size - 1;
+context.last_key = NULL;
+
+query = ( NULL == token ) ? page->first_query : page->next_query;
+
+sqlite3_reset( query );
+sqlite3_clear_bindings( query );
+
+success = ( SQLITE_OK == sqlite3_bind_int( query, PAGE_SIZE_PARAM, page->page_size ) ) &&
+          ( ( NULL == token ) || ( SQLITE_OK == sqlite3_bind_value( query, LAST_KEY_PARAM, token->last_key ) ) );
+
+if( success )
+    {
+    success = ( CQLITE_SUCCESS == cqlite_select_rows_read( query, NULL, page_row_read, &context, model_size, model_list_out, model_list_cnt_out ) );
+    }
+
+// Only a full page may be followed by another
+if( success && ( NULL != context.last_key ) )
+    {
+    next_token = malloc( sizeof( *next_token ) );
+    success = ( NULL != next_token );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+
+    if( NULL != next_token )
+        {
+        next_token->last_key = context.last_key;
+        context.last_key = NULL;
+        *token_out = next_token;
+        }
+    }
+
+// Clean up
+sqlite3_value_free( context.last_key );
+sqlite3_reset( query );
+
+return rcode;
+}
+
+
+// Free page continuation token.
+void cqlite_page_token_free
+    (
+    cqlite_page_token_t * token //!< Token to free, may be NULL
+    )
+{
+if( NULL != token )
+    {
+    sqlite3_value_free( token->last_key );
+    free( token );
+    }
+}
+
+
+/**
+* Read page row.
+*
+* Reads the row with the caller's function, and keeps a copy of the key
+* of the last row of a full page for the next page's token.
+*/
+static int page_row_read
+    (
+    sqlite3_stmt *  query,
+    void *          model_list,
+    int             next_model_list_idx,
+    void *          context
+    )
+{
+int                     success;
+page_read_context_t *   page_context;
+
+page_context = (page_read_context_t*)context;
+
+success = page_context->add_to_list_func( query, model_list, next_model_list_idx );
+
+if( success && ( next_model_list_idx == page_context->last_idx ) )
+    {
+    page_context->last_key = sqlite3_value_dup( sqlite3_column_value( query, page_context->key_column ) );
+    success = ( NULL != page_context->last_key ) && ( SQLITE_NULL != sqlite3_value_type( page_context->last_key ) );
+    }
+
+return success;
+}
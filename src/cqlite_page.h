@@ -0,0 +1,95 @@
+/** @file */
+
+#ifndef _CQLITE_PAGE_H
+#define _CQLITE_PAGE_H
+
+#include <sqlite3.h>
+
+#include "cqlite.h"
+
+/**
+* Keyset pager.
+*
+* Reads the results of a base SELECT query in pages ordered by a unique
+* key column. Each page after the first seeks past the last key of the
+* previous page with WHERE key > ? instead of skipping rows with OFFSET,
+* so every page costs the same no matter how deep it is, and no COUNT
+* query is needed. A pager must only be used by one thread at a time,
+* just like its connection.
+*/
+typedef struct cqlite_page_s cqlite_page_t;
+
+/**
+* Page continuation token.
+*
+* Opaque position after the last row of a page, from which the next page
+* resumes. Tokens do not reference their pager and may outlive it.
+*/
+typedef struct cqlite_page_token_s cqlite_page_token_t;
+
+/**
+* Create keyset pager.
+*
+* The base query is a SELECT query without ORDER BY or LIMIT clauses,
+* optionally ending with a semicolon. The key column must be a column of
+* its results that is unique and never NULL, such as the INTEGER PRIMARY
+* KEY or a rowid selected as a named column, and should be indexed so
+* that each page is found with a seek. For instance:
+*
+*       "SELECT rowid AS row_id, * FROM my_table WHERE my_column = 7;"
+*
+* with "row_id" as the key column. Pages are ordered by ascending keys,
+* or descending keys if is_descending is set. The caller must call
+* cqlite_page_free() on page_out.
+*/
+cqlite_rcode_t cqlite_page_create
+    (
+    sqlite3 *           db,                 //!< Database on which to execute the queries
+    char const * const  base_query_str,     //!< Parameter-less SELECT query string
+    char const * const  key_column_name,    //!< Name of the unique key column of the results
+    int                 is_descending,      //!< Order pages by descending keys?
+    int                 page_size,          //!< Maximum number of models per page
+    cqlite_page_t **    page_out            //!< (out) Keyset pager, caller must free
+    );
+
+/**
+* Free keyset pager.
+*/
+void cqlite_page_free
+    (
+    cqlite_page_t * page    //!< Keyset pager to free, may be NULL
+    );
+
+/**
+* Read page.
+*
+* Reads the page that follows the provided token, or the first page if
+* the token is NULL, into a newly allocated model list as by
+* cqlite_select_query_execute() in single-pass mode.
+*
+* If the page is full, token_out is set to a new token from which the
+* next page resumes, otherwise it is set to NULL since there are no
+* more pages. A full last page is followed by an empty page. The
+* caller must call cqlite_page_token_free() on token_out, and is
+* responsible for model_list_out as with cqlite_select_query_execute().
+*/
+cqlite_rcode_t cqlite_page_read
+    (
+    cqlite_page_t *                 page,               //!< Keyset pager
+    cqlite_page_token_t const *     token,              //!< Token of the previous page, NULL for the first page
+    cqlite_model_add_to_list_func_t add_to_list_func,   //!< Add model to list function pointer
+    size_t                          model_size,         //!< Size of the model type
+    void **                         model_list_out,     //!< (out) List of models read from the page, caller must free
+    int *                           model_list_cnt_out, //!< (out) Number of models read from the page
+    cqlite_page_token_t **          token_out           //!< (out) Token of the next page, NULL after the last page
+    );
+
+/**
+* Free page continuation token.
+*/
+void cqlite_page_token_free
+    (
+    cqlite_page_token_t * token //!< Token to free, may be NULL
+    );
+
+#endif
@@ -0,0 +1,865 @@
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cqlite_parallel.h"
+#include "cqlite_stmt_cache.h"
+
+#define NO_CALLBACK         ( NULL )
+#define NO_CALLBACK_PARAM   ( NULL )
+#define NO_ERROR_MESSAGE    ( NULL )
+#define FIRST_KEY_PARAM     ( 1 )
+#define LAST_KEY_PARAM      ( 2 )
+#define MIN_KEY_COL         ( 0 )
+#define MAX_KEY_COL         ( 1 )
+
+
+/**********************************************
+Types
+**********************************************/
+typedef struct parallel_run_s parallel_run_t;
+
+/**
+* Partition read function type.
+*
+* Reads the key range of a single partition on the provided connection,
+* which is inside a read transaction shared by all partitions. Functions
+* that call parallel_barrier_wait() must do so the same number of times
+* whether or not they succeed, or the other partitions will hang.
+*/
+typedef int (*partition_read_func_t)
+    (
+    cqlite_stmt_cache_t *   stmt_cache,     //!< Statement cache of the partition's connection
+    int                     partition_idx,  //!< Index of the partition
+    int                     is_empty,       //!< Is the key range empty?
+    sqlite_int64            first_key,      //!< First key of the range
+    sqlite_int64            last_key,       //!< Last key of the range
+    void *                  context         //!< Context of the run
+    );
+
+typedef struct
+    {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    int             thread_cnt;     //!< Number of threads that must arrive
+    int             arrived_cnt;    //!< Number of threads that have arrived
+    unsigned int    generation;     //!< Incremented each time all threads arrive
+    } barrier_t;
+
+struct parallel_run_s
+    {
+    cqlite_pool_t *         pool;               //!< Connection pool
+    char const *            bounds_query_str;   //!< Query returning the smallest and largest key
+    partition_read_func_t   read_func;          //!< Function reading a partition
+    void *                  context;            //!< Context passed to read_func
+    int                     partition_cnt;      //!< Number of partitions, one per worker thread
+    int                     is_started;         //!< Have all worker threads been created?
+    pthread_mutex_t         start_mutex;        //!< Protects is_started
+    pthread_cond_t          start_cond;         //!< Signaled once all worker threads are created
+    barrier_t               partition_barrier;  //!< Available to read_func for synchronizing partitions
+    atomic_int              failed;             //!< Has any partition failed?
+    };
+
+typedef struct
+    {
+    parallel_run_t *        run;
+    int                     partition_idx;
+    cqlite_pool_conn_t *    conn;           //!< Read connection of the partition
+    int                     is_begun;       //!< Were the read transaction started and the bounds read?
+    int                     is_empty;       //!< Are there no keys to split?
+    sqlite_int64            min_key;        //!< Smallest key of the bounds
+    sqlite_int64            max_key;        //!< Largest key of the bounds
+    } partition_args_t;
+
+typedef struct
+    {
+    char const *        select_query_str;
+    cqlite_fold_func_t  fold_func;
+    size_t              accumulator_size;
+    void *              accumulators;   //!< Accumulator of each partition
+    } fold_context_t;
+
+typedef struct
+    {
+    parallel_run_t *                run;
+    char const *                    select_query_str;
+    char const *                    count_query_str;
+    cqlite_model_add_to_list_func_t add_to_list_func;
+    size_t                          model_size;
+    int *                           model_cnts;     //!< Number of models in each partition
+    int *                           model_offsets;  //!< Index of the first model of each partition
+    void **                         model_lists;    //!< List of each partition, single pass only
+    void *                          model_list;     //!< List of all partitions
+    int                             model_list_cnt; //!< Number of models in all partitions
+    } select_context_t;
+
+
+/**********************************************
+Functions
+**********************************************/
+static void barrier_destroy
+    (
+    barrier_t * barrier
+    );
+
+static void barrier_init
+    (
+    barrier_t * barrier,
+    int         thread_cnt
+    );
+
+static int barrier_wait
+    (
+    barrier_t * barrier
+    );
+
+static int fold_partition_read
+    (
+    cqlite_stmt_cache_t *   stmt_cache,
+    int                     partition_idx,
+    int                     is_empty,
+    sqlite_int64            first_key,
+    sqlite_int64            last_key,
+    void *                  context
+    );
+
+static int parallel_barrier_wait
+    (
+    parallel_run_t * run
+    );
+
+static int parallel_run
+    (
+    parallel_run_t * run
+    );
+
+static void partition_begin
+    (
+    partition_args_t * args
+    );
+
+static void partition_end
+    (
+    parallel_run_t *        run,
+    cqlite_pool_conn_t *    conn
+    );
+
+static int partition_keys_bind
+    (
+    sqlite3_stmt *  query,
+    sqlite_int64    first_key,
+    sqlite_int64    last_key
+    );
+
+static void * partition_thread
+    (
+    void * args
+    );
+
+static int select_partition_read
+    (
+    cqlite_stmt_cache_t *   stmt_cache,
+    int                     partition_idx,
+    int                     is_empty,
+    sqlite_int64            first_key,
+    sqlite_int64            last_key,
+    void *                  context
+    );
+
+
+// Execute SELECT query as a fold in parallel.
+cqlite_rcode_t cqlite_parallel_fold_query_execute
+    (
+    cqlite_pool_t *             pool,               //!< Connection pool
+    char const * const          bounds_query_str,   //!< Query returning the smallest and largest key
+    char const * const          select_query_str,   //!< SELECT query string taking the first and last key of a range
+    cqlite_fold_func_t          fold_func,          //!< Function to fold a row result into an accumulator
+    cqlite_fold_merge_func_t    merge_func,         //!< Function to merge the accumulator of a partition into the caller's
+    void const *                identity,           //!< Accumulator that merging leaves unchanged, each partition starts from it
+    void *                      accumulator,        //!< (in/out) Accumulator of the fold
+    size_t                      accumulator_size,   //!< Size of the accumulator type
+    int                         partition_cnt       //!< Number of key ranges and worker threads
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+int             i;
+void *          result = NULL;
+parallel_run_t  run;
+fold_context_t  context;
+
+memset( &context, 0, sizeof( context ) );
+context.select_query_str = select_query_str;
+context.fold_func = fold_func;
+context.accumulator_size = accumulator_size;
+
+memset( &run, 0, sizeof( run ) );
+run.pool = pool;
+run.bounds_query_str = bounds_query_str;
+run.read_func = fold_partition_read;
+run.context = &context;
+run.partition_cnt = ( partition_cnt < cqlite_pool_reader_cnt( pool ) ) ? partition_cnt : cqlite_pool_reader_cnt( pool );
+
+success = ( run.partition_cnt > 0 ) && ( accumulator_size > 0 );
+
+// Every partition starts from the identity, so that the caller's
+// initial value is only applied once when the partitions are merged.
+if( success )
+    {
+    context.accumulators = malloc( run.partition_cnt * accumulator_size );
+    result = malloc( accumulator_size );
+    success = ( NULL != context.accumulators ) && ( NULL != result );
+    }
+
+if( success )
+    {
+    for( i = 0; i < run.partition_cnt; i++ )
+        {
+        memcpy( (char*)context.accumulators + ( i * accumulator_size ), identity, accumulator_size );
+        }
+
+    success = parallel_run( &run );
+    }
+
+// Merge into a copy so the caller's accumulator is only changed if
+// every partition merges successfully.
+if( success )
+    {
+    memcpy( result, accumulator, accumulator_size );
+
+    for( i = 0; success && ( i < run.partition_cnt ); i++ )
+        {
+        success = merge_func( result, (char*)context.accumulators + ( i * accumulator_size ) );
+        }
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    memcpy( accumulator, result, accumulator_size );
+    }
+
+// Clean up
+free( context.accumulators );
+free( result );
+
+return rcode;
+}
+
+
+// Execute SELECT query in parallel.
+cqlite_rcode_t cqlite_parallel_select_query_execute
+    (
+    cqlite_pool_t *                 pool,               //!< Connection pool
+    char const * const              bounds_query_str,   //!< Query returning the smallest and largest key
+    char const * const              select_query_str,   //!< SELECT query string taking the first and last key of a range
+    char const * const              count_query_str,    //!< COUNT query string taking the first and last key of a range, NULL for single pass
+    cqlite_model_add_to_list_func_t add_to_list_func,   //!< Add model to list function pointer
+    size_t                          model_size,         //!< Size of the model type
+    int                             partition_cnt,      //!< Number of key ranges and worker threads
+    void **                         model_list_out,     //!< (out) List of models read from query, caller must free
+    int *                           model_list_cnt_out  //!< (out) Number of models read from query
+    )
+{
+cqlite_rcode_t      rcode = CQLITE_ERROR;
+int                 success;
+int                 i;
+int                 merge_cnt;
+void *              grown_list;
+parallel_run_t      run;
+select_context_t    context;
+
+*model_list_out = NULL;
+*model_list_cnt_out = 0;
+
+memset( &context, 0, sizeof( context ) );
+context.select_query_str = select_query_str;
+context.count_query_str = count_query_str;
+context.add_to_list_func = add_to_list_func;
+context.model_size = model_size;
+
+memset( &run, 0, sizeof( run ) );
+run.pool = pool;
+run.bounds_query_str = bounds_query_str;
+run.read_func = select_partition_read;
+run.context = &context;
+context.run = &run;
+run.partition_cnt = ( partition_cnt < cqlite_pool_reader_cnt( pool ) ) ? partition_cnt : cqlite_pool_reader_cnt( pool );
+
+context.model_cnts = calloc( run.partition_cnt, sizeof( *context.model_cnts ) );
+context.model_offsets = calloc( run.partition_cnt, sizeof( *context.model_offsets ) );
+context.model_lists = calloc( run.partition_cnt, sizeof( *context.model_lists ) );
+
+success = ( run.partition_cnt > 0 ) &&
+          ( NULL != context.model_cnts ) &&
+          ( NULL != context.model_offsets ) &&
+          ( NULL != context.model_lists );
+
+if( success )
+    {
+    success = parallel_run( &run );
+    }
+
+// Without a COUNT query, each partition was read into its own list.
+// The others are appended to the first one, which takes ownership of
+// their models. This is done even if a partition failed, so that the
+// caller can free the models read so far.
+if( ( NULL == count_query_str ) && ( run.partition_cnt > 0 ) && ( NULL != context.model_lists ) )
+    {
+    for( merge_cnt = 0; merge_cnt < run.partition_cnt; merge_cnt++ )
+        {
+        if( context.model_cnts[merge_cnt] > ( INT_MAX - context.model_list_cnt ) )
+            {
+            success = 0;
+            break;
+            }
+
+        context.model_offsets[merge_cnt] = context.model_list_cnt;
+        context.model_list_cnt += context.model_cnts[merge_cnt];
+        }
+
+    context.model_list = context.model_lists[0];
+
+    if( ( merge_cnt > 1 ) && ( context.model_list_cnt > context.model_cnts[0] ) )
+        {
+        grown_list = realloc( context.model_list, context.model_list_cnt * model_size );
+
+        if( NULL != grown_list )
+            {
+            context.model_list = grown_list;
+            }
+        else
+            {
+            success = 0;
+            merge_cnt = 1;
+            context.model_list_cnt = context.model_cnts[0];
+            }
+        }
+
+    for( i = 1; i < merge_cnt; i++ )
+        {
+        if( context.model_cnts[i] > 0 )
+            {
+            memcpy( (char*)context.model_list + ( context.model_offsets[i] * model_size ), context.model_lists[i], context.model_cnts[i] * model_size );
+            }
+        }
+
+    for( i = 1; i < run.partition_cnt; i++ )
+        {
+        free( context.model_lists[i] );
+        }
+    }
+
+// Set the output
+*model_list_out = context.model_list;
+*model_list_cnt_out = context.model_list_cnt;
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+// Clean up
+free( context.model_cnts );
+free( context.model_offsets );
+free( context.model_lists );
+
+return rcode;
+}
+
+
+/**
+* Destroy barrier.
+*/
+static void barrier_destroy
+    (
+    barrier_t * barrier
+    )
+{
+pthread_mutex_destroy( &barrier->mutex );
+pthread_cond_destroy( &barrier->cond );
+}
+
+
+/**
+* Initialize barrier.
+*
+* POSIX barriers are optional and unavailable on some platforms, so a
+* minimal barrier is implemented with a mutex and condition variable.
+*/
+static void barrier_init
+    (
+    barrier_t * barrier,
+    int         thread_cnt
+    )
+{
+pthread_mutex_init( &barrier->mutex, NULL );
+pthread_cond_init( &barrier->cond, NULL );
+
+barrier->thread_cnt = thread_cnt;
+barrier->arrived_cnt = 0;
+barrier->generation = 0;
+}
+
+
+/**
+* Wait at barrier.
+*
+* Blocks until all threads have arrived at the barrier. Returns 1 in
+* exactly one of the threads, which was the last to arrive, and 0 in all
+* of the others.
+*/
+static int barrier_wait
+    (
+    barrier_t * barrier
+    )
+{
+int             is_last;
+unsigned int    generation;
+
+pthread_mutex_lock( &barrier->mutex );
+
+generation = barrier->generation;
+barrier->arrived_cnt++;
+is_last = ( barrier->arrived_cnt == barrier->thread_cnt );
+
+if( is_last )
+    {
+    barrier->arrived_cnt = 0;
+    barrier->generation++;
+    pthread_cond_broadcast( &barrier->cond );
+    }
+else
+    {
+    while( generation == barrier->generation )
+        {
+        pthread_cond_wait( &barrier->cond, &barrier->mutex );
+        }
+    }
+
+pthread_mutex_unlock( &barrier->mutex );
+
+return is_last;
+}
+
+
+/**
+* Fold SELECT query partition.
+*
+* Implements partition_read_func_t for cqlite_parallel_fold_query_execute().
+*/
+static int fold_partition_read
+    (
+    cqlite_stmt_cache_t *   stmt_cache,
+    int                     partition_idx,
+    int                     is_empty,
+    sqlite_int64            first_key,
+    sqlite_int64            last_key,
+    void *                  context
+    )
+{
+fold_context_t *    fold_context;
+int                 success = 1;
+sqlite3_stmt *      select_query = NULL;
+
+fold_context = (fold_context_t*)context;
+
+if( !is_empty )
+    {
+    success = ( CQLITE_SUCCESS == cqlite_stmt_cache_acquire( stmt_cache, fold_context->select_query_str, &select_query ) ) &&
+              partition_keys_bind( select_query, first_key, last_key ) &&
+              ( CQLITE_SUCCESS == cqlite_fold_query_execute_prepared( select_query, fold_context->fold_func, (char*)fold_context->accumulators + ( partition_idx * fold_context->accumulator_size ) ) );
+    }
+
+// Clean up
+if( NULL != select_query )
+    {
+    cqlite_stmt_cache_release( stmt_cache, select_query );
+    }
+
+return success;
+}
+
+
+/**
+* Wait for all partitions.
+*
+* Blocks until all partitions of the run have called this. Returns 1 in
+* exactly one partition and 0 in all others.
+*/
+static int parallel_barrier_wait
+    (
+    parallel_run_t * run
+    )
+{
+return barrier_wait( &run->partition_barrier );
+}
+
+
+/**
+* Run partitions in parallel.
+*
+* Checks out one read connection per partition, starts a read
+* transaction on each of them, and then starts one worker thread per
+* partition and waits for all of them to finish. If fewer connections
+* are free or fewer threads can be created than requested, the key
+* range is split into fewer partitions.
+*/
+static int parallel_run
+    (
+    parallel_run_t * run
+    )
+{
+int                     success;
+int                     i;
+int                     conn_cnt = 0;
+int                     thread_cnt = 0;
+pthread_t *             threads;
+partition_args_t *      args;
+cqlite_pool_conn_t *    writer;
+
+threads = calloc( run->partition_cnt, sizeof( *threads ) );
+args = calloc( run->partition_cnt, sizeof( *args ) );
+success = ( NULL != threads ) && ( NULL != args );
+
+atomic_init( &run->failed, 0 );
+pthread_mutex_init( &run->start_mutex, NULL );
+pthread_cond_init( &run->start_cond, NULL );
+
+// The read connections are checked out before the write connection,
+// so the run never holds the writer while waiting for a reader that
+// another thread holds while waiting for the writer. Only the first
+// reader is waited for, the others are taken as long as they are free.
+if( success )
+    {
+    cqlite_pool_reader_acquire( run->pool, &args[conn_cnt].conn );
+    conn_cnt++;
+    }
+
+while( success && ( conn_cnt < run->partition_cnt ) && ( CQLITE_SUCCESS == cqlite_pool_reader_try_acquire( run->pool, &args[conn_cnt].conn ) ) )
+    {
+    conn_cnt++;
+    }
+
+// Keep writers of the pool out until every partition has started its
+// read transaction, so that they all read the same snapshot.
+if( conn_cnt > 0 )
+    {
+    cqlite_pool_writer_acquire( run->pool, &writer );
+
+    for( i = 0; i < conn_cnt; i++ )
+        {
+        args[i].run = run;
+        args[i].partition_idx = i;
+        partition_begin( &args[i] );
+        }
+
+    cqlite_pool_release( run->pool, writer );
+    }
+
+for( i = 0; success && ( i < conn_cnt ); i++ )
+    {
+    success = ( 0 == pthread_create( &threads[thread_cnt], NULL, partition_thread, &args[i] ) );
+
+    if( success )
+        {
+        thread_cnt++;
+        }
+    }
+
+// Partitions without a thread give their connection back
+for( i = thread_cnt; i < conn_cnt; i++ )
+    {
+    partition_end( run, args[i].conn );
+    }
+
+// Let the threads go now that it is known how many there are
+run->partition_cnt = thread_cnt;
+barrier_init( &run->partition_barrier, thread_cnt );
+
+pthread_mutex_lock( &run->start_mutex );
+run->is_started = 1;
+pthread_cond_broadcast( &run->start_cond );
+pthread_mutex_unlock( &run->start_mutex );
+
+for( i = 0; i < thread_cnt; i++ )
+    {
+    pthread_join( threads[i], NULL );
+    }
+
+success = ( thread_cnt > 0 ) && ( 0 == atomic_load( &run->failed ) );
+
+// Clean up
+barrier_destroy( &run->partition_barrier );
+pthread_mutex_destroy( &run->start_mutex );
+pthread_cond_destroy( &run->start_cond );
+free( threads );
+free( args );
+
+return success;
+}
+
+
+/**
+* Begin partition.
+*
+* Starts a read transaction on the partition's connection and reads the
+* bounds of all keys in it, which pins the snapshot of the partition.
+*/
+static void partition_begin
+    (
+    partition_args_t * args
+    )
+{
+cqlite_stmt_cache_t *   stmt_cache;
+sqlite3_stmt *          bounds_query = NULL;
+
+stmt_cache = cqlite_pool_conn_stmt_cache( args->conn );
+args->is_empty = 1;
+
+// Reading the bounds starts the read transaction
+args->is_begun = ( SQLITE_OK == sqlite3_exec( cqlite_pool_conn_db( args->conn ), "BEGIN;", NO_CALLBACK, NO_CALLBACK_PARAM, NO_ERROR_MESSAGE ) ) &&
+                 ( CQLITE_SUCCESS == cqlite_stmt_cache_acquire( stmt_cache, args->run->bounds_query_str, &bounds_query ) ) &&
+                 ( SQLITE_ROW == sqlite3_step( bounds_query ) );
+
+if( args->is_begun && ( SQLITE_NULL != sqlite3_column_type( bounds_query, MIN_KEY_COL ) ) )
+    {
+    args->is_empty = 0;
+    args->min_key = sqlite3_column_int64( bounds_query, MIN_KEY_COL );
+    args->max_key = sqlite3_column_int64( bounds_query, MAX_KEY_COL );
+    }
+
+// Clean up
+if( NULL != bounds_query )
+    {
+    cqlite_stmt_cache_release( stmt_cache, bounds_query );
+    }
+}
+
+
+/**
+* End partition.
+*
+* Ends the read transaction of a partition's connection and returns the
+* connection to the pool.
+*/
+static void partition_end
+    (
+    parallel_run_t *        run,
+    cqlite_pool_conn_t *    conn
+    )
+{
+sqlite3_exec( cqlite_pool_conn_db( conn ), "COMMIT;", NO_CALLBACK, NO_CALLBACK_PARAM, NO_ERROR_MESSAGE );
+cqlite_pool_release( run->pool, conn );
+}
+
+
+/**
+* Bind partition keys.
+*
+* Binds the first and last key of a partition to a query.
+*/
+static int partition_keys_bind
+    (
+    sqlite3_stmt *  query,
+    sqlite_int64    first_key,
+    sqlite_int64    last_key
+    )
+{
+return ( SQLITE_OK == sqlite3_bind_int64( query, FIRST_KEY_PARAM, first_key ) ) &&
+       ( SQLITE_OK == sqlite3_bind_int64( query, LAST_KEY_PARAM, last_key ) );
+}
+
+
+/**
+* Partition worker thread.
+*
+* Determines the key range of its partition from the bounds read when
+* the partition began, reads the partition using the run's read
+* function, and ends the partition.
+*/
+static void * partition_thread
+    (
+    void * args
+    )
+{
+partition_args_t *      partition;
+parallel_run_t *        run;
+int                     success;
+int                     is_empty;
+sqlite_int64            first_key = 0;
+sqlite_int64            last_key = 0;
+sqlite3_uint64          key_cnt;
+sqlite3_uint64          partition_size;
+sqlite3_uint64          partition_start;
+
+partition = (partition_args_t*)args;
+run = partition->run;
+success = partition->is_begun;
+is_empty = partition->is_empty;
+
+pthread_mutex_lock( &run->start_mutex );
+while( !run->is_started )
+    {
+    pthread_cond_wait( &run->start_cond, &run->start_mutex );
+    }
+pthread_mutex_unlock( &run->start_mutex );
+
+// Split the keys as evenly as possible, giving the first partitions
+// one extra key each until the remainder is used up. Unsigned math
+// avoids overflowing when the keys span most of the 64-bit range.
+if( !is_empty )
+    {
+    key_cnt = (sqlite3_uint64)partition->max_key - (sqlite3_uint64)partition->min_key + 1;
+
+    partition_size = key_cnt / run->partition_cnt;
+    partition_start = ( partition_size * partition->partition_idx ) + ( ( (sqlite3_uint64)partition->partition_idx < ( key_cnt % run->partition_cnt ) ) ? (sqlite3_uint64)partition->partition_idx : ( key_cnt % run->partition_cnt ) );
+
+    if( (sqlite3_uint64)partition->partition_idx < ( key_cnt % run->partition_cnt ) )
+        {
+        partition_size++;
+        }
+
+    is_empty = ( 0 == partition_size );
+    first_key = (sqlite_int64)( (sqlite3_uint64)partition->min_key + partition_start );
+    last_key = (sqlite_int64)( (sqlite3_uint64)first_key + partition_size - 1 );
+    }
+
+success = run->read_func( cqlite_pool_conn_stmt_cache( partition->conn ), partition->partition_idx, ( !success ) || is_empty, first_key, last_key, run->context ) && success;
+
+partition_end( run, partition->conn );
+
+if( !success )
+    {
+    atomic_store( &run->failed, 1 );
+    }
+
+return NULL;
+}
+
+
+/**
+* Read SELECT query partition.
+*
+* Implements partition_read_func_t for cqlite_parallel_select_query_execute().
+*/
+static int select_partition_read
+    (
+    cqlite_stmt_cache_t *   stmt_cache,
+    int                     partition_idx,
+    int                     is_empty,
+    sqlite_int64            first_key,
+    sqlite_int64            last_key,
+    void *                  context
+    )
+{
+select_context_t *  select_context;
+parallel_run_t *    run;
+int                 success = 1;
+int                 i;
+int                 model_idx = 0;
+int                 sqlite_rcode = SQLITE_ERROR;
+sqlite3_stmt *      select_query = NULL;
+sqlite3_stmt *      count_query = NULL;
+
+select_context = (select_context_t*)context;
+run = select_context->run;
+
+if( !is_empty )
+    {
+    success = ( CQLITE_SUCCESS == cqlite_stmt_cache_acquire( stmt_cache, select_context->select_query_str, &select_query ) ) &&
+              partition_keys_bind( select_query, first_key, last_key );
+    }
+
+if( NULL == select_context->count_query_str )
+    {
+    if( success && !is_empty )
+        {
+        success = ( CQLITE_SUCCESS == cqlite_select_query_execute_prepared( select_query, NULL, select_context->add_to_list_func, select_context->model_size, &select_context->model_lists[partition_idx], &select_context->model_cnts[partition_idx] ) );
+        }
+    }
+else
+    {
+    if( success && !is_empty )
+        {
+        success = ( CQLITE_SUCCESS == cqlite_stmt_cache_acquire( stmt_cache, select_context->count_query_str, &count_query ) ) &&
+                  partition_keys_bind( count_query, first_key, last_key ) &&
+                  ( CQLITE_SUCCESS == cqlite_count_query_execute_prepared( count_query, &select_context->model_cnts[partition_idx] ) );
+        }
+
+    // Once every partition is counted, one of them allocates the list
+    if( parallel_barrier_wait( run ) )
+        {
+        for( i = 0; i < run->partition_cnt; i++ )
+            {
+            select_context->model_offsets[i] = select_context->model_list_cnt;
+
+            if( select_context->model_cnts[i] > ( INT_MAX - select_context->model_list_cnt ) )
+                {
+                atomic_store( &run->failed, 1 );
+                break;
+                }
+
+            select_context->model_list_cnt += select_context->model_cnts[i];
+            }
+
+        if( ( 0 == atomic_load( &run->failed ) ) && ( select_context->model_list_cnt > 0 ) )
+            {
+            select_context->model_list = calloc( select_context->model_list_cnt, select_context->model_size );
+
+            if( NULL == select_context->model_list )
+                {
+                atomic_store( &run->failed, 1 );
+                }
+            }
+
+        if( NULL == select_context->model_list )
+            {
+            select_context->model_list_cnt = 0;
+            }
+        }
+
+    parallel_barrier_wait( run );
+
+    // Read the partition into its slice of the list, unless
+    // another partition failed and there is no point to it.
+    success = success && ( 0 == atomic_load( &run->failed ) );
+
+    if( success && !is_empty )
+        {
+        sqlite_rcode = sqlite3_step( select_query );
+        }
+
+    while( success && !is_empty && ( SQLITE_ROW == sqlite_rcode ) )
+        {
+        // All partitions read the same snapshot, so this
+        // can only happen if the queries are inconsistent.
+        success = ( model_idx < select_context->model_cnts[partition_idx] ) &&
+                  select_context->add_to_list_func( select_query, select_context->model_list, select_context->model_offsets[partition_idx] + model_idx );
+
+        sqlite_rcode = sqlite3_step( select_query );
+        model_idx++;
+        }
+
+    if( success && !is_empty )
+        {
+        success = ( SQLITE_DONE == sqlite_rcode );
+        }
+    }
+
+// Clean up
+if( NULL != count_query )
+    {
+    cqlite_stmt_cache_release( stmt_cache, count_query );
+    }
+
+if( NULL != select_query )
+    {
+    cqlite_stmt_cache_release( stmt_cache, select_query );
+    }
+
+return success;
+}
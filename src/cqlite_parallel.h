@@ -0,0 +1,91 @@
+/** @file */
+
+#ifndef _CQLITE_PARALLEL_H
+#define _CQLITE_PARALLEL_H
+
+#include <sqlite3.h>
+
+#include "cqlite.h"
+#include "cqlite_fold.h"
+#include "cqlite_pool.h"
+
+/**
+* Execute SELECT query as a fold in parallel.
+*
+* Splits a SELECT query into key ranges exactly like
+* cqlite_parallel_select_query_execute(), and folds each range on its
+* own worker thread as by cqlite_fold_query_execute(), without reading
+* any results into models.
+*
+* Each partition folds into its own copy of identity, an accumulator
+* that merge_func leaves unchanged, such as a zero sum or an empty
+* histogram, which must not own memory that the copies would share. The
+* caller's accumulator holds the initial value of the fold. Once all
+* partitions are done, merge_func combines their accumulators into the
+* caller's accumulator in key order on the calling thread, so neither
+* function needs to be thread-safe with respect to the accumulators and
+* the result is the same as that of cqlite_fold_query_execute(). On
+* error, the caller's accumulator is left unchanged.
+*/
+cqlite_rcode_t cqlite_parallel_fold_query_execute
+    (
+    cqlite_pool_t *             pool,               //!< Connection pool
+    char const * const          bounds_query_str,   //!< Query returning the smallest and largest key
+    char const * const          select_query_str,   //!< SELECT query string taking the first and last key of a range
+    cqlite_fold_func_t          fold_func,          //!< Function to fold a row result into an accumulator
+    cqlite_fold_merge_func_t    merge_func,         //!< Function to merge the accumulator of a partition into the caller's
+    void const *                identity,           //!< Accumulator that merging leaves unchanged, each partition starts from it
+    void *                      accumulator,        //!< (in/out) Accumulator of the fold
+    size_t                      accumulator_size,   //!< Size of the accumulator type
+    int                         partition_cnt       //!< Number of key ranges and worker threads
+    );
+
+/**
+* Execute SELECT query in parallel.
+*
+* Splits a SELECT query into key ranges that are read concurrently by
+* partition_cnt worker threads, each on its own read connection of the
+* provided pool, and returns the results in a single list exactly like
+* cqlite_select_query_execute().
+*
+* The bounds query must return the smallest and largest key of the
+* results, for instance:
+*
+*         "SELECT MIN(id), MAX(id) FROM my_table WHERE my_column = 7;"
+*
+* The SELECT and COUNT queries must take the first and last key of a
+* range as parameters 1 and 2 and should order the results by key:
+*
+*         "SELECT * FROM my_table WHERE my_column = 7 AND id BETWEEN ?1 AND ?2 ORDER BY id;"
+*         "SELECT COUNT(*) FROM my_table WHERE my_column = 7 AND id BETWEEN ?1 AND ?2;"
+*
+* The key should be the rowid or an indexed integer column so that each
+* range can be found with a seek. With a COUNT query, every worker reads
+* its results directly into its own slice of the list. Without one, each
+* worker reads its results in a single pass and the slices are then
+* copied into one list.
+*
+* All workers read from the same snapshot of the database. This is
+* ensured by checking out their read connections first and then holding
+* the pool's write connection while each of them starts its read
+* transaction, so writes made outside of the pool are not excluded. The
+* number of workers is limited to the number of read connections of the
+* pool that are free when the query starts, and is at least one.
+*
+* The calling thread must not hold any connection of the pool, as the
+* query waits for both a read connection and the write connection.
+*/
+cqlite_rcode_t cqlite_parallel_select_query_execute
+    (
+    cqlite_pool_t *                 pool,               //!< Connection pool
+    char const * const              bounds_query_str,   //!< Query returning the smallest and largest key
+    char const * const              select_query_str,   //!< SELECT query string taking the first and last key of a range
+    char const * const              count_query_str,    //!< COUNT query string taking the first and last key of a range, NULL for single pass
+    cqlite_model_add_to_list_func_t add_to_list_func,   //!< Add model to list function pointer
+    size_t                          model_size,         //!< Size of the model type
+    int                             partition_cnt,      //!< Number of key ranges and worker threads
+    void **                         model_list_out,     //!< (out) List of models read from query, caller must free
+    int *                           model_list_cnt_out  //!< (out) Number of models read from query
+    );
+
+#endif
@@ -0,0 +1,479 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cqlite_pipeline.h"
+#include "cqlite_private.h"
+
+#define READ_TO_END         ( -1 )
+#define NO_TAIL             ( NULL )
+#define CACHE_LINE_SIZE     ( 64 )
+#define RING_SPIN_CNT       ( 256 )
+#define IS_PRODUCER         ( 1 )
+#define IS_CONSUMER         ( 0 )
+
+
+/**********************************************
+Types
+**********************************************/
+// The head is only written by the producer and the tail only by the
+// consumer, each on its own cache line. Both only ever increase, and
+// head - tail is the number of decoded models in the ring.
+typedef struct
+    {
+    sqlite3_stmt *                      select_query;           //!< Query stepped by the producer
+    cqlite_model_from_row_result_func_t from_row_result_func;   //!< Function to decode a row result into a model
+    cqlite_model_free_func_t            model_free_func;        //!< Function to free memory owned by a model, may be NULL
+    size_t                              model_size;             //!< Size of the model type
+    size_t                              slot_cnt;               //!< Number of slots in the ring
+    unsigned char *                     slots;                  //!< slot_cnt models
+    int                                 failed;                 //!< Did the producer fail? Read once it is joined
+    _Alignas( CACHE_LINE_SIZE ) atomic_size_t   head;           //!< Number of models decoded
+    _Alignas( CACHE_LINE_SIZE ) atomic_size_t   tail;           //!< Number of models processed
+    _Alignas( CACHE_LINE_SIZE ) atomic_int      is_done;        //!< Has the producer decoded its last model?
+    atomic_int                          is_stopped;             //!< Has processing failed?
+    atomic_int                          sleeper_cnt;            //!< Number of threads waiting on the condition
+    pthread_mutex_t                     mutex;                  //!< Only taken to sleep and to wake sleepers
+    pthread_cond_t                      cond;                   //!< Signaled when a side that may be asleep makes progress
+    } pipeline_t;
+
+
+/**********************************************
+Functions
+**********************************************/
+static void * producer_thread
+    (
+    void * args
+    );
+
+static int ring_is_ready
+    (
+    pipeline_t *    pipeline,
+    int             is_producer
+    );
+
+static void ring_wait
+    (
+    pipeline_t *    pipeline,
+    int             is_producer
+    );
+
+static void ring_wake
+    (
+    pipeline_t *    pipeline
+    );
+
+static int row_produce
+    (
+    pipeline_t *            pipeline,
+    cqlite_stats_call_t *   stats_call,
+    sqlite_int64 *          phase_start_ns,
+    void *                  slot,
+    int *                   is_end_out
+    );
+
+static int rows_process_inline
+    (
+    pipeline_t *            pipeline,
+    cqlite_pipeline_func_t  process_func,
+    void *                  context
+    );
+
+
+// Execute pipelined SELECT query.
+cqlite_rcode_t cqlite_pipeline_query_execute
+    (
+    sqlite3 *                           db,                     //!< Database on which to execute the query
+    char const * const                  select_query_str,       //!< Parameter-less SELECT query string
+    cqlite_model_from_row_result_func_t from_row_result_func,   //!< Function to decode a row result into a model
+    cqlite_model_free_func_t            model_free_func,        //!< Function to free memory owned by a model, may be NULL
+    size_t                              model_size,             //!< Size of the model type
+    int                                 slot_cnt,               //!< Number of models the ring holds, at least 1
+    cqlite_pipeline_func_t              process_func,           //!< Function to process each model
+    void *                              context                 //!< Context passed to process_func
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+sqlite3_stmt *  select_query = NULL;
+sqlite_int64    prepare_start_ns;
+
+prepare_start_ns = cqlite_stats_prepare_begin();
+success = ( SQLITE_OK == sqlite3_prepare_v2( db, select_query_str, READ_TO_END, &select_query, NO_TAIL ) );
+cqlite_stats_prepare_end( CQLITE_STATS_API_SELECT, prepare_start_ns );
+
+if( success )
+    {
+    rcode = cqlite_pipeline_query_execute_prepared( select_query, from_row_result_func, model_free_func, model_size, slot_cnt, process_func, context );
+    }
+
+// Clean up
+sqlite3_finalize( select_query );
+
+return rcode;
+}
+
+
+// Execute prepared pipelined SELECT query.
+cqlite_rcode_t cqlite_pipeline_query_execute_prepared
+    (
+    sqlite3_stmt *                      select_query,           //!< Prepared SELECT query
+    cqlite_model_from_row_result_func_t from_row_result_func,   //!< Function to decode a row result into a model
+    cqlite_model_free_func_t            model_free_func,        //!< Function to free memory owned by a model, may be NULL
+    size_t                              model_size,             //!< Size of the model type
+    int                                 slot_cnt,               //!< Number of models the ring holds, at least 1
+    cqlite_pipeline_func_t              process_func,           //!< Function to process each model
+    void *                              context                 //!< Context passed to process_func
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+int             is_thread_started = 0;
+int             is_done = 0;
+size_t          head = 0;
+size_t          tail = 0;
+void *          slot;
+pipeline_t      pipeline;
+pthread_t       thread;
+
+memset( &pipeline, 0, sizeof( pipeline ) );
+
+pipeline.select_query = select_query;
+pipeline.from_row_result_func = from_row_result_func;
+pipeline.model_free_func = model_free_func;
+pipeline.model_size = model_size;
+pipeline.slot_cnt = ( slot_cnt > 0 ) ? (size_t)slot_cnt : 0;
+
+atomic_init( &pipeline.head, 0 );
+atomic_init( &pipeline.tail, 0 );
+atomic_init( &pipeline.is_done, 0 );
+atomic_init( &pipeline.is_stopped, 0 );
+atomic_init( &pipeline.sleeper_cnt, 0 );
+pthread_mutex_init( &pipeline.mutex, NULL );
+pthread_cond_init( &pipeline.cond, NULL );
+
+success = ( pipeline.slot_cnt > 0 ) && ( model_size > 0 );
+
+if( success )
+    {
+    pipeline.slots = malloc( pipeline.slot_cnt * model_size );
+    success = ( NULL != pipeline.slots );
+    }
+
+// Decode inline if the thread cannot be created
+if( success )
+    {
+    is_thread_started = ( 0 == pthread_create( &thread, NULL, producer_thread, &pipeline ) );
+
+    if( !is_thread_started )
+        {
+        success = rows_process_inline( &pipeline, process_func, context );
+        }
+    }
+
+// Models already decoded when processing fails are still freed, and
+// the ring is drained until the producer notices it was stopped.
+while( is_thread_started && !is_done )
+    {
+    if( head == tail )
+        {
+        ring_wait( &pipeline, IS_CONSUMER );
+        head = atomic_load( &pipeline.head );
+        }
+
+    if( head != tail )
+        {
+        slot = &pipeline.slots[( tail % pipeline.slot_cnt ) * model_size];
+
+        if( success )
+            {
+            success = process_func( slot, context );
+
+            if( !success )
+                {
+                atomic_store( &pipeline.is_stopped, 1 );
+                }
+            }
+
+        if( NULL != model_free_func )
+            {
+            model_free_func( slot );
+            }
+
+        tail++;
+        atomic_store( &pipeline.tail, tail );
+        ring_wake( &pipeline );
+        }
+    else
+        {
+        // The last model is published before the producer is done
+        is_done = atomic_load( &pipeline.is_done ) &&
+                  ( tail == atomic_load( &pipeline.head ) );
+        }
+    }
+
+if( is_thread_started )
+    {
+    pthread_join( thread, NULL );
+    success = success && !pipeline.failed;
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+// Clean up
+free( pipeline.slots );
+pthread_mutex_destroy( &pipeline.mutex );
+pthread_cond_destroy( &pipeline.cond );
+
+return rcode;
+}
+
+
+/**
+* Producer thread.
+*
+* Steps the query and decodes its rows into the ring ahead of the
+* consumer until the last row, until decoding fails, or until the
+* consumer stops. The instrumented call runs on this thread, so that
+* its statistics and trace records cover the statement.
+*/
+static void * producer_thread
+    (
+    void * args
+    )
+{
+pipeline_t *        pipeline;
+int                 success = 1;
+int                 is_end = 0;
+size_t              head = 0;
+size_t              tail = 0;
+sqlite_int64        row_cnt = 0;
+void *              slot;
+cqlite_stats_call_t stats_call;
+sqlite_int64        phase_start_ns;
+
+pipeline = (pipeline_t*)args;
+
+cqlite_stats_call_begin( &stats_call, CQLITE_STATS_API_SELECT );
+phase_start_ns = cqlite_stats_clock( &stats_call );
+
+while( success && !is_end )
+    {
+    // Time spent waiting on the consumer belongs to no phase
+    if( ( head - tail ) == pipeline->slot_cnt )
+        {
+        ring_wait( pipeline, IS_PRODUCER );
+        tail = atomic_load( &pipeline->tail );
+        phase_start_ns = cqlite_stats_clock( &stats_call );
+        }
+
+    if( atomic_load( &pipeline->is_stopped ) )
+        {
+        is_end = 1;
+        }
+    else if( ( head - tail ) < pipeline->slot_cnt )
+        {
+        slot = &pipeline->slots[( head % pipeline->slot_cnt ) * pipeline->model_size];
+        success = row_produce( pipeline, &stats_call, &phase_start_ns, slot, &is_end );
+
+        if( success && !is_end )
+            {
+            row_cnt++;
+
+            head++;
+            atomic_store( &pipeline->head, head );
+            ring_wake( pipeline );
+            }
+        }
+    }
+
+stats_call.rows_read = row_cnt;
+cqlite_stats_call_end( &stats_call, pipeline->select_query, success );
+
+pipeline->failed = !success;
+
+atomic_store( &pipeline->is_done, 1 );
+ring_wake( pipeline );
+
+return NULL;
+}
+
+
+/**
+* Can a side of the ring make progress?
+*
+* The producer can once a slot is free or processing has stopped, the
+* consumer once a model is decoded or the producer is done.
+*/
+static int ring_is_ready
+    (
+    pipeline_t *    pipeline,
+    int             is_producer
+    )
+{
+int is_ready;
+
+if( is_producer )
+    {
+    is_ready = ( ( atomic_load( &pipeline->head ) - atomic_load( &pipeline->tail ) ) < pipeline->slot_cnt ) ||
+               atomic_load( &pipeline->is_stopped );
+    }
+else
+    {
+    is_ready = ( atomic_load( &pipeline->head ) != atomic_load( &pipeline->tail ) ) ||
+               atomic_load( &pipeline->is_done );
+    }
+
+return is_ready;
+}
+
+
+/**
+* Wait until a side of the ring can make progress.
+*
+* Spins briefly, since the other side usually catches up quickly, then
+* sleeps on the condition. A sleeper is counted before it checks the
+* ring one last time, and ring_wake() checks the count after publishing
+* its progress, so with sequentially consistent atomics either the
+* sleeper sees the progress or the waker sees the sleeper.
+*/
+static void ring_wait
+    (
+    pipeline_t *    pipeline,
+    int             is_producer
+    )
+{
+int i;
+
+for( i = 0; ( i < RING_SPIN_CNT ) && !ring_is_ready( pipeline, is_producer ); i++ )
+    {
+    }
+
+if( !ring_is_ready( pipeline, is_producer ) )
+    {
+    pthread_mutex_lock( &pipeline->mutex );
+    atomic_fetch_add( &pipeline->sleeper_cnt, 1 );
+
+    while( !ring_is_ready( pipeline, is_producer ) )
+        {
+        pthread_cond_wait( &pipeline->cond, &pipeline->mutex );
+        }
+
+    atomic_fetch_sub( &pipeline->sleeper_cnt, 1 );
+    pthread_mutex_unlock( &pipeline->mutex );
+    }
+}
+
+
+/**
+* Wake the other side of the ring.
+*
+* Only takes the mutex if the other side may be asleep, so the ring
+* stays lock-free while both sides keep up.
+*/
+static void ring_wake
+    (
+    pipeline_t *    pipeline
+    )
+{
+if( atomic_load( &pipeline->sleeper_cnt ) > 0 )
+    {
+    pthread_mutex_lock( &pipeline->mutex );
+    pthread_cond_broadcast( &pipeline->cond );
+    pthread_mutex_unlock( &pipeline->mutex );
+    }
+}
+
+
+/**
+* Decode next row into slot.
+*
+* Steps the query and decodes the row result into the zeroed slot, or
+* sets is_end_out if there are no more rows. A model that fails to
+* decode is freed.
+*/
+static int row_produce
+    (
+    pipeline_t *            pipeline,
+    cqlite_stats_call_t *   stats_call,
+    sqlite_int64 *          phase_start_ns,
+    void *                  slot,
+    int *                   is_end_out
+    )
+{
+int success;
+int sqlite_rcode;
+
+sqlite_rcode = sqlite3_step( pipeline->select_query );
+*phase_start_ns = cqlite_stats_phase_end( stats_call, CQLITE_STATS_PHASE_STEP, *phase_start_ns );
+
+*is_end_out = ( SQLITE_ROW != sqlite_rcode );
+success = ( SQLITE_ROW == sqlite_rcode ) || ( SQLITE_DONE == sqlite_rcode );
+
+if( success && !*is_end_out )
+    {
+    memset( slot, 0, pipeline->model_size );
+    success = pipeline->from_row_result_func( pipeline->select_query, slot );
+    *phase_start_ns = cqlite_stats_phase_end( stats_call, CQLITE_STATS_PHASE_DECODE, *phase_start_ns );
+
+    if( !success && ( NULL != pipeline->model_free_func ) )
+        {
+        pipeline->model_free_func( slot );
+        }
+    }
+
+return success;
+}
+
+
+/**
+* Process rows on the calling thread.
+*
+* Decodes and processes each row in turn through the first slot of the
+* ring, for when the producer thread cannot be created.
+*/
+static int rows_process_inline
+    (
+    pipeline_t *            pipeline,
+    cqlite_pipeline_func_t  process_func,
+    void *                  context
+    )
+{
+int                 success = 1;
+int                 is_end = 0;
+sqlite_int64        row_cnt = 0;
+cqlite_stats_call_t stats_call;
+sqlite_int64        phase_start_ns;
+
+cqlite_stats_call_begin( &stats_call, CQLITE_STATS_API_SELECT );
+phase_start_ns = cqlite_stats_clock( &stats_call );
+
+while( success && !is_end )
+    {
+    success = row_produce( pipeline, &stats_call, &phase_start_ns, pipeline->slots, &is_end );
+
+    if( success && !is_end )
+        {
+        row_cnt++;
+
+        success = process_func( pipeline->slots, context );
+
+        if( NULL != pipeline->model_free_func )
+            {
+            pipeline->model_free_func( pipeline->slots );
+            }
+
+        phase_start_ns = cqlite_stats_clock( &stats_call );
+        }
+    }
+
+stats_call.rows_read = row_cnt;
+cqlite_stats_call_end( &stats_call, pipeline->select_query, success );
+
+return success;
+}
@@ -0,0 +1,72 @@
+/** @file */
+
+#ifndef _CQLITE_PIPELINE_H
+#define _CQLITE_PIPELINE_H
+
+#include <sqlite3.h>
+
+#include "cqlite.h"
+
+#define CQLITE_PIPELINE_SLOT_CNT    ( 64 )  //!< Suggested number of models decoded ahead of the consumer
+
+/**
+* Process model function type.
+*
+* Processes a model decoded from a row result of a pipelined query on
+* the calling thread. The model is only valid until the function
+* returns, after which its slot is freed with the model free function
+* and reused. To keep memory owned by the model, copy the model and
+* zero it. Returns 1 on success, 0 on error, which stops the query.
+*/
+typedef int (*cqlite_pipeline_func_t)
+    (
+    void *  model,      //!< Model decoded from a row result
+    void *  context     //!< Context provided by the caller
+    );
+
+/**
+* Execute pipelined SELECT query.
+*
+* Executes the provided SELECT query string that takes no parameters in
+* a single pass like cqlite_fold_query_execute(), except that stepping
+* the query and decoding its rows into models with from_row_result_func
+* run on a producer thread, while process_func handles the models in
+* order on the calling thread. The producer decodes up to slot_cnt rows
+* ahead into a lock-free ring and waits whenever the ring is full, so
+* memory use does not grow with the number of rows. Long scans whose
+* rows are expensive to process overlap SQLite's page reads with the
+* processing instead of alternating between them.
+*
+* The connection is used by the producer thread for the whole call, so
+* process_func must not use it. If the producer thread cannot be
+* created, the query is executed on the calling thread.
+*/
+cqlite_rcode_t cqlite_pipeline_query_execute
+    (
+    sqlite3 *                           db,                     //!< Database on which to execute the query
+    char const * const                  select_query_str,       //!< Parameter-less SELECT query string
+    cqlite_model_from_row_result_func_t from_row_result_func,   //!< Function to decode a row result into a model
+    cqlite_model_free_func_t            model_free_func,        //!< Function to free memory owned by a model, may be NULL
+    size_t                              model_size,             //!< Size of the model type
+    int                                 slot_cnt,               //!< Number of models the ring holds, at least 1
+    cqlite_pipeline_func_t              process_func,           //!< Function to process each model
+    void *                              context                 //!< Context passed to process_func
+    );
+
+/**
+* Execute prepared pipelined SELECT query.
+*
+* @see cqlite_pipeline_query_execute()
+*/
+cqlite_rcode_t cqlite_pipeline_query_execute_prepared
+    (
+    sqlite3_stmt *                      select_query,           //!< Prepared SELECT query
+    cqlite_model_from_row_result_func_t from_row_result_func,   //!< Function to decode a row result into a model
+    cqlite_model_free_func_t            model_free_func,        //!< Function to free memory owned by a model, may be NULL
+    size_t                              model_size,             //!< Size of the model type
+    int                                 slot_cnt,               //!< Number of models the ring holds, at least 1
+    cqlite_pipeline_func_t              process_func,           //!< Function to process each model
+    void *                              context                 //!< Context passed to process_func
+    );
+
+#endif
@@ -0,0 +1,450 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cqlite_pool.h"
+#include "cqlite_private.h"
+
+#define NO_CALLBACK         ( NULL )
+#define NO_CALLBACK_PARAM   ( NULL )
+#define NO_ERROR_MESSAGE    ( NULL )
+#define NO_VFS              ( NULL )
+#define BUSY_TIMEOUT_MS     ( 5000 )
+#define NO_READER_HINT      ( -1 )
+
+
+/**********************************************
+Types
+**********************************************/
+struct cqlite_pool_conn_s
+    {
+    sqlite3 *               db;         //!< Database connection
+    cqlite_stmt_cache_t *   stmt_cache; //!< Statement cache of the connection
+    atomic_int              in_use;     //!< Is the connection checked out?
+    int                     is_writer;  //!< Is this the write connection?
+    };
+
+struct cqlite_pool_s
+    {
+    int                     reader_cnt;     //!< Number of read connections
+    cqlite_pool_conn_t *    readers;        //!< Read connections
+    cqlite_pool_conn_t      writer;         //!< Write connection
+    pthread_mutex_t         writer_mutex;   //!< Held while the write connection is checked out
+    pthread_mutex_t         wait_mutex;     //!< Protects waiting for a read connection
+    pthread_cond_t          wait_cond;      //!< Signaled when a read connection is released
+    atomic_int              waiter_cnt;     //!< Number of threads waiting for a read connection
+    };
+
+
+/**********************************************
+Variables
+**********************************************/
+
+// Read connection each thread last used, so that threads spread out
+// over the connections and keep coming back to the same one.
+static _Thread_local int    t_reader_hint = NO_READER_HINT;
+static atomic_int           s_next_reader_hint;
+
+
+/**********************************************
+Functions
+**********************************************/
+static int pool_conn_open
+    (
+    char const * const      path,
+    int                     flags,
+    int                     stmt_cache_capacity,
+    cqlite_pool_conn_t *    conn
+    );
+
+static void pool_conn_close
+    (
+    cqlite_pool_conn_t * conn
+    );
+
+static cqlite_pool_conn_t * pool_reader_try_acquire
+    (
+    cqlite_pool_t * pool
+    );
+
+
+// Close connection pool.
+void cqlite_pool_close
+    (
+    cqlite_pool_t * pool    //!< Pool to close
+    )
+{
+int i;
+
+if( NULL != pool )
+    {
+    // Close the readers first so that the writer can clean up the WAL.
+    for( i = 0; ( NULL != pool->readers ) && ( i < pool->reader_cnt ); i++ )
+        {
+        pool_conn_close( &pool->readers[i] );
+        }
+
+    pool_conn_close( &pool->writer );
+
+    pthread_mutex_destroy( &pool->writer_mutex );
+    pthread_mutex_destroy( &pool->wait_mutex );
+    pthread_cond_destroy( &pool->wait_cond );
+
+    free( pool->readers );
+    free( pool );
+    }
+}
+
+
+// Get pooled connection database handle.
+sqlite3 * cqlite_pool_conn_db
+    (
+    cqlite_pool_conn_t const * conn //!< Pooled connection
+    )
+{
+return conn->db;
+}
+
+
+// Get pooled connection statement cache.
+cqlite_stmt_cache_t * cqlite_pool_conn_stmt_cache
+    (
+    cqlite_pool_conn_t const * conn //!< Pooled connection
+    )
+{
+return conn->stmt_cache;
+}
+
+
+// Execute count query using connection pool.
+cqlite_rcode_t cqlite_pool_count_query_execute
+    (
+    cqlite_pool_t *     pool,               //!< Connection pool
+    char const * const  count_query_str,    //!< Parameter-less COUNT query string
+    int *               count_out           //!< (out) Returned count
+    )
+{
+cqlite_rcode_t          rcode = CQLITE_ERROR;
+cqlite_pool_conn_t *    conn;
+
+*count_out = 0;
+
+if( CQLITE_SUCCESS == cqlite_pool_reader_acquire( pool, &conn ) )
+    {
+    rcode = cqlite_stmt_cache_count_query_execute( conn->stmt_cache, count_query_str, count_out );
+
+    // Clean up
+    cqlite_pool_release( pool, conn );
+    }
+
+return rcode;
+}
+
+
+// Find model by id using connection pool.
+cqlite_rcode_t cqlite_pool_find_by_id
+    (
+    cqlite_pool_t *                     pool,                   //!< Connection pool
+    char const * const                  find_by_id_query,       //!< SELECT query string taking a single id parameter
+    sqlite_int64                        id,                     //!< Id to search for
+    cqlite_model_from_row_result_func_t model_from_result_func, //!< Function to read the result into the model
+    int *                               found_out,              //!< (out) Was a record found?
+    void *                              model_out               //!< (out) Found model
+    )
+{
+cqlite_rcode_t          rcode = CQLITE_ERROR;
+cqlite_pool_conn_t *    conn;
+
+*found_out = 0;
+
+if( CQLITE_SUCCESS == cqlite_pool_reader_acquire( pool, &conn ) )
+    {
+    rcode = cqlite_stmt_cache_find_by_id( conn->stmt_cache, find_by_id_query, id, model_from_result_func, found_out, model_out );
+
+    // Clean up
+    cqlite_pool_release( pool, conn );
+    }
+
+return rcode;
+}
+
+
+// Open connection pool.
+cqlite_rcode_t cqlite_pool_open
+    (
+    char const * const  path,                   //!< Path of the database file
+    int                 reader_cnt,             //!< Number of read connections
+    int                 stmt_cache_capacity,    //!< Number of prepared statements cached per connection
+    cqlite_pool_t **    pool_out                //!< (out) Connection pool, caller must close
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+int             i;
+cqlite_pool_t * pool;
+
+*pool_out = NULL;
+
+pool = calloc( 1, sizeof( *pool ) );
+
+if( NULL != pool )
+    {
+    pthread_mutex_init( &pool->writer_mutex, NULL );
+    pthread_mutex_init( &pool->wait_mutex, NULL );
+    pthread_cond_init( &pool->wait_cond, NULL );
+    }
+
+success = ( NULL != pool ) && ( reader_cnt > 0 );
+
+if( success )
+    {
+    pool->readers = calloc( reader_cnt, sizeof( *pool->readers ) );
+    success = ( NULL != pool->readers );
+    }
+
+// The write connection must switch to WAL mode before the
+// read-only connections are opened since they cannot.
+if( success )
+    {
+    pool->reader_cnt = reader_cnt;
+    pool->writer.is_writer = 1;
+
+    success = pool_conn_open( path, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, stmt_cache_capacity, &pool->writer ) &&
+              ( SQLITE_OK == sqlite3_exec( pool->writer.db, "PRAGMA journal_mode=WAL;", NO_CALLBACK, NO_CALLBACK_PARAM, NO_ERROR_MESSAGE ) ) &&
+              cqlite_journal_mode_is_wal( pool->writer.db );
+    }
+
+for( i = 0; success && ( i < reader_cnt ); i++ )
+    {
+    success = pool_conn_open( path, SQLITE_OPEN_READONLY, stmt_cache_capacity, &pool->readers[i] );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    *pool_out = pool;
+    }
+else if( NULL != pool )
+    {
+    cqlite_pool_close( pool );
+    }
+
+return rcode;
+}
+
+
+// Acquire read connection.
+cqlite_rcode_t cqlite_pool_reader_acquire
+    (
+    cqlite_pool_t *         pool,       //!< Connection pool
+    cqlite_pool_conn_t **   conn_out    //!< (out) Read connection, caller must release
+    )
+{
+cqlite_pool_conn_t * conn;
+
+conn = pool_reader_try_acquire( pool );
+
+// All connections are checked out, wait for one to be released.
+// The waiter count is raised before trying again so that a release
+// happening in between is guaranteed to signal the condition.
+while( NULL == conn )
+    {
+    pthread_mutex_lock( &pool->wait_mutex );
+    atomic_fetch_add( &pool->waiter_cnt, 1 );
+
+    conn = pool_reader_try_acquire( pool );
+
+    if( NULL == conn )
+        {
+        pthread_cond_wait( &pool->wait_cond, &pool->wait_mutex );
+        }
+
+    atomic_fetch_sub( &pool->waiter_cnt, 1 );
+    pthread_mutex_unlock( &pool->wait_mutex );
+
+    if( NULL == conn )
+        {
+        conn = pool_reader_try_acquire( pool );
+        }
+    }
+
+*conn_out = conn;
+
+return CQLITE_SUCCESS;
+}
+
+
+// Try to acquire read connection.
+cqlite_rcode_t cqlite_pool_reader_try_acquire
+    (
+    cqlite_pool_t *         pool,       //!< Connection pool
+    cqlite_pool_conn_t **   conn_out    //!< (out) Read connection, caller must release
+    )
+{
+*conn_out = pool_reader_try_acquire( pool );
+
+return ( NULL != *conn_out ) ? CQLITE_SUCCESS : CQLITE_ERROR;
+}
+
+
+// Get number of read connections.
+int cqlite_pool_reader_cnt
+    (
+    cqlite_pool_t const * pool  //!< Connection pool
+    )
+{
+return pool->reader_cnt;
+}
+
+
+// Release pooled connection.
+void cqlite_pool_release
+    (
+    cqlite_pool_t *         pool,   //!< Connection pool
+    cqlite_pool_conn_t *    conn    //!< Connection to release
+    )
+{
+if( conn->is_writer )
+    {
+    pthread_mutex_unlock( &pool->writer_mutex );
+    }
+else
+    {
+    atomic_store( &conn->in_use, 0 );
+
+    // Only pay for the mutex when someone is actually waiting.
+    if( 0 < atomic_load( &pool->waiter_cnt ) )
+        {
+        pthread_mutex_lock( &pool->wait_mutex );
+        pthread_cond_signal( &pool->wait_cond );
+        pthread_mutex_unlock( &pool->wait_mutex );
+        }
+    }
+}
+
+
+// Execute SELECT query using connection pool.
+cqlite_rcode_t cqlite_pool_select_query_execute
+    (
+    cqlite_pool_t *                 pool,               //!< Connection pool
+    char const * const              select_query_str,   //!< Parameter-less SELECT query string
+    char const * const              count_query_str,    //!< Parameter-less COUNT query string, NULL for single pass
+    cqlite_model_add_to_list_func_t add_to_list_func,   //!< Add model to list function pointer
+    size_t                          model_size,         //!< Size of the model type
+    void **                         model_list_out,     //!< (out) List of models read from query, caller must free
+    int *                           model_list_cnt_out  //!< (out) Number of models read from query
+    )
+{
+cqlite_rcode_t          rcode = CQLITE_ERROR;
+cqlite_pool_conn_t *    conn;
+
+*model_list_out = NULL;
+*model_list_cnt_out = 0;
+
+if( CQLITE_SUCCESS == cqlite_pool_reader_acquire( pool, &conn ) )
+    {
+    rcode = cqlite_stmt_cache_select_query_execute( conn->stmt_cache, select_query_str, count_query_str, add_to_list_func, model_size, model_list_out, model_list_cnt_out );
+
+    // Clean up
+    cqlite_pool_release( pool, conn );
+    }
+
+return rcode;
+}
+
+
+// Acquire write connection.
+cqlite_rcode_t cqlite_pool_writer_acquire
+    (
+    cqlite_pool_t *         pool,       //!< Connection pool
+    cqlite_pool_conn_t **   conn_out    //!< (out) Write connection, caller must release
+    )
+{
+pthread_mutex_lock( &pool->writer_mutex );
+
+*conn_out = &pool->writer;
+
+return CQLITE_SUCCESS;
+}
+
+
+/**
+* Open pooled connection.
+*
+* Connections are opened without SQLite's per-connection mutex since
+* the pool guarantees that only one thread uses a connection at a time.
+*/
+static int pool_conn_open
+    (
+    char const * const      path,
+    int                     flags,
+    int                     stmt_cache_capacity,
+    cqlite_pool_conn_t *    conn
+    )
+{
+int success;
+
+success = ( SQLITE_OK == sqlite3_open_v2( path, &conn->db, flags | SQLITE_OPEN_NOMUTEX, NO_VFS ) ) &&
+          ( SQLITE_OK == sqlite3_busy_timeout( conn->db, BUSY_TIMEOUT_MS ) ) &&
+          ( CQLITE_SUCCESS == cqlite_stmt_cache_create( conn->db, stmt_cache_capacity, &conn->stmt_cache ) );
+
+atomic_init( &conn->in_use, 0 );
+
+return success;
+}
+
+
+/**
+* Close pooled connection.
+*/
+static void pool_conn_close
+    (
+    cqlite_pool_conn_t * conn
+    )
+{
+cqlite_stmt_cache_free( conn->stmt_cache );
+sqlite3_close( conn->db );
+
+conn->stmt_cache = NULL;
+conn->db = NULL;
+}
+
+
+/**
+* Try to acquire read connection.
+*
+* Checks out the first free read connection starting from the one the
+* calling thread used last without blocking. Returns NULL if all read
+* connections are checked out.
+*/
+static cqlite_pool_conn_t * pool_reader_try_acquire
+    (
+    cqlite_pool_t * pool
+    )
+{
+cqlite_pool_conn_t *    conn = NULL;
+int                     expected;
+int                     reader_idx;
+int                     i;
+
+if( NO_READER_HINT == t_reader_hint )
+    {
+    t_reader_hint = atomic_fetch_add( &s_next_reader_hint, 1 ) & 0x7fffffff;
+    }
+
+for( i = 0; ( NULL == conn ) && ( i < pool->reader_cnt ); i++ )
+    {
+    reader_idx = ( t_reader_hint + i ) % pool->reader_cnt;
+    expected = 0;
+
+    if( atomic_compare_exchange_strong( &pool->readers[reader_idx].in_use, &expected, 1 ) )
+        {
+        conn = &pool->readers[reader_idx];
+        t_reader_hint = reader_idx;
+        }
+    }
+
+return conn;
+}
@@ -0,0 +1,189 @@
+/** @file */
+
+#ifndef _CQLITE_POOL_H
+#define _CQLITE_POOL_H
+
+#include <sqlite3.h>
+
+#include "cqlite.h"
+#include "cqlite_stmt_cache.h"
+
+/**
+* Connection pool.
+*
+* Holds a fixed number of read-only connections and a single write
+* connection to one database file in WAL mode, so that any number of
+* threads can read concurrently with each other and with the writer.
+* Every connection has its own prepared statement cache. Connections are
+* checked out by one thread at a time and returned when done.
+*/
+typedef struct cqlite_pool_s cqlite_pool_t;
+
+/**
+* Pooled connection.
+*
+* A connection checked out of a cqlite_pool_t.
+*/
+typedef struct cqlite_pool_conn_s cqlite_pool_conn_t;
+
+/**
+* Close connection pool.
+*
+* Closes all connections of the pool and frees the pool. All connections
+* must have been released before calling this.
+*/
+void cqlite_pool_close
+    (
+    cqlite_pool_t * pool    //!< Pool to close
+    );
+
+/**
+* Get pooled connection database handle.
+*/
+sqlite3 * cqlite_pool_conn_db
+    (
+    cqlite_pool_conn_t const * conn //!< Pooled connection
+    );
+
+/**
+* Get pooled connection statement cache.
+*/
+cqlite_stmt_cache_t * cqlite_pool_conn_stmt_cache
+    (
+    cqlite_pool_conn_t const * conn //!< Pooled connection
+    );
+
+/**
+* Execute count query using connection pool.
+*
+* Executes the query on a read connection checked out for the duration
+* of the call.
+*
+* @see cqlite_count_query_execute()
+*/
+cqlite_rcode_t cqlite_pool_count_query_execute
+    (
+    cqlite_pool_t *     pool,               //!< Connection pool
+    char const * const  count_query_str,    //!< Parameter-less COUNT query string
+    int *               count_out           //!< (out) Returned count
+    );
+
+/**
+* Find model by id using connection pool.
+*
+* Executes the query on a read connection checked out for the duration
+* of the call.
+*
+* @see cqlite_find_by_id()
+*/
+cqlite_rcode_t cqlite_pool_find_by_id
+    (
+    cqlite_pool_t *                     pool,                   //!< Connection pool
+    char const * const                  find_by_id_query,       //!< SELECT query string taking a single id parameter
+    sqlite_int64                        id,                     //!< Id to search for
+    cqlite_model_from_row_result_func_t model_from_result_func, //!< Function to read the result into the model
+    int *                               found_out,              //!< (out) Was a record found?
+    void *                              model_out               //!< (out) Found model
+    );
+
+/**
+* Open connection pool.
+*
+* Opens reader_cnt read-only connections and one write connection to
+* the database file at the provided path, creating it if needed, and
+* switches the database to WAL mode. Each connection caches up to
+* stmt_cache_capacity prepared statements. The caller must call
+* cqlite_pool_close() on pool_out.
+*
+* Fails if the database cannot be put in WAL mode, as for in-memory
+* databases or on file systems without shared memory support.
+*/
+cqlite_rcode_t cqlite_pool_open
+    (
+    char const * const  path,                   //!< Path of the database file
+    int                 reader_cnt,             //!< Number of read connections
+    int                 stmt_cache_capacity,    //!< Number of prepared statements cached per connection
+    cqlite_pool_t **    pool_out                //!< (out) Connection pool, caller must close
+    );
+
+/**
+* Acquire read connection.
+*
+* Checks out one of the pool's read-only connections, blocking until one
+* is available. Each thread prefers the connection it used last, so that
+* threads rarely contend for the same connection. The caller must call
+* cqlite_pool_release() on conn_out.
+*/
+cqlite_rcode_t cqlite_pool_reader_acquire
+    (
+    cqlite_pool_t *         pool,       //!< Connection pool
+    cqlite_pool_conn_t **   conn_out    //!< (out) Read connection, caller must release
+    );
+
+/**
+* Try to acquire read connection.
+*
+* Checks out one of the pool's read-only connections like
+* cqlite_pool_reader_acquire(), but returns CQLITE_ERROR instead of
+* blocking if all of them are checked out. The caller must call
+* cqlite_pool_release() on conn_out.
+*/
+cqlite_rcode_t cqlite_pool_reader_try_acquire
+    (
+    cqlite_pool_t *         pool,       //!< Connection pool
+    cqlite_pool_conn_t **   conn_out    //!< (out) Read connection, caller must release
+    );
+
+/**
+* Get number of read connections.
+*/
+int cqlite_pool_reader_cnt
+    (
+    cqlite_pool_t const * pool  //!< Connection pool
+    );
+
+/**
+* Release pooled connection.
+*
+* Returns a read or write connection to the pool. Any statements on the
+* connection must have been reset or finalized.
+*/
+void cqlite_pool_release
+    (
+    cqlite_pool_t *         pool,   //!< Connection pool
+    cqlite_pool_conn_t *    conn    //!< Connection to release
+    );
+
+/**
+* Execute SELECT query using connection pool.
+*
+* Executes the query on a read connection checked out for the duration
+* of the call.
+*
+* @see cqlite_select_query_execute()
+*/
+cqlite_rcode_t cqlite_pool_select_query_execute
+    (
+    cqlite_pool_t *                 pool,               //!< Connection pool
+    char const * const              select_query_str,   //!< Parameter-less SELECT query string
+    char const * const              count_query_str,    //!< Parameter-less COUNT query string, NULL for single pass
+    cqlite_model_add_to_list_func_t add_to_list_func,   //!< Add model to list function pointer
+    size_t                          model_size,         //!< Size of the model type
+    void **                         model_list_out,     //!< (out) List of models read from query, caller must free
+    int *                           model_list_cnt_out  //!< (out) Number of models read from query
+    );
+
+/**
+* Acquire write connection.
+*
+* Checks out the pool's only write connection, blocking until it is
+* available. The caller must call cqlite_pool_release() on conn_out from
+* the same thread.
+*/
+cqlite_rcode_t cqlite_pool_writer_acquire
+    (
+    cqlite_pool_t *         pool,       //!< Connection pool
+    cqlite_pool_conn_t **   conn_out    //!< (out) Write connection, caller must release
+    );
+
+#endif
@@ -0,0 +1,290 @@
+#ifndef _CQLITE_PRIVATE_H
+#define _CQLITE_PRIVATE_H
+
+#include <sqlite3.h>
+
+#include "cqlite.h"
+#include "cqlite_stats.h"
+
+/*
+* Declarations shared between the CQLite modules that are not part of
+* the public interface.
+*/
+
+/**
+* Row read function type.
+*
+* Generalization of cqlite_model_add_to_list_func_t that is also passed
+* a context pointer so that the different SELECT variants can share a
+* single row loop. Returns 1 on success, 0 on error.
+*/
+typedef int (*cqlite_row_read_func_t)
+    (
+    sqlite3_stmt *  query,                  //!< Query pointing at row result
+    void *          model_list,             //!< List of all models returned so far
+    int             next_model_list_idx,    //!< Index into the model list into which the query row result should be read
+    void *          context                 //!< Context provided by the caller of cqlite_select_rows_read()
+    );
+
+/**
+* Row bind function type.
+*
+* Generalization of cqlite_model_bind_func_t that is also passed a
+* context pointer so that the different INSERT variants can share a
+* single batch loop. Returns 1 on success, 0 on error.
+*/
+typedef int (*cqlite_row_bind_func_t)
+    (
+    sqlite3_stmt *  query,      //!< Prepared query to bind the model to
+    void const *    model,      //!< Model whose fields are bound
+    void *          context     //!< Context provided by the caller of cqlite_insert_rows()
+    );
+
+/**
+* Find many query prepare function type.
+*
+* Prepares the query made of the prefix followed by an IN-list of
+* chunk_size parameters, or of more parameters, which are bound by
+* repeating the last id of each chunk. The query is set in query_out
+* even on error if it was prepared, and is cleaned up by the caller of
+* cqlite_find_many_rows(). Returns 1 on success, 0 on error.
+*/
+typedef int (*cqlite_find_many_prepare_func_t)
+    (
+    char const *    find_many_query_prefix, //!< SELECT query string ending in "IN "
+    int             chunk_size,             //!< Minimum number of parameters in the IN-list
+    void *          context,                //!< Context provided by the caller of cqlite_find_many_rows()
+    sqlite3_stmt ** query_out               //!< (out) Prepared query
+    );
+
+/**
+* Instrumented call.
+*
+* Accumulates the statistics of a single call on the stack until
+* cqlite_stats_call_end() adds them to the process-wide statistics.
+* All of its functions do nothing if statistics were disabled when the
+* call began, except for tracking the innermost call of each thread.
+*/
+typedef struct cqlite_stats_call_s
+    {
+    struct cqlite_stats_call_s *    outer;                              //!< Call this one is nested in on the same thread
+    cqlite_stats_api_t              api;                                //!< Function group of the call
+    unsigned int                    flags;                              //!< CQLITE_STATS_* flags at the start of the call
+    unsigned int                    phase_mask;                         //!< Bit of each phase the call entered
+    sqlite_int64                    start_ns;                           //!< Time the call began
+    sqlite_int64                    phase_ns[CQLITE_STATS_PHASE_CNT];   //!< Time spent in each phase
+    sqlite_int64                    rows_read;                          //!< Number of rows read into models
+    sqlite_int64                    bytes_allocated;                    //!< Bytes allocated for models
+    } cqlite_stats_call_t;
+
+/**
+* Add allocated bytes to statistics.
+*
+* Adds to the innermost call in progress on the calling thread, if any.
+*/
+void cqlite_stats_bytes_add
+    (
+    size_t size //!< Number of bytes allocated
+    );
+
+/**
+* Begin instrumented call.
+*/
+void cqlite_stats_call_begin
+    (
+    cqlite_stats_call_t *   call,   //!< Call to begin
+    cqlite_stats_api_t      api     //!< Function group of the call
+    );
+
+/**
+* End instrumented call.
+*
+* Adds the call to the process-wide statistics along with the
+* sqlite3_stmt_status() counters of query if they are enabled.
+*/
+void cqlite_stats_call_end
+    (
+    cqlite_stats_call_t *   call,   //!< Call to end
+    sqlite3_stmt *          query,  //!< Statement executed by the call, may be NULL
+    int                     success //!< Did the call succeed?
+    );
+
+/**
+* Get time for instrumented call.
+*
+* Returns the current time in nanoseconds, or 0 if the call is not
+* collecting statistics.
+*/
+sqlite_int64 cqlite_stats_clock
+    (
+    cqlite_stats_call_t const * call    //!< Instrumented call
+    );
+
+/**
+* Get function group of current call.
+*
+* Returns 1 and sets api_out if the calling thread is inside an
+* instrumented call, whether or not statistics are enabled, otherwise
+* returns 0.
+*/
+int cqlite_stats_current_api
+    (
+    cqlite_stats_api_t *    api_out     //!< (out) Function group of the innermost call
+    );
+
+/**
+* End phase of instrumented call.
+*
+* Adds the time since start_ns to the provided phase of the call and
+* returns the current time, so that consecutive phases can be chained.
+*/
+sqlite_int64 cqlite_stats_phase_end
+    (
+    cqlite_stats_call_t *   call,       //!< Instrumented call
+    cqlite_stats_phase_t    phase,      //!< Phase that ended
+    sqlite_int64            start_ns    //!< Time the phase began
+    );
+
+/**
+* Begin preparing statement.
+*
+* Returns the current time in nanoseconds, or 0 if statistics are
+* disabled.
+*/
+sqlite_int64 cqlite_stats_prepare_begin
+    (
+    void
+    );
+
+/**
+* End preparing statement.
+*
+* Records the time since start_ns in the PREPARE phase of the provided
+* function group.
+*/
+void cqlite_stats_prepare_end
+    (
+    cqlite_stats_api_t  api,        //!< Function group preparing the statement
+    sqlite_int64        start_ns    //!< Value returned by cqlite_stats_prepare_begin()
+    );
+
+/**
+* Step count query.
+*
+* Reads the result of a COUNT query and resets it, without recording it
+* as a call in the statistics, for use by the other instrumented calls.
+* Returns 1 on success, 0 on error, including counts that do not fit in
+* an int.
+*/
+int cqlite_count_query_step
+    (
+    sqlite3_stmt *  count_query,    //!< Prepared COUNT query
+    int *           count_out       //!< (out) Returned count
+    );
+
+/**
+* Step 64-bit count query.
+*
+* Same as cqlite_count_query_step() for counts that may not fit in an
+* int.
+*/
+int cqlite_count_query_step_int64
+    (
+    sqlite3_stmt *  count_query,    //!< Prepared COUNT query
+    sqlite_int64 *  count_out       //!< (out) Returned count
+    );
+
+/**
+* Build find many query.
+*
+* Appends an IN-list of chunk_size parameters to the query prefix.
+* Returns a string the caller must free, or NULL on error.
+*/
+char * cqlite_find_many_query_build
+    (
+    char const *    find_many_query_prefix, //!< SELECT query string ending in "IN "
+    int             chunk_size              //!< Number of parameters in the IN-list
+    );
+
+/**
+* Find many models by id using any prepare function.
+*
+* Implements cqlite_find_many_by_ids() for any prepare function. The
+* query is set in select_query_out once prepared, and the caller must
+* finalize or release it whether or not the function succeeds.
+*/
+cqlite_rcode_t cqlite_find_many_rows
+    (
+    cqlite_find_many_prepare_func_t     prepare_func,           //!< Function to prepare the query for a chunk size
+    void *                              context,                //!< Context passed to prepare_func
+    char const * const                  find_many_query_prefix, //!< SELECT query string ending in "IN "
+    int                                 id_column,              //!< Result column holding the id
+    sqlite_int64 const *                ids,                    //!< Ids to search for
+    int                                 id_cnt,                 //!< Number of ids
+    cqlite_model_from_row_result_func_t model_from_result_func, //!< Function to read a result into a model
+    size_t                              model_size,             //!< Size of the model type
+    void *                              model_list,             //!< (out) Found models in the order of ids
+    unsigned char *                     found_bits,             //!< (out) Bit of each id that was found
+    sqlite3_stmt **                     select_query_out        //!< (out) Prepared query, caller must clean up regardless of the result
+    );
+
+/**
+* Insert models in batches.
+*
+* Implements cqlite_insert_many_prepared() for any row bind function.
+*/
+cqlite_rcode_t cqlite_insert_rows
+    (
+    sqlite3 *               db,                 //!< Database on which to execute the query
+    sqlite3_stmt *          insert_query,       //!< Prepared INSERT query
+    cqlite_row_bind_func_t  row_bind_func,      //!< Function to bind a model to the query
+    void *                  context,            //!< Context passed to row_bind_func
+    void const *            model_list,         //!< List of models to insert
+    size_t                  model_size,         //!< Size of the model type
+    int                     model_list_cnt,     //!< Number of models to insert
+    int                     batch_size,         //!< Number of models inserted per transaction
+    sqlite_int64 **         row_ids_out         //!< (out) Generated row id of each model, caller must free, may be NULL
+    );
+
+/**
+* Is the journal mode WAL?
+*
+* Setting the journal mode does not fail when the database cannot use
+* WAL, as for in-memory databases or on file systems without shared
+* memory, it silently keeps the previous mode instead, so it must be
+* read back. Returns 1 if the mode is WAL, 0 otherwise or on error.
+*/
+int cqlite_journal_mode_is_wal
+    (
+    sqlite3 * db    //!< Database to check
+    );
+
+/**
+* Hash query string.
+*
+* Computes the 32-bit FNV-1a hash of the query string, for the caches
+* keyed by SQL text.
+*/
+unsigned int cqlite_query_str_hash
+    (
+    char const * query_str  //!< Query string to hash
+    );
+
+/**
+* Read SELECT query rows into model list.
+*
+* Implements cqlite_select_query_execute_prepared() for any row read
+* function, including its single-pass mode when count_query is NULL.
+*/
+cqlite_rcode_t cqlite_select_rows_read
+    (
+    sqlite3_stmt *          select_query,       //!< Prepared SELECT query
+    sqlite3_stmt *          count_query,        //!< Prepared COUNT query, NULL for single pass
+    cqlite_row_read_func_t  row_read_func,      //!< Function to read a row into the model list
+    void *                  context,            //!< Context passed to row_read_func
+    size_t                  model_size,         //!< Size of the model type
+    void **                 model_list_out,     //!< (out) List of models read from query, caller must free
+    int *                   model_list_cnt_out  //!< (out) Number of models read from query
+    );
+
+#endif
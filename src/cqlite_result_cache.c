@@ -0,0 +1,1110 @@
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "cqlite_private.h"
+#include "cqlite_result_cache.h"
+#include "cqlite_stmt_cache.h"
+
+#define READ_TO_END             ( -1 )
+#define NO_TAIL                 ( NULL )
+#define INTERNAL_TABLE_PREFIX   ( "sqlite_" )
+
+
+/**********************************************
+Types
+**********************************************/
+struct cqlite_cached_result_s
+    {
+    atomic_int                  ref_cnt;            //!< Number of references held by the cache and callers
+    void *                      model_list;         //!< Models read from the query
+    int                         model_cnt;          //!< Number of models
+    size_t                      model_size;         //!< Size of the model type
+    cqlite_model_free_func_t    model_free_func;    //!< Function to free the memory owned by a model, may be NULL
+    };
+
+// Table read by cached results
+typedef struct result_cache_table_s
+    {
+    char *                          name;       //!< Name of the table
+    int                             ref_cnt;    //!< Number of entries reading the table
+    struct result_cache_table_s *   next;       //!< Next table read by any entry
+    } result_cache_table_t;
+
+typedef struct result_cache_entry_s
+    {
+    char *                          key;            //!< SQL text along with the exact value of each bound parameter
+    unsigned int                    hash;           //!< Hash of the key
+    int                             is_count;       //!< Is this the count of a COUNT query rather than a SELECT result?
+    int                             count;          //!< Cached count
+    cqlite_cached_result_t *        result;         //!< Cached SELECT result
+    result_cache_table_t **         tables;         //!< Tables read by the queries
+    int                             table_cnt;      //!< Number of tables
+    struct result_cache_entry_s *   bucket_next;    //!< Next entry in the same hash bucket
+    struct result_cache_entry_s *   prev;           //!< Previous entry in the LRU list
+    struct result_cache_entry_s *   next;           //!< Next entry in the LRU list
+    } result_cache_entry_t;
+
+struct cqlite_result_cache_s
+    {
+    sqlite3 *                       db;                 //!< Connection whose results are cached
+    cqlite_stmt_cache_t *           stmt_cache;         //!< Statements used to expand the parameters of lookups
+    sqlite3_stmt *                  version_query;      //!< Query returning the data and schema versions
+    sqlite_int64                    data_version;       //!< Data version when last looked
+    sqlite_int64                    schema_version;     //!< Schema version when last looked
+    sqlite_int64                    total_changes;      //!< Rows changed by the connection when last looked
+    sqlite_int64                    hooked_changes;     //!< Rows changed that reached the update hook since last looked
+    int                             capacity;           //!< Maximum number of entries
+    int                             entry_cnt;          //!< Number of entries
+    unsigned int                    bucket_cnt;         //!< Number of hash buckets, always a power of two
+    result_cache_entry_t **         buckets;            //!< Hash buckets keyed by SQL text
+    result_cache_entry_t *          lru_head;           //!< Most recently used entry
+    result_cache_entry_t *          lru_tail;           //!< Least recently used entry
+    result_cache_table_t *          tables;             //!< Tables read by any entry
+    int                             has_pending_writes; //!< Has the connection written since its last commit or rollback?
+    int                             is_capturing;       //!< Is the authorizer collecting the tables read by a query?
+    int                             capture_failed;     //!< Did collecting the tables fail?
+    char **                         capture_names;      //!< Names of the tables collected so far
+    int                             capture_cnt;        //!< Number of tables collected
+    int                             capture_capacity;   //!< Capacity of capture_names
+    cqlite_result_cache_stats_t     stats;              //!< Cache statistics
+    };
+
+
+/**********************************************
+Functions
+**********************************************/
+static int authorize
+    (
+    void *          context,
+    int             action,
+    char const *    arg1,
+    char const *    arg2,
+    char const *    db_name,
+    char const *    trigger_name
+    );
+
+static void capture_reset
+    (
+    cqlite_result_cache_t * cache
+    );
+
+static int commit_hook
+    (
+    void * context
+    );
+
+static int entry_add
+    (
+    cqlite_result_cache_t *     cache,
+    char const *                key,
+    unsigned int                hash,
+    int                         is_count,
+    int                         count,
+    cqlite_cached_result_t *    result
+    );
+
+static result_cache_entry_t * entry_find
+    (
+    cqlite_result_cache_t * cache,
+    char const *            key,
+    unsigned int            hash,
+    int                     is_count
+    );
+
+static void entry_free
+    (
+    cqlite_result_cache_t * cache,
+    result_cache_entry_t *  entry
+    );
+
+static void entry_touch
+    (
+    cqlite_result_cache_t * cache,
+    result_cache_entry_t *  entry
+    );
+
+static int key_build
+    (
+    cqlite_result_cache_t *     cache,
+    char const *                query_str,
+    cqlite_model_bind_func_t    params_bind_func,
+    void const *                params,
+    char **                     key_out
+    );
+
+static int query_prepare_captured
+    (
+    cqlite_result_cache_t * cache,
+    char const *            query_str,
+    sqlite3_stmt **         query_out
+    );
+
+static void rollback_hook
+    (
+    void * context
+    );
+
+static void table_release
+    (
+    cqlite_result_cache_t * cache,
+    result_cache_table_t *  table
+    );
+
+static void update_hook
+    (
+    void *          context,
+    int             operation,
+    char const *    db_name,
+    char const *    table_name,
+    sqlite_int64    row_id
+    );
+
+static void versions_check
+    (
+    cqlite_result_cache_t * cache
+    );
+
+
+// Get cached result models.
+void const * cqlite_cached_result_models
+    (
+    cqlite_cached_result_t const *  result,         //!< Cached result
+    int *                           model_cnt_out   //!< (out) Number of models in the list
+    )
+{
+*model_cnt_out = result->model_cnt;
+
+return result->model_list;
+}
+
+
+// Release cached result.
+void cqlite_cached_result_release
+    (
+    cqlite_cached_result_t * result    //!< Result to release, may be NULL
+    )
+{
+int i;
+
+if( ( NULL != result ) && ( 1 == atomic_fetch_sub( &result->ref_cnt, 1 ) ) )
+    {
+    for( i = 0; ( NULL != result->model_free_func ) && ( i < result->model_cnt ); i++ )
+        {
+        result->model_free_func( (char*)result->model_list + ( i * result->model_size ) );
+        }
+
+    free( result->model_list );
+    free( result );
+    }
+}
+
+
+// Clear query result cache.
+void cqlite_result_cache_clear
+    (
+    cqlite_result_cache_t * cache   //!< Query result cache
+    )
+{
+while( NULL != cache->lru_head )
+    {
+    entry_free( cache, cache->lru_head );
+    }
+}
+
+
+// Execute count query using query result cache.
+cqlite_rcode_t cqlite_result_cache_count_query_execute
+    (
+    cqlite_result_cache_t * cache,              //!< Query result cache
+    char const * const      count_query_str,    //!< Parameter-less COUNT query string
+    int *                   count_out           //!< (out) Returned count
+    )
+{
+cqlite_rcode_t          rcode = CQLITE_ERROR;
+unsigned int            hash;
+result_cache_entry_t *  entry;
+sqlite3_stmt *          count_query = NULL;
+
+*count_out = 0;
+
+versions_check( cache );
+
+hash = cqlite_query_str_hash( count_query_str );
+entry = entry_find( cache, count_query_str, hash, 1 );
+
+if( NULL != entry )
+    {
+    cache->stats.hits++;
+    entry_touch( cache, entry );
+
+    *count_out = entry->count;
+    rcode = CQLITE_SUCCESS;
+    }
+else
+    {
+    cache->stats.misses++;
+
+    if( query_prepare_captured( cache, count_query_str, &count_query ) )
+        {
+        rcode = cqlite_count_query_execute_prepared( count_query, count_out );
+        }
+
+    if( ( CQLITE_SUCCESS == rcode ) && !cache->has_pending_writes )
+        {
+        // Failing to cache the count is not fatal.
+        entry_add( cache, count_query_str, hash, 1, *count_out, NULL );
+        }
+    }
+
+// Clean up
+sqlite3_finalize( count_query );
+capture_reset( cache );
+
+return rcode;
+}
+
+
+// Create query result cache.
+cqlite_rcode_t cqlite_result_cache_create
+    (
+    sqlite3 *                   db,         //!< Database connection whose results are cached
+    int                         capacity,   //!< Maximum number of cached results
+    cqlite_result_cache_t **    cache_out   //!< (out) Query result cache, caller must free
+    )
+{
+cqlite_rcode_t          rcode = CQLITE_ERROR;
+int                     success;
+cqlite_result_cache_t * cache;
+
+*cache_out = NULL;
+
+cache = calloc( 1, sizeof( *cache ) );
+success = ( NULL != cache ) && ( capacity > 0 );
+
+if( success )
+    {
+    cache->db = db;
+    cache->capacity = capacity;
+    cache->data_version = -1;
+    cache->schema_version = -1;
+    cache->total_changes = sqlite3_total_changes64( db );
+
+    // Keep the load factor of the hash table at or below one half.
+    cache->bucket_cnt = 1;
+    while( cache->bucket_cnt < ( 2u * (unsigned int)capacity ) )
+        {
+        cache->bucket_cnt *= 2;
+        }
+
+    cache->buckets = calloc( cache->bucket_cnt, sizeof( *cache->buckets ) );
+    success = ( NULL != cache->buckets ) &&
+              ( CQLITE_SUCCESS == cqlite_stmt_cache_create( db, capacity, &cache->stmt_cache ) ) &&
+              ( SQLITE_OK == sqlite3_prepare_v3( db, "SELECT d.data_version, s.schema_version FROM pragma_data_version AS d, pragma_schema_version AS s;", READ_TO_END, SQLITE_PREPARE_PERSISTENT, &cache->version_query, NO_TAIL ) );
+    }
+
+if( success )
+    {
+    sqlite3_set_authorizer( db, authorize, cache );
+    sqlite3_update_hook( db, update_hook, cache );
+    sqlite3_commit_hook( db, commit_hook, cache );
+    sqlite3_rollback_hook( db, rollback_hook, cache );
+
+    rcode = CQLITE_SUCCESS;
+    *cache_out = cache;
+    }
+else if( NULL != cache )
+    {
+    sqlite3_finalize( cache->version_query );
+    cqlite_stmt_cache_free( cache->stmt_cache );
+    free( cache->buckets );
+    free( cache );
+    }
+
+return rcode;
+}
+
+
+// Free query result cache.
+void cqlite_result_cache_free
+    (
+    cqlite_result_cache_t * cache   //!< Query result cache
+    )
+{
+if( NULL != cache )
+    {
+    sqlite3_set_authorizer( cache->db, NULL, NULL );
+    sqlite3_update_hook( cache->db, NULL, NULL );
+    sqlite3_commit_hook( cache->db, NULL, NULL );
+    sqlite3_rollback_hook( cache->db, NULL, NULL );
+
+    cqlite_result_cache_clear( cache );
+
+    sqlite3_finalize( cache->version_query );
+    cqlite_stmt_cache_free( cache->stmt_cache );
+    free( cache->capture_names );
+    free( cache->buckets );
+    free( cache );
+    }
+}
+
+
+// Execute SELECT query using query result cache.
+cqlite_rcode_t cqlite_result_cache_select_query_execute
+    (
+    cqlite_result_cache_t *         cache,              //!< Query result cache
+    char const * const              select_query_str,   //!< SELECT query string
+    char const * const              count_query_str,    //!< COUNT query string taking the same parameters, NULL for single pass
+    cqlite_model_bind_func_t        params_bind_func,   //!< Function to bind params to the queries, NULL if parameter-less
+    void const *                    params,             //!< Parameters passed to params_bind_func
+    cqlite_model_add_to_list_func_t add_to_list_func,   //!< Add model to list function pointer
+    cqlite_model_free_func_t        model_free_func,    //!< Function to free the memory owned by a model, may be NULL
+    size_t                          model_size,         //!< Size of the model type
+    cqlite_cached_result_t **       result_out          //!< (out) Cached result, caller must release
+    )
+{
+cqlite_rcode_t              rcode = CQLITE_ERROR;
+int                         success = 1;
+unsigned int                hash;
+char *                      params_key = NULL;
+char const *                key;
+result_cache_entry_t *      entry;
+cqlite_cached_result_t *    result = NULL;
+sqlite3_stmt *              select_query = NULL;
+sqlite3_stmt *              count_query = NULL;
+
+*result_out = NULL;
+
+versions_check( cache );
+
+// Parameter-less queries are keyed by their SQL text alone. Otherwise
+// the key holds the exact value of every bound parameter as well.
+key = select_query_str;
+
+if( NULL != params_bind_func )
+    {
+    success = key_build( cache, select_query_str, params_bind_func, params, &params_key );
+    key = params_key;
+    }
+
+if( success )
+    {
+    hash = cqlite_query_str_hash( key );
+    entry = entry_find( cache, key, hash, 0 );
+
+    if( NULL != entry )
+        {
+        cache->stats.hits++;
+        entry_touch( cache, entry );
+
+        result = entry->result;
+        atomic_fetch_add( &result->ref_cnt, 1 );
+        rcode = CQLITE_SUCCESS;
+        }
+    else
+        {
+        cache->stats.misses++;
+
+        result = calloc( 1, sizeof( *result ) );
+        success = ( NULL != result );
+
+        if( success )
+            {
+            atomic_init( &result->ref_cnt, 1 );
+            result->model_size = model_size;
+            result->model_free_func = model_free_func;
+            }
+
+        // The queries are prepared afresh so that the authorizer sees
+        // every table they read.
+        success = success &&
+                  query_prepare_captured( cache, select_query_str, &select_query ) &&
+                  ( ( NULL == count_query_str ) || query_prepare_captured( cache, count_query_str, &count_query ) );
+
+        success = success &&
+                  ( ( NULL == params_bind_func ) ||
+                    ( params_bind_func( select_query, params ) && ( ( NULL == count_query ) || params_bind_func( count_query, params ) ) ) );
+
+        if( success )
+            {
+            rcode = cqlite_select_query_execute_prepared( select_query, count_query, add_to_list_func, model_size, &result->model_list, &result->model_cnt );
+            }
+
+        if( ( CQLITE_SUCCESS == rcode ) && !cache->has_pending_writes )
+            {
+            // Failing to cache the result is not fatal.
+            entry_add( cache, key, hash, 0, 0, result );
+            }
+        }
+    }
+
+if( CQLITE_SUCCESS == rcode )
+    {
+    *result_out = result;
+    }
+else
+    {
+    cqlite_cached_result_release( result );
+    }
+
+// Clean up
+sqlite3_finalize( count_query );
+sqlite3_finalize( select_query );
+sqlite3_free( params_key );
+capture_reset( cache );
+
+return rcode;
+}
+
+
+// Get query result cache statistics.
+void cqlite_result_cache_stats_get
+    (
+    cqlite_result_cache_t const *   cache,      //!< Query result cache
+    cqlite_result_cache_stats_t *   stats_out   //!< (out) Cache statistics
+    )
+{
+*stats_out = cache->stats;
+}
+
+
+/**
+* Authorize statement action.
+*
+* Collects the tables read by a statement being prepared while
+* capturing, and disables the truncate optimization of DELETE
+* statements on user tables so that the update hook sees every deleted
+* row. Never denies an action.
+*/
+static int authorize
+    (
+    void *          context,
+    int             action,
+    char const *    arg1,
+    char const *    arg2,
+    char const *    db_name,
+    char const *    trigger_name
+    )
+{
+cqlite_result_cache_t * cache;
+int                     rc = SQLITE_OK;
+int                     i;
+char **                 names;
+
+cache = (cqlite_result_cache_t*)context;
+
+if( ( SQLITE_READ == action ) && cache->is_capturing && ( NULL != arg1 ) )
+    {
+    for( i = 0; ( i < cache->capture_cnt ) && ( 0 != strcasecmp( arg1, cache->capture_names[i] ) ); i++ );
+
+    if( ( i == cache->capture_cnt ) && ( cache->capture_cnt == cache->capture_capacity ) )
+        {
+        names = realloc( cache->capture_names, ( 2 * cache->capture_capacity + 1 ) * sizeof( *names ) );
+
+        if( NULL != names )
+            {
+            cache->capture_names = names;
+            cache->capture_capacity = 2 * cache->capture_capacity + 1;
+            }
+        }
+
+    if( ( i == cache->capture_cnt ) && ( cache->capture_cnt < cache->capture_capacity ) )
+        {
+        cache->capture_names[cache->capture_cnt] = strdup( arg1 );
+        cache->capture_failed |= ( NULL == cache->capture_names[cache->capture_cnt] );
+        cache->capture_cnt += ( NULL != cache->capture_names[cache->capture_cnt] );
+        }
+    else if( i == cache->capture_cnt )
+        {
+        cache->capture_failed = 1;
+        }
+    }
+else if( ( SQLITE_DELETE == action ) && ( NULL != arg1 ) && ( 0 != strncmp( arg1, INTERNAL_TABLE_PREFIX, strlen( INTERNAL_TABLE_PREFIX ) ) ) )
+    {
+    // Ignoring a DELETE only bypasses the truncate optimization, the
+    // rows are still deleted one at a time.
+    rc = SQLITE_IGNORE;
+    }
+
+return rc;
+}
+
+
+/**
+* Reset table capture.
+*
+* Forgets the tables collected for the previous lookup.
+*/
+static void capture_reset
+    (
+    cqlite_result_cache_t * cache
+    )
+{
+int i;
+
+for( i = 0; i < cache->capture_cnt; i++ )
+    {
+    free( cache->capture_names[i] );
+    }
+
+cache->capture_cnt = 0;
+cache->capture_failed = 0;
+}
+
+
+/**
+* Commit hook.
+*
+* Cached results may be added again once the connection's writes are
+* committed. Never turns the commit into a rollback.
+*/
+static int commit_hook
+    (
+    void * context
+    )
+{
+( (cqlite_result_cache_t*)context )->has_pending_writes = 0;
+
+return 0;
+}
+
+
+/**
+* Add cache entry.
+*
+* Caches the count or result under the key along with the tables
+* collected while preparing its queries, evicting the least recently
+* used entry if the cache is full. Returns 1 on success, 0 on error.
+*/
+static int entry_add
+    (
+    cqlite_result_cache_t *     cache,
+    char const *                key,
+    unsigned int                hash,
+    int                         is_count,
+    int                         count,
+    cqlite_cached_result_t *    result
+    )
+{
+int                     success;
+int                     i;
+result_cache_entry_t *  entry;
+result_cache_entry_t ** bucket;
+result_cache_table_t *  table;
+
+success = !cache->capture_failed;
+
+if( success && ( cache->entry_cnt >= cache->capacity ) )
+    {
+    cache->stats.evictions++;
+    entry_free( cache, cache->lru_tail );
+    }
+
+entry = success ? calloc( 1, sizeof( *entry ) ) : NULL;
+success = ( NULL != entry );
+
+if( success )
+    {
+    entry->key = strdup( key );
+    entry->tables = calloc( cache->capture_cnt + 1, sizeof( *entry->tables ) );
+    success = ( NULL != entry->key ) && ( NULL != entry->tables );
+    }
+
+// Reference the tables read by the entry, adding the ones no other
+// entry reads yet.
+for( i = 0; success && ( i < cache->capture_cnt ); i++ )
+    {
+    for( table = cache->tables; ( NULL != table ) && ( 0 != strcasecmp( table->name, cache->capture_names[i] ) ); table = table->next );
+
+    if( NULL == table )
+        {
+        table = calloc( 1, sizeof( *table ) );
+        success = ( NULL != table ) && ( NULL != ( table->name = strdup( cache->capture_names[i] ) ) );
+
+        if( success )
+            {
+            table->next = cache->tables;
+            cache->tables = table;
+            }
+        else
+            {
+            free( table );
+            }
+        }
+
+    if( success )
+        {
+        table->ref_cnt++;
+        entry->tables[entry->table_cnt++] = table;
+        }
+    }
+
+if( success )
+    {
+    entry->hash = hash;
+    entry->is_count = is_count;
+    entry->count = count;
+    entry->result = result;
+
+    if( NULL != result )
+        {
+        atomic_fetch_add( &result->ref_cnt, 1 );
+        }
+
+    bucket = &cache->buckets[hash & ( cache->bucket_cnt - 1 )];
+    entry->bucket_next = *bucket;
+    *bucket = entry;
+
+    entry->next = cache->lru_head;
+    cache->lru_head = entry;
+
+    if( NULL != entry->next )
+        {
+        entry->next->prev = entry;
+        }
+    else
+        {
+        cache->lru_tail = entry;
+        }
+
+    cache->entry_cnt++;
+    }
+else if( NULL != entry )
+    {
+    for( i = 0; i < entry->table_cnt; i++ )
+        {
+        table_release( cache, entry->tables[i] );
+        }
+
+    free( entry->tables );
+    free( entry->key );
+    free( entry );
+    }
+
+return success;
+}
+
+
+/**
+* Find cache entry.
+*/
+static result_cache_entry_t * entry_find
+    (
+    cqlite_result_cache_t * cache,
+    char const *            key,
+    unsigned int            hash,
+    int                     is_count
+    )
+{
+result_cache_entry_t * entry;
+
+for( entry = cache->buckets[hash & ( cache->bucket_cnt - 1 )]; NULL != entry; entry = entry->bucket_next )
+    {
+    if( ( hash == entry->hash ) && ( is_count == entry->is_count ) && ( 0 == strcmp( key, entry->key ) ) )
+        {
+        break;
+        }
+    }
+
+return entry;
+}
+
+
+/**
+* Free cache entry.
+*
+* Removes the entry from the cache, drops the cache's reference to its
+* result, and frees the tables no other entry reads.
+*/
+static void entry_free
+    (
+    cqlite_result_cache_t * cache,
+    result_cache_entry_t *  entry
+    )
+{
+int                     i;
+result_cache_entry_t ** link;
+
+// Unlink the entry from its hash bucket
+link = &cache->buckets[entry->hash & ( cache->bucket_cnt - 1 )];
+
+while( *link != entry )
+    {
+    link = &( *link )->bucket_next;
+    }
+
+*link = entry->bucket_next;
+
+// Unlink the entry from the LRU list
+if( NULL != entry->prev )
+    {
+    entry->prev->next = entry->next;
+    }
+else
+    {
+    cache->lru_head = entry->next;
+    }
+
+if( NULL != entry->next )
+    {
+    entry->next->prev = entry->prev;
+    }
+else
+    {
+    cache->lru_tail = entry->prev;
+    }
+
+cache->entry_cnt--;
+
+for( i = 0; i < entry->table_cnt; i++ )
+    {
+    table_release( cache, entry->tables[i] );
+    }
+
+cqlite_cached_result_release( entry->result );
+free( entry->tables );
+free( entry->key );
+free( entry );
+}
+
+
+/**
+* Mark cache entry as most recently used.
+*/
+static void entry_touch
+    (
+    cqlite_result_cache_t * cache,
+    result_cache_entry_t *  entry
+    )
+{
+if( cache->lru_head != entry )
+    {
+    entry->prev->next = entry->next;
+
+    if( NULL != entry->next )
+        {
+        entry->next->prev = entry->prev;
+        }
+    else
+        {
+        cache->lru_tail = entry->prev;
+        }
+
+    entry->prev = NULL;
+    entry->next = cache->lru_head;
+    cache->lru_head->prev = entry;
+    cache->lru_head = entry;
+    }
+}
+
+
+/**
+* Build key of parameterized query.
+*
+* Binds the parameters to a statement that selects each parameter of
+* the query under the same name and index, and appends the type and
+* exact value of each to the query's SQL text, which is prefixed with
+* its length so that no parameter-less query has the same key.
+* sqlite3_expanded_sql() is not used since it prints REAL values with
+* only 15 significant digits, giving distinct values the same key. The
+* caller must call sqlite3_free() on key_out. Returns 1 on success, 0 on
+* error.
+*/
+static int key_build
+    (
+    cqlite_result_cache_t *     cache,
+    char const *                query_str,
+    cqlite_model_bind_func_t    params_bind_func,
+    void const *                params,
+    char **                     key_out
+    )
+{
+int                     success;
+int                     i;
+int                     j;
+int                     param_cnt = 0;
+int                     type;
+int                     size;
+double                  real;
+sqlite3_uint64          real_bits;
+unsigned char const *   bytes;
+char const *            name;
+char *                  params_query_str = NULL;
+sqlite3_str *           str;
+sqlite3_stmt *          query = NULL;
+
+*key_out = NULL;
+
+success = ( CQLITE_SUCCESS == cqlite_stmt_cache_acquire( cache->stmt_cache, query_str, &query ) );
+
+// Unnamed parameters are numbered explicitly, so named ones that
+// follow them in index order keep their index.
+if( success )
+    {
+    param_cnt = sqlite3_bind_parameter_count( query );
+    str = sqlite3_str_new( cache->db );
+    sqlite3_str_appendall( str, ( param_cnt > 0 ) ? "SELECT " : "SELECT NULL" );
+
+    for( i = 1; i <= param_cnt; i++ )
+        {
+        name = sqlite3_bind_parameter_name( query, i );
+
+        if( NULL != name )
+            {
+            sqlite3_str_appendf( str, "%s%s", ( i > 1 ) ? ", " : "", name );
+            }
+        else
+            {
+            sqlite3_str_appendf( str, "%s?%d", ( i > 1 ) ? ", " : "", i );
+            }
+        }
+
+    sqlite3_str_appendall( str, ";" );
+    params_query_str = sqlite3_str_finish( str );
+    success = ( NULL != params_query_str );
+
+    cqlite_stmt_cache_release( cache->stmt_cache, query );
+    query = NULL;
+    }
+
+success = success &&
+          ( CQLITE_SUCCESS == cqlite_stmt_cache_acquire( cache->stmt_cache, params_query_str, &query ) ) &&
+          params_bind_func( query, params ) &&
+          ( SQLITE_ROW == sqlite3_step( query ) );
+
+if( success )
+    {
+    str = sqlite3_str_new( cache->db );
+    sqlite3_str_appendf( str, "%d:%s", (int)strlen( query_str ), query_str );
+
+    for( i = 0; i < param_cnt; i++ )
+        {
+        type = sqlite3_column_type( query, i );
+
+        switch( type )
+            {
+            case SQLITE_INTEGER:
+                sqlite3_str_appendf( str, "\nI%lld", (long long)sqlite3_column_int64( query, i ) );
+                break;
+
+            case SQLITE_FLOAT:
+                real = sqlite3_column_double( query, i );
+                memcpy( &real_bits, &real, sizeof( real_bits ) );
+                sqlite3_str_appendf( str, "\nR%016llx", (unsigned long long)real_bits );
+                break;
+
+            case SQLITE_TEXT:
+            case SQLITE_BLOB:
+                // Text is hex-encoded like blobs since it may hold NULs
+                bytes = ( SQLITE_TEXT == type ) ? sqlite3_column_text( query, i ) : sqlite3_column_blob( query, i );
+                size = sqlite3_column_bytes( query, i );
+                sqlite3_str_appendf( str, "\n%c%d:", ( SQLITE_TEXT == type ) ? 'T' : 'B', size );
+
+                for( j = 0; j < size; j++ )
+                    {
+                    sqlite3_str_appendf( str, "%02x", bytes[j] );
+                    }
+                break;
+
+            default:
+                sqlite3_str_appendall( str, "\nN" );
+                break;
+            }
+        }
+
+    *key_out = sqlite3_str_finish( str );
+    success = ( NULL != *key_out );
+    }
+
+// Clean up
+if( NULL != query )
+    {
+    cqlite_stmt_cache_release( cache->stmt_cache, query );
+    }
+
+sqlite3_free( params_query_str );
+
+return success;
+}
+
+
+/**
+* Prepare query while capturing its tables.
+*
+* Adds the tables the query reads to the ones collected by earlier
+* calls since the capture was last reset. Returns 1 on success, 0 on
+* error.
+*/
+static int query_prepare_captured
+    (
+    cqlite_result_cache_t * cache,
+    char const *            query_str,
+    sqlite3_stmt **         query_out
+    )
+{
+int success;
+
+cache->is_capturing = 1;
+success = ( SQLITE_OK == sqlite3_prepare_v2( cache->db, query_str, READ_TO_END, query_out, NO_TAIL ) );
+cache->is_capturing = 0;
+
+return success;
+}
+
+
+/**
+* Rollback hook.
+*
+* The results dropped by the rolled back writes were stale for no more
+* than the transaction, so only the pending writes are forgotten.
+*/
+static void rollback_hook
+    (
+    void * context
+    )
+{
+( (cqlite_result_cache_t*)context )->has_pending_writes = 0;
+}
+
+
+/**
+* Release table.
+*
+* Drops an entry's reference to the table, freeing the table once no
+* entry reads it.
+*/
+static void table_release
+    (
+    cqlite_result_cache_t * cache,
+    result_cache_table_t *  table
+    )
+{
+result_cache_table_t ** link;
+
+table->ref_cnt--;
+
+if( 0 == table->ref_cnt )
+    {
+    link = &cache->tables;
+
+    while( *link != table )
+        {
+        link = &( *link )->next;
+        }
+
+    *link = table->next;
+
+    free( table->name );
+    free( table );
+    }
+}
+
+
+/**
+* Update hook.
+*
+* Drops every cached result that read the written table. Writes to
+* WITHOUT ROWID tables never reach the hook and are caught by
+* versions_check() instead.
+*/
+static void update_hook
+    (
+    void *          context,
+    int             operation,
+    char const *    db_name,
+    char const *    table_name,
+    sqlite_int64    row_id
+    )
+{
+cqlite_result_cache_t * cache;
+result_cache_table_t *  table;
+result_cache_entry_t *  entry;
+result_cache_entry_t *  next_entry;
+int                     remaining_cnt;
+int                     i;
+int                     reads_table;
+
+cache = (cqlite_result_cache_t*)context;
+cache->has_pending_writes = 1;
+cache->hooked_changes++;
+
+for( table = cache->tables; ( NULL != table ) && ( 0 != strcasecmp( table->name, table_name ) ); table = table->next );
+
+// The table is freed along with the last entry reading it
+remaining_cnt = ( NULL != table ) ? table->ref_cnt : 0;
+
+for( entry = cache->lru_head; ( remaining_cnt > 0 ) && ( NULL != entry ); entry = next_entry )
+    {
+    next_entry = entry->next;
+    reads_table = 0;
+
+    for( i = 0; !reads_table && ( i < entry->table_cnt ); i++ )
+        {
+        reads_table = ( table == entry->tables[i] );
+        }
+
+    if( reads_table )
+        {
+        cache->stats.invalidations++;
+        remaining_cnt--;
+        entry_free( cache, entry );
+        }
+    }
+}
+
+
+/**
+* Check database versions.
+*
+* Drops every cached result if another connection committed or the
+* schema changed since the last lookup. The data version does not change
+* for the connection's own writes, so it also drops them if the
+* connection changed rows that did not reach the update hook, which is
+* the case for WITHOUT ROWID tables.
+*/
+static void versions_check
+    (
+    cqlite_result_cache_t * cache
+    )
+{
+sqlite_int64 data_version = -1;
+sqlite_int64 schema_version = -1;
+sqlite_int64 total_changes;
+int          has_unhooked_changes;
+
+total_changes = sqlite3_total_changes64( cache->db );
+has_unhooked_changes = ( ( total_changes - cache->total_changes ) != cache->hooked_changes );
+
+cache->total_changes = total_changes;
+cache->hooked_changes = 0;
+
+// Results read while the unhooked changes are uncommitted must not be
+// cached either.
+if( has_unhooked_changes && !sqlite3_get_autocommit( cache->db ) )
+    {
+    cache->has_pending_writes = 1;
+    }
+
+if( SQLITE_ROW == sqlite3_step( cache->version_query ) )
+    {
+    data_version = sqlite3_column_int64( cache->version_query, 0 );
+    schema_version = sqlite3_column_int64( cache->version_query, 1 );
+    }
+
+sqlite3_reset( cache->version_query );
+
+// A failed check drops everything as well
+if( ( data_version != cache->data_version ) ||
+    ( schema_version != cache->schema_version ) ||
+    ( data_version < 0 ) ||
+    has_unhooked_changes )
+    {
+    cache->stats.invalidations += cache->entry_cnt;
+    cqlite_result_cache_clear( cache );
+
+    cache->data_version = data_version;
+    cache->schema_version = schema_version;
+    }
+}
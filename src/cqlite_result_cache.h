@@ -0,0 +1,168 @@
+/** @file */
+
+#ifndef _CQLITE_RESULT_CACHE_H
+#define _CQLITE_RESULT_CACHE_H
+
+#include <sqlite3.h>
+
+#include "cqlite.h"
+
+/**
+* Query result cache.
+*
+* Caches the results of SELECT and COUNT queries on a single database
+* connection, keyed by their SQL text along with the exact value of
+* each bound parameter, so that repeating a query against tables that have not
+* changed costs a hash lookup instead of a query.
+*
+* Each cached result records the tables its queries read, as reported
+* by the authorizer while they are prepared. Writes through the
+* connection drop the cached results of the tables they touch as soon
+* as they happen. Commits made by other connections, schema changes and
+* writes to WITHOUT ROWID tables, which SQLite does not report to the
+* update hook, drop every cached result on the next lookup. The cached queries must
+* be deterministic, so queries calling functions such as random() or
+* reading the current time must not be cached.
+*
+* The cache owns the authorizer, update hook, commit hook and rollback
+* hook of its connection for as long as it exists. Its authorizer
+* disables the truncate optimization of DELETE statements so that every
+* deleted row reaches the update hook. A cache must only be used by one
+* thread at a time, just like its connection.
+*/
+typedef struct cqlite_result_cache_s cqlite_result_cache_t;
+
+/**
+* Cached result.
+*
+* Reference-counted model list shared by the cache and every caller
+* that looked it up. The models must not be modified. A cached result
+* may be released on any thread, even after its cache is freed.
+*/
+typedef struct cqlite_cached_result_s cqlite_cached_result_t;
+
+/**
+* Query result cache statistics.
+*/
+typedef struct
+    {
+    sqlite_int64    hits;           //!< Number of lookups satisfied by a cached result
+    sqlite_int64    misses;         //!< Number of lookups that had to execute their query
+    sqlite_int64    evictions;      //!< Number of results evicted to make room for others
+    sqlite_int64    invalidations;  //!< Number of results dropped because their tables changed
+    } cqlite_result_cache_stats_t;
+
+/**
+* Get cached result models.
+*
+* Returns the model list of the result and sets model_cnt_out to its
+* length. The list remains valid until the result is released.
+*/
+void const * cqlite_cached_result_models
+    (
+    cqlite_cached_result_t const *  result,         //!< Cached result
+    int *                           model_cnt_out   //!< (out) Number of models in the list
+    );
+
+/**
+* Release cached result.
+*
+* Drops the caller's reference to the result. The models are freed
+* once neither the cache nor any caller references the result.
+*/
+void cqlite_cached_result_release
+    (
+    cqlite_cached_result_t * result    //!< Result to release, may be NULL
+    );
+
+/**
+* Clear query result cache.
+*
+* Drops every cached result. Results still referenced by callers remain
+* valid until they are released.
+*/
+void cqlite_result_cache_clear
+    (
+    cqlite_result_cache_t * cache   //!< Query result cache
+    );
+
+/**
+* Execute count query using query result cache.
+*
+* Returns the cached count if the query's tables have not changed since
+* it was last executed, otherwise executes the query and caches its
+* count.
+*
+* @see cqlite_count_query_execute()
+*/
+cqlite_rcode_t cqlite_result_cache_count_query_execute
+    (
+    cqlite_result_cache_t * cache,              //!< Query result cache
+    char const * const      count_query_str,    //!< Parameter-less COUNT query string
+    int *                   count_out           //!< (out) Returned count
+    );
+
+/**
+* Create query result cache.
+*
+* Creates a cache for the provided database connection that holds at
+* most capacity results and installs its hooks on the connection. The
+* caller must call cqlite_result_cache_free() on cache_out before
+* closing the connection.
+*/
+cqlite_rcode_t cqlite_result_cache_create
+    (
+    sqlite3 *                   db,         //!< Database connection whose results are cached
+    int                         capacity,   //!< Maximum number of cached results
+    cqlite_result_cache_t **    cache_out   //!< (out) Query result cache, caller must free
+    );
+
+/**
+* Free query result cache.
+*
+* Removes the cache's hooks from its connection, drops every cached
+* result, and frees the cache.
+*/
+void cqlite_result_cache_free
+    (
+    cqlite_result_cache_t * cache   //!< Query result cache
+    );
+
+/**
+* Execute SELECT query using query result cache.
+*
+* Binds params to the queries with params_bind_func, unless it is NULL
+* for parameter-less queries, and looks up the SELECT query's SQL text
+* along with the exact value of each bound parameter. On a hit, result_out references
+* the cached result. On a miss, the queries are executed as by
+* cqlite_select_query_execute(), and the result is cached unless the
+* connection has uncommitted writes, since those may yet be rolled
+* back.
+*
+* model_free_func frees the memory owned by each model once the result
+* is freed, and may be NULL if models own no memory. The caller must
+* call cqlite_cached_result_release() on result_out.
+*/
+cqlite_rcode_t cqlite_result_cache_select_query_execute
+    (
+    cqlite_result_cache_t *         cache,              //!< Query result cache
+    char const * const              select_query_str,   //!< SELECT query string
+    char const * const              count_query_str,    //!< COUNT query string taking the same parameters, NULL for single pass
+    cqlite_model_bind_func_t        params_bind_func,   //!< Function to bind params to the queries, NULL if parameter-less
+    void const *                    params,             //!< Parameters passed to params_bind_func
+    cqlite_model_add_to_list_func_t add_to_list_func,   //!< Add model to list function pointer
+    cqlite_model_free_func_t        model_free_func,    //!< Function to free the memory owned by a model, may be NULL
+    size_t                          model_size,         //!< Size of the model type
+    cqlite_cached_result_t **       result_out          //!< (out) Cached result, caller must release
+    );
+
+/**
+* Get query result cache statistics.
+*/
+void cqlite_result_cache_stats_get
+    (
+    cqlite_result_cache_t const *   cache,      //!< Query result cache
+    cqlite_result_cache_stats_t *   stats_out   //!< (out) Cache statistics
+    );
+
+#endif
@@ -0,0 +1,338 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "cqlite_segmented.h"
+#include "cqlite_private.h"
+
+#define READ_TO_END                     ( -1 )
+#define NO_TAIL                         ( NULL )
+#define SEGMENT_TARGET_SIZE             ( 1024 * 1024 )
+#define SEGMENT_TABLE_INITIAL_CAPACITY  ( 16 )
+
+
+/**********************************************
+Types
+**********************************************/
+struct cqlite_segmented_list_s
+    {
+    void **         segments;           //!< Table of segments, each holding segment_model_cnt models
+    sqlite_int64    segment_cnt;        //!< Number of allocated segments
+    sqlite_int64    segment_capacity;   //!< Number of segments the table can hold
+    sqlite_int64    segment_model_cnt;  //!< Number of models per segment
+    sqlite_int64    model_cnt;          //!< Number of models in the list
+    size_t          model_size;         //!< Size of the model type
+    };
+
+
+/**********************************************
+Functions
+**********************************************/
+static int segment_add
+    (
+    cqlite_segmented_list_t *   list
+    );
+
+static int segment_table_grow
+    (
+    cqlite_segmented_list_t *   list
+    );
+
+
+// Get model from segmented list.
+void * cqlite_segmented_list_at
+    (
+    cqlite_segmented_list_t const * list,   //!< Segmented model list
+    sqlite_int64                    idx     //!< Index of the model
+    )
+{
+void * model = NULL;
+
+if( ( idx >= 0 ) && ( idx < list->model_cnt ) )
+    {
+    model = (char*)list->segments[idx / list->segment_model_cnt] + ( ( idx % list->segment_model_cnt ) * list->model_size );
+    }
+
+return model;
+}
+
+
+// Get number of models in segmented list.
+sqlite_int64 cqlite_segmented_list_cnt
+    (
+    cqlite_segmented_list_t const * list    //!< Segmented model list
+    )
+{
+return list->model_cnt;
+}
+
+
+// Free segmented list.
+void cqlite_segmented_list_free
+    (
+    cqlite_segmented_list_t *   list,           //!< Segmented model list to free, may be NULL
+    cqlite_model_free_func_t    model_free_func //!< Function to free the memory owned by a model, may be NULL
+    )
+{
+cqlite_segmented_list_iter_t    iter;
+void *                          model;
+sqlite_int64                    i;
+
+if( NULL != list )
+    {
+    if( NULL != model_free_func )
+        {
+        cqlite_segmented_list_iter_init( list, &iter );
+
+        while( NULL != ( model = cqlite_segmented_list_iter_next( &iter ) ) )
+            {
+            model_free_func( model );
+            }
+        }
+
+    for( i = 0; i < list->segment_cnt; i++ )
+        {
+        free( list->segments[i] );
+        }
+
+    free( list->segments );
+    free( list );
+    }
+}
+
+
+// Initialize segmented list iterator.
+void cqlite_segmented_list_iter_init
+    (
+    cqlite_segmented_list_t const * list,       //!< Segmented model list to iterate
+    cqlite_segmented_list_iter_t *  iter_out    //!< (out) Iterator
+    )
+{
+iter_out->list = list;
+iter_out->segment_idx = 0;
+iter_out->segment_offset = 0;
+iter_out->remaining_cnt = list->model_cnt;
+}
+
+
+// Get next model from segmented list iterator.
+void * cqlite_segmented_list_iter_next
+    (
+    cqlite_segmented_list_iter_t *  iter    //!< Iterator
+    )
+{
+void * model = NULL;
+
+if( iter->remaining_cnt > 0 )
+    {
+    model = (char*)iter->list->segments[iter->segment_idx] + ( iter->segment_offset * iter->list->model_size );
+
+    iter->remaining_cnt--;
+    iter->segment_offset++;
+
+    if( iter->segment_offset == iter->list->segment_model_cnt )
+        {
+        iter->segment_idx++;
+        iter->segment_offset = 0;
+        }
+    }
+
+return model;
+}
+
+
+// Execute SELECT query into segmented list.
+cqlite_rcode_t cqlite_segmented_select_query_execute
+    (
+    sqlite3 *                           db,                         //!< Database on which to execute the query
+    char const * const                  select_query_str,           //!< Parameter-less SELECT query string
+    cqlite_model_from_row_result_func_t model_from_row_result_func, //!< Function to read a row result into a model
+    cqlite_model_free_func_t            model_free_func,            //!< Function to free the memory owned by a model, may be NULL
+    size_t                              model_size,                 //!< Size of the model type
+    cqlite_segmented_list_t **          list_out                    //!< (out) List of models read from query, caller must free
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+sqlite3_stmt *  select_query = NULL;
+sqlite_int64    prepare_start_ns;
+
+*list_out = NULL;
+
+prepare_start_ns = cqlite_stats_prepare_begin();
+success = ( SQLITE_OK == sqlite3_prepare_v2( db, select_query_str, READ_TO_END, &select_query, NO_TAIL ) );
+cqlite_stats_prepare_end( CQLITE_STATS_API_SELECT, prepare_start_ns );
+
+if( success )
+    {
+    rcode = cqlite_segmented_select_query_execute_prepared( select_query, model_from_row_result_func, model_free_func, model_size, list_out );
+    }
+
+// Clean up
+sqlite3_finalize( select_query );
+
+return rcode;
+}
+
+
+// Execute prepared SELECT query into segmented list.
+cqlite_rcode_t cqlite_segmented_select_query_execute_prepared
+    (
+    sqlite3_stmt *                      select_query,               //!< Prepared SELECT query
+    cqlite_model_from_row_result_func_t model_from_row_result_func, //!< Function to read a row result into a model
+    cqlite_model_free_func_t            model_free_func,            //!< Function to free the memory owned by a model, may be NULL
+    size_t                              model_size,                 //!< Size of the model type
+    cqlite_segmented_list_t **          list_out                    //!< (out) List of models read from query, caller must free
+    )
+{
+cqlite_rcode_t              rcode = CQLITE_ERROR;
+int                         success;
+int                         sqlite_rcode = SQLITE_ERROR;
+sqlite_int64                segment_offset = 0;
+void *                      model;
+cqlite_segmented_list_t *   list;
+cqlite_stats_call_t         stats_call;
+sqlite_int64                phase_start_ns;
+
+*list_out = NULL;
+
+cqlite_stats_call_begin( &stats_call, CQLITE_STATS_API_SELECT );
+phase_start_ns = cqlite_stats_clock( &stats_call );
+
+list = calloc( 1, sizeof( *list ) );
+success = ( NULL != list ) && ( model_size > 0 );
+
+if( success )
+    {
+    list->model_size = model_size;
+    list->segment_model_cnt = ( model_size < SEGMENT_TARGET_SIZE ) ? ( SEGMENT_TARGET_SIZE / model_size ) : 1;
+
+    sqlite_rcode = sqlite3_step( select_query );
+    phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_STEP, phase_start_ns );
+    }
+
+// Read each result into the next model, starting a new segment
+// whenever the last one is full.
+while( success && ( SQLITE_ROW == sqlite_rcode ) )
+    {
+    if( 0 == segment_offset )
+        {
+        success = segment_add( list );
+        phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_ALLOC, phase_start_ns );
+        }
+
+    if( success )
+        {
+        model = (char*)list->segments[list->segment_cnt - 1] + ( segment_offset * model_size );
+        success = model_from_row_result_func( select_query, model );
+        phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_DECODE, phase_start_ns );
+
+        // A model that failed to read may own memory too
+        list->model_cnt++;
+        segment_offset = ( segment_offset + 1 ) % list->segment_model_cnt;
+        }
+
+    if( success )
+        {
+        sqlite_rcode = sqlite3_step( select_query );
+        phase_start_ns = cqlite_stats_phase_end( &stats_call, CQLITE_STATS_PHASE_STEP, phase_start_ns );
+        }
+    }
+
+// Ensure all results were successfully read
+if( success )
+    {
+    success = ( SQLITE_DONE == sqlite_rcode );
+    }
+
+if( NULL != list )
+    {
+    stats_call.rows_read = list->model_cnt;
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    *list_out = list;
+    }
+else
+    {
+    cqlite_segmented_list_free( list, model_free_func );
+    }
+
+cqlite_stats_call_end( &stats_call, select_query, success );
+
+return rcode;
+}
+
+
+/**
+* Add segment to segmented list.
+*
+* Appends a zeroed segment to the list, growing its segment table if
+* it is full. Returns 1 on success, 0 on error.
+*/
+static int segment_add
+    (
+    cqlite_segmented_list_t *   list
+    )
+{
+int     success = 1;
+void *  segment;
+
+if( list->segment_cnt == list->segment_capacity )
+    {
+    success = segment_table_grow( list );
+    }
+
+if( success )
+    {
+    segment = calloc( list->segment_model_cnt, list->model_size );
+    success = ( NULL != segment );
+    }
+
+if( success )
+    {
+    cqlite_stats_bytes_add( list->segment_model_cnt * list->model_size );
+
+    list->segments[list->segment_cnt] = segment;
+    list->segment_cnt++;
+    }
+
+return success;
+}
+
+
+/**
+* Grow segment table.
+*
+* Doubles the number of segments the table of the list can hold. Only
+* the segment pointers are copied, never the models. Returns 1 on
+* success, 0 on error.
+*/
+static int segment_table_grow
+    (
+    cqlite_segmented_list_t *   list
+    )
+{
+int             success;
+sqlite_int64    new_capacity;
+void **         new_segments = NULL;
+
+new_capacity = ( list->segment_capacity > 0 ) ? ( list->segment_capacity * 2 ) : SEGMENT_TABLE_INITIAL_CAPACITY;
+
+success = ( (size_t)new_capacity <= ( SIZE_MAX / sizeof( *list->segments ) ) );
+
+if( success )
+    {
+    new_segments = realloc( list->segments, new_capacity * sizeof( *list->segments ) );
+    success = ( NULL != new_segments );
+    }
+
+if( success )
+    {
+    list->segments = new_segments;
+    list->segment_capacity = new_capacity;
+    }
+
+return success;
+}
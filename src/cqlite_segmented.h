@@ -0,0 +1,126 @@
+/** @file */
+
+#ifndef _CQLITE_SEGMENTED_H
+#define _CQLITE_SEGMENTED_H
+
+#include <sqlite3.h>
+
+#include "cqlite.h"
+
+/**
+* Segmented model list.
+*
+* List of models stored in fixed-size segments of about a megabyte
+* each, with 64-bit indices. Unlike the contiguous lists returned by
+* cqlite_select_query_execute(), it grows without ever copying its
+* models or needing a single allocation for all of them, so results of
+* billions of rows fit wherever the memory for them exists. Models stay
+* at the same address for the lifetime of the list.
+*/
+typedef struct cqlite_segmented_list_s cqlite_segmented_list_t;
+
+/**
+* Segmented model list iterator.
+*
+* Visits the models of a list in order without computing the segment
+* of each index. Initialize with cqlite_segmented_list_iter_init().
+*/
+typedef struct
+    {
+    cqlite_segmented_list_t const * list;           //!< List being iterated
+    sqlite_int64                    segment_idx;    //!< Segment of the next model
+    sqlite_int64                    segment_offset; //!< Index of the next model within its segment
+    sqlite_int64                    remaining_cnt;  //!< Number of models not yet visited
+    } cqlite_segmented_list_iter_t;
+
+/**
+* Get model from segmented list.
+*
+* Returns a pointer to the model at the provided index, or NULL if the
+* index is out of range.
+*/
+void * cqlite_segmented_list_at
+    (
+    cqlite_segmented_list_t const * list,   //!< Segmented model list
+    sqlite_int64                    idx     //!< Index of the model
+    );
+
+/**
+* Get number of models in segmented list.
+*/
+sqlite_int64 cqlite_segmented_list_cnt
+    (
+    cqlite_segmented_list_t const * list    //!< Segmented model list
+    );
+
+/**
+* Free segmented list.
+*
+* Calls model_free_func on every model, unless it is NULL for models
+* that own no memory, and frees the list.
+*/
+void cqlite_segmented_list_free
+    (
+    cqlite_segmented_list_t *   list,           //!< Segmented model list to free, may be NULL
+    cqlite_model_free_func_t    model_free_func //!< Function to free the memory owned by a model, may be NULL
+    );
+
+/**
+* Initialize segmented list iterator.
+*
+* Positions the iterator before the first model of the list.
+*/
+void cqlite_segmented_list_iter_init
+    (
+    cqlite_segmented_list_t const * list,       //!< Segmented model list to iterate
+    cqlite_segmented_list_iter_t *  iter_out    //!< (out) Iterator
+    );
+
+/**
+* Get next model from segmented list iterator.
+*
+* Returns a pointer to the next model of the list, or NULL once every
+* model was visited.
+*/
+void * cqlite_segmented_list_iter_next
+    (
+    cqlite_segmented_list_iter_t *  iter    //!< Iterator
+    );
+
+/**
+* Execute SELECT query into segmented list.
+*
+* Executes the provided SELECT query string that takes no parameters in
+* a single pass, reading each row result into the next model of a new
+* segmented list with model_from_row_result_func. Since the list grows
+* a segment at a time, no COUNT query is needed to size it.
+*
+* On error, model_free_func is called on the models read so far,
+* unless it is NULL, and list_out is set to NULL. The caller must call
+* cqlite_segmented_list_free() on list_out.
+*/
+cqlite_rcode_t cqlite_segmented_select_query_execute
+    (
+    sqlite3 *                           db,                         //!< Database on which to execute the query
+    char const * const                  select_query_str,           //!< Parameter-less SELECT query string
+    cqlite_model_from_row_result_func_t model_from_row_result_func, //!< Function to read a row result into a model
+    cqlite_model_free_func_t            model_free_func,            //!< Function to free the memory owned by a model, may be NULL
+    size_t                              model_size,                 //!< Size of the model type
+    cqlite_segmented_list_t **          list_out                    //!< (out) List of models read from query, caller must free
+    );
+
+/**
+* Execute prepared SELECT query into segmented list.
+*
+* @see cqlite_segmented_select_query_execute()
+*/
+cqlite_rcode_t cqlite_segmented_select_query_execute_prepared
+    (
+    sqlite3_stmt *                      select_query,               //!< Prepared SELECT query
+    cqlite_model_from_row_result_func_t model_from_row_result_func, //!< Function to read a row result into a model
+    cqlite_model_free_func_t            model_free_func,            //!< Function to free the memory owned by a model, may be NULL
+    size_t                              model_size,                 //!< Size of the model type
+    cqlite_segmented_list_t **          list_out                    //!< (out) List of models read from query, caller must free
+    );
+
+#endif
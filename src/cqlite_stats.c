@@ -0,0 +1,447 @@
+#include <limits.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#include "cqlite_stats.h"
+#include "cqlite_private.h"
+
+#define NS_PER_SEC          ( 1000000000LL )
+#define STMT_STATUS_RESET   ( 1 )
+
+
+/**********************************************
+Types
+**********************************************/
+typedef struct
+    {
+    atomic_llong    cnt;
+    atomic_llong    total_ns;
+    atomic_llong    buckets[CQLITE_STATS_BUCKET_CNT];
+    } histogram_t;
+
+typedef struct
+    {
+    atomic_llong    call_cnt;
+    atomic_llong    error_cnt;
+    atomic_llong    rows_read;
+    atomic_llong    bytes_allocated;
+    histogram_t     latency;
+    histogram_t     phases[CQLITE_STATS_PHASE_CNT];
+    atomic_llong    fullscan_steps;
+    atomic_llong    sorts;
+    atomic_llong    autoindexes;
+    atomic_llong    vm_steps;
+    } api_stats_t;
+
+
+/**********************************************
+Variables
+**********************************************/
+
+// Statistics are only ever added to, so relaxed atomics are enough for
+// concurrent calls to never lose counts. Static storage starts zeroed.
+static atomic_uint                          s_flags;
+static api_stats_t                          s_api_stats[CQLITE_STATS_API_CNT];
+static _Thread_local cqlite_stats_call_t *  t_current_call = NULL;
+
+
+/**********************************************
+Functions
+**********************************************/
+static void counter_add
+    (
+    atomic_llong *  counter,
+    sqlite_int64    value
+    );
+
+static void histogram_add
+    (
+    histogram_t *   histogram,
+    sqlite_int64    duration_ns
+    );
+
+static void histogram_get
+    (
+    histogram_t const *         histogram,
+    cqlite_stats_histogram_t *  histogram_out
+    );
+
+static void histogram_reset
+    (
+    histogram_t * histogram
+    );
+
+static sqlite_int64 now_ns
+    (
+    void
+    );
+
+
+// Enable statistics.
+void cqlite_stats_enable
+    (
+    unsigned int flags  //!< CQLITE_STATS_* flags
+    )
+{
+// Statement status counters are meaningless without the calls they belong to.
+if( !( flags & CQLITE_STATS_ENABLED ) )
+    {
+    flags = CQLITE_STATS_DISABLED;
+    }
+
+atomic_store( &s_flags, flags );
+}
+
+
+// Get statistics.
+void cqlite_stats_get
+    (
+    cqlite_stats_t * stats_out  //!< (out) Statistics
+    )
+{
+int                         i;
+int                         j;
+api_stats_t const *         api_stats;
+cqlite_stats_api_stats_t *  api_stats_out;
+
+for( i = 0; i < CQLITE_STATS_API_CNT; i++ )
+    {
+    api_stats = &s_api_stats[i];
+    api_stats_out = &stats_out->apis[i];
+
+    api_stats_out->call_cnt = atomic_load_explicit( &api_stats->call_cnt, memory_order_relaxed );
+    api_stats_out->error_cnt = atomic_load_explicit( &api_stats->error_cnt, memory_order_relaxed );
+    api_stats_out->rows_read = atomic_load_explicit( &api_stats->rows_read, memory_order_relaxed );
+    api_stats_out->bytes_allocated = atomic_load_explicit( &api_stats->bytes_allocated, memory_order_relaxed );
+    api_stats_out->fullscan_steps = atomic_load_explicit( &api_stats->fullscan_steps, memory_order_relaxed );
+    api_stats_out->sorts = atomic_load_explicit( &api_stats->sorts, memory_order_relaxed );
+    api_stats_out->autoindexes = atomic_load_explicit( &api_stats->autoindexes, memory_order_relaxed );
+    api_stats_out->vm_steps = atomic_load_explicit( &api_stats->vm_steps, memory_order_relaxed );
+
+    histogram_get( &api_stats->latency, &api_stats_out->latency );
+
+    for( j = 0; j < CQLITE_STATS_PHASE_CNT; j++ )
+        {
+        histogram_get( &api_stats->phases[j], &api_stats_out->phases[j] );
+        }
+    }
+}
+
+
+// Get histogram percentile.
+sqlite_int64 cqlite_stats_histogram_percentile
+    (
+    cqlite_stats_histogram_t const *    histogram,  //!< Latency histogram
+    double                              percentile  //!< Percentile to get
+    )
+{
+sqlite_int64    upper_bound_ns = 0;
+sqlite_int64    rank;
+sqlite_int64    cnt = 0;
+int             i;
+
+// Smallest number of durations that make up the percentile
+rank = (sqlite_int64)( ( percentile * histogram->cnt ) / 100.0 );
+rank += ( rank < ( ( percentile * histogram->cnt ) / 100.0 ) ) ? 1 : 0;
+rank = ( rank < 1 ) ? 1 : rank;
+
+for( i = 0; ( histogram->cnt > 0 ) && ( cnt < rank ) && ( i < CQLITE_STATS_BUCKET_CNT ); i++ )
+    {
+    cnt += histogram->buckets[i];
+    upper_bound_ns = ( i < ( CQLITE_STATS_BUCKET_CNT - 1 ) ) ? ( ( 1LL << ( i + 1 ) ) - 1 ) : LLONG_MAX;
+    }
+
+return upper_bound_ns;
+}
+
+
+// Reset statistics.
+void cqlite_stats_reset
+    (
+    void
+    )
+{
+int             i;
+int             j;
+api_stats_t *   api_stats;
+
+for( i = 0; i < CQLITE_STATS_API_CNT; i++ )
+    {
+    api_stats = &s_api_stats[i];
+
+    atomic_store_explicit( &api_stats->call_cnt, 0, memory_order_relaxed );
+    atomic_store_explicit( &api_stats->error_cnt, 0, memory_order_relaxed );
+    atomic_store_explicit( &api_stats->rows_read, 0, memory_order_relaxed );
+    atomic_store_explicit( &api_stats->bytes_allocated, 0, memory_order_relaxed );
+    atomic_store_explicit( &api_stats->fullscan_steps, 0, memory_order_relaxed );
+    atomic_store_explicit( &api_stats->sorts, 0, memory_order_relaxed );
+    atomic_store_explicit( &api_stats->autoindexes, 0, memory_order_relaxed );
+    atomic_store_explicit( &api_stats->vm_steps, 0, memory_order_relaxed );
+
+    histogram_reset( &api_stats->latency );
+
+    for( j = 0; j < CQLITE_STATS_PHASE_CNT; j++ )
+        {
+        histogram_reset( &api_stats->phases[j] );
+        }
+    }
+}
+
+
+/**********************************************
+Internal functions
+**********************************************/
+
+// Add allocated bytes to statistics.
+void cqlite_stats_bytes_add
+    (
+    size_t size //!< Number of bytes allocated
+    )
+{
+if( ( NULL != t_current_call ) && t_current_call->flags )
+    {
+    t_current_call->bytes_allocated += size;
+    }
+}
+
+
+// Get function group of current call.
+int cqlite_stats_current_api
+    (
+    cqlite_stats_api_t *    api_out     //!< (out) Function group of the innermost call
+    )
+{
+int is_in_call;
+
+is_in_call = ( NULL != t_current_call );
+
+if( is_in_call )
+    {
+    *api_out = t_current_call->api;
+    }
+
+return is_in_call;
+}
+
+
+// Begin instrumented call.
+void cqlite_stats_call_begin
+    (
+    cqlite_stats_call_t *   call,   //!< Call to begin
+    cqlite_stats_api_t      api     //!< Function group of the call
+    )
+{
+call->flags = atomic_load_explicit( &s_flags, memory_order_relaxed );
+
+// The innermost call is tracked even without statistics, so that the
+// tracer can tell which call executed a statement.
+call->api = api;
+call->outer = t_current_call;
+t_current_call = call;
+
+if( call->flags )
+    {
+    memset( call->phase_ns, 0, sizeof( call->phase_ns ) );
+    call->phase_mask = 0;
+    call->rows_read = 0;
+    call->bytes_allocated = 0;
+
+    call->start_ns = now_ns();
+    }
+}
+
+
+// End instrumented call.
+void cqlite_stats_call_end
+    (
+    cqlite_stats_call_t *   call,   //!< Call to end
+    sqlite3_stmt *          query,  //!< Statement executed by the call, may be NULL
+    int                     success //!< Did the call succeed?
+    )
+{
+sqlite_int64    end_ns;
+api_stats_t *   api_stats;
+int             i;
+
+t_current_call = call->outer;
+
+if( call->flags )
+    {
+    end_ns = now_ns();
+    api_stats = &s_api_stats[call->api];
+
+    counter_add( &api_stats->call_cnt, 1 );
+    counter_add( &api_stats->error_cnt, success ? 0 : 1 );
+    counter_add( &api_stats->rows_read, call->rows_read );
+    counter_add( &api_stats->bytes_allocated, call->bytes_allocated );
+    histogram_add( &api_stats->latency, end_ns - call->start_ns );
+
+    for( i = 0; i < CQLITE_STATS_PHASE_CNT; i++ )
+        {
+        if( call->phase_mask & ( 1u << i ) )
+            {
+            histogram_add( &api_stats->phases[i], call->phase_ns[i] );
+            }
+        }
+
+    if( ( call->flags & CQLITE_STATS_STMT_STATUS ) && ( NULL != query ) )
+        {
+        counter_add( &api_stats->fullscan_steps, sqlite3_stmt_status( query, SQLITE_STMTSTATUS_FULLSCAN_STEP, STMT_STATUS_RESET ) );
+        counter_add( &api_stats->sorts, sqlite3_stmt_status( query, SQLITE_STMTSTATUS_SORT, STMT_STATUS_RESET ) );
+        counter_add( &api_stats->autoindexes, sqlite3_stmt_status( query, SQLITE_STMTSTATUS_AUTOINDEX, STMT_STATUS_RESET ) );
+        counter_add( &api_stats->vm_steps, sqlite3_stmt_status( query, SQLITE_STMTSTATUS_VM_STEP, STMT_STATUS_RESET ) );
+        }
+    }
+}
+
+
+// Get time for instrumented call.
+sqlite_int64 cqlite_stats_clock
+    (
+    cqlite_stats_call_t const * call    //!< Instrumented call
+    )
+{
+return call->flags ? now_ns() : 0;
+}
+
+
+// End phase of instrumented call.
+sqlite_int64 cqlite_stats_phase_end
+    (
+    cqlite_stats_call_t *   call,       //!< Instrumented call
+    cqlite_stats_phase_t    phase,      //!< Phase that ended
+    sqlite_int64            start_ns    //!< Time the phase began
+    )
+{
+sqlite_int64 end_ns = 0;
+
+if( call->flags )
+    {
+    end_ns = now_ns();
+
+    call->phase_ns[phase] += end_ns - start_ns;
+    call->phase_mask |= ( 1u << phase );
+    }
+
+return end_ns;
+}
+
+
+// Begin preparing statement.
+sqlite_int64 cqlite_stats_prepare_begin
+    (
+    void
+    )
+{
+return atomic_load_explicit( &s_flags, memory_order_relaxed ) ? now_ns() : 0;
+}
+
+
+// End preparing statement.
+void cqlite_stats_prepare_end
+    (
+    cqlite_stats_api_t  api,        //!< Function group preparing the statement
+    sqlite_int64        start_ns    //!< Value returned by cqlite_stats_prepare_begin()
+    )
+{
+// Statistics may have been enabled while preparing.
+if( 0 != start_ns )
+    {
+    histogram_add( &s_api_stats[api].phases[CQLITE_STATS_PHASE_PREPARE], now_ns() - start_ns );
+    }
+}
+
+
+/**
+* Add to counter.
+*/
+static void counter_add
+    (
+    atomic_llong *  counter,
+    sqlite_int64    value
+    )
+{
+atomic_fetch_add_explicit( counter, value, memory_order_relaxed );
+}
+
+
+/**
+* Add duration to histogram.
+*/
+static void histogram_add
+    (
+    histogram_t *   histogram,
+    sqlite_int64    duration_ns
+    )
+{
+int bucket = 0;
+
+// Index of the highest set bit
+while( ( bucket < ( CQLITE_STATS_BUCKET_CNT - 1 ) ) && ( ( duration_ns >> ( bucket + 1 ) ) > 0 ) )
+    {
+    bucket++;
+    }
+
+counter_add( &histogram->cnt, 1 );
+counter_add( &histogram->total_ns, duration_ns );
+counter_add( &histogram->buckets[bucket], 1 );
+}
+
+
+/**
+* Copy histogram.
+*/
+static void histogram_get
+    (
+    histogram_t const *         histogram,
+    cqlite_stats_histogram_t *  histogram_out
+    )
+{
+int i;
+
+histogram_out->cnt = atomic_load_explicit( &histogram->cnt, memory_order_relaxed );
+histogram_out->total_ns = atomic_load_explicit( &histogram->total_ns, memory_order_relaxed );
+
+for( i = 0; i < CQLITE_STATS_BUCKET_CNT; i++ )
+    {
+    histogram_out->buckets[i] = atomic_load_explicit( &histogram->buckets[i], memory_order_relaxed );
+    }
+}
+
+
+/**
+* Reset histogram.
+*/
+static void histogram_reset
+    (
+    histogram_t * histogram
+    )
+{
+int i;
+
+atomic_store_explicit( &histogram->cnt, 0, memory_order_relaxed );
+atomic_store_explicit( &histogram->total_ns, 0, memory_order_relaxed );
+
+for( i = 0; i < CQLITE_STATS_BUCKET_CNT; i++ )
+    {
+    atomic_store_explicit( &histogram->buckets[i], 0, memory_order_relaxed );
+    }
+}
+
+
+/**
+* Get monotonic time in nanoseconds.
+*/
+static sqlite_int64 now_ns
+    (
+    void
+    )
+{
+struct timespec now;
+
+clock_gettime( CLOCK_MONOTONIC, &now );
+
+return ( (sqlite_int64)now.tv_sec * NS_PER_SEC ) + now.tv_nsec;
+}
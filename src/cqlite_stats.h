@@ -0,0 +1,136 @@
+/** @file */
+
+#ifndef _CQLITE_STATS_H
+#define _CQLITE_STATS_H
+
+#include <sqlite3.h>
+
+#include "cqlite.h"
+
+#define CQLITE_STATS_DISABLED       ( 0 )       //!< Collect no statistics
+#define CQLITE_STATS_ENABLED        ( 1 << 0 )  //!< Collect call counts and latencies
+#define CQLITE_STATS_STMT_STATUS    ( 1 << 1 )  //!< Also collect sqlite3_stmt_status() counters
+
+#define CQLITE_STATS_BUCKET_CNT     ( 40 )
+
+/**
+* Instrumented function group.
+*/
+typedef enum
+    {
+    CQLITE_STATS_API_SELECT,    //!< cqlite_select_query_execute() and the functions built on it
+    CQLITE_STATS_API_FIND,      //!< cqlite_find() and cqlite_find_by_id()
+    CQLITE_STATS_API_COUNT,     //!< cqlite_count_query_execute()
+    CQLITE_STATS_API_INSERT,    //!< cqlite_insert_query_execute(), once per model for cqlite_insert_many()
+
+    CQLITE_STATS_API_CNT
+    } cqlite_stats_api_t;
+
+/**
+* Phase of an instrumented call.
+*/
+typedef enum
+    {
+    CQLITE_STATS_PHASE_PREPARE, //!< Preparing statements from query strings
+    CQLITE_STATS_PHASE_COUNT,   //!< Executing the COUNT query of a SELECT
+    CQLITE_STATS_PHASE_STEP,    //!< Stepping statements to their results
+    CQLITE_STATS_PHASE_DECODE,  //!< Reading results into models with the caller's callback
+    CQLITE_STATS_PHASE_ALLOC,   //!< Allocating and growing model lists
+
+    CQLITE_STATS_PHASE_CNT
+    } cqlite_stats_phase_t;
+
+/**
+* Latency histogram.
+*
+* Bucket i counts durations of at least 2^i and less than 2^(i+1)
+* nanoseconds. The first bucket also counts durations of 0 and the last
+* bucket counts all longer durations.
+*/
+typedef struct
+    {
+    sqlite_int64    cnt;                                //!< Number of recorded durations
+    sqlite_int64    total_ns;                           //!< Sum of recorded durations
+    sqlite_int64    buckets[CQLITE_STATS_BUCKET_CNT];   //!< Number of durations in each bucket
+    } cqlite_stats_histogram_t;
+
+/**
+* Statistics of one function group.
+*
+* The latency covers executing an already prepared statement. Time
+* spent preparing statements is recorded separately in the PREPARE
+* phase. Each phase records one duration per call that entered it,
+* summed over all rows of the call.
+*/
+typedef struct
+    {
+    sqlite_int64                call_cnt;                           //!< Number of calls
+    sqlite_int64                error_cnt;                          //!< Number of calls that failed
+    sqlite_int64                rows_read;                          //!< Number of rows read into models
+    sqlite_int64                bytes_allocated;                    //!< Bytes allocated for model lists and strings
+    cqlite_stats_histogram_t    latency;                            //!< Duration of each call
+    cqlite_stats_histogram_t    phases[CQLITE_STATS_PHASE_CNT];     //!< Duration of each phase per call
+    sqlite_int64                fullscan_steps;                     //!< SQLITE_STMTSTATUS_FULLSCAN_STEP
+    sqlite_int64                sorts;                              //!< SQLITE_STMTSTATUS_SORT
+    sqlite_int64                autoindexes;                        //!< SQLITE_STMTSTATUS_AUTOINDEX
+    sqlite_int64                vm_steps;                           //!< SQLITE_STMTSTATUS_VM_STEP
+    } cqlite_stats_api_stats_t;
+
+/**
+* Statistics of all function groups.
+*/
+typedef struct
+    {
+    cqlite_stats_api_stats_t apis[CQLITE_STATS_API_CNT];   //!< Statistics indexed by cqlite_stats_api_t
+    } cqlite_stats_t;
+
+/**
+* Enable statistics.
+*
+* Statistics are process-wide and disabled by default. Pass a
+* combination of the CQLITE_STATS_ENABLED and CQLITE_STATS_STMT_STATUS
+* flags to start collecting them, or CQLITE_STATS_DISABLED to stop.
+* Collecting timings reads the clock a few times per row.
+*
+* With CQLITE_STATS_STMT_STATUS, the sqlite3_stmt_status() counters of
+* each statement executed by an instrumented call are added to the
+* statistics and reset.
+*/
+void cqlite_stats_enable
+    (
+    unsigned int flags  //!< CQLITE_STATS_* flags
+    );
+
+/**
+* Get statistics.
+*
+* Copies the statistics collected since the last reset. Calls made
+* concurrently with this may be partially included.
+*/
+void cqlite_stats_get
+    (
+    cqlite_stats_t * stats_out  //!< (out) Statistics
+    );
+
+/**
+* Get histogram percentile.
+*
+* Returns an upper bound of the provided percentile, between 0 and 100,
+* of the durations recorded in the histogram, in nanoseconds. Returns 0
+* if the histogram is empty.
+*/
+sqlite_int64 cqlite_stats_histogram_percentile
+    (
+    cqlite_stats_histogram_t const *    histogram,  //!< Latency histogram
+    double                              percentile  //!< Percentile to get
+    );
+
+/**
+* Reset statistics.
+*/
+void cqlite_stats_reset
+    (
+    void
+    );
+
+#endif
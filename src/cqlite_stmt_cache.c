@@ -0,0 +1,610 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cqlite_private.h"
+#include "cqlite_stmt_cache.h"
+
+#define READ_TO_END             ( -1 )
+#define NO_TAIL                 ( NULL )
+#define RESET_COUNTER           ( 1 )
+
+
+/**********************************************
+Types
+**********************************************/
+typedef struct stmt_cache_entry_s
+    {
+    char *                      query_str;   //!< SQL text the statement was prepared from
+    unsigned int                hash;        //!< Hash of the SQL text
+    sqlite3_stmt *              query;       //!< Cached prepared statement
+    int                         in_use;      //!< Is the statement currently acquired?
+    struct stmt_cache_entry_s * bucket_next; //!< Next entry in the same hash bucket
+    struct stmt_cache_entry_s * prev;        //!< Previous entry in the idle (LRU) or in-use list
+    struct stmt_cache_entry_s * next;        //!< Next entry in the idle (LRU) or in-use list
+    } stmt_cache_entry_t;
+
+typedef struct
+    {
+    stmt_cache_entry_t *    head;
+    stmt_cache_entry_t *    tail;
+    } stmt_cache_entry_list_t;
+
+struct cqlite_stmt_cache_s
+    {
+    sqlite3 *                   db;         //!< Connection whose statements are cached
+    int                         capacity;   //!< Maximum number of entries
+    int                         entry_cnt;  //!< Number of idle and in-use entries
+    unsigned int                bucket_cnt; //!< Number of hash buckets, always a power of two
+    stmt_cache_entry_t **       buckets;    //!< Hash buckets keyed by SQL text
+    stmt_cache_entry_list_t     idle;       //!< Idle entries, most recently used first
+    stmt_cache_entry_list_t     in_use;     //!< Acquired entries
+    cqlite_stmt_cache_stats_t   stats;      //!< Cache statistics
+    };
+
+
+/**********************************************
+Functions
+**********************************************/
+static void entry_free
+    (
+    cqlite_stmt_cache_t *   cache,
+    stmt_cache_entry_t *    entry
+    );
+
+static void entry_list_push
+    (
+    stmt_cache_entry_list_t *   list,
+    stmt_cache_entry_t *        entry
+    );
+
+static void entry_list_remove
+    (
+    stmt_cache_entry_list_t *   list,
+    stmt_cache_entry_t *        entry
+    );
+
+static int find_many_query_acquire
+    (
+    char const *    find_many_query_prefix,
+    int             chunk_size,
+    void *          context,
+    sqlite3_stmt ** query_out
+    );
+
+
+// Acquire statement from cache.
+cqlite_rcode_t cqlite_stmt_cache_acquire
+    (
+    cqlite_stmt_cache_t *   cache,      //!< Statement cache
+    char const * const      query_str,  //!< SQL text of the statement
+    sqlite3_stmt **         query_out   //!< (out) Prepared statement, must be released
+    )
+{
+cqlite_rcode_t          rcode = CQLITE_ERROR;
+int                     success = 1;
+unsigned int            hash;
+stmt_cache_entry_t **   bucket;
+stmt_cache_entry_t *    entry;
+stmt_cache_entry_t *    new_entry = NULL;
+sqlite3_stmt *          query = NULL;
+
+*query_out = NULL;
+
+hash = cqlite_query_str_hash( query_str );
+bucket = &cache->buckets[hash & ( cache->bucket_cnt - 1 )];
+
+for( entry = *bucket; NULL != entry; entry = entry->bucket_next )
+    {
+    if( ( hash == entry->hash ) && ( 0 == strcmp( query_str, entry->query_str ) ) )
+        {
+        break;
+        }
+    }
+
+if( ( NULL != entry ) && ( !entry->in_use ) )
+    {
+    cache->stats.hits++;
+
+    entry_list_remove( &cache->idle, entry );
+    entry_list_push( &cache->in_use, entry );
+    entry->in_use = 1;
+
+    query = entry->query;
+    }
+else
+    {
+    cache->stats.misses++;
+
+    success = ( SQLITE_OK == sqlite3_prepare_v3( cache->db, query_str, READ_TO_END, SQLITE_PREPARE_PERSISTENT, &query, NO_TAIL ) ) &&
+              ( NULL != query );
+
+    // Make room for the new statement. If the same statement is already
+    // acquired, or every cached statement is acquired, then the new
+    // statement is handed out uncached and finalized on release.
+    if( success && ( NULL == entry ) && ( cache->entry_cnt >= cache->capacity ) && ( NULL != cache->idle.tail ) )
+        {
+        cache->stats.evictions++;
+        entry_free( cache, cache->idle.tail );
+        }
+
+    if( success && ( NULL == entry ) && ( cache->entry_cnt < cache->capacity ) )
+        {
+        new_entry = calloc( 1, sizeof( *new_entry ) );
+
+        if( NULL != new_entry )
+            {
+            new_entry->query_str = strdup( query_str );
+            }
+
+        if( ( NULL != new_entry ) && ( NULL != new_entry->query_str ) )
+            {
+            new_entry->hash = hash;
+            new_entry->query = query;
+            new_entry->in_use = 1;
+            new_entry->bucket_next = *bucket;
+            *bucket = new_entry;
+            entry_list_push( &cache->in_use, new_entry );
+            cache->entry_cnt++;
+            }
+        else if( NULL != new_entry )
+            {
+            // Failing to cache the statement is not fatal.
+            free( new_entry );
+            }
+        }
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    *query_out = query;
+    }
+else
+    {
+    sqlite3_finalize( query );
+    }
+
+return rcode;
+}
+
+
+// Clear statement cache.
+void cqlite_stmt_cache_clear
+    (
+    cqlite_stmt_cache_t * cache //!< Statement cache
+    )
+{
+while( NULL != cache->idle.head )
+    {
+    entry_free( cache, cache->idle.head );
+    }
+}
+
+
+// Execute count query using statement cache.
+cqlite_rcode_t cqlite_stmt_cache_count_query_execute
+    (
+    cqlite_stmt_cache_t *   cache,              //!< Statement cache
+    char const * const      count_query_str,    //!< Parameter-less COUNT query string
+    int *                   count_out           //!< (out) Returned count
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+sqlite3_stmt *  count_query = NULL;
+
+*count_out = 0;
+
+if( CQLITE_SUCCESS == cqlite_stmt_cache_acquire( cache, count_query_str, &count_query ) )
+    {
+    rcode = cqlite_count_query_execute_prepared( count_query, count_out );
+
+    // Clean up
+    cqlite_stmt_cache_release( cache, count_query );
+    }
+
+return rcode;
+}
+
+
+// Create statement cache.
+cqlite_rcode_t cqlite_stmt_cache_create
+    (
+    sqlite3 *               db,         //!< Database connection whose statements are cached
+    int                     capacity,   //!< Maximum number of cached statements
+    cqlite_stmt_cache_t **  cache_out   //!< (out) Statement cache, caller must free
+    )
+{
+cqlite_rcode_t          rcode = CQLITE_ERROR;
+int                     success;
+cqlite_stmt_cache_t *   cache;
+
+*cache_out = NULL;
+
+cache = calloc( 1, sizeof( *cache ) );
+success = ( NULL != cache ) && ( capacity > 0 );
+
+if( success )
+    {
+    cache->db = db;
+    cache->capacity = capacity;
+
+    // Keep the load factor of the hash table at or below one half.
+    cache->bucket_cnt = 1;
+    while( cache->bucket_cnt < ( 2u * (unsigned int)capacity ) )
+        {
+        cache->bucket_cnt *= 2;
+        }
+
+    cache->buckets = calloc( cache->bucket_cnt, sizeof( *cache->buckets ) );
+    success = ( NULL != cache->buckets );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    *cache_out = cache;
+    }
+else if( NULL != cache )
+    {
+    free( cache->buckets );
+    free( cache );
+    }
+
+return rcode;
+}
+
+
+// Get statement cache database.
+sqlite3 * cqlite_stmt_cache_db
+    (
+    cqlite_stmt_cache_t const * cache   //!< Statement cache
+    )
+{
+return cache->db;
+}
+
+
+// Find model by id using statement cache.
+cqlite_rcode_t cqlite_stmt_cache_find_by_id
+    (
+    cqlite_stmt_cache_t *               cache,                  //!< Statement cache
+    char const * const                  find_by_id_query,       //!< SELECT query string taking a single id parameter
+    sqlite_int64                        id,                     //!< Id to search for
+    cqlite_model_from_row_result_func_t model_from_result_func, //!< Function to read the result into the model
+    int *                               found_out,              //!< (out) Was a record found?
+    void *                              model_out               //!< (out) Found model
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+sqlite3_stmt *  select_query = NULL;
+
+*found_out = 0;
+
+success = ( CQLITE_SUCCESS == cqlite_stmt_cache_acquire( cache, find_by_id_query, &select_query ) ) &&
+          ( SQLITE_OK == sqlite3_bind_int64( select_query, 1, id ) );
+
+if( success )
+    {
+    rcode = cqlite_find( select_query, model_from_result_func, found_out, model_out );
+    }
+
+// Clean up
+if( NULL != select_query )
+    {
+    cqlite_stmt_cache_release( cache, select_query );
+    }
+
+return rcode;
+}
+
+
+// Find many models by id using statement cache.
+cqlite_rcode_t cqlite_stmt_cache_find_many_by_ids
+    (
+    cqlite_stmt_cache_t *               cache,                  //!< Statement cache
+    char const * const                  find_many_query_prefix, //!< SELECT query string ending in "IN "
+    int                                 id_column,              //!< Result column holding the id
+    sqlite_int64 const *                ids,                    //!< Ids to search for
+    int                                 id_cnt,                 //!< Number of ids
+    cqlite_model_from_row_result_func_t model_from_result_func, //!< Function to read a result into a model
+    size_t                              model_size,             //!< Size of the model type
+    void *                              model_list,             //!< (out) Found models in the order of ids
+    unsigned char *                     found_bits              //!< (out) Bit of each id that was found
+    )
+{
+cqlite_rcode_t  rcode;
+sqlite3_stmt *  select_query = NULL;
+
+rcode = cqlite_find_many_rows( find_many_query_acquire, cache, find_many_query_prefix, id_column, ids, id_cnt, model_from_result_func, model_size, model_list, found_bits, &select_query );
+
+// Clean up
+if( NULL != select_query )
+    {
+    cqlite_stmt_cache_release( cache, select_query );
+    }
+
+return rcode;
+}
+
+
+// Free statement cache.
+void cqlite_stmt_cache_free
+    (
+    cqlite_stmt_cache_t * cache //!< Statement cache
+    )
+{
+if( NULL != cache )
+    {
+    cqlite_stmt_cache_clear( cache );
+
+    while( NULL != cache->in_use.head )
+        {
+        entry_free( cache, cache->in_use.head );
+        }
+
+    free( cache->buckets );
+    free( cache );
+    }
+}
+
+
+// Insert many models using statement cache.
+cqlite_rcode_t cqlite_stmt_cache_insert_many
+    (
+    cqlite_stmt_cache_t *       cache,              //!< Statement cache
+    char const * const          insert_query_str,   //!< INSERT query string taking the model's parameters
+    cqlite_model_bind_func_t    model_bind_func,    //!< Function to bind a model to the query
+    void const *                model_list,         //!< List of models to insert
+    size_t                      model_size,         //!< Size of the model type
+    int                         model_list_cnt,     //!< Number of models to insert
+    int                         batch_size,         //!< Number of models inserted per transaction
+    sqlite_int64 **             row_ids_out         //!< (out) Generated row id of each model, caller must free, may be NULL
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+sqlite3_stmt *  insert_query = NULL;
+
+if( NULL != row_ids_out )
+    {
+    *row_ids_out = NULL;
+    }
+
+if( CQLITE_SUCCESS == cqlite_stmt_cache_acquire( cache, insert_query_str, &insert_query ) )
+    {
+    rcode = cqlite_insert_many_prepared( cache->db, insert_query, model_bind_func, model_list, model_size, model_list_cnt, batch_size, row_ids_out );
+    cqlite_stmt_cache_release( cache, insert_query );
+    }
+
+return rcode;
+}
+
+
+// Release statement to cache.
+void cqlite_stmt_cache_release
+    (
+    cqlite_stmt_cache_t *   cache,  //!< Statement cache
+    sqlite3_stmt *          query   //!< Statement returned by cqlite_stmt_cache_acquire()
+    )
+{
+stmt_cache_entry_t * entry;
+
+sqlite3_reset( query );
+sqlite3_clear_bindings( query );
+
+// Only a handful of statements are ever acquired at once, so
+// searching the in-use list is cheaper than hashing the query.
+for( entry = cache->in_use.head; NULL != entry; entry = entry->next )
+    {
+    if( query == entry->query )
+        {
+        break;
+        }
+    }
+
+if( NULL == entry )
+    {
+    // Uncached statement
+    sqlite3_finalize( query );
+    }
+else
+    {
+    // SQLite transparently re-prepares a statement whose schema changed.
+    // When that happens, the plans of all other idle statements are stale
+    // and may refer to tables that no longer exist, so drop them.
+    if( 0 != sqlite3_stmt_status( query, SQLITE_STMTSTATUS_REPREPARE, RESET_COUNTER ) )
+        {
+        cache->stats.invalidations++;
+        cqlite_stmt_cache_clear( cache );
+        }
+
+    entry->in_use = 0;
+    entry_list_remove( &cache->in_use, entry );
+    entry_list_push( &cache->idle, entry );
+    }
+}
+
+
+// Execute SELECT query using statement cache.
+cqlite_rcode_t cqlite_stmt_cache_select_query_execute
+    (
+    cqlite_stmt_cache_t *           cache,              //!< Statement cache
+    char const * const              select_query_str,   //!< Parameter-less SELECT query string
+    char const * const              count_query_str,    //!< Parameter-less COUNT query string, NULL for single pass
+    cqlite_model_add_to_list_func_t add_to_list_func,   //!< Add model to list function pointer
+    size_t                          model_size,         //!< Size of the model type
+    void **                         model_list_out,     //!< (out) List of models read from query, caller must free
+    int *                           model_list_cnt_out  //!< (out) Number of models read from query
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+sqlite3_stmt *  select_query = NULL;
+sqlite3_stmt *  count_query = NULL;
+
+*model_list_out = NULL;
+*model_list_cnt_out = 0;
+
+success = ( CQLITE_SUCCESS == cqlite_stmt_cache_acquire( cache, select_query_str, &select_query ) );
+
+if( success && ( NULL != count_query_str ) )
+    {
+    success = ( CQLITE_SUCCESS == cqlite_stmt_cache_acquire( cache, count_query_str, &count_query ) );
+    }
+
+if( success )
+    {
+    rcode = cqlite_select_query_execute_prepared( select_query, count_query, add_to_list_func, model_size, model_list_out, model_list_cnt_out );
+    }
+
+// Clean up
+if( NULL != count_query )
+    {
+    cqlite_stmt_cache_release( cache, count_query );
+    }
+
+if( NULL != select_query )
+    {
+    cqlite_stmt_cache_release( cache, select_query );
+    }
+
+return rcode;
+}
+
+
+// Get statement cache statistics.
+void cqlite_stmt_cache_stats_get
+    (
+    cqlite_stmt_cache_t const *     cache,      //!< Statement cache
+    cqlite_stmt_cache_stats_t *     stats_out   //!< (out) Cache statistics
+    )
+{
+*stats_out = cache->stats;
+}
+
+
+/**
+* Free cache entry.
+*
+* Removes the entry from the cache and finalizes its statement.
+*/
+static void entry_free
+    (
+    cqlite_stmt_cache_t *   cache,
+    stmt_cache_entry_t *    entry
+    )
+{
+stmt_cache_entry_t ** link;
+
+// Unlink the entry from its hash bucket
+link = &cache->buckets[entry->hash & ( cache->bucket_cnt - 1 )];
+
+while( *link != entry )
+    {
+    link = &( *link )->bucket_next;
+    }
+
+*link = entry->bucket_next;
+
+entry_list_remove( entry->in_use ? &cache->in_use : &cache->idle, entry );
+cache->entry_cnt--;
+
+sqlite3_finalize( entry->query );
+free( entry->query_str );
+free( entry );
+}
+
+
+/**
+* Push entry onto the front of a list.
+*/
+static void entry_list_push
+    (
+    stmt_cache_entry_list_t *   list,
+    stmt_cache_entry_t *        entry
+    )
+{
+entry->prev = NULL;
+entry->next = list->head;
+
+if( NULL != list->head )
+    {
+    list->head->prev = entry;
+    }
+else
+    {
+    list->tail = entry;
+    }
+
+list->head = entry;
+}
+
+
+/**
+* Remove entry from a list.
+*/
+static void entry_list_remove
+    (
+    stmt_cache_entry_list_t *   list,
+    stmt_cache_entry_t *        entry
+    )
+{
+if( NULL != entry->prev )
+    {
+    entry->prev->next = entry->next;
+    }
+else
+    {
+    list->head = entry->next;
+    }
+
+if( NULL != entry->next )
+    {
+    entry->next->prev = entry->prev;
+    }
+else
+    {
+    list->tail = entry->prev;
+    }
+
+entry->prev = NULL;
+entry->next = NULL;
+}
+
+
+/**
+* Acquire find many query.
+*
+* Implements cqlite_find_many_prepare_func_t for a statement cache. The
+* chunk size is rounded up to a power of two so that only a handful of
+* IN-list lengths are cached for each query prefix.
+*/
+static int find_many_query_acquire
+    (
+    char const *    find_many_query_prefix,
+    int             chunk_size,
+    void *          context,
+    sqlite3_stmt ** query_out
+    )
+{
+int     success;
+int     param_cnt = 1;
+char *  query_str;
+
+while( param_cnt < chunk_size )
+    {
+    param_cnt *= 2;
+    }
+
+param_cnt = ( param_cnt < CQLITE_FIND_MANY_CHUNK_SIZE ) ? param_cnt : CQLITE_FIND_MANY_CHUNK_SIZE;
+
+query_str = cqlite_find_many_query_build( find_many_query_prefix, param_cnt );
+success = ( NULL != query_str ) &&
+          ( CQLITE_SUCCESS == cqlite_stmt_cache_acquire( (cqlite_stmt_cache_t*)context, query_str, query_out ) );
+
+// Clean up
+free( query_str );
+
+return success;
+}
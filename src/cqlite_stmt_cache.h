@@ -0,0 +1,199 @@
+/** @file */
+
+#ifndef _CQLITE_STMT_CACHE_H
+#define _CQLITE_STMT_CACHE_H
+
+#include <sqlite3.h>
+
+#include "cqlite.h"
+
+/**
+* Prepared statement cache.
+*
+* Caches prepared statements for a single database connection keyed by
+* their SQL text so that repeatedly executed queries are only parsed
+* and planned once. The cache holds at most a fixed number of statements
+* and evicts the least recently used statement when it is full. A cache
+* must only be used by one thread at a time, just like its connection.
+*/
+typedef struct cqlite_stmt_cache_s cqlite_stmt_cache_t;
+
+/**
+* Prepared statement cache statistics.
+*/
+typedef struct
+    {
+    sqlite_int64    hits;           //!< Number of acquires satisfied by a cached statement
+    sqlite_int64    misses;         //!< Number of acquires that had to prepare a statement
+    sqlite_int64    evictions;      //!< Number of statements evicted to make room for others
+    sqlite_int64    invalidations;  //!< Number of times the cache was cleared due to a schema change
+    } cqlite_stmt_cache_stats_t;
+
+/**
+* Acquire statement from cache.
+*
+* Returns a prepared statement for the provided SQL text, preparing it
+* only if no idle cached statement exists for the same text. The caller
+* may bind parameters to and step query_out, but must hand it back with
+* cqlite_stmt_cache_release() rather than calling sqlite3_finalize().
+*/
+cqlite_rcode_t cqlite_stmt_cache_acquire
+    (
+    cqlite_stmt_cache_t *   cache,      //!< Statement cache
+    char const * const      query_str,  //!< SQL text of the statement
+    sqlite3_stmt **         query_out   //!< (out) Prepared statement, must be released
+    );
+
+/**
+* Clear statement cache.
+*
+* Finalizes all idle statements held by the cache. Statements that are
+* currently acquired are unaffected.
+*/
+void cqlite_stmt_cache_clear
+    (
+    cqlite_stmt_cache_t * cache //!< Statement cache
+    );
+
+/**
+* Execute count query using statement cache.
+*
+* @see cqlite_count_query_execute()
+*/
+cqlite_rcode_t cqlite_stmt_cache_count_query_execute
+    (
+    cqlite_stmt_cache_t *   cache,              //!< Statement cache
+    char const * const      count_query_str,    //!< Parameter-less COUNT query string
+    int *                   count_out           //!< (out) Returned count
+    );
+
+/**
+* Create statement cache.
+*
+* Creates a statement cache for the provided database connection that
+* holds at most capacity statements. The caller must call
+* cqlite_stmt_cache_free() on cache_out before closing the connection.
+*/
+cqlite_rcode_t cqlite_stmt_cache_create
+    (
+    sqlite3 *               db,         //!< Database connection whose statements are cached
+    int                     capacity,   //!< Maximum number of cached statements
+    cqlite_stmt_cache_t **  cache_out   //!< (out) Statement cache, caller must free
+    );
+
+/**
+* Get statement cache database.
+*
+* Returns the database connection whose statements are cached.
+*/
+sqlite3 * cqlite_stmt_cache_db
+    (
+    cqlite_stmt_cache_t const * cache   //!< Statement cache
+    );
+
+/**
+* Find model by id using statement cache.
+*
+* @see cqlite_find_by_id()
+*/
+cqlite_rcode_t cqlite_stmt_cache_find_by_id
+    (
+    cqlite_stmt_cache_t *               cache,                  //!< Statement cache
+    char const * const                  find_by_id_query,       //!< SELECT query string taking a single id parameter
+    sqlite_int64                        id,                     //!< Id to search for
+    cqlite_model_from_row_result_func_t model_from_result_func, //!< Function to read the result into the model
+    int *                               found_out,              //!< (out) Was a record found?
+    void *                              model_out               //!< (out) Found model
+    );
+
+/**
+* Find many models by id using statement cache.
+*
+* Each chunk's IN-list is rounded up to a power of two parameters, and
+* padded by repeating its last id, so that only a handful of statements
+* are cached for each query prefix.
+*
+* @see cqlite_find_many_by_ids()
+*/
+cqlite_rcode_t cqlite_stmt_cache_find_many_by_ids
+    (
+    cqlite_stmt_cache_t *               cache,                  //!< Statement cache
+    char const * const                  find_many_query_prefix, //!< SELECT query string ending in "IN "
+    int                                 id_column,              //!< Result column holding the id
+    sqlite_int64 const *                ids,                    //!< Ids to search for
+    int                                 id_cnt,                 //!< Number of ids
+    cqlite_model_from_row_result_func_t model_from_result_func, //!< Function to read a result into a model
+    size_t                              model_size,             //!< Size of the model type
+    void *                              model_list,             //!< (out) Found models in the order of ids
+    unsigned char *                     found_bits              //!< (out) Bit of each id that was found
+    );
+
+/**
+* Free statement cache.
+*
+* Finalizes all statements held by the cache and frees the cache. All
+* acquired statements must be released before calling this.
+*/
+void cqlite_stmt_cache_free
+    (
+    cqlite_stmt_cache_t * cache //!< Statement cache
+    );
+
+/**
+* Insert many models using statement cache.
+*
+* @see cqlite_insert_many()
+*/
+cqlite_rcode_t cqlite_stmt_cache_insert_many
+    (
+    cqlite_stmt_cache_t *       cache,              //!< Statement cache
+    char const * const          insert_query_str,   //!< INSERT query string taking the model's parameters
+    cqlite_model_bind_func_t    model_bind_func,    //!< Function to bind a model to the query
+    void const *                model_list,         //!< List of models to insert
+    size_t                      model_size,         //!< Size of the model type
+    int                         model_list_cnt,     //!< Number of models to insert
+    int                         batch_size,         //!< Number of models inserted per transaction
+    sqlite_int64 **             row_ids_out         //!< (out) Generated row id of each model, caller must free, may be NULL
+    );
+
+/**
+* Release statement to cache.
+*
+* Resets and clears the bindings of a statement returned by
+* cqlite_stmt_cache_acquire() and returns it to the cache. If the
+* statement had to be re-prepared because the database schema changed,
+* all other idle statements are finalized as well since their plans are
+* equally stale.
+*/
+void cqlite_stmt_cache_release
+    (
+    cqlite_stmt_cache_t *   cache,  //!< Statement cache
+    sqlite3_stmt *          query   //!< Statement returned by cqlite_stmt_cache_acquire()
+    );
+
+/**
+* Execute SELECT query using statement cache.
+*
+* @see cqlite_select_query_execute()
+*/
+cqlite_rcode_t cqlite_stmt_cache_select_query_execute
+    (
+    cqlite_stmt_cache_t *           cache,              //!< Statement cache
+    char const * const              select_query_str,   //!< Parameter-less SELECT query string
+    char const * const              count_query_str,    //!< Parameter-less COUNT query string, NULL for single pass
+    cqlite_model_add_to_list_func_t add_to_list_func,   //!< Add model to list function pointer
+    size_t                          model_size,         //!< Size of the model type
+    void **                         model_list_out,     //!< (out) List of models read from query, caller must free
+    int *                           model_list_cnt_out  //!< (out) Number of models read from query
+    );
+
+/**
+* Get statement cache statistics.
+*/
+void cqlite_stmt_cache_stats_get
+    (
+    cqlite_stmt_cache_t const *     cache,      //!< Statement cache
+    cqlite_stmt_cache_stats_t *     stats_out   //!< (out) Cache statistics
+    );
+
+#endif
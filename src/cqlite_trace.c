@@ -0,0 +1,532 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cqlite_trace.h"
+#include "cqlite_private.h"
+
+#define NS_PER_SEC          ( 1000000000LL )
+#define TRACE_MAGIC         ( "CQLTRACE" )
+#define TRACE_MAGIC_SIZE    ( 8 )
+#define TRACE_VERSION       ( 1 )
+#define FILE_HEADER_SIZE    ( TRACE_MAGIC_SIZE + 4 )
+#define RECORD_HEADER_SIZE  ( 25 )
+#define RECORD_NO_API       ( 0xFF )
+#define NO_TRACE_EVENTS     ( 0 )
+#define TRACE_EVENTS        ( SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE )
+#define STMT_START_CNT      ( 16 )
+
+// Offsets of the little-endian fields of a record header, which is
+// followed by the SQL of the record without a NUL terminator.
+#define RECORD_API_OFFSET       ( 0 )
+#define RECORD_THREAD_OFFSET    ( 1 )
+#define RECORD_START_OFFSET     ( 5 )
+#define RECORD_DURATION_OFFSET  ( 13 )
+#define RECORD_SQL_LEN_OFFSET   ( 21 )
+
+
+/**********************************************
+Types
+**********************************************/
+struct cqlite_trace_s
+    {
+    FILE *          file;       //!< Log file
+    pthread_mutex_t mutex;      //!< Serializes writing records from different threads
+    sqlite_int64    open_ns;    //!< Time the tracer was opened
+    atomic_int      failed;     //!< Has writing any record failed?
+    };
+
+typedef struct
+    {
+    sqlite3_stmt *  query;      //!< Statement in progress, NULL if the slot is free
+    sqlite_int64    start_ns;   //!< Time the statement started
+    } stmt_start_t;
+
+struct cqlite_trace_reader_s
+    {
+    FILE *  file;           //!< Log file
+    char *  sql;            //!< SQL of the last record read
+    size_t  sql_capacity;   //!< Size of the SQL buffer
+    };
+
+
+/**********************************************
+Variables
+**********************************************/
+// SQLite only times statements to the millisecond, so each thread
+// times the statements it has in progress itself, from their first step
+// to their completion. This assumes that statements complete on the
+// thread that started them, as the slots are per thread.
+static atomic_uint                  s_thread_cnt;
+static _Thread_local unsigned int   t_thread_id = 0;
+static _Thread_local stmt_start_t   t_stmt_starts[STMT_START_CNT];
+
+
+/**********************************************
+Functions
+**********************************************/
+static sqlite_int64 now_ns
+    (
+    void
+    );
+
+static unsigned int read_u32
+    (
+    unsigned char const * buffer
+    );
+
+static sqlite_int64 read_u64
+    (
+    unsigned char const * buffer
+    );
+
+static int trace_callback
+    (
+    unsigned int    event,
+    void *          context,
+    void *          p,
+    void *          x
+    );
+
+static void write_u32
+    (
+    unsigned char * buffer,
+    unsigned int    value
+    );
+
+static void write_u64
+    (
+    unsigned char * buffer,
+    sqlite_int64    value
+    );
+
+
+// Attach tracer to connection.
+cqlite_rcode_t cqlite_trace_attach
+    (
+    cqlite_trace_t *    trace,  //!< Tracer
+    sqlite3 *           db      //!< Connection to trace
+    )
+{
+cqlite_rcode_t rcode = CQLITE_ERROR;
+
+if( SQLITE_OK == sqlite3_trace_v2( db, TRACE_EVENTS, trace_callback, trace ) )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+return rcode;
+}
+
+
+// Close tracer.
+cqlite_rcode_t cqlite_trace_close
+    (
+    cqlite_trace_t *    trace   //!< Tracer to close, may be NULL
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success = 1;
+
+if( NULL != trace )
+    {
+    success = ( 0 == atomic_load( &trace->failed ) );
+    success = ( 0 == fclose( trace->file ) ) && success;
+
+    pthread_mutex_destroy( &trace->mutex );
+    free( trace );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+return rcode;
+}
+
+
+// Detach tracer from connection.
+void cqlite_trace_detach
+    (
+    sqlite3 *   db  //!< Traced connection
+    )
+{
+sqlite3_trace_v2( db, NO_TRACE_EVENTS, NULL, NULL );
+}
+
+
+// Open tracer.
+cqlite_rcode_t cqlite_trace_open
+    (
+    char const *        path,       //!< Path of the log file
+    cqlite_trace_t **   trace_out   //!< (out) Tracer, caller must close
+    )
+{
+cqlite_rcode_t      rcode = CQLITE_ERROR;
+int                 success;
+cqlite_trace_t *    trace;
+unsigned char       header[FILE_HEADER_SIZE];
+
+*trace_out = NULL;
+
+trace = calloc( 1, sizeof( *trace ) );
+success = ( NULL != trace );
+
+if( success )
+    {
+    trace->file = fopen( path, "wb" );
+    success = ( NULL != trace->file );
+    }
+
+if( success )
+    {
+    memcpy( header, TRACE_MAGIC, TRACE_MAGIC_SIZE );
+    write_u32( &header[TRACE_MAGIC_SIZE], TRACE_VERSION );
+
+    success = ( 1 == fwrite( header, sizeof( header ), 1, trace->file ) );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+
+    pthread_mutex_init( &trace->mutex, NULL );
+    atomic_init( &trace->failed, 0 );
+    trace->open_ns = now_ns();
+
+    *trace_out = trace;
+    }
+else
+    {
+    if( ( NULL != trace ) && ( NULL != trace->file ) )
+        {
+        fclose( trace->file );
+        }
+
+    free( trace );
+    }
+
+return rcode;
+}
+
+
+// Close trace reader.
+void cqlite_trace_reader_close
+    (
+    cqlite_trace_reader_t * reader  //!< Trace reader to close, may be NULL
+    )
+{
+if( NULL != reader )
+    {
+    if( NULL != reader->file )
+        {
+        fclose( reader->file );
+        }
+
+    free( reader->sql );
+    free( reader );
+    }
+}
+
+
+// Read next trace record.
+cqlite_rcode_t cqlite_trace_reader_next
+    (
+    cqlite_trace_reader_t * reader,     //!< Trace reader
+    cqlite_trace_record_t * record_out, //!< (out) Record read from the log
+    int *                   found_out   //!< (out) Was a record read?
+    )
+{
+cqlite_rcode_t  rcode = CQLITE_ERROR;
+int             success;
+size_t          read_size;
+unsigned int    api;
+unsigned int    sql_len = 0;
+char *          new_sql;
+unsigned char   header[RECORD_HEADER_SIZE];
+
+*found_out = 0;
+memset( record_out, 0, sizeof( *record_out ) );
+
+// The log may only end between records
+read_size = fread( header, 1, sizeof( header ), reader->file );
+success = ( sizeof( header ) == read_size ) || ( ( 0 == read_size ) && feof( reader->file ) );
+
+if( success && ( sizeof( header ) == read_size ) )
+    {
+    api = header[RECORD_API_OFFSET];
+    sql_len = read_u32( &header[RECORD_SQL_LEN_OFFSET] );
+
+    success = ( ( api < CQLITE_STATS_API_CNT ) || ( RECORD_NO_API == api ) ) &&
+              ( sql_len < INT32_MAX );
+
+    if( success && ( sql_len >= reader->sql_capacity ) )
+        {
+        new_sql = realloc( reader->sql, (size_t)sql_len + 1 );
+        success = ( NULL != new_sql );
+
+        if( success )
+            {
+            reader->sql = new_sql;
+            reader->sql_capacity = (size_t)sql_len + 1;
+            }
+        }
+
+    if( success )
+        {
+        success = ( sql_len == fread( reader->sql, 1, sql_len, reader->file ) );
+        }
+
+    if( success )
+        {
+        reader->sql[sql_len] = '\0';
+
+        record_out->api = ( RECORD_NO_API == api ) ? CQLITE_TRACE_NO_API : (int)api;
+        record_out->thread_id = read_u32( &header[RECORD_THREAD_OFFSET] );
+        record_out->start_ns = read_u64( &header[RECORD_START_OFFSET] );
+        record_out->duration_ns = read_u64( &header[RECORD_DURATION_OFFSET] );
+        record_out->sql = reader->sql;
+        record_out->sql_len = (int)sql_len;
+
+        *found_out = 1;
+        }
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    }
+
+return rcode;
+}
+
+
+// Open trace reader.
+cqlite_rcode_t cqlite_trace_reader_open
+    (
+    char const *                path,       //!< Path of the log file
+    cqlite_trace_reader_t **    reader_out  //!< (out) Trace reader, caller must close
+    )
+{
+cqlite_rcode_t          rcode = CQLITE_ERROR;
+int                     success;
+cqlite_trace_reader_t * reader;
+unsigned char           header[FILE_HEADER_SIZE];
+
+*reader_out = NULL;
+
+reader = calloc( 1, sizeof( *reader ) );
+success = ( NULL != reader );
+
+if( success )
+    {
+    reader->file = fopen( path, "rb" );
+    success = ( NULL != reader->file );
+    }
+
+if( success )
+    {
+    success = ( 1 == fread( header, sizeof( header ), 1, reader->file ) ) &&
+              ( 0 == memcmp( header, TRACE_MAGIC, TRACE_MAGIC_SIZE ) ) &&
+              ( TRACE_VERSION == read_u32( &header[TRACE_MAGIC_SIZE] ) );
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    *reader_out = reader;
+    }
+else
+    {
+    cqlite_trace_reader_close( reader );
+    }
+
+return rcode;
+}
+
+
+/**
+* Get monotonic time in nanoseconds.
+*/
+static sqlite_int64 now_ns
+    (
+    void
+    )
+{
+struct timespec now;
+
+clock_gettime( CLOCK_MONOTONIC, &now );
+
+return ( (sqlite_int64)now.tv_sec * NS_PER_SEC ) + now.tv_nsec;
+}
+
+
+/**
+* Read little-endian 32-bit value.
+*/
+static unsigned int read_u32
+    (
+    unsigned char const * buffer
+    )
+{
+return (unsigned int)buffer[0] |
+       ( (unsigned int)buffer[1] << 8 ) |
+       ( (unsigned int)buffer[2] << 16 ) |
+       ( (unsigned int)buffer[3] << 24 );
+}
+
+
+/**
+* Read little-endian 64-bit value.
+*/
+static sqlite_int64 read_u64
+    (
+    unsigned char const * buffer
+    )
+{
+return (sqlite_int64)( (sqlite3_uint64)read_u32( buffer ) | ( (sqlite3_uint64)read_u32( &buffer[4] ) << 32 ) );
+}
+
+
+/**
+* Log completed statement.
+*
+* Implements the sqlite3_trace_v2() callback. SQLITE_TRACE_STMT notes
+* the time a statement is first stepped, and SQLITE_TRACE_PROFILE logs
+* it once it completes, with the wall time in between. A statement that
+* completes on another thread than the one that started it is logged
+* with the duration SQLite reports instead. A record is assembled on
+* the stack and written along with the SQL under the tracer's lock, so
+* that records of different threads never interleave.
+*/
+static int trace_callback
+    (
+    unsigned int    event,
+    void *          context,
+    void *          p,
+    void *          x
+    )
+{
+cqlite_trace_t *    trace;
+sqlite3_stmt *      query;
+sqlite_int64        end_ns;
+sqlite_int64        duration_ns;
+cqlite_stats_api_t  api;
+char *              expanded_sql;
+char const *        sql;
+size_t              sql_len;
+int                 success;
+int                 i;
+stmt_start_t *      stmt_start = NULL;
+unsigned char       header[RECORD_HEADER_SIZE];
+
+trace = (cqlite_trace_t*)context;
+query = (sqlite3_stmt*)p;
+
+for( i = 0; ( NULL == stmt_start ) && ( i < STMT_START_CNT ); i++ )
+    {
+    if( t_stmt_starts[i].query == query )
+        {
+        stmt_start = &t_stmt_starts[i];
+        }
+    }
+
+// Triggers also report their start, with SQL starting with a comment.
+// A statement left over from before a detach is simply restarted.
+if( ( SQLITE_TRACE_STMT == event ) && ( 0 != strncmp( (char const*)x, "--", 2 ) ) )
+    {
+    for( i = 0; ( NULL == stmt_start ) && ( i < STMT_START_CNT ); i++ )
+        {
+        if( NULL == t_stmt_starts[i].query )
+            {
+            stmt_start = &t_stmt_starts[i];
+            }
+        }
+
+    if( NULL != stmt_start )
+        {
+        stmt_start->query = query;
+        stmt_start->start_ns = now_ns();
+        }
+    }
+
+if( SQLITE_TRACE_PROFILE == event )
+    {
+    end_ns = now_ns();
+    duration_ns = *(sqlite_int64*)x;
+
+    if( NULL != stmt_start )
+        {
+        duration_ns = end_ns - stmt_start->start_ns;
+        stmt_start->query = NULL;
+        }
+
+    if( 0 == t_thread_id )
+        {
+        t_thread_id = atomic_fetch_add( &s_thread_cnt, 1 ) + 1;
+        }
+
+    // Parameters are expanded into literals so the statement can be
+    // replayed as is. Expanding fails for very long statements.
+    expanded_sql = sqlite3_expanded_sql( query );
+    sql = ( NULL != expanded_sql ) ? expanded_sql : sqlite3_sql( query );
+    sql_len = strlen( sql );
+
+    header[RECORD_API_OFFSET] = cqlite_stats_current_api( &api ) ? (unsigned char)api : RECORD_NO_API;
+    write_u32( &header[RECORD_THREAD_OFFSET], t_thread_id );
+    write_u64( &header[RECORD_START_OFFSET], end_ns - duration_ns - trace->open_ns );
+    write_u64( &header[RECORD_DURATION_OFFSET], duration_ns );
+    write_u32( &header[RECORD_SQL_LEN_OFFSET], (unsigned int)sql_len );
+
+    pthread_mutex_lock( &trace->mutex );
+
+    success = ( 1 == fwrite( header, sizeof( header ), 1, trace->file ) ) &&
+              ( sql_len == fwrite( sql, 1, sql_len, trace->file ) );
+
+    pthread_mutex_unlock( &trace->mutex );
+
+    if( !success )
+        {
+        atomic_store( &trace->failed, 1 );
+        }
+
+    sqlite3_free( expanded_sql );
+    }
+
+return 0;
+}
+
+
+/**
+* Write little-endian 32-bit value.
+*/
+static void write_u32
+    (
+    unsigned char * buffer,
+    unsigned int    value
+    )
+{
+buffer[0] = (unsigned char)( value );
+buffer[1] = (unsigned char)( value >> 8 );
+buffer[2] = (unsigned char)( value >> 16 );
+buffer[3] = (unsigned char)( value >> 24 );
+}
+
+
+/**
+* Write little-endian 64-bit value.
+*/
+static void write_u64
+    (
+    unsigned char * buffer,
+    sqlite_int64    value
+    )
+{
+write_u32( buffer, (unsigned int)( (sqlite3_uint64)value ) );
+write_u32( &buffer[4], (unsigned int)( (sqlite3_uint64)value >> 32 ) );
+}
@@ -0,0 +1,134 @@
+/** @file */
+
+#ifndef _CQLITE_TRACE_H
+#define _CQLITE_TRACE_H
+
+#include <sqlite3.h>
+
+#include "cqlite.h"
+#include "cqlite_stats.h"
+
+#define CQLITE_TRACE_NO_API ( -1 )  //!< Statement executed outside of any instrumented call
+
+/**
+* Tracer.
+*
+* Writes a compact binary log of every statement completed on the
+* connections attached to it, for replaying production traffic against
+* a copy of the database with the cqlite_replay tool. Each record holds
+* the SQL of the statement with its bound parameters expanded into
+* literals, the wall time from its first step to its completion, the
+* thread that ran it, and the CQLite function group it was executed by.
+* The wall time includes the time the caller spent between steps, such
+* as reading each row into a model.
+*
+* A tracer may be attached to any number of connections used from any
+* number of threads. Each statement must complete on the thread that
+* first stepped it. Otherwise its duration falls back to the coarser
+* one SQLite reports.
+*/
+typedef struct cqlite_trace_s cqlite_trace_t;
+
+/**
+* Trace reader.
+*
+* Reads back the records of a log written by a tracer, in the order in
+* which the statements completed.
+*/
+typedef struct cqlite_trace_reader_s cqlite_trace_reader_t;
+
+/**
+* Trace record.
+*/
+typedef struct
+    {
+    int             api;            //!< cqlite_stats_api_t of the call that executed the statement, CQLITE_TRACE_NO_API if none
+    unsigned int    thread_id;      //!< Sequential id of the thread that executed the statement, starting at 1
+    sqlite_int64    start_ns;       //!< Time the statement started, relative to the opening of the tracer
+    sqlite_int64    duration_ns;    //!< Wall time from the first step of the statement to its completion
+    char const *    sql;            //!< Expanded SQL of the statement, owned by the reader
+    int             sql_len;        //!< Length of the SQL in bytes, not counting the NUL terminator
+    } cqlite_trace_record_t;
+
+/**
+* Attach tracer to connection.
+*
+* Logs every statement completed on the connection from now on. This
+* replaces any sqlite3_trace_v2() callback of the connection. The
+* connection must be detached or closed before the tracer is closed.
+*/
+cqlite_rcode_t cqlite_trace_attach
+    (
+    cqlite_trace_t *    trace,  //!< Tracer
+    sqlite3 *           db      //!< Connection to trace
+    );
+
+/**
+* Close tracer.
+*
+* Flushes and closes the log and frees the tracer. Returns CQLITE_ERROR
+* if any record could not be written.
+*/
+cqlite_rcode_t cqlite_trace_close
+    (
+    cqlite_trace_t *    trace   //!< Tracer to close, may be NULL
+    );
+
+/**
+* Detach tracer from connection.
+*
+* Stops logging the statements of the connection.
+*/
+void cqlite_trace_detach
+    (
+    sqlite3 *   db  //!< Traced connection
+    );
+
+/**
+* Open tracer.
+*
+* Creates the log file at the provided path, replacing any existing
+* file. The caller must call cqlite_trace_close() on trace_out.
+*/
+cqlite_rcode_t cqlite_trace_open
+    (
+    char const *        path,       //!< Path of the log file
+    cqlite_trace_t **   trace_out   //!< (out) Tracer, caller must close
+    );
+
+/**
+* Close trace reader.
+*/
+void cqlite_trace_reader_close
+    (
+    cqlite_trace_reader_t * reader  //!< Trace reader to close, may be NULL
+    );
+
+/**
+* Read next trace record.
+*
+* Reads the next record of the log into record_out and sets found_out
+* to 1, or sets found_out to 0 at the end of the log. The SQL of the
+* record is only valid until the next call.
+*/
+cqlite_rcode_t cqlite_trace_reader_next
+    (
+    cqlite_trace_reader_t * reader,     //!< Trace reader
+    cqlite_trace_record_t * record_out, //!< (out) Record read from the log
+    int *                   found_out   //!< (out) Was a record read?
+    );
+
+/**
+* Open trace reader.
+*
+* Opens the log file at the provided path, which must have been written
+* by a tracer. The caller must call cqlite_trace_reader_close() on
+* reader_out.
+*/
+cqlite_rcode_t cqlite_trace_reader_open
+    (
+    char const *                path,       //!< Path of the log file
+    cqlite_trace_reader_t **    reader_out  //!< (out) Trace reader, caller must close
+    );
+
+#endif
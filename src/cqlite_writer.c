@@ -0,0 +1,667 @@
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cqlite_stmt_cache.h"
+#include "cqlite_writer.h"
+
+#define NO_CALLBACK         ( NULL )
+#define NO_CALLBACK_PARAM   ( NULL )
+#define NO_ERROR_MESSAGE    ( NULL )
+#define NO_VFS              ( NULL )
+#define NO_DEADLINE         ( NULL )
+#define BUSY_TIMEOUT_MS     ( 5000 )
+#define NS_PER_SEC          ( 1000000000L )
+#define NS_PER_US           ( 1000L )
+
+
+/**********************************************
+Types
+**********************************************/
+
+// Link of the writer's intrusive job queue
+typedef struct queue_node_s
+    {
+    struct queue_node_s * _Atomic next;
+    } queue_node_t;
+
+struct cqlite_writer_job_s
+    {
+    queue_node_t                    node;               //!< Link in the writer's queue, must be first
+    cqlite_writer_t *               writer;             //!< Writer the job was queued on
+    char const *                    insert_query_str;   //!< INSERT query string
+    cqlite_model_bind_func_t        model_bind_func;    //!< Function to bind the model to the query
+    cqlite_writer_complete_func_t   complete_func;      //!< Function called when the job completes, may be NULL
+    void *                          context;            //!< Context passed to complete_func
+    int                             has_waiter;         //!< Will cqlite_writer_job_wait() free the job?
+    atomic_int                      is_done;            //!< Has the job completed?
+    cqlite_rcode_t                  rcode;              //!< Result of the job
+    sqlite_int64                    row_id;             //!< Generated row id
+    cqlite_writer_job_t *           batch_next;         //!< Next job in the same transaction
+    max_align_t                     model[];            //!< Copy of the model
+    };
+
+struct cqlite_writer_s
+    {
+    sqlite3 *               db;                 //!< Write connection
+    cqlite_stmt_cache_t *   stmt_cache;         //!< Statement cache of the write connection
+    int                     max_batch_size;     //!< Maximum number of jobs per transaction
+    int                     commit_window_us;   //!< Time to gather jobs into a transaction
+    pthread_t               thread;             //!< Writer's thread
+    int                     is_thread_started;  //!< Was the writer's thread created?
+    queue_node_t * _Atomic  queue_tail;         //!< Most recently queued node, exchanged by producers
+    queue_node_t *          queue_head;         //!< Oldest queued node, only used by the writer's thread
+    queue_node_t            queue_stub;         //!< Node keeping the queue non-empty
+    atomic_int              wake_pending;       //!< Were jobs queued since the writer's thread last looked?
+    atomic_int              is_closing;         //!< Is the writer being closed?
+    pthread_mutex_t         wake_mutex;         //!< Protects waiting for jobs
+    pthread_cond_t          wake_cond;          //!< Signaled when jobs are queued or the writer is closing
+    pthread_mutex_t         done_mutex;         //!< Protects waiting for jobs to complete
+    pthread_cond_t          done_cond;          //!< Broadcast when a transaction completes
+    };
+
+
+/**********************************************
+Functions
+**********************************************/
+static void batch_complete
+    (
+    cqlite_writer_t *       writer,
+    cqlite_writer_job_t *   batch
+    );
+
+static void batch_fail
+    (
+    cqlite_writer_job_t * batch
+    );
+
+static void batch_run
+    (
+    cqlite_writer_t *       writer,
+    cqlite_writer_job_t *   first_job
+    );
+
+static void job_execute
+    (
+    cqlite_writer_t *       writer,
+    cqlite_writer_job_t *   job
+    );
+
+static cqlite_writer_job_t * queue_pop
+    (
+    cqlite_writer_t * writer
+    );
+
+static void queue_push
+    (
+    cqlite_writer_t *   writer,
+    queue_node_t *      node
+    );
+
+static void writer_wait
+    (
+    cqlite_writer_t *       writer,
+    struct timespec const * deadline
+    );
+
+static void writer_wake
+    (
+    cqlite_writer_t * writer
+    );
+
+static void * writer_thread
+    (
+    void * args
+    );
+
+
+// Close asynchronous writer.
+void cqlite_writer_close
+    (
+    cqlite_writer_t * writer    //!< Writer to close
+    )
+{
+if( NULL != writer )
+    {
+    // The writer's thread drains the queue before it exits.
+    if( writer->is_thread_started )
+        {
+        atomic_store( &writer->is_closing, 1 );
+
+        pthread_mutex_lock( &writer->wake_mutex );
+        pthread_cond_signal( &writer->wake_cond );
+        pthread_mutex_unlock( &writer->wake_mutex );
+
+        pthread_join( writer->thread, NULL );
+        }
+
+    cqlite_stmt_cache_free( writer->stmt_cache );
+    sqlite3_close( writer->db );
+
+    pthread_mutex_destroy( &writer->wake_mutex );
+    pthread_cond_destroy( &writer->wake_cond );
+    pthread_mutex_destroy( &writer->done_mutex );
+    pthread_cond_destroy( &writer->done_cond );
+
+    free( writer );
+    }
+}
+
+
+// Queue insert job.
+cqlite_rcode_t cqlite_writer_insert
+    (
+    cqlite_writer_t *               writer,             //!< Asynchronous writer
+    char const * const              insert_query_str,   //!< INSERT query string taking the model's parameters
+    cqlite_model_bind_func_t        model_bind_func,    //!< Function to bind a model to the query
+    void const *                    model,              //!< Model to insert
+    size_t                          model_size,         //!< Size of the model type
+    cqlite_writer_complete_func_t   complete_func,      //!< Function called when the job completes, may be NULL
+    void *                          context,            //!< Context passed to complete_func
+    cqlite_writer_job_t **          job_out             //!< (out) Job to wait on, may be NULL
+    )
+{
+cqlite_rcode_t          rcode = CQLITE_ERROR;
+cqlite_writer_job_t *   job;
+
+if( NULL != job_out )
+    {
+    *job_out = NULL;
+    }
+
+job = malloc( sizeof( *job ) + model_size );
+
+if( NULL != job )
+    {
+    job->writer = writer;
+    job->insert_query_str = insert_query_str;
+    job->model_bind_func = model_bind_func;
+    job->complete_func = complete_func;
+    job->context = context;
+    job->has_waiter = ( NULL != job_out );
+    job->rcode = CQLITE_ERROR;
+    job->row_id = CQLITE_INVALID_ROW_ID;
+    job->batch_next = NULL;
+    atomic_init( &job->is_done, 0 );
+    memcpy( job->model, model, model_size );
+
+    // The job may complete and be freed as soon as it is queued.
+    if( NULL != job_out )
+        {
+        *job_out = job;
+        }
+
+    queue_push( writer, &job->node );
+    writer_wake( writer );
+
+    rcode = CQLITE_SUCCESS;
+    }
+
+return rcode;
+}
+
+
+// Wait for writer job.
+cqlite_rcode_t cqlite_writer_job_wait
+    (
+    cqlite_writer_job_t *   job,        //!< Job returned by cqlite_writer_insert()
+    sqlite_int64 *          row_id_out  //!< (out) Generated row id, may be NULL
+    )
+{
+cqlite_rcode_t rcode;
+
+// Transactions complete all of their jobs with a single broadcast
+pthread_mutex_lock( &job->writer->done_mutex );
+
+while( !atomic_load( &job->is_done ) )
+    {
+    pthread_cond_wait( &job->writer->done_cond, &job->writer->done_mutex );
+    }
+
+pthread_mutex_unlock( &job->writer->done_mutex );
+
+rcode = job->rcode;
+
+if( NULL != row_id_out )
+    {
+    *row_id_out = job->row_id;
+    }
+
+free( job );
+
+return rcode;
+}
+
+
+// Open asynchronous writer.
+cqlite_rcode_t cqlite_writer_open
+    (
+    char const * const  path,                   //!< Path of the database file
+    int                 stmt_cache_capacity,    //!< Number of prepared statements cached by the writer
+    int                 max_batch_size,         //!< Maximum number of jobs per transaction
+    int                 commit_window_us,       //!< Time to gather jobs into a transaction
+    cqlite_writer_t **  writer_out              //!< (out) Asynchronous writer, caller must close
+    )
+{
+cqlite_rcode_t      rcode = CQLITE_ERROR;
+int                 success;
+cqlite_writer_t *   writer;
+
+*writer_out = NULL;
+
+writer = calloc( 1, sizeof( *writer ) );
+success = ( NULL != writer );
+
+if( success )
+    {
+    writer->max_batch_size = max_batch_size;
+    writer->commit_window_us = commit_window_us;
+
+    atomic_init( &writer->queue_stub.next, NULL );
+    atomic_init( &writer->queue_tail, &writer->queue_stub );
+    writer->queue_head = &writer->queue_stub;
+    atomic_init( &writer->wake_pending, 0 );
+    atomic_init( &writer->is_closing, 0 );
+
+    pthread_mutex_init( &writer->wake_mutex, NULL );
+    pthread_cond_init( &writer->wake_cond, NULL );
+    pthread_mutex_init( &writer->done_mutex, NULL );
+    pthread_cond_init( &writer->done_cond, NULL );
+
+    // Only the writer's thread uses the connection, so it is opened
+    // without SQLite's per-connection mutex.
+    success = ( SQLITE_OK == sqlite3_open_v2( path, &writer->db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, NO_VFS ) ) &&
+              ( SQLITE_OK == sqlite3_busy_timeout( writer->db, BUSY_TIMEOUT_MS ) ) &&
+              ( CQLITE_SUCCESS == cqlite_stmt_cache_create( writer->db, stmt_cache_capacity, &writer->stmt_cache ) );
+    }
+
+if( success )
+    {
+    success = ( 0 == pthread_create( &writer->thread, NULL, writer_thread, writer ) );
+    writer->is_thread_started = success;
+    }
+
+if( success )
+    {
+    rcode = CQLITE_SUCCESS;
+    *writer_out = writer;
+    }
+else
+    {
+    cqlite_writer_close( writer );
+    }
+
+return rcode;
+}
+
+
+/**
+* Complete batch of jobs.
+*
+* Calls the complete function of each job of a finished transaction,
+* then wakes the threads waiting on any of them with one broadcast.
+* Jobs without a waiter are freed here.
+*/
+static void batch_complete
+    (
+    cqlite_writer_t *       writer,
+    cqlite_writer_job_t *   batch
+    )
+{
+cqlite_writer_job_t *   job;
+cqlite_writer_job_t *   next_job;
+int                     has_waiter = 0;
+
+pthread_mutex_lock( &writer->done_mutex );
+
+// A waiter may free its job as soon as it is marked done, so the job
+// must not be touched afterwards.
+for( job = batch; NULL != job; job = next_job )
+    {
+    next_job = job->batch_next;
+
+    if( NULL != job->complete_func )
+        {
+        job->complete_func( job->rcode, job->row_id, job->context );
+        }
+
+    if( job->has_waiter )
+        {
+        has_waiter = 1;
+        atomic_store( &job->is_done, 1 );
+        }
+    else
+        {
+        free( job );
+        }
+    }
+
+if( has_waiter )
+    {
+    pthread_cond_broadcast( &writer->done_cond );
+    }
+
+pthread_mutex_unlock( &writer->done_mutex );
+}
+
+
+/**
+* Fail batch of jobs.
+*
+* Marks every job of a transaction that was rolled back as failed.
+*/
+static void batch_fail
+    (
+    cqlite_writer_job_t * batch
+    )
+{
+cqlite_writer_job_t * job;
+
+for( job = batch; NULL != job; job = job->batch_next )
+    {
+    job->rcode = CQLITE_ERROR;
+    job->row_id = CQLITE_INVALID_ROW_ID;
+    }
+}
+
+
+/**
+* Run batch of jobs.
+*
+* Executes first_job and the jobs queued behind it in one transaction,
+* until the queue is empty and the commit window has passed or the
+* batch is full, then commits and completes them.
+*/
+static void batch_run
+    (
+    cqlite_writer_t *       writer,
+    cqlite_writer_job_t *   first_job
+    )
+{
+int                     success;
+int                     batch_cnt = 0;
+cqlite_writer_job_t *   job;
+cqlite_writer_job_t *   batch = NULL;
+cqlite_writer_job_t *   batch_last = NULL;
+struct timespec         deadline;
+
+clock_gettime( CLOCK_REALTIME, &deadline );
+deadline.tv_sec += writer->commit_window_us / 1000000;
+deadline.tv_nsec += ( writer->commit_window_us % 1000000 ) * NS_PER_US;
+
+if( deadline.tv_nsec >= NS_PER_SEC )
+    {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= NS_PER_SEC;
+    }
+
+success = ( SQLITE_OK == sqlite3_exec( writer->db, "BEGIN IMMEDIATE;", NO_CALLBACK, NO_CALLBACK_PARAM, NO_ERROR_MESSAGE ) );
+
+for( job = first_job; NULL != job; )
+    {
+    if( success )
+        {
+        job_execute( writer, job );
+        }
+
+    // Errors such as a full disk roll back the whole transaction
+    // rather than just the failed statement.
+    if( success && ( CQLITE_SUCCESS != job->rcode ) && sqlite3_get_autocommit( writer->db ) )
+        {
+        success = 0;
+        }
+
+    if( NULL == batch )
+        {
+        batch = job;
+        }
+    else
+        {
+        batch_last->batch_next = job;
+        }
+
+    batch_last = job;
+    batch_cnt++;
+
+    // Gather the jobs queued since the transaction began
+    job = NULL;
+
+    if( ( writer->max_batch_size <= 0 ) || ( batch_cnt < writer->max_batch_size ) )
+        {
+        atomic_store( &writer->wake_pending, 0 );
+        job = queue_pop( writer );
+
+        if( ( NULL == job ) && ( writer->commit_window_us > 0 ) && !atomic_load( &writer->is_closing ) )
+            {
+            writer_wait( writer, &deadline );
+            job = queue_pop( writer );
+            }
+        }
+    }
+
+if( success )
+    {
+    success = ( SQLITE_OK == sqlite3_exec( writer->db, "COMMIT;", NO_CALLBACK, NO_CALLBACK_PARAM, NO_ERROR_MESSAGE ) );
+    }
+
+if( !success )
+    {
+    if( !sqlite3_get_autocommit( writer->db ) )
+        {
+        sqlite3_exec( writer->db, "ROLLBACK;", NO_CALLBACK, NO_CALLBACK_PARAM, NO_ERROR_MESSAGE );
+        }
+
+    batch_fail( batch );
+    }
+
+batch_complete( writer, batch );
+}
+
+
+/**
+* Execute job.
+*/
+static void job_execute
+    (
+    cqlite_writer_t *       writer,
+    cqlite_writer_job_t *   job
+    )
+{
+int             success;
+sqlite3_stmt *  insert_query = NULL;
+
+success = ( CQLITE_SUCCESS == cqlite_stmt_cache_acquire( writer->stmt_cache, job->insert_query_str, &insert_query ) );
+
+success = success &&
+          job->model_bind_func( insert_query, job->model ) &&
+          ( CQLITE_SUCCESS == cqlite_insert_query_execute( writer->db, insert_query, &job->row_id ) );
+
+job->rcode = success ? CQLITE_SUCCESS : CQLITE_ERROR;
+
+if( !success )
+    {
+    job->row_id = CQLITE_INVALID_ROW_ID;
+    }
+
+// Clean up
+if( NULL != insert_query )
+    {
+    cqlite_stmt_cache_release( writer->stmt_cache, insert_query );
+    }
+}
+
+
+/**
+* Pop job from queue.
+*
+* Returns the oldest queued job, or NULL if the queue is empty. Only
+* the writer's thread may pop jobs. A producer that has swapped itself
+* in as the tail but not yet linked its node briefly hides the rest of
+* the queue, in which case this yields until the link appears.
+*/
+static cqlite_writer_job_t * queue_pop
+    (
+    cqlite_writer_t * writer
+    )
+{
+cqlite_writer_job_t *   job = NULL;
+queue_node_t *          head;
+queue_node_t *          next;
+int                     is_done = 0;
+
+while( !is_done )
+    {
+    head = writer->queue_head;
+    next = atomic_load( &head->next );
+
+    // Skip over the stub node
+    if( ( &writer->queue_stub == head ) && ( NULL != next ) )
+        {
+        writer->queue_head = next;
+        head = next;
+        next = atomic_load( &head->next );
+        }
+
+    if( NULL != next )
+        {
+        writer->queue_head = next;
+        job = (cqlite_writer_job_t*)head;
+        is_done = 1;
+        }
+    else if( head != atomic_load( &writer->queue_tail ) )
+        {
+        // A producer is between swapping the tail and linking its node
+        sched_yield();
+        }
+    else if( &writer->queue_stub == head )
+        {
+        is_done = 1;
+        }
+    else
+        {
+        // The head is the last node, put the stub behind it so that it
+        // can be removed without racing producers for the tail.
+        queue_push( writer, &writer->queue_stub );
+        }
+    }
+
+return job;
+}
+
+
+/**
+* Push node onto queue.
+*
+* Safe to call from any number of threads at once.
+*/
+static void queue_push
+    (
+    cqlite_writer_t *   writer,
+    queue_node_t *      node
+    )
+{
+queue_node_t * prev;
+
+atomic_store( &node->next, NULL );
+prev = atomic_exchange( &writer->queue_tail, node );
+atomic_store( &prev->next, node );
+}
+
+
+/**
+* Wait for jobs.
+*
+* Blocks the writer's thread until jobs are queued, the writer is
+* closing, or the deadline passes if it is not NO_DEADLINE.
+*/
+static void writer_wait
+    (
+    cqlite_writer_t *       writer,
+    struct timespec const * deadline
+    )
+{
+int rc = 0;
+
+pthread_mutex_lock( &writer->wake_mutex );
+
+while( !atomic_load( &writer->wake_pending ) && !atomic_load( &writer->is_closing ) && ( ETIMEDOUT != rc ) )
+    {
+    if( NO_DEADLINE == deadline )
+        {
+        pthread_cond_wait( &writer->wake_cond, &writer->wake_mutex );
+        }
+    else
+        {
+        rc = pthread_cond_timedwait( &writer->wake_cond, &writer->wake_mutex, deadline );
+        }
+    }
+
+pthread_mutex_unlock( &writer->wake_mutex );
+}
+
+
+/**
+* Wake writer's thread.
+*
+* Only the first producer after the writer's thread last looked at the
+* queue pays for the mutex, later ones see the wakeup already pending.
+*/
+static void writer_wake
+    (
+    cqlite_writer_t * writer
+    )
+{
+if( 0 == atomic_exchange( &writer->wake_pending, 1 ) )
+    {
+    pthread_mutex_lock( &writer->wake_mutex );
+    pthread_cond_signal( &writer->wake_cond );
+    pthread_mutex_unlock( &writer->wake_mutex );
+    }
+}
+
+
+/**
+* Writer's thread.
+*
+* Runs a transaction for each group of queued jobs, sleeping while the
+* queue is empty, until the writer is closed and the queue drained.
+*/
+static void * writer_thread
+    (
+    void * args
+    )
+{
+cqlite_writer_t *       writer;
+cqlite_writer_job_t *   job;
+int                     is_done = 0;
+
+writer = (cqlite_writer_t*)args;
+
+while( !is_done )
+    {
+    // Clear the pending wakeup before looking so that jobs queued
+    // after the queue is found empty always raise it again.
+    atomic_store( &writer->wake_pending, 0 );
+    job = queue_pop( writer );
+
+    if( NULL != job )
+        {
+        batch_run( writer, job );
+        }
+    else if( atomic_load( &writer->is_closing ) )
+        {
+        is_done = 1;
+        }
+    else
+        {
+        writer_wait( writer, NO_DEADLINE );
+        }
+    }
+
+return NULL;
+}
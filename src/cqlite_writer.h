@@ -0,0 +1,116 @@
+/** @file */
+
+#ifndef _CQLITE_WRITER_H
+#define _CQLITE_WRITER_H
+
+#include <sqlite3.h>
+
+#include "cqlite.h"
+
+/**
+* Asynchronous writer.
+*
+* Owns a write connection to one database file and a thread that
+* executes the insert jobs queued by any number of other threads. Jobs
+* are queued without taking a lock, and all jobs that queue up while
+* the previous transaction commits are grouped into the next one, so
+* that many writers share each journal sync.
+*/
+typedef struct cqlite_writer_s cqlite_writer_t;
+
+/**
+* Writer job.
+*
+* Handle to an insert queued with cqlite_writer_insert() that can be
+* waited on for its result.
+*/
+typedef struct cqlite_writer_job_s cqlite_writer_job_t;
+
+/**
+* Job complete function type.
+*
+* Called on the writer's thread once the transaction holding the job
+* has committed or failed. The row id is CQLITE_INVALID_ROW_ID unless
+* rcode is CQLITE_SUCCESS. These functions must not block or use the
+* writer.
+*/
+typedef void (*cqlite_writer_complete_func_t)
+    (
+    cqlite_rcode_t  rcode,      //!< Result of the job
+    sqlite_int64    row_id,     //!< Generated row id of the inserted model
+    void *          context     //!< Context provided to cqlite_writer_insert()
+    );
+
+/**
+* Close asynchronous writer.
+*
+* Executes all jobs queued before the call, then stops the writer's
+* thread, closes its connection, and frees the writer. No jobs may be
+* queued concurrently with or after this call.
+*/
+void cqlite_writer_close
+    (
+    cqlite_writer_t * writer    //!< Writer to close
+    );
+
+/**
+* Queue insert job.
+*
+* Copies the model_size bytes of the model into the job and queues it
+* on the writer without blocking. The writer's thread later binds the
+* copy to the INSERT query with model_bind_func and executes it. The
+* query string and any memory the model points to, such as strings,
+* must remain valid until the job completes.
+*
+* When the job completes, complete_func is called if it is not NULL.
+* If job_out is not NULL, it is set to a handle that the caller must
+* pass to cqlite_writer_job_wait(). Otherwise the job is freed by the
+* writer once it completes.
+*/
+cqlite_rcode_t cqlite_writer_insert
+    (
+    cqlite_writer_t *               writer,             //!< Asynchronous writer
+    char const * const              insert_query_str,   //!< INSERT query string taking the model's parameters
+    cqlite_model_bind_func_t        model_bind_func,    //!< Function to bind a model to the query
+    void const *                    model,              //!< Model to insert
+    size_t                          model_size,         //!< Size of the model type
+    cqlite_writer_complete_func_t   complete_func,      //!< Function called when the job completes, may be NULL
+    void *                          context,            //!< Context passed to complete_func
+    cqlite_writer_job_t **          job_out             //!< (out) Job to wait on, may be NULL
+    );
+
+/**
+* Wait for writer job.
+*
+* Blocks until the job has completed, frees it, and returns its result.
+* The row id is set to the generated row id of the inserted model, or
+* CQLITE_INVALID_ROW_ID if the job failed.
+*/
+cqlite_rcode_t cqlite_writer_job_wait
+    (
+    cqlite_writer_job_t *   job,        //!< Job returned by cqlite_writer_insert()
+    sqlite_int64 *          row_id_out  //!< (out) Generated row id, may be NULL
+    );
+
+/**
+* Open asynchronous writer.
+*
+* Opens a write connection to the database file at the provided path,
+* creating it if needed, and starts the writer's thread. Each
+* transaction holds at most max_batch_size jobs, or any number of jobs
+* if max_batch_size is not positive. If commit_window_us is positive,
+* the writer keeps each transaction open for up to that many
+* microseconds after its first job to gather more jobs, trading latency
+* for fewer syncs. The caller must call cqlite_writer_close() on
+* writer_out.
+*/
+cqlite_rcode_t cqlite_writer_open
+    (
+    char const * const  path,                   //!< Path of the database file
+    int                 stmt_cache_capacity,    //!< Number of prepared statements cached by the writer
+    int                 max_batch_size,         //!< Maximum number of jobs per transaction
+    int                 commit_window_us,       //!< Time to gather jobs into a transaction
+    cqlite_writer_t **  writer_out              //!< (out) Asynchronous writer, caller must close
+    );
+
+#endif
@@ -1,76 +1,2116 @@
+#include <fcntl.h>
+#include <float.h>
+#include <pthread.h>
 #include <sqlite3.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "cqlite.h"
 #include "test_database.h"
+#include "test_gen.h"
 #include "unity.h"
 
 #define TEST_DATABASE_FILE  ( "test.db" )
+#define TEST_MODEL_CNT      ( 100 )
+#define TEST_CACHE_CAPACITY ( 4 )
+#define TEST_BATCH_SIZE     ( 7 )
+#define TEST_POOL_FILE      ( "test_pool.db" )
+#define TEST_THREAD_CNT     ( 4 )
+#define TEST_NULL_MODEL_IDX ( 70 )
+#define TEST_FIND_MANY_CNT  ( 1500 )
+#define TEST_WRITER_BATCH   ( 64 )
+#define TEST_WRITER_WINDOW  ( 1000 )
+#define TEST_IMPORT_CSV     ( "test_import.csv" )
+#define TEST_IMPORT_BINARY  ( "test_import.bin" )
+#define TEST_IMPORT_CNT     ( 3000 )
+#define TEST_IMPORT_BATCH   ( 1000 )
+#define TEST_PROFILE_FILE   ( "test_profile.db" )
+#define TEST_PROFILE_WAL    ( "test_profile.db-wal" )
+#define TEST_POLL_MS        ( 5 )
+#define TEST_IDLE_MS        ( 50 )
+#define TEST_WAIT_MS        ( 5000 )
+#define TEST_SEGMENTED_CNT  ( 50000 )
+#define TEST_TRACE_FILE     ( "test_trace.bin" )
+#define TEST_BLOB_SIZE      ( ( 3 * CQLITE_BLOB_CHUNK_SIZE ) + 123 )
+#define TEST_BLOB_CHUNK     ( 1000 )
+#define TEST_BLOB_IN_FILE   ( "test_blob_in.bin" )
+#define TEST_BLOB_OUT_FILE  ( "test_blob_out.bin" )
 
 // Database handle shared by all tests. We assume that the
 // tests are never run in parallel so it is safe for them to
 // share a single database handle.
 sqlite3 * g_db = NULL;
 
+// Arguments of a thread reading models from a connection pool
+typedef struct
+    {
+    cqlite_pool_t *             pool;
+    test_model_list_t const *   expected_models;
+    int                         success;
+    } pool_reader_args_t;
+
+// Arguments of a thread queueing models on an asynchronous writer
+typedef struct
+    {
+    cqlite_writer_t *   writer;
+    test_model_list_t   models;
+    atomic_int *        callback_success_cnt;
+    int                 success;
+    } writer_insert_args_t;
+
 
 /*************************************
 Test functions
 *************************************/
+static void test_arena_select
+    (
+    void
+    );
+
+static void test_blob
+    (
+    void
+    );
+
+static void test_cursor
+    (
+    void
+    );
+
+static void test_find_many
+    (
+    void
+    );
+
+static void test_fold
+    (
+    void
+    );
+
+static void test_generated
+    (
+    void
+    );
+
+static void test_import
+    (
+    void
+    );
+
+static void test_insert_many
+    (
+    void
+    );
+
+static void test_insert_mapped
+    (
+    void
+    );
+
 static void test_insert_new
     (
     void
     );
 
+static void test_open
+    (
+    void
+    );
+
+static void test_page
+    (
+    void
+    );
+
+static void test_parallel_select
+    (
+    void
+    );
+
+static void test_pipeline
+    (
+    void
+    );
+
+static void test_pool
+    (
+    void
+    );
+
+static void test_result_cache
+    (
+    void
+    );
+
+static void test_select_columnar
+    (
+    void
+    );
+
+static void test_select_counted
+    (
+    void
+    );
+
+static void test_select_mapped
+    (
+    void
+    );
+
+static void test_select_segmented
+    (
+    void
+    );
+
+static void test_select_single_pass
+    (
+    void
+    );
+
+static void test_stats
+    (
+    void
+    );
+
+static void test_stmt_cache
+    (
+    void
+    );
+
+static void test_string_view
+    (
+    void
+    );
+
+static void test_trace
+    (
+    void
+    );
+
+static void test_writer
+    (
+    void
+    );
+
 /*************************************
 Helper functions
 *************************************/
 static void after_all_tests
     (
     void
-    );
+    );
+
+static void assert_gen_model_equal
+    (
+    test_model_t const *    expected,
+    test_gen_t const *      actual
+    );
+
+static void assert_model_in_database
+    (
+    sqlite3 *               db,
+    test_model_t const *    model
+    );
+
+static void assert_totals_of_models
+    (
+    test_model_list_t const *   models,
+    test_model_totals_t const * totals
+    );
+
+static int before_all_tests
+    (
+    void
+    );
+
+static int before_each_test
+    (
+    void
+    );
+
+static void insert_test_models
+    (
+    int                 model_cnt,
+    test_model_list_t * models_out
+    );
+
+static void open_test_pool
+    (
+    int                 reader_cnt,
+    test_model_list_t * models_out,
+    cqlite_pool_t **    pool_out
+    );
+
+static void * pool_reader_thread
+    (
+    void * args
+    );
+
+static void remove_database_files
+    (
+    char const * path
+    );
+
+static void write_test_file
+    (
+    char const *    path,
+    void const *    data,
+    size_t          size
+    );
+
+static void writer_callback_count
+    (
+    cqlite_rcode_t  rcode,
+    sqlite_int64    row_id,
+    void *          context
+    );
+
+static void * writer_insert_thread
+    (
+    void * args
+    );
+
+
+/**
+* Tests selecting records with their strings allocated from an arena
+*/
+static void test_arena_select
+    (
+    void
+    )
+{
+int                 success;
+test_model_list_t   expected_models;
+test_model_list_t   actual_models;
+cqlite_arena_t *    arena;
+
+before_each_test();
+
+insert_test_models( TEST_MODEL_CNT, &expected_models );
+
+success = test_model_select_all_arena( g_db, &actual_models, &arena );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( test_model_lists_are_equal( &expected_models, &actual_models ) );
+
+// Clean up, the strings of the actual models are owned by the arena.
+free( actual_models.list );
+cqlite_arena_free( arena );
+test_model_list_free( &expected_models );
+}
+
+
+/**
+* Tests streaming blobs in chunks to and from buffers and files
+*/
+static void test_blob
+    (
+    void
+    )
+{
+int                     success;
+int                     i;
+int                     fd;
+int                     read_cnt;
+sqlite_int64            row_id;
+sqlite_int64            file_row_id;
+unsigned char *         expected;
+unsigned char *         actual;
+FILE *                  file;
+sqlite3_stmt *          insert_query;
+cqlite_blob_writer_t *  writer;
+cqlite_blob_reader_t *  reader;
+
+before_each_test();
+
+success = ( SQLITE_OK == sqlite3_exec( g_db, "CREATE TABLE IF NOT EXISTS test_blob ( id INTEGER PRIMARY KEY, data BLOB ); DELETE FROM test_blob;", NULL, NULL, NULL ) ) &&
+          ( SQLITE_OK == sqlite3_prepare_v2( g_db, "INSERT INTO test_blob VALUES ( NULL, ?1 );", -1, &insert_query, NULL ) );
+TEST_ASSERT_TRUE( success );
+
+expected = malloc( TEST_BLOB_SIZE );
+actual = malloc( TEST_BLOB_SIZE );
+TEST_ASSERT_NOT_NULL( expected );
+TEST_ASSERT_NOT_NULL( actual );
+
+for( i = 0; i < TEST_BLOB_SIZE; i++ )
+    {
+    expected[i] = (unsigned char)( ( i * 31 ) + ( i >> 8 ) );
+    }
+
+// Fill a zeroblob from a buffer in chunks
+success = ( CQLITE_SUCCESS == cqlite_blob_insert( g_db, insert_query, 1, TEST_BLOB_SIZE, "test_blob", "data", &writer, &row_id ) );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( CQLITE_INVALID_ROW_ID != row_id );
+TEST_ASSERT_EQUAL_INT( TEST_BLOB_SIZE, cqlite_blob_writer_size( writer ) );
+
+for( i = 0; success && ( i < TEST_BLOB_SIZE ); i += TEST_BLOB_CHUNK )
+    {
+    success = ( CQLITE_SUCCESS == cqlite_blob_writer_write( writer, &expected[i], ( ( TEST_BLOB_SIZE - i ) < TEST_BLOB_CHUNK ) ? ( TEST_BLOB_SIZE - i ) : TEST_BLOB_CHUNK ) );
+    }
+
+TEST_ASSERT_TRUE( success );
+
+// A blob cannot grow
+TEST_ASSERT_TRUE( CQLITE_ERROR == cqlite_blob_writer_write( writer, expected, 1 ) );
+TEST_ASSERT_TRUE( CQLITE_SUCCESS == cqlite_blob_writer_close( writer ) );
+
+// Read it back into a buffer in chunks
+success = ( CQLITE_SUCCESS == cqlite_blob_reader_open( g_db, "test_blob", "data", row_id, &reader ) );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( TEST_BLOB_SIZE, cqlite_blob_reader_size( reader ) );
+
+read_cnt = TEST_BLOB_CHUNK;
+
+for( i = 0; success && ( read_cnt > 0 ); i += read_cnt )
+    {
+    success = ( CQLITE_SUCCESS == cqlite_blob_reader_read( reader, &actual[i], ( ( TEST_BLOB_SIZE - i ) < TEST_BLOB_CHUNK ) ? ( TEST_BLOB_SIZE - i ) : TEST_BLOB_CHUNK, &read_cnt ) );
+    }
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( TEST_BLOB_SIZE, i );
+TEST_ASSERT_EQUAL_MEMORY( expected, actual, TEST_BLOB_SIZE );
+
+// Fill a zeroblob from a file
+write_test_file( TEST_BLOB_IN_FILE, expected, TEST_BLOB_SIZE );
+
+sqlite3_reset( insert_query );
+
+fd = open( TEST_BLOB_IN_FILE, O_RDONLY );
+success = ( fd >= 0 ) &&
+          ( CQLITE_SUCCESS == cqlite_blob_insert( g_db, insert_query, 1, TEST_BLOB_SIZE, "test_blob", "data", &writer, &file_row_id ) ) &&
+          ( CQLITE_SUCCESS == cqlite_blob_writer_write_from_fd( writer, fd, CQLITE_BLOB_CHUNK_SIZE ) ) &&
+          ( CQLITE_SUCCESS == cqlite_blob_writer_close( writer ) );
+close( fd );
+
+TEST_ASSERT_TRUE( success );
+
+// A file shorter than the blob leaves it unfilled
+sqlite3_reset( insert_query );
+
+fd = open( TEST_BLOB_IN_FILE, O_RDONLY );
+success = ( fd >= 0 ) &&
+          ( CQLITE_SUCCESS == cqlite_blob_insert( g_db, insert_query, 1, TEST_BLOB_SIZE + 1, "test_blob", "data", &writer, NULL ) );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( CQLITE_ERROR == cqlite_blob_writer_write_from_fd( writer, fd, CQLITE_BLOB_CHUNK_SIZE ) );
+TEST_ASSERT_TRUE( CQLITE_SUCCESS == cqlite_blob_writer_close( writer ) );
+close( fd );
+
+// Read it back into a file through the same reader
+fd = open( TEST_BLOB_OUT_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+success = ( fd >= 0 ) &&
+          ( CQLITE_SUCCESS == cqlite_blob_reader_reopen( reader, file_row_id ) ) &&
+          ( CQLITE_SUCCESS == cqlite_blob_reader_read_to_fd( reader, fd, CQLITE_BLOB_CHUNK_SIZE ) );
+close( fd );
+
+TEST_ASSERT_TRUE( success );
+
+memset( actual, 0, TEST_BLOB_SIZE );
+file = fopen( TEST_BLOB_OUT_FILE, "rb" );
+TEST_ASSERT_NOT_NULL( file );
+TEST_ASSERT_TRUE( TEST_BLOB_SIZE == fread( actual, 1, TEST_BLOB_SIZE, file ) );
+TEST_ASSERT_TRUE( EOF == fgetc( file ) );
+fclose( file );
+
+TEST_ASSERT_EQUAL_MEMORY( expected, actual, TEST_BLOB_SIZE );
+
+// A row inserted without a writer is still reported
+sqlite3_reset( insert_query );
+row_id = CQLITE_INVALID_ROW_ID;
+
+TEST_ASSERT_TRUE( CQLITE_ERROR == cqlite_blob_insert( g_db, insert_query, 1, 1, "test_blob", "missing", &writer, &row_id ) );
+TEST_ASSERT_NULL( writer );
+TEST_ASSERT_TRUE( CQLITE_INVALID_ROW_ID != row_id );
+
+// Clean up
+cqlite_blob_reader_close( reader );
+sqlite3_finalize( insert_query );
+free( expected );
+free( actual );
+unlink( TEST_BLOB_IN_FILE );
+unlink( TEST_BLOB_OUT_FILE );
+}
+
+
+/**
+* Tests reading records in batches through a cursor
+*/
+static void test_cursor
+    (
+    void
+    )
+{
+int                 success;
+int                 model_idx = 0;
+int                 i;
+test_model_list_t   expected_models;
+test_model_t *      batch;
+int                 batch_cnt;
+cqlite_cursor_t *   cursor;
+
+before_each_test();
+
+insert_test_models( TEST_MODEL_CNT, &expected_models );
+
+success = test_model_cursor_open( g_db, TEST_BATCH_SIZE, &cursor );
+TEST_ASSERT_TRUE( success );
+
+do
+    {
+    success = ( CQLITE_SUCCESS == cqlite_cursor_next( cursor, (void**)&batch, &batch_cnt ) );
+
+    TEST_ASSERT_TRUE( success );
+    TEST_ASSERT_TRUE( batch_cnt <= TEST_BATCH_SIZE );
+
+    for( i = 0; i < batch_cnt; i++ )
+        {
+        TEST_ASSERT_TRUE( model_idx < expected_models.cnt );
+        TEST_ASSERT_TRUE( test_models_are_equal( &expected_models.list[model_idx], &batch[i] ) );
+        model_idx++;
+        }
+    }
+while( batch_cnt > 0 );
+
+TEST_ASSERT_EQUAL_INT( expected_models.cnt, model_idx );
+
+// Clean up
+cqlite_cursor_close( cursor );
+test_model_list_free( &expected_models );
+}
+
+
+/**
+* Tests finding many records by id in a single call
+*/
+static void test_find_many
+    (
+    void
+    )
+{
+int                 i;
+int                 success;
+int                 expected_idx;
+test_model_list_t   expected_models;
+test_model_list_t   actual_models;
+sqlite3_int64 *     ids;
+unsigned char *     found_bits;
+
+before_each_test();
+
+insert_test_models( TEST_MODEL_CNT, &expected_models );
+
+// Every third id is missing and the others repeat, so that the unique
+// ids span more than one chunk with duplicates on either side.
+ids = malloc( TEST_FIND_MANY_CNT * sizeof( *ids ) );
+found_bits = malloc( CQLITE_FOUND_BITS_SIZE( TEST_FIND_MANY_CNT ) );
+TEST_ASSERT_NOT_NULL( ids );
+TEST_ASSERT_NOT_NULL( found_bits );
+
+for( i = 0; i < TEST_FIND_MANY_CNT; i++ )
+    {
+    ids[i] = ( 0 == ( i % 3 ) ) ? -1 - i : expected_models.list[( i * 7 ) % expected_models.cnt].id;
+    }
+
+success = test_model_find_many_by_ids( g_db, ids, TEST_FIND_MANY_CNT, &actual_models, found_bits );
+
+TEST_ASSERT_TRUE( success );
+
+for( i = 0; i < TEST_FIND_MANY_CNT; i++ )
+    {
+    expected_idx = ( i * 7 ) % expected_models.cnt;
+
+    TEST_ASSERT_EQUAL_INT( ( 0 != ( i % 3 ) ), CQLITE_FOUND_BIT_IS_SET( found_bits, i ) );
+    TEST_ASSERT_TRUE( ( 0 == ( i % 3 ) ) || test_models_are_equal( &expected_models.list[expected_idx], &actual_models.list[i] ) );
+    }
+
+test_model_list_free( &actual_models );
+
+// No ids should find nothing
+success = test_model_find_many_by_ids( g_db, ids, 0, &actual_models, found_bits );
+
+TEST_ASSERT_TRUE( success );
+
+// Clean up
+test_model_list_free( &actual_models );
+test_model_list_free( &expected_models );
+free( found_bits );
+free( ids );
+}
+
+
+/**
+* Tests folding records without reading them into models
+*/
+static void test_fold
+    (
+    void
+    )
+{
+int                     success;
+test_model_list_t       expected_models;
+test_model_totals_t     totals;
+sqlite3_int64           int_field_sum;
+cqlite_pool_t *         pool;
+cqlite_pool_conn_t *    writer;
+
+before_each_test();
+
+// An empty result leaves the accumulator at its initial value
+success = test_model_fold_totals( g_db, 0, &totals );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( 0 == totals.row_cnt );
+
+insert_test_models( TEST_MODEL_CNT, &expected_models );
+
+success = test_model_fold_totals( g_db, 0, &totals );
+
+TEST_ASSERT_TRUE( success );
+assert_totals_of_models( &expected_models, &totals );
+
+test_model_list_free( &expected_models );
+
+// Partitions are merged in key order
+open_test_pool( TEST_THREAD_CNT, &expected_models, &pool );
+
+success = test_model_fold_totals_parallel( pool, TEST_THREAD_CNT, 0, &totals );
+
+TEST_ASSERT_TRUE( success );
+assert_totals_of_models( &expected_models, &totals );
+
+success = test_model_fold_totals_parallel( pool, TEST_THREAD_CNT * 2, 0, &totals );
+
+TEST_ASSERT_TRUE( success );
+assert_totals_of_models( &expected_models, &totals );
+
+// The initial value is applied once, as in a sequential fold
+success = test_model_fold_totals_parallel( pool, TEST_THREAD_CNT, 0, &totals );
+TEST_ASSERT_TRUE( success );
+int_field_sum = totals.int_field_sum;
+
+success = test_model_fold_totals_parallel( pool, TEST_THREAD_CNT, 10, &totals );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( ( int_field_sum + 10 ) == totals.int_field_sum );
+TEST_ASSERT_TRUE( expected_models.cnt == totals.row_cnt );
+
+// An empty table has no bounds to split
+cqlite_pool_writer_acquire( pool, &writer );
+success = ( SQLITE_OK == sqlite3_exec( cqlite_pool_conn_db( writer ), "DELETE FROM test;", NULL, NULL, NULL ) );
+cqlite_pool_release( pool, writer );
+TEST_ASSERT_TRUE( success );
+
+success = test_model_fold_totals_parallel( pool, TEST_THREAD_CNT, 0, &totals );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( 0 == totals.row_cnt );
+
+// Clean up
+cqlite_pool_close( pool );
+test_model_list_free( &expected_models );
+remove_database_files( TEST_POOL_FILE );
+}
+
+
+/**
+* Tests the model functions generated by cqlite_gen
+*/
+static void test_generated
+    (
+    void
+    )
+{
+int                 success;
+int                 found;
+int                 i;
+int                 model_cnt;
+test_model_list_t   expected_models;
+test_model_t        expected_model;
+test_gen_t *        models;
+test_gen_t          model;
+
+before_each_test();
+
+insert_test_models( TEST_MODEL_CNT, &expected_models );
+
+// The generated decoder reads the same models as the hand-written one
+success = ( CQLITE_SUCCESS == test_gen_select_all( g_db, &models, &model_cnt ) );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( expected_models.cnt, model_cnt );
+
+for( i = 0; i < model_cnt; i++ )
+    {
+    assert_gen_model_equal( &expected_models.list[i], &models[i] );
+    }
+
+test_gen_list_free( models, model_cnt );
+
+success = ( CQLITE_SUCCESS == test_gen_find_by_id( g_db, expected_models.list[TEST_MODEL_CNT / 2].id, &found, &model ) );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( found );
+assert_gen_model_equal( &expected_models.list[TEST_MODEL_CNT / 2], &model );
+
+test_gen_free( &model );
+
+success = ( CQLITE_SUCCESS == test_gen_find_by_id( g_db, CQLITE_INVALID_ROW_ID, &found, &model ) );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_FALSE( found );
+
+// The generated binder inserts a model the hand-written decoder reads back
+memset( &model, 0, sizeof( model ) );
+model.real_field = 2.5;
+model.int_field = 42;
+model.dynamic_string_field = strdup( "Generated" );
+strcpy( model.fixed_string_field, "XYZ" );
+
+success = ( CQLITE_SUCCESS == test_gen_insert( g_db, &model ) );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( CQLITE_INVALID_ROW_ID != model.id );
+
+test_model_init( &expected_model );
+expected_model.id = model.id;
+expected_model.real_field = model.real_field;
+expected_model.int_field = model.int_field;
+expected_model.dynamic_string_field = model.dynamic_string_field;
+strcpy( expected_model.fixed_string_field, model.fixed_string_field );
+
+assert_model_in_database( g_db, &expected_model );
+
+// Clean up
+test_gen_free( &model );
+test_model_list_free( &expected_models );
+}
+
+
+/**
+* Tests importing records from CSV and binary files
+*/
+static void test_import
+    (
+    void
+    )
+{
+static char const csv[] =
+    "id,real_field,int_field,dynamic_string_field,fixed_string_field\n"
+    "1,1.5,10,\"Say \"\"hi\"\"\",ABC\r\n"
+    "2,-2.25,-20,\"a,b\",\n"
+    "\n"
+    "3,,30,plain,\"\"\n";
+
+static char const bad_csv[] =
+    "id,real_field,int_field,dynamic_string_field,fixed_string_field\n"
+    "1,1.5,10,a,A\n"
+    "2,2.5,20,b,B\n"
+    "3,oops,30,c,C\n";
+
+static char const trailing_empty_csv[] =
+    "id,real_field,int_field,dynamic_string_field,fixed_string_field\n"
+    "1,1.5,10,a,";
+
+test_model_t csv_models[] =
+    {/* id, real_field, int_field,  dynamic_string, fixed_string    */
+        { 1, 1.5,       10,         "Say \"hi\"",   "ABC" },
+        { 2, -2.25,     -20,        "a,b",          "" },
+        { 3, 0.0,       30,         "plain",        "" },
+    };
+
+int                 i;
+int                 use_parse_thread;
+int                 success;
+sqlite3_int64       row_cnt;
+test_model_list_t   expected_models;
+test_model_list_t   actual_models;
+test_record_t *     records;
+
+// Text is unescaped in the private mapping, so the file must be
+// unchanged for the second import.
+write_test_file( TEST_IMPORT_CSV, csv, sizeof( csv ) - 1 );
+
+for( use_parse_thread = 0; use_parse_thread <= 1; use_parse_thread++ )
+    {
+    before_each_test();
+
+    success = test_model_import_csv( g_db, TEST_IMPORT_CSV, 2, use_parse_thread, &row_cnt );
+    TEST_ASSERT_TRUE( success );
+    TEST_ASSERT_EQUAL_INT( 3, row_cnt );
+
+    success = test_model_select_all( g_db, SELECT_MODE_SINGLE_PASS, &actual_models );
+    TEST_ASSERT_TRUE( success );
+    TEST_ASSERT_EQUAL_INT( 3, actual_models.cnt );
+
+    for( i = 0; i < actual_models.cnt; i++ )
+        {
+        TEST_ASSERT_TRUE( test_models_are_equal( &csv_models[i], &actual_models.list[i] ) );
+        }
+
+    test_model_list_free( &actual_models );
+    }
+
+// An empty last field may end the file without a newline
+write_test_file( TEST_IMPORT_CSV, trailing_empty_csv, sizeof( trailing_empty_csv ) - 1 );
+
+for( use_parse_thread = 0; use_parse_thread <= 1; use_parse_thread++ )
+    {
+    before_each_test();
+
+    success = test_model_import_csv( g_db, TEST_IMPORT_CSV, 2, use_parse_thread, &row_cnt );
+    TEST_ASSERT_TRUE( success );
+    TEST_ASSERT_EQUAL_INT( 1, row_cnt );
+
+    success = test_model_select_all( g_db, SELECT_MODE_SINGLE_PASS, &actual_models );
+    TEST_ASSERT_TRUE( success );
+    TEST_ASSERT_EQUAL_INT( 1, actual_models.cnt );
+    TEST_ASSERT_EQUAL_INT( 1, actual_models.list[0].id );
+    TEST_ASSERT_EQUAL_STRING( "a", actual_models.list[0].dynamic_string_field );
+    TEST_ASSERT_EQUAL_STRING( "", actual_models.list[0].fixed_string_field );
+
+    test_model_list_free( &actual_models );
+    }
+
+// Batches committed before a malformed line are kept
+write_test_file( TEST_IMPORT_CSV, bad_csv, sizeof( bad_csv ) - 1 );
+
+for( use_parse_thread = 0; use_parse_thread <= 1; use_parse_thread++ )
+    {
+    before_each_test();
+
+    success = test_model_import_csv( g_db, TEST_IMPORT_CSV, 1, use_parse_thread, &row_cnt );
+    TEST_ASSERT_FALSE( success );
+    TEST_ASSERT_EQUAL_INT( 2, row_cnt );
+
+    success = test_model_select_all( g_db, SELECT_MODE_SINGLE_PASS, &actual_models );
+    TEST_ASSERT_TRUE( success );
+    TEST_ASSERT_EQUAL_INT( 2, actual_models.cnt );
+
+    test_model_list_free( &actual_models );
+    }
+
+// Inside the caller's transaction, the failed batch is rolled back
+// without ending the transaction
+for( use_parse_thread = 0; use_parse_thread <= 1; use_parse_thread++ )
+    {
+    before_each_test();
+
+    success = ( SQLITE_OK == sqlite3_exec( g_db, "BEGIN;", NULL, NULL, NULL ) );
+    TEST_ASSERT_TRUE( success );
+
+    success = test_model_import_csv( g_db, TEST_IMPORT_CSV, 0, use_parse_thread, &row_cnt );
+    TEST_ASSERT_FALSE( success );
+    TEST_ASSERT_EQUAL_INT( 0, row_cnt );
+    TEST_ASSERT_FALSE( sqlite3_get_autocommit( g_db ) );
+
+    success = test_model_select_all( g_db, SELECT_MODE_SINGLE_PASS, &actual_models );
+    TEST_ASSERT_TRUE( success );
+    TEST_ASSERT_EQUAL_INT( 0, actual_models.cnt );
+    test_model_list_free( &actual_models );
+
+    success = test_model_import_csv( g_db, TEST_IMPORT_CSV, 1, use_parse_thread, &row_cnt );
+    TEST_ASSERT_FALSE( success );
+    TEST_ASSERT_EQUAL_INT( 2, row_cnt );
+
+    success = ( SQLITE_OK == sqlite3_exec( g_db, "COMMIT;", NULL, NULL, NULL ) );
+    TEST_ASSERT_TRUE( success );
+
+    success = test_model_select_all( g_db, SELECT_MODE_SINGLE_PASS, &actual_models );
+    TEST_ASSERT_TRUE( success );
+    TEST_ASSERT_EQUAL_INT( 2, actual_models.cnt );
+
+    test_model_list_free( &actual_models );
+    }
+
+// Import enough binary records to cycle through the parse thread's chunks
+records = calloc( TEST_IMPORT_CNT, sizeof( test_record_t ) );
+TEST_ASSERT_NOT_NULL( records );
+
+test_model_list_init( &expected_models );
+expected_models.list = calloc( TEST_IMPORT_CNT, sizeof( test_model_t ) );
+TEST_ASSERT_NOT_NULL( expected_models.list );
+expected_models.cnt = TEST_IMPORT_CNT;
+
+for( i = 0; i < TEST_IMPORT_CNT; i++ )
+    {
+    records[i].id = i + 1;
+    records[i].real_field = i * 0.5;
+    records[i].int_field = -i;
+    snprintf( records[i].dynamic_string_field, sizeof( records[i].dynamic_string_field ), "Record %d", i );
+    strcpy( records[i].fixed_string_field, "REC" );
+
+    expected_models.list[i].id = records[i].id;
+    expected_models.list[i].real_field = records[i].real_field;
+    expected_models.list[i].int_field = records[i].int_field;
+    expected_models.list[i].dynamic_string_field = strdup( records[i].dynamic_string_field );
+    strcpy( expected_models.list[i].fixed_string_field, "REC" );
+    }
+
+write_test_file( TEST_IMPORT_BINARY, records, TEST_IMPORT_CNT * sizeof( test_record_t ) );
+
+for( use_parse_thread = 0; use_parse_thread <= 1; use_parse_thread++ )
+    {
+    before_each_test();
+
+    success = test_model_import_binary( g_db, TEST_IMPORT_BINARY, TEST_IMPORT_BATCH, use_parse_thread, &row_cnt );
+    TEST_ASSERT_TRUE( success );
+    TEST_ASSERT_EQUAL_INT( TEST_IMPORT_CNT, row_cnt );
+
+    success = test_model_select_all( g_db, SELECT_MODE_SINGLE_PASS, &actual_models );
+    TEST_ASSERT_TRUE( success );
+    TEST_ASSERT_TRUE( test_model_lists_are_equal( &expected_models, &actual_models ) );
+
+    test_model_list_free( &actual_models );
+    }
+
+// A partial record rolls back its whole batch
+write_test_file( TEST_IMPORT_BINARY, records, sizeof( test_record_t ) + ( sizeof( test_record_t ) / 2 ) );
+
+before_each_test();
+
+success = test_model_import_binary( g_db, TEST_IMPORT_BINARY, TEST_IMPORT_BATCH, 1, &row_cnt );
+TEST_ASSERT_FALSE( success );
+TEST_ASSERT_EQUAL_INT( 0, row_cnt );
+
+success = test_model_select_all( g_db, SELECT_MODE_SINGLE_PASS, &actual_models );
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( 0, actual_models.cnt );
+
+// Clean up
+test_model_list_free( &actual_models );
+test_model_list_free( &expected_models );
+free( records );
+unlink( TEST_IMPORT_CSV );
+unlink( TEST_IMPORT_BINARY );
+}
+
+
+/**
+* Tests inserting many new records into the database in batches
+*/
+static void test_insert_many
+    (
+    void
+    )
+{
+int                 i;
+int                 success;
+test_model_list_t   expected_models;
+test_model_list_t   actual_models;
+char                dynamic_string[32];
+char                trigger_str[160];
+
+before_each_test();
+
+test_model_list_init( &expected_models );
+
+expected_models.list = calloc( TEST_MODEL_CNT, sizeof( test_model_t ) );
+TEST_ASSERT_NOT_NULL( expected_models.list );
+expected_models.cnt = TEST_MODEL_CNT;
+
+for( i = 0; i < expected_models.cnt; i++ )
+    {
+    snprintf( dynamic_string, sizeof( dynamic_string ), "Model %d", i );
+
+    expected_models.list[i].id = CQLITE_INVALID_ROW_ID;
+    expected_models.list[i].int_field = i;
+    expected_models.list[i].dynamic_string_field = strdup( dynamic_string );
+    strcpy( expected_models.list[i].fixed_string_field, "XYZ" );
+    }
+
+// Use a batch size that does not evenly divide the number of models
+success = test_model_insert_many( g_db, &expected_models, TEST_BATCH_SIZE );
+TEST_ASSERT_TRUE( success );
+
+for( i = 0; i < expected_models.cnt; i++ )
+    {
+    TEST_ASSERT( CQLITE_INVALID_ROW_ID != expected_models.list[i].id );
+    }
+
+success = test_model_select_all( g_db, SELECT_MODE_SINGLE_PASS, &actual_models );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( test_model_lists_are_equal( &expected_models, &actual_models ) );
+
+test_model_list_free( &actual_models );
+
+// Inside the caller's transaction, only the failed batch is rolled back
+snprintf( trigger_str, sizeof( trigger_str ), "CREATE TRIGGER fail_insert BEFORE INSERT ON test WHEN NEW.int_field = %d BEGIN SELECT RAISE(ABORT, 'fail'); END;", TEST_BATCH_SIZE + 2 );
+
+success = test_database_delete_all_data( g_db ) &&
+          ( SQLITE_OK == sqlite3_exec( g_db, trigger_str, NULL, NULL, NULL ) ) &&
+          ( SQLITE_OK == sqlite3_exec( g_db, "BEGIN;", NULL, NULL, NULL ) );
+TEST_ASSERT_TRUE( success );
+
+success = test_model_insert_many( g_db, &expected_models, TEST_BATCH_SIZE );
+TEST_ASSERT_FALSE( success );
+
+success = ( SQLITE_OK == sqlite3_exec( g_db, "COMMIT;", NULL, NULL, NULL ) ) &&
+          test_model_select_all( g_db, SELECT_MODE_SINGLE_PASS, &actual_models );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( TEST_BATCH_SIZE, actual_models.cnt );
+
+// Clean up
+sqlite3_exec( g_db, "DROP TRIGGER fail_insert;", NULL, NULL, NULL );
+test_model_list_free( &expected_models );
+test_model_list_free( &actual_models );
+}
+
+
+/**
+* Tests inserting records bound with parameter descriptors
+*/
+static void test_insert_mapped
+    (
+    void
+    )
+{
+int                 i;
+int                 success;
+test_model_list_t   expected_models;
+test_model_list_t   actual_models;
+char                dynamic_string[32];
+test_model_t        new_model;
+
+before_each_test();
+
+test_model_list_init( &expected_models );
+
+expected_models.list = calloc( TEST_MODEL_CNT, sizeof( test_model_t ) );
+TEST_ASSERT_NOT_NULL( expected_models.list );
+expected_models.cnt = TEST_MODEL_CNT;
+
+for( i = 0; i < expected_models.cnt; i++ )
+    {
+    snprintf( dynamic_string, sizeof( dynamic_string ), "Model %d", i );
+
+    expected_models.list[i].id = CQLITE_INVALID_ROW_ID;
+    expected_models.list[i].real_field = i * 0.5;
+    expected_models.list[i].int_field = i;
+    strcpy( expected_models.list[i].fixed_string_field, "XYZ" );
+
+    // Some strings are NULL
+    if( TEST_NULL_MODEL_IDX != i )
+        {
+        expected_models.list[i].dynamic_string_field = strdup( dynamic_string );
+        }
+    }
+
+success = test_model_insert_many_mapped( g_db, &expected_models, TEST_BATCH_SIZE );
+TEST_ASSERT_TRUE( success );
+
+success = test_model_select_all( g_db, SELECT_MODE_SINGLE_PASS, &actual_models );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( test_model_lists_are_equal( &expected_models, &actual_models ) );
+
+test_model_list_free( &actual_models );
+
+// Strings bound in place are read back intact
+test_model_init( &new_model );
+new_model.real_field = 1.0;
+new_model.int_field = 1;
+new_model.dynamic_string_field = strdup( "Hello" );
+strcpy( new_model.fixed_string_field, "ABC" );
+
+success = test_model_insert_new_mapped( g_db, &new_model );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( CQLITE_INVALID_ROW_ID != new_model.id );
+assert_model_in_database( g_db, &new_model );
+
+// Clean up
+test_model_free( &new_model );
+test_model_list_free( &expected_models );
+}
+
+
+/**
+* Tests inserting a new record into the database
+*/
+static void test_insert_new
+    (
+    void
+    )
+{
+test_model_t new_model = 
+    {/* id,                     real_field,     int_field,  dynamic_string, fixed_string    */
+        CQLITE_INVALID_ROW_ID,  1.0,            1,          "Hello",        "ABC" 
+    };
+
+int success;
+
+before_each_test();
+
+// Attempt to insert a new model into the database.
+success = test_model_insert_new( g_db, &new_model );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT( CQLITE_INVALID_ROW_ID != new_model.id );
+
+// Ensure the model was actually saved to the database
+assert_model_in_database( g_db, &new_model );
+}
+
+
+/**
+* Tests opening a database with a profile and checkpointing it in the
+* background
+*/
+static void test_open
+    (
+    void
+    )
+{
+cqlite_checkpoint_config_t config =
+    {/* poll_interval_ms,   idle_ms,        wal_size_limit  */
+        TEST_POLL_MS,       TEST_IDLE_MS,   0
+    };
+
+int                     i;
+int                     success;
+int                     value;
+sqlite3 *               db;
+cqlite_checkpointer_t * checkpointer;
+test_model_t            model;
+test_model_list_t       actual_models;
+struct stat             wal_stat;
+
+remove_database_files( TEST_PROFILE_FILE );
+
+// An in-memory database cannot be put in WAL mode
+success = ( CQLITE_SUCCESS == cqlite_open( ":memory:", CQLITE_PROFILE_READ_HEAVY, &db ) );
+TEST_ASSERT_FALSE( success );
+TEST_ASSERT_NULL( db );
+
+success = ( CQLITE_SUCCESS == cqlite_open( TEST_PROFILE_FILE, CQLITE_PROFILE_WRITE_HEAVY, &db ) );
+TEST_ASSERT_TRUE( success );
+
+success = ( CQLITE_SUCCESS == cqlite_count_query_execute( db, "PRAGMA wal_autocheckpoint;", &value ) );
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( 0, value );
+
+success = test_database_init( db );
+TEST_ASSERT_TRUE( success );
+
+// Without automatic checkpoints, commits pile up in the WAL
+for( i = 0; i < TEST_MODEL_CNT; i++ )
+    {
+    test_model_init( &model );
+    model.id = CQLITE_INVALID_ROW_ID;
+    model.int_field = i;
+    strcpy( model.fixed_string_field, "ABC" );
+
+    success = test_model_insert_new( db, &model );
+    TEST_ASSERT_TRUE( success );
+    }
+
+TEST_ASSERT_EQUAL_INT( 0, stat( TEST_PROFILE_WAL, &wal_stat ) );
+TEST_ASSERT_TRUE( wal_stat.st_size > 0 );
+
+// The checkpointer truncates the WAL once the database goes idle
+success = ( CQLITE_SUCCESS == cqlite_checkpointer_open( TEST_PROFILE_FILE, &config, &checkpointer ) );
+TEST_ASSERT_TRUE( success );
+
+for( i = 0; ( i < TEST_WAIT_MS ) && ( 0 == stat( TEST_PROFILE_WAL, &wal_stat ) ) && ( wal_stat.st_size > 0 ); i += TEST_POLL_MS )
+    {
+    usleep( TEST_POLL_MS * 1000 );
+    }
+
+TEST_ASSERT_EQUAL_INT( 0, wal_stat.st_size );
+
+cqlite_checkpointer_close( checkpointer );
+
+success = test_model_select_all( db, SELECT_MODE_COUNTED, &actual_models );
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( TEST_MODEL_CNT, actual_models.cnt );
+
+// Clean up
+test_model_list_free( &actual_models );
+sqlite3_close( db );
+remove_database_files( TEST_PROFILE_FILE );
+}
+
+
+/**
+* Tests reading records in pages resumed from continuation tokens
+*/
+static void test_page
+    (
+    void
+    )
+{
+int                     success;
+int                     is_descending;
+int                     page_size;
+int                     model_idx;
+int                     page_cnt;
+int                     i;
+test_model_list_t       expected_models;
+test_model_list_t       page_models;
+cqlite_page_t *         page;
+cqlite_page_token_t *   token;
+cqlite_page_token_t *   next_token;
+
+before_each_test();
+
+insert_test_models( TEST_MODEL_CNT, &expected_models );
+
+// Ascending pages that do not evenly divide the models end with a
+// partial page, descending pages that do end with an empty page.
+for( is_descending = 0; is_descending <= 1; is_descending++ )
+    {
+    page_size = is_descending ? 10 : TEST_BATCH_SIZE;
+
+    success = test_model_page_create( g_db, page_size, is_descending, &page );
+    TEST_ASSERT_TRUE( success );
+
+    model_idx = 0;
+    page_cnt = 0;
+    token = NULL;
+
+    do
+        {
+        success = test_model_page_read( page, token, &page_models, &next_token );
+        TEST_ASSERT_TRUE( success );
+        TEST_ASSERT_TRUE( page_models.cnt <= page_size );
+        TEST_ASSERT_EQUAL_INT( ( page_models.cnt == page_size ), ( NULL != next_token ) );
+
+        for( i = 0; i < page_models.cnt; i++ )
+            {
+            TEST_ASSERT_TRUE( model_idx < expected_models.cnt );
+            TEST_ASSERT_TRUE( test_models_are_equal( &expected_models.list[is_descending ? ( expected_models.cnt - 1 - model_idx ) : model_idx], &page_models.list[i] ) );
+            model_idx++;
+            }
+
+        test_model_list_free( &page_models );
+        cqlite_page_token_free( token );
+        token = next_token;
+        page_cnt++;
+        }
+    while( NULL != token );
+
+    TEST_ASSERT_EQUAL_INT( expected_models.cnt, model_idx );
+    TEST_ASSERT_EQUAL_INT( ( expected_models.cnt / page_size ) + 1, page_cnt );
+
+    cqlite_page_free( page );
+    }
+
+// Clean up
+test_model_list_free( &expected_models );
+}
+
+
+/**
+* Tests selecting all records in parallel on a connection pool
+*/
+static void test_parallel_select
+    (
+    void
+    )
+{
+int                     success;
+test_model_list_t       expected_models;
+test_model_list_t       actual_models;
+cqlite_pool_t *         pool;
+cqlite_pool_conn_t *    reader;
+cqlite_pool_conn_t *    writer;
+
+open_test_pool( TEST_THREAD_CNT, &expected_models, &pool );
+
+success = test_model_select_all_parallel( pool, SELECT_MODE_COUNTED, TEST_THREAD_CNT, &actual_models );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( test_model_lists_are_equal( &expected_models, &actual_models ) );
+test_model_list_free( &actual_models );
+
+success = test_model_select_all_parallel( pool, SELECT_MODE_SINGLE_PASS, TEST_THREAD_CNT, &actual_models );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( test_model_lists_are_equal( &expected_models, &actual_models ) );
+test_model_list_free( &actual_models );
+
+// More partitions than read connections are limited to the connections
+success = test_model_select_all_parallel( pool, SELECT_MODE_COUNTED, TEST_THREAD_CNT * 2, &actual_models );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( test_model_lists_are_equal( &expected_models, &actual_models ) );
+test_model_list_free( &actual_models );
+
+// Read connections held elsewhere are left out of the partitions
+cqlite_pool_reader_acquire( pool, &reader );
+
+success = test_model_select_all_parallel( pool, SELECT_MODE_COUNTED, TEST_THREAD_CNT, &actual_models );
+
+cqlite_pool_release( pool, reader );
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( test_model_lists_are_equal( &expected_models, &actual_models ) );
+test_model_list_free( &actual_models );
+
+// An empty table has no bounds to split
+cqlite_pool_writer_acquire( pool, &writer );
+success = ( SQLITE_OK == sqlite3_exec( cqlite_pool_conn_db( writer ), "DELETE FROM test;", NULL, NULL, NULL ) );
+cqlite_pool_release( pool, writer );
+TEST_ASSERT_TRUE( success );
+
+success = test_model_select_all_parallel( pool, SELECT_MODE_COUNTED, TEST_THREAD_CNT, &actual_models );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( 0, actual_models.cnt );
+test_model_list_free( &actual_models );
+
+// Clean up
+cqlite_pool_close( pool );
+test_model_list_free( &expected_models );
+remove_database_files( TEST_POOL_FILE );
+}
+
+
+/**
+* Tests processing models decoded on a producer thread
+*/
+static void test_pipeline
+    (
+    void
+    )
+{
+int                     success;
+test_model_list_t       expected_models;
+test_model_totals_t     totals;
+
+before_each_test();
+
+// An empty result processes nothing
+success = test_model_pipeline_totals( g_db, CQLITE_PIPELINE_SLOT_CNT, 0, &totals );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( 0 == totals.row_cnt );
+
+insert_test_models( TEST_MODEL_CNT, &expected_models );
+
+success = test_model_pipeline_totals( g_db, CQLITE_PIPELINE_SLOT_CNT, 0, &totals );
+
+TEST_ASSERT_TRUE( success );
+assert_totals_of_models( &expected_models, &totals );
+
+// A single slot makes the producer wait on every row
+success = test_model_pipeline_totals( g_db, 1, 0, &totals );
+
+TEST_ASSERT_TRUE( success );
+assert_totals_of_models( &expected_models, &totals );
+
+// Failing to process stops the producer, models decoded ahead are freed
+success = test_model_pipeline_totals( g_db, 4, TEST_MODEL_CNT / 2, &totals );
+
+TEST_ASSERT_FALSE( success );
+TEST_ASSERT_TRUE( ( TEST_MODEL_CNT / 2 ) == totals.row_cnt );
+
+// The ring needs a slot
+success = test_model_pipeline_totals( g_db, 0, 0, &totals );
+
+TEST_ASSERT_FALSE( success );
+TEST_ASSERT_TRUE( 0 == totals.row_cnt );
+
+// Clean up
+test_model_list_free( &expected_models );
+}
+
+
+/**
+* Tests reading records concurrently through a connection pool
+*/
+static void test_pool
+    (
+    void
+    )
+{
+int                     i;
+int                     success;
+int                     count;
+test_model_list_t       expected_models;
+cqlite_pool_t *         pool;
+pool_reader_args_t      reader_args[TEST_THREAD_CNT];
+pthread_t               reader_threads[TEST_THREAD_CNT];
+
+// An in-memory database cannot be put in WAL mode
+success = ( CQLITE_SUCCESS == cqlite_pool_open( ":memory:", 1, TEST_CACHE_CAPACITY, &pool ) );
+TEST_ASSERT_FALSE( success );
+TEST_ASSERT_NULL( pool );
+
+// Use fewer connections than threads so that threads have to wait
+open_test_pool( TEST_THREAD_CNT / 2, &expected_models, &pool );
+
+for( i = 0; i < TEST_THREAD_CNT; i++ )
+    {
+    reader_args[i].pool = pool;
+    reader_args[i].expected_models = &expected_models;
+    reader_args[i].success = 0;
+
+    TEST_ASSERT_EQUAL_INT( 0, pthread_create( &reader_threads[i], NULL, pool_reader_thread, &reader_args[i] ) );
+    }
+
+for( i = 0; i < TEST_THREAD_CNT; i++ )
+    {
+    pthread_join( reader_threads[i], NULL );
+    TEST_ASSERT_TRUE( reader_args[i].success );
+    }
+
+success = ( CQLITE_SUCCESS == cqlite_pool_count_query_execute( pool, "SELECT COUNT(*) FROM test;", &count ) );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( expected_models.cnt, count );
+
+// Clean up
+cqlite_pool_close( pool );
+test_model_list_free( &expected_models );
+remove_database_files( TEST_POOL_FILE );
+}
+
+
+/**
+* Tests caching query results until their tables are written
+*/
+static void test_result_cache
+    (
+    void
+    )
+{
+int                             success;
+int                             count;
+test_model_list_t               expected_models;
+test_model_list_t               actual_models;
+test_model_t                    new_model;
+cqlite_result_cache_t *         cache;
+cqlite_cached_result_t *        result;
+cqlite_cached_result_t *        cached_result;
+cqlite_result_cache_stats_t     stats;
+sqlite3 *                       other_db;
+
+before_each_test();
+
+insert_test_models( TEST_MODEL_CNT, &expected_models );
+
+success = ( CQLITE_SUCCESS == cqlite_result_cache_create( g_db, TEST_CACHE_CAPACITY, &cache ) );
+TEST_ASSERT_TRUE( success );
+
+// Repeating a query shares the first result
+success = test_model_select_all_cached( cache, &result );
+TEST_ASSERT_TRUE( success );
+
+actual_models.list = (test_model_t*)cqlite_cached_result_models( result, &actual_models.cnt );
+TEST_ASSERT_TRUE( test_model_lists_are_equal( &expected_models, &actual_models ) );
+
+success = test_model_select_all_cached( cache, &cached_result );
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( result == cached_result );
+
+cqlite_cached_result_release( cached_result );
+
+success = test_model_count_cached( cache, &count ) && test_model_count_cached( cache, &count );
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( TEST_MODEL_CNT, count );
+
+// Queries with different parameters are cached separately
+success = test_model_select_range_cached( cache, expected_models.list[10].id, expected_models.list[19].id, &cached_result );
+TEST_ASSERT_TRUE( success );
+cqlite_cached_result_models( cached_result, &count );
+TEST_ASSERT_EQUAL_INT( 10, count );
+cqlite_cached_result_release( cached_result );
+
+success = test_model_select_range_cached( cache, expected_models.list[10].id, expected_models.list[19].id, &cached_result );
+TEST_ASSERT_TRUE( success );
+cqlite_cached_result_release( cached_result );
+
+success = test_model_select_range_cached( cache, expected_models.list[10].id, expected_models.list[14].id, &cached_result );
+TEST_ASSERT_TRUE( success );
+cqlite_cached_result_models( cached_result, &count );
+TEST_ASSERT_EQUAL_INT( 5, count );
+cqlite_cached_result_release( cached_result );
+
+cqlite_result_cache_stats_get( cache, &stats );
+TEST_ASSERT_EQUAL_INT( 3, stats.hits );
+TEST_ASSERT_EQUAL_INT( 4, stats.misses );
+TEST_ASSERT_EQUAL_INT( 0, stats.invalidations );
+
+// Writing the table drops its results, but references stay valid
+test_model_init( &new_model );
+new_model.id = CQLITE_INVALID_ROW_ID;
+strcpy( new_model.fixed_string_field, "NEW" );
+
+success = test_model_insert_new( g_db, &new_model );
+TEST_ASSERT_TRUE( success );
+
+success = test_model_select_all_cached( cache, &cached_result );
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( result != cached_result );
+cqlite_cached_result_models( cached_result, &count );
+TEST_ASSERT_EQUAL_INT( TEST_MODEL_CNT + 1, count );
+cqlite_cached_result_release( cached_result );
+
+actual_models.list = (test_model_t*)cqlite_cached_result_models( result, &actual_models.cnt );
+TEST_ASSERT_TRUE( test_model_lists_are_equal( &expected_models, &actual_models ) );
+cqlite_cached_result_release( result );
+
+cqlite_result_cache_stats_get( cache, &stats );
+TEST_ASSERT_EQUAL_INT( 4, stats.invalidations );
+
+// Deleting every row is seen even though DELETE could truncate the table
+success = test_model_count_cached( cache, &count );
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( TEST_MODEL_CNT + 1, count );
+
+success = test_database_delete_all_data( g_db ) && test_model_count_cached( cache, &count );
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( 0, count );
+
+// Commits by other connections are seen on the next lookup
+success = ( SQLITE_OK == sqlite3_open( TEST_DATABASE_FILE, &other_db ) ) &&
+          test_model_insert_new( other_db, &new_model ) &&
+          test_model_count_cached( cache, &count );
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( 1, count );
+
+// Writes to WITHOUT ROWID tables never reach the update hook
+success = ( SQLITE_OK == sqlite3_exec( g_db, "CREATE TABLE keyed (key TEXT PRIMARY KEY) WITHOUT ROWID; INSERT INTO keyed VALUES ('a');", NULL, NULL, NULL ) ) &&
+          ( CQLITE_SUCCESS == cqlite_result_cache_count_query_execute( cache, "SELECT COUNT(*) FROM keyed;", &count ) ) &&
+          ( CQLITE_SUCCESS == cqlite_result_cache_count_query_execute( cache, "SELECT COUNT(*) FROM keyed;", &count ) );
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( 1, count );
+
+success = ( SQLITE_OK == sqlite3_exec( g_db, "INSERT INTO keyed VALUES ('b');", NULL, NULL, NULL ) ) &&
+          ( CQLITE_SUCCESS == cqlite_result_cache_count_query_execute( cache, "SELECT COUNT(*) FROM keyed;", &count ) );
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( 2, count );
+
+// Doubles that only differ past their 15th digit are cached separately
+new_model.real_field = 1.0;
+success = test_model_insert_new( g_db, &new_model );
+TEST_ASSERT_TRUE( success );
+new_model.real_field = 1.0 + DBL_EPSILON;
+success = test_model_insert_new( g_db, &new_model );
+TEST_ASSERT_TRUE( success );
+
+success = test_model_select_by_real_cached( cache, 1.0, &result ) &&
+          test_model_select_by_real_cached( cache, 1.0 + DBL_EPSILON, &cached_result );
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( result != cached_result );
+
+actual_models.list = (test_model_t*)cqlite_cached_result_models( result, &actual_models.cnt );
+TEST_ASSERT_EQUAL_INT( 1, actual_models.cnt );
+TEST_ASSERT_TRUE( 1.0 == actual_models.list[0].real_field );
+
+actual_models.list = (test_model_t*)cqlite_cached_result_models( cached_result, &actual_models.cnt );
+TEST_ASSERT_EQUAL_INT( 1, actual_models.cnt );
+TEST_ASSERT_TRUE( ( 1.0 + DBL_EPSILON ) == actual_models.list[0].real_field );
+
+cqlite_cached_result_release( result );
+cqlite_cached_result_release( cached_result );
+
+// Clean up
+sqlite3_close( other_db );
+cqlite_result_cache_free( cache );
+test_model_list_free( &expected_models );
+}
+
+
+/**
+* Tests selecting all records into aligned per-column arrays
+*/
+static void test_select_columnar
+    (
+    void
+    )
+{
+int                                 success;
+int                                 i;
+int                                 is_null;
+select_mode_t                       select_mode;
+test_model_list_t                   expected_models;
+cqlite_columnar_result_t            result;
+cqlite_columnar_column_t const *    columns;
+char                                null_query_str[128];
+
+before_each_test();
+
+// An empty result should still be safe to free
+success = test_model_select_all_columnar( g_db, SELECT_MODE_SINGLE_PASS, &result );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( 0, result.row_cnt );
+cqlite_columnar_result_free( &result );
+
+// Enough results to require growing the arrays, one with a NULL string
+insert_test_models( TEST_MODEL_CNT, &expected_models );
+
+snprintf( null_query_str, sizeof( null_query_str ), "UPDATE test SET dynamic_string_field = NULL WHERE id = %lld;", (long long)expected_models.list[TEST_NULL_MODEL_IDX].id );
+success = ( SQLITE_OK == sqlite3_exec( g_db, null_query_str, NULL, NULL, NULL ) );
+TEST_ASSERT_TRUE( success );
+
+for( select_mode = SELECT_MODE_COUNTED; select_mode <= SELECT_MODE_SINGLE_PASS; select_mode++ )
+    {
+    success = test_model_select_all_columnar( g_db, select_mode, &result );
+
+    TEST_ASSERT_TRUE( success );
+    TEST_ASSERT_EQUAL_INT( expected_models.cnt, result.row_cnt );
+
+    columns = result.columns;
+
+    TEST_ASSERT_EQUAL_INT( 0, (uintptr_t)columns[0].int64_values % CQLITE_COLUMNAR_ALIGNMENT );
+    TEST_ASSERT_EQUAL_INT( 0, (uintptr_t)columns[1].double_values % CQLITE_COLUMNAR_ALIGNMENT );
+    TEST_ASSERT_EQUAL_INT( 0, (uintptr_t)columns[3].text_offsets % CQLITE_COLUMNAR_ALIGNMENT );
+    TEST_ASSERT_EQUAL_INT( 0, (uintptr_t)columns[3].text_data % CQLITE_COLUMNAR_ALIGNMENT );
+
+    // Only the column containing the NULL should have NULL bits
+    TEST_ASSERT_NULL( columns[0].null_bits );
+    TEST_ASSERT_NOT_NULL( columns[3].null_bits );
+
+    for( i = 0; i < result.row_cnt; i++ )
+        {
+        is_null = ( 0 != ( columns[3].null_bits[i / 64] & ( (sqlite_uint64)1 << ( i % 64 ) ) ) );
+
+        TEST_ASSERT_TRUE( expected_models.list[i].id == columns[0].int64_values[i] );
+        TEST_ASSERT_TRUE( expected_models.list[i].real_field == columns[1].double_values[i] );
+        TEST_ASSERT_TRUE( expected_models.list[i].int_field == columns[2].int64_values[i] );
+        TEST_ASSERT_EQUAL_STRING( expected_models.list[i].fixed_string_field, cqlite_columnar_text_get( &columns[4], i ) );
+        TEST_ASSERT_EQUAL_INT( ( TEST_NULL_MODEL_IDX == i ), is_null );
+        TEST_ASSERT_EQUAL_STRING( is_null ? "" : expected_models.list[i].dynamic_string_field, cqlite_columnar_text_get( &columns[3], i ) );
+        }
+
+    cqlite_columnar_result_free( &result );
+    }
+
+// Clean up
+test_model_list_free( &expected_models );
+}
+
+
+/**
+* Tests selecting all records using a COUNT query to size the results
+*/
+static void test_select_counted
+    (
+    void
+    )
+{
+int                 success;
+test_model_list_t   expected_models;
+test_model_list_t   actual_models;
+
+before_each_test();
+
+insert_test_models( TEST_MODEL_CNT, &expected_models );
+
+success = test_model_select_all( g_db, SELECT_MODE_COUNTED, &actual_models );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( test_model_lists_are_equal( &expected_models, &actual_models ) );
+
+// Clean up
+test_model_list_free( &expected_models );
+test_model_list_free( &actual_models );
+}
+
+
+/**
+* Tests selecting all records using column descriptors
+*/
+static void test_select_mapped
+    (
+    void
+    )
+{
+int                 success;
+test_model_list_t   expected_models;
+test_model_list_t   actual_models;
+
+before_each_test();
+
+insert_test_models( TEST_MODEL_CNT, &expected_models );
+
+success = test_model_select_all_mapped( g_db, &actual_models );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( test_model_lists_are_equal( &expected_models, &actual_models ) );
+
+// Clean up
+test_model_list_free( &expected_models );
+test_model_list_free( &actual_models );
+}
+
+
+/**
+* Tests selecting all records into a segmented list
+*/
+static void test_select_segmented
+    (
+    void
+    )
+{
+int                             success;
+int                             i;
+sqlite_int64                    count;
+test_model_list_t               expected_models;
+cqlite_segmented_list_t *       list;
+cqlite_segmented_list_iter_t    iter;
+test_model_t *                  model;
+
+before_each_test();
+
+// An empty result has no models to visit
+success = test_model_select_all_segmented( g_db, &list );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( 0 == cqlite_segmented_list_cnt( list ) );
+TEST_ASSERT_NULL( cqlite_segmented_list_at( list, 0 ) );
+
+cqlite_segmented_list_iter_init( list, &iter );
+TEST_ASSERT_NULL( cqlite_segmented_list_iter_next( &iter ) );
+
+test_model_segmented_list_free( list );
+
+// Enough results to span several segments
+success = ( SQLITE_OK == sqlite3_exec( g_db, "BEGIN;", NULL, NULL, NULL ) );
+TEST_ASSERT_TRUE( success );
+
+insert_test_models( TEST_SEGMENTED_CNT, &expected_models );
+
+success = ( SQLITE_OK == sqlite3_exec( g_db, "COMMIT;", NULL, NULL, NULL ) );
+TEST_ASSERT_TRUE( success );
+
+success = ( CQLITE_SUCCESS == cqlite_count_query_execute_int64( g_db, "SELECT COUNT(*) FROM test;", &count ) );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( TEST_SEGMENTED_CNT == count );
+
+success = test_model_select_all_segmented( g_db, &list );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( TEST_SEGMENTED_CNT == cqlite_segmented_list_cnt( list ) );
+
+cqlite_segmented_list_iter_init( list, &iter );
+
+for( i = 0; i < expected_models.cnt; i++ )
+    {
+    model = cqlite_segmented_list_iter_next( &iter );
+
+    TEST_ASSERT_TRUE( model == cqlite_segmented_list_at( list, i ) );
+    TEST_ASSERT_TRUE( test_models_are_equal( &expected_models.list[i], model ) );
+    }
+
+TEST_ASSERT_NULL( cqlite_segmented_list_iter_next( &iter ) );
+TEST_ASSERT_NULL( cqlite_segmented_list_at( list, -1 ) );
+TEST_ASSERT_NULL( cqlite_segmented_list_at( list, TEST_SEGMENTED_CNT ) );
+
+// Clean up
+test_model_list_free( &expected_models );
+test_model_segmented_list_free( list );
+}
+
+
+/**
+* Tests selecting all records in a single pass without a COUNT query
+*/
+static void test_select_single_pass
+    (
+    void
+    )
+{
+int                 success;
+test_model_list_t   expected_models;
+test_model_list_t   actual_models;
+
+before_each_test();
+
+// An empty result should not allocate a list
+success = test_model_select_all( g_db, SELECT_MODE_SINGLE_PASS, &actual_models );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( 0, actual_models.cnt );
+TEST_ASSERT_NULL( actual_models.list );
+
+// Enough results to require growing the list several times
+insert_test_models( TEST_MODEL_CNT, &expected_models );
+
+success = test_model_select_all( g_db, SELECT_MODE_SINGLE_PASS, &actual_models );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( test_model_lists_are_equal( &expected_models, &actual_models ) );
+
+// Clean up
+test_model_list_free( &expected_models );
+test_model_list_free( &actual_models );
+}
+
+
+/**
+* Tests collecting statistics of SELECT and find calls
+*/
+static void test_stats
+    (
+    void
+    )
+{
+int                                 success;
+int                                 model_found;
+test_model_list_t                   expected_models;
+test_model_list_t                   actual_models;
+test_model_t                        actual_model;
+cqlite_stats_t                      stats;
+cqlite_stats_api_stats_t const *    select_stats;
+cqlite_stats_api_stats_t const *    find_stats;
+
+before_each_test();
+
+insert_test_models( TEST_MODEL_CNT, &expected_models );
+
+cqlite_stats_enable( CQLITE_STATS_ENABLED | CQLITE_STATS_STMT_STATUS );
+cqlite_stats_reset();
+
+success = test_model_select_all( g_db, SELECT_MODE_COUNTED, &actual_models ) &&
+          test_model_find_by_id( g_db, expected_models.list[0].id, &model_found, &actual_model );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( model_found );
+
+cqlite_stats_get( &stats );
+select_stats = &stats.apis[CQLITE_STATS_API_SELECT];
+find_stats = &stats.apis[CQLITE_STATS_API_FIND];
+
+TEST_ASSERT_EQUAL_INT( 1, select_stats->call_cnt );
+TEST_ASSERT_EQUAL_INT( 0, select_stats->error_cnt );
+TEST_ASSERT_EQUAL_INT( TEST_MODEL_CNT, select_stats->rows_read );
+TEST_ASSERT_TRUE( select_stats->bytes_allocated >= (sqlite_int64)( TEST_MODEL_CNT * sizeof( test_model_t ) ) );
+TEST_ASSERT_EQUAL_INT( 1, select_stats->latency.cnt );
+TEST_ASSERT_EQUAL_INT( 1, select_stats->phases[CQLITE_STATS_PHASE_PREPARE].cnt );
+TEST_ASSERT_EQUAL_INT( 1, select_stats->phases[CQLITE_STATS_PHASE_COUNT].cnt );
+TEST_ASSERT_EQUAL_INT( 1, select_stats->phases[CQLITE_STATS_PHASE_ALLOC].cnt );
+TEST_ASSERT_EQUAL_INT( 1, select_stats->phases[CQLITE_STATS_PHASE_STEP].cnt );
+TEST_ASSERT_EQUAL_INT( 1, select_stats->phases[CQLITE_STATS_PHASE_DECODE].cnt );
+TEST_ASSERT_TRUE( select_stats->vm_steps > 0 );
+TEST_ASSERT_TRUE( cqlite_stats_histogram_percentile( &select_stats->latency, 99.0 ) > 0 );
+
+TEST_ASSERT_EQUAL_INT( 1, find_stats->call_cnt );
+TEST_ASSERT_EQUAL_INT( 1, find_stats->rows_read );
+TEST_ASSERT_EQUAL_INT( 1, find_stats->phases[CQLITE_STATS_PHASE_DECODE].cnt );
+
+// The COUNT query of the SELECT is not a call of its own
+TEST_ASSERT_EQUAL_INT( 0, stats.apis[CQLITE_STATS_API_COUNT].call_cnt );
+
+test_model_list_free( &actual_models );
+test_model_free( &actual_model );
+
+// Nothing is collected while disabled
+cqlite_stats_enable( CQLITE_STATS_DISABLED );
+
+success = test_model_select_all( g_db, SELECT_MODE_SINGLE_PASS, &actual_models );
+TEST_ASSERT_TRUE( success );
+
+cqlite_stats_get( &stats );
+TEST_ASSERT_EQUAL_INT( 1, stats.apis[CQLITE_STATS_API_SELECT].call_cnt );
+
+cqlite_stats_reset();
+cqlite_stats_get( &stats );
+TEST_ASSERT_EQUAL_INT( 0, stats.apis[CQLITE_STATS_API_SELECT].call_cnt );
+
+// Clean up
+test_model_list_free( &expected_models );
+test_model_list_free( &actual_models );
+}
+
+
+/**
+* Tests finding records through a prepared statement cache
+*/
+static void test_stmt_cache
+    (
+    void
+    )
+{
+int                         i;
+int                         success;
+int                         model_found;
+int                         count;
+sqlite_int64                misses;
+sqlite3_int64               ids[3];
+unsigned char               found_bits[CQLITE_FOUND_BITS_SIZE( 3 )];
+test_model_list_t           expected_models;
+test_model_list_t           actual_models;
+test_model_t                actual_model;
+cqlite_stmt_cache_t *       cache;
+cqlite_stmt_cache_stats_t   stats;
 
-static void assert_model_in_database
-    (
-    sqlite3 *               db,
-    test_model_t const *    model
-    );
+before_each_test();
 
-static int before_all_tests
+insert_test_models( TEST_MODEL_CNT, &expected_models );
+
+success = ( CQLITE_SUCCESS == cqlite_stmt_cache_create( g_db, TEST_CACHE_CAPACITY, &cache ) );
+TEST_ASSERT_TRUE( success );
+
+// Only the first lookup should need to prepare the query
+for( i = 0; i < expected_models.cnt; i++ )
+    {
+    success = test_model_find_by_id_cached( cache, expected_models.list[i].id, &model_found, &actual_model );
+
+    TEST_ASSERT_TRUE( success );
+    TEST_ASSERT_TRUE( model_found );
+    TEST_ASSERT_TRUE( test_models_are_equal( &expected_models.list[i], &actual_model ) );
+
+    test_model_free( &actual_model );
+    }
+
+cqlite_stmt_cache_stats_get( cache, &stats );
+TEST_ASSERT_EQUAL_INT( expected_models.cnt - 1, stats.hits );
+TEST_ASSERT_EQUAL_INT( 1, stats.misses );
+
+// A schema change should invalidate the cached statements
+success = ( CQLITE_SUCCESS == cqlite_stmt_cache_count_query_execute( cache, "SELECT COUNT(*) FROM test;", &count ) ) &&
+          ( SQLITE_OK == sqlite3_exec( g_db, "CREATE INDEX test_int_field_idx ON test(int_field);", NULL, NULL, NULL ) ) &&
+          ( CQLITE_SUCCESS == cqlite_stmt_cache_count_query_execute( cache, "SELECT COUNT(*) FROM test;", &count ) ) &&
+          ( SQLITE_OK == sqlite3_exec( g_db, "DROP INDEX test_int_field_idx;", NULL, NULL, NULL ) );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( expected_models.cnt, count );
+
+cqlite_stmt_cache_stats_get( cache, &stats );
+TEST_ASSERT_EQUAL_INT( 1, stats.invalidations );
+misses = stats.misses;
+
+// Inserting and finding many models again should reuse their statements
+for( i = 0; i < 2; i++ )
+    {
+    success = test_model_insert_many_cached( cache, &expected_models, 0 );
+    TEST_ASSERT_TRUE( success );
+
+    ids[0] = expected_models.list[0].id;
+    ids[1] = -1;
+    ids[2] = expected_models.list[2].id;
+
+    success = test_model_find_many_by_ids_cached( cache, ids, 3, &actual_models, found_bits );
+    TEST_ASSERT_TRUE( success );
+    TEST_ASSERT_TRUE( CQLITE_FOUND_BIT_IS_SET( found_bits, 0 ) );
+    TEST_ASSERT_FALSE( CQLITE_FOUND_BIT_IS_SET( found_bits, 1 ) );
+    TEST_ASSERT_TRUE( CQLITE_FOUND_BIT_IS_SET( found_bits, 2 ) );
+    TEST_ASSERT_TRUE( test_models_are_equal( &expected_models.list[0], &actual_models.list[0] ) );
+    TEST_ASSERT_TRUE( test_models_are_equal( &expected_models.list[2], &actual_models.list[2] ) );
+
+    test_model_list_free( &actual_models );
+    }
+
+cqlite_stmt_cache_stats_get( cache, &stats );
+TEST_ASSERT_EQUAL_INT( 2, stats.misses - misses );
+
+success = ( CQLITE_SUCCESS == cqlite_count_query_execute( g_db, "SELECT COUNT(*) FROM test;", &count ) );
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( 3 * expected_models.cnt, count );
+
+// Clean up
+cqlite_stmt_cache_free( cache );
+test_model_list_free( &expected_models );
+}
+
+
+/**
+* Tests borrowing strings and blobs from row results without copying
+*/
+static void test_string_view
     (
     void
-    );
+    )
+{
+int                     i;
+int                     success;
+sqlite3_stmt *          query;
+test_model_list_t       expected_models;
+cqlite_string_view_t    string;
+cqlite_string_view_t    null_string;
+cqlite_blob_view_t      blob;
 
-static int before_each_test
+before_each_test();
+
+insert_test_models( TEST_MODEL_CNT, &expected_models );
+
+success = ( SQLITE_OK == sqlite3_prepare_v2( g_db, "SELECT dynamic_string_field, CAST(dynamic_string_field AS BLOB), NULL, int_field FROM test ORDER BY id;", -1, &query, NULL ) );
+TEST_ASSERT_TRUE( success );
+
+for( i = 0; i < expected_models.cnt; i++ )
+    {
+    TEST_ASSERT_EQUAL_INT( SQLITE_ROW, sqlite3_step( query ) );
+
+    success = ( CQLITE_SUCCESS == cqlite_string_view_read( query, 0, &string ) ) &&
+              ( CQLITE_SUCCESS == cqlite_blob_view_read( query, 1, &blob ) ) &&
+              ( CQLITE_SUCCESS == cqlite_string_view_read( query, 2, &null_string ) );
+
+    TEST_ASSERT_TRUE( success );
+    TEST_ASSERT_EQUAL_INT( strlen( expected_models.list[i].dynamic_string_field ), string.len );
+    TEST_ASSERT_EQUAL_MEMORY( expected_models.list[i].dynamic_string_field, string.text, string.len );
+    TEST_ASSERT_EQUAL_INT( string.len, blob.len );
+    TEST_ASSERT_EQUAL_MEMORY( expected_models.list[i].dynamic_string_field, blob.data, blob.len );
+    TEST_ASSERT_NULL( null_string.text );
+    TEST_ASSERT_EQUAL_INT( 0, null_string.len );
+
+    // Numbers are not converted to strings or blobs
+    TEST_ASSERT_EQUAL_INT( CQLITE_ERROR, cqlite_string_view_read( query, 3, &string ) );
+    TEST_ASSERT_EQUAL_INT( CQLITE_ERROR, cqlite_blob_view_read( query, 0, &blob ) );
+    }
+
+TEST_ASSERT_EQUAL_INT( SQLITE_DONE, sqlite3_step( query ) );
+
+// Clean up
+sqlite3_finalize( query );
+test_model_list_free( &expected_models );
+}
+
+
+/**
+* Tests tracing statements and reading the trace back
+*/
+static void test_trace
     (
     void
-    );
+    )
+{
+int                     success;
+int                     found;
+int                     api_cnts[CQLITE_STATS_API_CNT] = { 0 };
+int                     no_api_cnt = 0;
+unsigned int            thread_id = 0;
+test_model_list_t       expected_models;
+test_model_list_t       actual_models;
+cqlite_trace_t *        trace;
+cqlite_trace_reader_t * reader;
+cqlite_trace_record_t   record;
+
+before_each_test();
+
+success = ( CQLITE_SUCCESS == cqlite_trace_open( TEST_TRACE_FILE, &trace ) ) &&
+          ( CQLITE_SUCCESS == cqlite_trace_attach( trace, g_db ) );
+TEST_ASSERT_TRUE( success );
+
+insert_test_models( TEST_MODEL_CNT, &expected_models );
+
+success = test_model_select_all( g_db, SELECT_MODE_COUNTED, &actual_models );
+TEST_ASSERT_TRUE( success );
+test_model_list_free( &actual_models );
+
+success = ( SQLITE_OK == sqlite3_exec( g_db, "SELECT 1;", NULL, NULL, NULL ) );
+TEST_ASSERT_TRUE( success );
+
+// Statements after detaching are not traced
+cqlite_trace_detach( g_db );
+
+success = ( SQLITE_OK == sqlite3_exec( g_db, "SELECT 2;", NULL, NULL, NULL ) );
+TEST_ASSERT_TRUE( success );
+
+success = ( CQLITE_SUCCESS == cqlite_trace_close( trace ) );
+TEST_ASSERT_TRUE( success );
+
+// Read the trace back
+success = ( CQLITE_SUCCESS == cqlite_trace_reader_open( TEST_TRACE_FILE, &reader ) ) &&
+          ( CQLITE_SUCCESS == cqlite_trace_reader_next( reader, &record, &found ) );
+TEST_ASSERT_TRUE( success );
+
+while( success && found )
+    {
+    TEST_ASSERT_TRUE( record.duration_ns >= 0 );
+    TEST_ASSERT_TRUE( ( 0 == thread_id ) || ( record.thread_id == thread_id ) );
+    thread_id = record.thread_id;
+
+    // Parameters are expanded into literals
+    TEST_ASSERT_NULL( strchr( record.sql, '?' ) );
+
+    if( CQLITE_TRACE_NO_API == record.api )
+        {
+        TEST_ASSERT_EQUAL_STRING( "SELECT 1;", record.sql );
+        no_api_cnt++;
+        }
+    else
+        {
+        api_cnts[record.api]++;
+        }
+
+    success = ( CQLITE_SUCCESS == cqlite_trace_reader_next( reader, &record, &found ) );
+    }
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_TRUE( 0 != thread_id );
+TEST_ASSERT_EQUAL_INT( TEST_MODEL_CNT, api_cnts[CQLITE_STATS_API_INSERT] );
+TEST_ASSERT_EQUAL_INT( 2, api_cnts[CQLITE_STATS_API_SELECT] );
+TEST_ASSERT_EQUAL_INT( 1, no_api_cnt );
+
+// Clean up
+cqlite_trace_reader_close( reader );
+test_model_list_free( &expected_models );
+unlink( TEST_TRACE_FILE );
+}
 
 
 /**
-* Tests inserting a new record into the database
+* Tests inserting records concurrently through an asynchronous writer
 */
-static void test_insert_new
+static void test_writer
     (
     void
     )
 {
-test_model_t new_model = 
-    {/* id,                     real_field,     int_field,  dynamic_string, fixed_string    */
-        CQLITE_INVALID_ROW_ID,  1.0,            1,          "Hello",        "ABC" 
-    };
-
-int success;
+int                     i;
+int                     j;
+int                     success;
+int                     count;
+atomic_int              callback_success_cnt;
+cqlite_writer_t *       writer;
+writer_insert_args_t    insert_args[TEST_THREAD_CNT];
+pthread_t               insert_threads[TEST_THREAD_CNT];
 
 before_each_test();
 
-// Attempt to insert a new model into the database.
-success = test_model_insert_new( g_db, &new_model );
+atomic_init( &callback_success_cnt, 0 );
 
+success = ( CQLITE_SUCCESS == cqlite_writer_open( TEST_DATABASE_FILE, TEST_CACHE_CAPACITY, TEST_WRITER_BATCH, TEST_WRITER_WINDOW, &writer ) );
 TEST_ASSERT_TRUE( success );
-TEST_ASSERT( CQLITE_INVALID_ROW_ID != new_model.id );
 
-// Ensure the model was actually saved to the database
-assert_model_in_database( g_db, &new_model );
+for( i = 0; i < TEST_THREAD_CNT; i++ )
+    {
+    insert_args[i].writer = writer;
+    insert_args[i].callback_success_cnt = &callback_success_cnt;
+    insert_args[i].success = 0;
+
+    TEST_ASSERT_EQUAL_INT( 0, pthread_create( &insert_threads[i], NULL, writer_insert_thread, &insert_args[i] ) );
+    }
+
+for( i = 0; i < TEST_THREAD_CNT; i++ )
+    {
+    pthread_join( insert_threads[i], NULL );
+    TEST_ASSERT_TRUE( insert_args[i].success );
+    }
+
+// Closing completes the jobs that were only tracked by callbacks
+cqlite_writer_close( writer );
+
+TEST_ASSERT_EQUAL_INT( TEST_THREAD_CNT * ( TEST_MODEL_CNT / 2 ), atomic_load( &callback_success_cnt ) );
+
+success = ( CQLITE_SUCCESS == cqlite_count_query_execute( g_db, "SELECT COUNT(*) FROM test;", &count ) );
+
+TEST_ASSERT_TRUE( success );
+TEST_ASSERT_EQUAL_INT( TEST_THREAD_CNT * TEST_MODEL_CNT, count );
+
+// The models that were waited on know their row ids
+for( i = 0; i < TEST_THREAD_CNT; i++ )
+    {
+    for( j = 0; j < insert_args[i].models.cnt; j += 2 )
+        {
+        assert_model_in_database( g_db, &insert_args[i].models.list[j] );
+        }
+
+    test_model_list_free( &insert_args[i].models );
+    }
 }
 
 
@@ -86,6 +2126,26 @@ unlink( TEST_DATABASE_FILE );
 }    
 
 
+/**
+* Assert generated model equal.
+*
+* Asserts that the given generated model holds the same fields as the
+* given test model.
+*/
+static void assert_gen_model_equal
+    (
+    test_model_t const *    expected,
+    test_gen_t const *      actual
+    )
+{
+TEST_ASSERT_TRUE( expected->id == actual->id );
+TEST_ASSERT_TRUE( expected->real_field == actual->real_field );
+TEST_ASSERT_EQUAL_INT( expected->int_field, actual->int_field );
+TEST_ASSERT_EQUAL_STRING( expected->dynamic_string_field, actual->dynamic_string_field );
+TEST_ASSERT_EQUAL_STRING( expected->fixed_string_field, actual->fixed_string_field );
+}
+
+
 /**
 * Assert model in database.
 *
@@ -114,6 +2174,33 @@ test_model_free( &actual_model );
 }    
 
 
+/**
+* Assert totals of models.
+*
+* Asserts that the given totals were folded from exactly the given
+* models, in order.
+*/
+static void assert_totals_of_models
+    (
+    test_model_list_t const *   models,
+    test_model_totals_t const * totals
+    )
+{
+int             i;
+sqlite3_int64   int_field_sum = 0;
+
+for( i = 0; i < models->cnt; i++ )
+    {
+    int_field_sum += models->list[i].int_field;
+    }
+
+TEST_ASSERT_TRUE( models->cnt == totals->row_cnt );
+TEST_ASSERT_TRUE( int_field_sum == totals->int_field_sum );
+TEST_ASSERT_TRUE( models->list[0].id == totals->first_id );
+TEST_ASSERT_TRUE( models->list[models->cnt - 1].id == totals->last_id );
+}
+
+
 /**
 * Run set up logic before all tests.
 */
@@ -147,6 +2234,248 @@ return test_database_delete_all_data( g_db );
 }    
 
 
+/**
+* Insert test models.
+*
+* Inserts the specified number of distinct models into the database
+* in order of increasing id and returns them in models_out. Caller must
+* call test_model_list_free() on models_out.
+*/
+static void insert_test_models
+    (
+    int                 model_cnt,
+    test_model_list_t * models_out
+    )
+{
+int     i;
+int     success;
+char    dynamic_string[32];
+
+test_model_list_init( models_out );
+
+models_out->list = calloc( model_cnt, sizeof( test_model_t ) );
+TEST_ASSERT_NOT_NULL( models_out->list );
+models_out->cnt = model_cnt;
+
+for( i = 0; i < model_cnt; i++ )
+    {
+    snprintf( dynamic_string, sizeof( dynamic_string ), "Model %d", i );
+
+    models_out->list[i].id = CQLITE_INVALID_ROW_ID;
+    models_out->list[i].real_field = i * 1.5;
+    models_out->list[i].int_field = i;
+    models_out->list[i].dynamic_string_field = strdup( dynamic_string );
+    strcpy( models_out->list[i].fixed_string_field, "ABC" );
+
+    success = test_model_insert_new( g_db, &models_out->list[i] );
+    TEST_ASSERT_TRUE( success );
+    }
+}
+
+
+/**
+* Open a connection pool on a populated test database.
+*
+* Opens a pool on a new test database and inserts TEST_MODEL_CNT models
+* through its write connection. Caller must call cqlite_pool_close() on
+* pool_out and test_model_list_free() on models_out.
+*/
+static void open_test_pool
+    (
+    int                 reader_cnt,
+    test_model_list_t * models_out,
+    cqlite_pool_t **    pool_out
+    )
+{
+int                     success;
+cqlite_pool_conn_t *    writer;
+
+remove_database_files( TEST_POOL_FILE );
+
+success = ( CQLITE_SUCCESS == cqlite_pool_open( TEST_POOL_FILE, reader_cnt, TEST_CACHE_CAPACITY, pool_out ) );
+TEST_ASSERT_TRUE( success );
+
+insert_test_models( TEST_MODEL_CNT, models_out );
+
+// Populate the pool's database through its write connection
+cqlite_pool_writer_acquire( *pool_out, &writer );
+
+success = test_database_init( cqlite_pool_conn_db( writer ) ) &&
+          test_model_insert_many( cqlite_pool_conn_db( writer ), models_out, TEST_MODEL_CNT );
+
+cqlite_pool_release( *pool_out, writer );
+TEST_ASSERT_TRUE( success );
+}
+
+
+/**
+* Pool reader thread.
+*
+* Finds every expected model by id and then selects all models through
+* the connection pool. Assertions cannot be made off the main thread, so
+* the outcome is reported through the success field of the arguments.
+*/
+static void * pool_reader_thread
+    (
+    void * args
+    )
+{
+pool_reader_args_t *    reader_args;
+int                     success = 1;
+int                     model_found;
+int                     i;
+test_model_t            actual_model;
+test_model_list_t       actual_models;
+
+reader_args = (pool_reader_args_t*)args;
+
+for( i = 0; success && ( i < reader_args->expected_models->cnt ); i++ )
+    {
+    success = test_model_find_by_id_pooled( reader_args->pool, reader_args->expected_models->list[i].id, &model_found, &actual_model ) &&
+              ( model_found ) &&
+              ( test_models_are_equal( &reader_args->expected_models->list[i], &actual_model ) );
+
+    test_model_free( &actual_model );
+    }
+
+if( success )
+    {
+    success = test_model_select_all_pooled( reader_args->pool, &actual_models ) &&
+              test_model_lists_are_equal( reader_args->expected_models, &actual_models );
+
+    test_model_list_free( &actual_models );
+    }
+
+reader_args->success = success;
+
+return NULL;
+}
+
+
+/**
+* Remove database files.
+*
+* Removes the database file at the provided path along with any WAL
+* and shared memory files left next to it.
+*/
+static void remove_database_files
+    (
+    char const * path
+    )
+{
+char file_path[256];
+
+unlink( path );
+
+snprintf( file_path, sizeof( file_path ), "%s-wal", path );
+unlink( file_path );
+
+snprintf( file_path, sizeof( file_path ), "%s-shm", path );
+unlink( file_path );
+}
+
+
+/**
+* Write test file.
+*
+* Replaces the file at the provided path with the provided data.
+*/
+static void write_test_file
+    (
+    char const *    path,
+    void const *    data,
+    size_t          size
+    )
+{
+FILE * file;
+
+file = fopen( path, "wb" );
+TEST_ASSERT_NOT_NULL( file );
+TEST_ASSERT_TRUE( size == fwrite( data, 1, size, file ) );
+TEST_ASSERT_EQUAL_INT( 0, fclose( file ) );
+}
+
+
+/**
+* Count successful writer jobs.
+*/
+static void writer_callback_count
+    (
+    cqlite_rcode_t  rcode,
+    sqlite_int64    row_id,
+    void *          context
+    )
+{
+if( ( CQLITE_SUCCESS == rcode ) && ( CQLITE_INVALID_ROW_ID != row_id ) )
+    {
+    atomic_fetch_add( (atomic_int*)context, 1 );
+    }
+}
+
+
+/**
+* Queue models on an asynchronous writer.
+*
+* Waits on the jobs of the even models to learn their row ids and only
+* counts the odd ones from the writer's callback.
+*/
+static void * writer_insert_thread
+    (
+    void * args
+    )
+{
+writer_insert_args_t *  insert_args;
+int                     success;
+int                     i;
+char                    dynamic_string[32];
+cqlite_writer_job_t **  jobs;
+
+insert_args = (writer_insert_args_t*)args;
+
+test_model_list_init( &insert_args->models );
+
+insert_args->models.list = calloc( TEST_MODEL_CNT, sizeof( test_model_t ) );
+jobs = calloc( TEST_MODEL_CNT, sizeof( *jobs ) );
+success = ( NULL != insert_args->models.list ) && ( NULL != jobs );
+
+if( success )
+    {
+    insert_args->models.cnt = TEST_MODEL_CNT;
+    }
+
+for( i = 0; success && ( i < TEST_MODEL_CNT ); i++ )
+    {
+    snprintf( dynamic_string, sizeof( dynamic_string ), "Async model %d", i );
+
+    insert_args->models.list[i].id = CQLITE_INVALID_ROW_ID;
+    insert_args->models.list[i].real_field = i * 0.5;
+    insert_args->models.list[i].int_field = i;
+    insert_args->models.list[i].dynamic_string_field = strdup( dynamic_string );
+    strcpy( insert_args->models.list[i].fixed_string_field, "XYZ" );
+
+    success = ( NULL != insert_args->models.list[i].dynamic_string_field ) &&
+              ( ( 0 == ( i % 2 ) ) ? test_model_insert_async( insert_args->writer, &insert_args->models.list[i], NULL, NULL, &jobs[i] ) :
+                                                     test_model_insert_async( insert_args->writer, &insert_args->models.list[i], writer_callback_count, insert_args->callback_success_cnt, NULL ) );
+    }
+
+// Every queued job must be waited on, even after an error
+for( i = 0; ( NULL != jobs ) && ( i < TEST_MODEL_CNT ); i += 2 )
+    {
+    if( NULL != jobs[i] )
+        {
+        success = ( CQLITE_SUCCESS == cqlite_writer_job_wait( jobs[i], &insert_args->models.list[i].id ) ) && success;
+        }
+    }
+
+insert_args->success = success;
+
+// Clean up
+free( jobs );
+
+return NULL;
+}
+
+
 /**
 * Top-level entry-point into the test suite
 */
@@ -159,7 +2488,32 @@ UNITY_BEGIN();
 
 before_all_tests();
 
+RUN_TEST(test_arena_select);
+RUN_TEST(test_blob);
+RUN_TEST(test_cursor);
+RUN_TEST(test_find_many);
+RUN_TEST(test_fold);
+RUN_TEST(test_generated);
+RUN_TEST(test_import);
+RUN_TEST(test_insert_many);
+RUN_TEST(test_insert_mapped);
 RUN_TEST(test_insert_new);
+RUN_TEST(test_open);
+RUN_TEST(test_page);
+RUN_TEST(test_parallel_select);
+RUN_TEST(test_pipeline);
+RUN_TEST(test_pool);
+RUN_TEST(test_result_cache);
+RUN_TEST(test_select_columnar);
+RUN_TEST(test_select_counted);
+RUN_TEST(test_select_mapped);
+RUN_TEST(test_select_segmented);
+RUN_TEST(test_select_single_pass);
+RUN_TEST(test_stats);
+RUN_TEST(test_stmt_cache);
+RUN_TEST(test_string_view);
+RUN_TEST(test_trace);
+RUN_TEST(test_writer);
 
 after_all_tests();
 
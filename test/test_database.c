@@ -20,6 +20,20 @@ typedef enum
     INSERT_MODE_EXISTING_RECORD,
     } insert_mode_t;
 
+// Parameters of the id range queries
+typedef struct
+    {
+    sqlite3_int64   min_id;
+    sqlite3_int64   max_id;
+    } id_range_t;
+
+// Context of the pipelined totals, which stop after stop_after_cnt models
+typedef struct
+    {
+    test_model_totals_t *   totals;
+    sqlite3_int64           stop_after_cnt;
+    } pipeline_totals_t;
+
 
 static char const * const TEST_TABLE_CREATE = 
     "CREATE TABLE IF NOT EXISTS test"
@@ -41,9 +55,74 @@ typedef enum
     } test_table_columns_t;
 
 
+static cqlite_column_desc_t const TEST_TABLE_COLUMNS[] =
+    {
+    CQLITE_COLUMN_DESC( TEST_TABLE_ID_COL,                   test_model_t, id,                   CQLITE_FIELD_INT64 ),
+    CQLITE_COLUMN_DESC( TEST_TABLE_REAL_FIELD_COL,           test_model_t, real_field,           CQLITE_FIELD_DOUBLE ),
+    CQLITE_COLUMN_DESC( TEST_TABLE_INT_FIELD_COL,            test_model_t, int_field,            CQLITE_FIELD_INT ),
+    CQLITE_COLUMN_DESC( TEST_TABLE_DYNAMIC_STRING_FIELD_COL, test_model_t, dynamic_string_field, CQLITE_FIELD_DYNAMIC_STRING ),
+    CQLITE_COLUMN_DESC( TEST_TABLE_FIXED_STRING_FIELD_COL,   test_model_t, fixed_string_field,   CQLITE_FIELD_FIXED_STRING ),
+    };
+
+#define TEST_TABLE_COLUMN_CNT ( sizeof( TEST_TABLE_COLUMNS ) / sizeof( TEST_TABLE_COLUMNS[0] ) )
+
+// Binds every field except the id so that a new record is inserted
+static cqlite_param_desc_t const TEST_TABLE_PARAMS[] =
+    {
+    CQLITE_PARAM_DESC( TEST_TABLE_REAL_FIELD_COL + 1,           test_model_t, real_field,           CQLITE_FIELD_DOUBLE ),
+    CQLITE_PARAM_DESC( TEST_TABLE_INT_FIELD_COL + 1,            test_model_t, int_field,            CQLITE_FIELD_INT ),
+    CQLITE_PARAM_DESC( TEST_TABLE_DYNAMIC_STRING_FIELD_COL + 1, test_model_t, dynamic_string_field, CQLITE_FIELD_DYNAMIC_STRING ),
+    CQLITE_PARAM_DESC( TEST_TABLE_FIXED_STRING_FIELD_COL + 1,   test_model_t, fixed_string_field,   CQLITE_FIELD_FIXED_STRING ),
+    };
+
+#define TEST_TABLE_PARAM_CNT ( sizeof( TEST_TABLE_PARAMS ) / sizeof( TEST_TABLE_PARAMS[0] ) )
+
+static cqlite_columnar_type_t const TEST_TABLE_COLUMNAR_TYPES[] =
+    {
+    [TEST_TABLE_ID_COL]                     = CQLITE_COLUMNAR_INT64,
+    [TEST_TABLE_REAL_FIELD_COL]             = CQLITE_COLUMNAR_DOUBLE,
+    [TEST_TABLE_INT_FIELD_COL]              = CQLITE_COLUMNAR_INT64,
+    [TEST_TABLE_DYNAMIC_STRING_FIELD_COL]   = CQLITE_COLUMNAR_TEXT,
+    [TEST_TABLE_FIXED_STRING_FIELD_COL]     = CQLITE_COLUMNAR_TEXT,
+    };
+
+#define TEST_TABLE_COLUMNAR_TYPE_CNT ( sizeof( TEST_TABLE_COLUMNAR_TYPES ) / sizeof( TEST_TABLE_COLUMNAR_TYPES[0] ) )
+
+static cqlite_import_field_t const TEST_TABLE_CSV_FIELDS[] =
+    {
+    [TEST_TABLE_ID_COL]                     = CQLITE_IMPORT_CSV_FIELD( CQLITE_IMPORT_INT64 ),
+    [TEST_TABLE_REAL_FIELD_COL]             = CQLITE_IMPORT_CSV_FIELD( CQLITE_IMPORT_DOUBLE ),
+    [TEST_TABLE_INT_FIELD_COL]              = CQLITE_IMPORT_CSV_FIELD( CQLITE_IMPORT_INT32 ),
+    [TEST_TABLE_DYNAMIC_STRING_FIELD_COL]   = CQLITE_IMPORT_CSV_FIELD( CQLITE_IMPORT_TEXT ),
+    [TEST_TABLE_FIXED_STRING_FIELD_COL]     = CQLITE_IMPORT_CSV_FIELD( CQLITE_IMPORT_TEXT ),
+    };
+
+#define TEST_TABLE_CSV_FIELD_CNT ( sizeof( TEST_TABLE_CSV_FIELDS ) / sizeof( TEST_TABLE_CSV_FIELDS[0] ) )
+
+static cqlite_import_field_t const TEST_TABLE_BINARY_FIELDS[] =
+    {
+    [TEST_TABLE_ID_COL]                     = CQLITE_IMPORT_BINARY_FIELD( test_record_t, id,                   CQLITE_IMPORT_INT64 ),
+    [TEST_TABLE_REAL_FIELD_COL]             = CQLITE_IMPORT_BINARY_FIELD( test_record_t, real_field,           CQLITE_IMPORT_DOUBLE ),
+    [TEST_TABLE_INT_FIELD_COL]              = CQLITE_IMPORT_BINARY_FIELD( test_record_t, int_field,            CQLITE_IMPORT_INT32 ),
+    [TEST_TABLE_DYNAMIC_STRING_FIELD_COL]   = CQLITE_IMPORT_BINARY_FIELD( test_record_t, dynamic_string_field, CQLITE_IMPORT_TEXT ),
+    [TEST_TABLE_FIXED_STRING_FIELD_COL]     = CQLITE_IMPORT_BINARY_FIELD( test_record_t, fixed_string_field,   CQLITE_IMPORT_TEXT ),
+    };
+
+#define TEST_TABLE_BINARY_FIELD_CNT ( sizeof( TEST_TABLE_BINARY_FIELDS ) / sizeof( TEST_TABLE_BINARY_FIELDS[0] ) )
+
+
 static char const * const TEST_TABLE_DELETE_ALL     = "DELETE FROM test;";
 static char const * const TEST_TABLE_INSERT         = "INSERT OR REPLACE INTO test VALUES (?, ?, ?, ?, ?);";
+static char const * const TEST_TABLE_SELECT_ALL     = "SELECT * FROM test ORDER BY id;";
 static char const * const TEST_TABLE_SELECT_BY_ID   = "SELECT * FROM test WHERE id = ?;";
+static char const * const TEST_TABLE_SELECT_BY_IDS  = "SELECT * FROM test WHERE id IN ";
+static char const * const TEST_TABLE_COUNT_ALL      = "SELECT COUNT(*) FROM test;";
+static char const * const TEST_TABLE_ID_BOUNDS      = "SELECT MIN(id), MAX(id) FROM test;";
+static char const * const TEST_TABLE_SELECT_RANGE   = "SELECT * FROM test WHERE id BETWEEN ?1 AND ?2 ORDER BY id;";
+static char const * const TEST_TABLE_COUNT_RANGE    = "SELECT COUNT(*) FROM test WHERE id BETWEEN ?1 AND ?2;";
+static char const * const TEST_TABLE_SELECT_BY_REAL  = "SELECT * FROM test WHERE real_field = ?1 ORDER BY id;";
+static char const * const TEST_TABLE_KEY_COLUMN     = "id";
+static char const * const TEST_TABLE_SELECT_PAGED   = "SELECT * FROM test;";
 
 
 /**********************************************
@@ -56,12 +135,68 @@ static int test_model_add_to_list
     int             next_model_list_idx
     );
 
+static int test_model_add_to_list_arena
+    (
+    sqlite3_stmt *      query,
+    void *              model_list,
+    int                 next_model_list_idx,
+    cqlite_arena_t *    arena
+    );
+
 static int test_model_from_row_result
     (
     sqlite3_stmt *  query,   
     void *          model_out
     );
 
+static int test_model_from_row_result_arena
+    (
+    sqlite3_stmt *      query,
+    cqlite_arena_t *    arena,
+    test_model_t *      test_model
+    );
+
+static void test_model_free_func
+    (
+    void * model
+    );
+
+static int test_model_bind_fields
+    (
+    sqlite3_stmt *  insert_query,
+    void const *    model
+    );
+
+static int test_model_totals_fold
+    (
+    sqlite3_stmt *  query,
+    void *          accumulator
+    );
+
+static int test_model_totals_merge
+    (
+    void *          accumulator,
+    void const *    partition_accumulator
+    );
+
+static int test_model_totals_process
+    (
+    void *          model,
+    void *          context
+    );
+
+static int test_id_range_bind
+    (
+    sqlite3_stmt *  query,
+    void const *    params
+    );
+
+static int test_real_bind
+    (
+    sqlite3_stmt *  query,
+    void const *    params
+    );
+
 static int test_model_insert_query_prepare
     (
     sqlite3 *               db,
@@ -214,6 +349,95 @@ return ( SQLITE_OK == sqlite3_exec( db, TEST_TABLE_CREATE, NO_CALLBACK, NO_CALLB
 }
 
 
+/**
+* Open cursor over all models.
+*
+* Opens a cursor that reads all models ordered by id in batches of
+* batch_size. Caller must call cqlite_cursor_close() on cursor_out.
+*/
+int test_model_cursor_open
+    (
+    sqlite3 *           db,
+    int                 batch_size,
+    cqlite_cursor_t **  cursor_out
+    )
+{
+cqlite_rcode_t rcode;
+
+rcode = cqlite_cursor_open( db, TEST_TABLE_SELECT_ALL, test_model_from_row_result, test_model_free_func, sizeof( test_model_t ), batch_size, cursor_out );
+
+return ( CQLITE_SUCCESS == rcode );
+}    
+
+
+/**
+* Count models using a query result cache.
+*/
+int test_model_count_cached
+    (
+    cqlite_result_cache_t * cache,
+    int *                   count_out
+    )
+{
+cqlite_rcode_t rcode;
+
+rcode = cqlite_result_cache_count_query_execute( cache, TEST_TABLE_COUNT_ALL, count_out );
+
+return ( CQLITE_SUCCESS == rcode );
+}
+
+
+/**
+* Fold totals of all models.
+*
+* Counts the models and sums their int fields, starting from initial_sum,
+* without reading them into models.
+*/
+int test_model_fold_totals
+    (
+    sqlite3 *               db,
+    sqlite3_int64           initial_sum,
+    test_model_totals_t *   totals_out
+    )
+{
+cqlite_rcode_t rcode;
+
+memset( totals_out, 0, sizeof( *totals_out ) );
+totals_out->int_field_sum = initial_sum;
+
+rcode = cqlite_fold_query_execute( db, TEST_TABLE_SELECT_ALL, test_model_totals_fold, totals_out );
+
+return ( CQLITE_SUCCESS == rcode );
+}
+
+
+/**
+* Fold totals of all models in parallel.
+*
+* Folds partition_cnt id ranges concurrently on the pool's read
+* connections and merges their totals, starting from initial_sum.
+*/
+int test_model_fold_totals_parallel
+    (
+    cqlite_pool_t *         pool,
+    int                     partition_cnt,
+    sqlite3_int64           initial_sum,
+    test_model_totals_t *   totals_out
+    )
+{
+cqlite_rcode_t      rcode;
+test_model_totals_t identity;
+
+memset( &identity, 0, sizeof( identity ) );
+memset( totals_out, 0, sizeof( *totals_out ) );
+totals_out->int_field_sum = initial_sum;
+
+rcode = cqlite_parallel_fold_query_execute( pool, TEST_TABLE_ID_BOUNDS, TEST_TABLE_SELECT_RANGE, test_model_totals_fold, test_model_totals_merge, &identity, totals_out, sizeof( *totals_out ), partition_cnt );
+
+return ( CQLITE_SUCCESS == rcode );
+}
+
+
 /**
 * Find model by id.
 *
@@ -239,127 +463,963 @@ return ( CQLITE_SUCCESS == rcode );
 
 
 /**
-* Insert new model.
+* Find model by id using a statement cache.
 *
-* Inserts the provided model as a new record into the database.
-* This will modify the provided model with the generated insert
-* id.
+* Caller must call test_model_free() on model_out.
 */
-int test_model_insert_new
+int test_model_find_by_id_cached
     (
-    sqlite3 *       db,
-    test_model_t *  model
+    cqlite_stmt_cache_t *   cache,
+    sqlite3_int64           id,
+    int *                   found_out,
+    test_model_t *          model_out
     )
 {
-int             success;
-sqlite3_stmt *  insert_query = NULL;
+cqlite_rcode_t rcode;
 
-success = test_model_insert_query_prepare( db, model, INSERT_MODE_NEW_RECORD, &insert_query );
+*found_out = 0;
+test_model_init( model_out );
 
-if( success )
+rcode = cqlite_stmt_cache_find_by_id( cache, TEST_TABLE_SELECT_BY_ID, id, test_model_from_row_result, found_out, model_out );
+
+return ( CQLITE_SUCCESS == rcode );
+}    
+
+
+/**
+* Find many models by id.
+*
+* Reads the model with ids[i] into models_out->list[i] and sets bit i
+* of found_bits, which must hold CQLITE_FOUND_BITS_SIZE( id_cnt ) bytes.
+* Caller must call test_model_list_free() on models_out.
+*/
+int test_model_find_many_by_ids
+    (
+    sqlite3 *               db,
+    sqlite3_int64 const *   ids,
+    int                     id_cnt,
+    test_model_list_t *     models_out,
+    unsigned char *         found_bits
+    )
+{
+cqlite_rcode_t rcode = CQLITE_ERROR;
+
+test_model_list_init( models_out );
+
+models_out->list = calloc( id_cnt, sizeof( test_model_t ) );
+
+if( ( NULL != models_out->list ) || ( 0 == id_cnt ) )
     {
-    success = ( CQLITE_SUCCESS == cqlite_insert_query_execute( db, insert_query, &model->id ) );
+    models_out->cnt = id_cnt;
+    rcode = cqlite_find_many_by_ids( db, TEST_TABLE_SELECT_BY_IDS, TEST_TABLE_ID_COL, ids, id_cnt, test_model_from_row_result, sizeof( test_model_t ), models_out->list, found_bits );
     }
 
-// Clean up.
-sqlite3_finalize( insert_query );
+return ( CQLITE_SUCCESS == rcode );
+}
 
-return success;
-}    
+
+/**
+* Find many models by id using a statement cache.
+*
+* Caller must call test_model_list_free() on models_out.
+*
+* @see test_model_find_many_by_ids()
+*/
+int test_model_find_many_by_ids_cached
+    (
+    cqlite_stmt_cache_t *   cache,
+    sqlite3_int64 const *   ids,
+    int                     id_cnt,
+    test_model_list_t *     models_out,
+    unsigned char *         found_bits
+    )
+{
+cqlite_rcode_t rcode = CQLITE_ERROR;
+
+test_model_list_init( models_out );
+
+models_out->list = calloc( id_cnt, sizeof( test_model_t ) );
+
+if( ( NULL != models_out->list ) || ( 0 == id_cnt ) )
+    {
+    models_out->cnt = id_cnt;
+    rcode = cqlite_stmt_cache_find_many_by_ids( cache, TEST_TABLE_SELECT_BY_IDS, TEST_TABLE_ID_COL, ids, id_cnt, test_model_from_row_result, sizeof( test_model_t ), models_out->list, found_bits );
+    }
+
+return ( CQLITE_SUCCESS == rcode );
+}
 
 
 /**
-* Add test model to result list.
+* Import models from binary file.
+*
+* Inserts every test_record_t of the file as a new record.
 */
-static int test_model_add_to_list
+int test_model_import_binary
     (
-    sqlite3_stmt *  query,             
-    void *          model_list,        
-    int             next_model_list_idx
+    sqlite3 *       db,
+    char const *    path,
+    int             batch_size,
+    int             use_parse_thread,
+    sqlite3_int64 * row_cnt_out
     )
 {
-test_model_t * test_models;
+cqlite_rcode_t rcode;
 
-test_models = (test_model_t*)model_list;
+rcode = cqlite_import_binary( db, path, TEST_TABLE_INSERT, TEST_TABLE_BINARY_FIELDS, TEST_TABLE_BINARY_FIELD_CNT, sizeof( test_record_t ), batch_size, use_parse_thread, row_cnt_out );
 
-return test_model_from_row_result( query, &test_models[next_model_list_idx] );
-}    
+return ( CQLITE_SUCCESS == rcode );
+}
 
 
 /**
-* Read test model from query row result.
+* Import models from CSV file.
+*
+* Inserts every line of the file after its header as a new record.
 */
-static int test_model_from_row_result
+int test_model_import_csv
     (
-    sqlite3_stmt *  query,   
-    void *          model_out
+    sqlite3 *       db,
+    char const *    path,
+    int             batch_size,
+    int             use_parse_thread,
+    sqlite3_int64 * row_cnt_out
     )
 {
-int             success;
-test_model_t *  test_model;
+cqlite_rcode_t rcode;
 
-test_model = (test_model_t*)model_out;
+rcode = cqlite_import_csv( db, path, TEST_TABLE_INSERT, TEST_TABLE_CSV_FIELDS, TEST_TABLE_CSV_FIELD_CNT, 1, batch_size, use_parse_thread, row_cnt_out );
 
-test_model_init( test_model );
+return ( CQLITE_SUCCESS == rcode );
+}
 
-test_model->id = sqlite3_column_int64( query, TEST_TABLE_ID_COL );
-test_model->real_field = sqlite3_column_double( query, TEST_TABLE_REAL_FIELD_COL );
-test_model->int_field = sqlite3_column_int( query, TEST_TABLE_INT_FIELD_COL );
 
-success = ( CQLITE_SUCCESS == cqlite_dynamic_string_read( query, TEST_TABLE_DYNAMIC_STRING_FIELD_COL, &test_model->dynamic_string_field ) );
+/**
+* Insert new model asynchronously.
+*
+* Queues the provided model as a new record on the writer. The model's
+* strings must remain valid until the job completes.
+*/
+int test_model_insert_async
+    (
+    cqlite_writer_t *               writer,
+    test_model_t const *            model,
+    cqlite_writer_complete_func_t   complete_func,
+    void *                          context,
+    cqlite_writer_job_t **          job_out
+    )
+{
+cqlite_rcode_t rcode;
+
+rcode = cqlite_writer_insert( writer, TEST_TABLE_INSERT, test_model_bind_fields, model, sizeof( test_model_t ), complete_func, context, job_out );
 
-if( success )
+return ( CQLITE_SUCCESS == rcode );
+}
+
+
+/**
+* Insert many models using a statement cache.
+*
+* Sets the id of each model to its generated row id.
+*/
+int test_model_insert_many_cached
+    (
+    cqlite_stmt_cache_t *   cache,
+    test_model_list_t *     models,
+    int                     batch_size
+    )
+{
+int             success;
+int             i;
+sqlite_int64 *  row_ids = NULL;
+
+success = ( CQLITE_SUCCESS == cqlite_stmt_cache_insert_many( cache, TEST_TABLE_INSERT, test_model_bind_fields, models->list, sizeof( test_model_t ), models->cnt, batch_size, &row_ids ) );
+
+for( i = 0; success && ( i < models->cnt ); i++ )
     {
-    success = ( CQLITE_SUCCESS == cqlite_fixed_length_string_read( query, TEST_TABLE_FIXED_STRING_FIELD_COL, test_model->fixed_string_field, sizeof( test_model->fixed_string_field ) ) );
+    models->list[i].id = row_ids[i];
     }
 
+// Clean up
+free( row_ids );
+
 return success;
 }
 
 
 /**
-* Prepare insert query for test model.
+* Insert many new models using parameter descriptors.
 *
-* The caller must call sqlite3_finalize on query_out.
+* Same as test_model_insert_many(), binding the models with
+* descriptors instead of a bind function.
 */
-static int test_model_insert_query_prepare
+int test_model_insert_many_mapped
     (
-    sqlite3 *               db,
-    test_model_t const *    model,
-    insert_mode_t           insert_mode,
-    sqlite3_stmt **         query_out
+    sqlite3 *           db,
+    test_model_list_t * models,
+    int                 batch_size
     )
 {
 int             success;
-sqlite3_stmt *  insert_query = NULL;
-
-*query_out = NULL;
+int             i;
+sqlite_int64 *  row_ids = NULL;
 
-success = ( SQLITE_OK == sqlite3_prepare_v2( db, TEST_TABLE_INSERT, READ_TO_END, &insert_query, NO_TAIL ) );
+success = ( CQLITE_SUCCESS == cqlite_mapping_insert_many( db, TEST_TABLE_INSERT, TEST_TABLE_PARAMS, TEST_TABLE_PARAM_CNT, models->list, sizeof( test_model_t ), models->cnt, batch_size, &row_ids ) );
 
-if( success )
+for( i = 0; success && ( i < models->cnt ); i++ )
     {
-    // Why are query parameters 1-indexed and query results 0-indexed?
-    success = ( SQLITE_OK == sqlite3_bind_double( insert_query, (TEST_TABLE_REAL_FIELD_COL + 1), model->real_field ) ) &&
-              ( SQLITE_OK == sqlite3_bind_int( insert_query, (TEST_TABLE_INT_FIELD_COL + 1), model->int_field ) ) &&
-              ( SQLITE_OK == sqlite3_bind_text( insert_query, (TEST_TABLE_DYNAMIC_STRING_FIELD_COL + 1), model->dynamic_string_field, READ_TO_END, SQLITE_TRANSIENT ) ) &&
-              ( SQLITE_OK == sqlite3_bind_text( insert_query, (TEST_TABLE_FIXED_STRING_FIELD_COL + 1), model->fixed_string_field, READ_TO_END, SQLITE_TRANSIENT ) );
+    models->list[i].id = row_ids[i];
     }
 
-if( success && ( INSERT_MODE_EXISTING_RECORD == insert_mode ) )
-    {
-    success = ( SQLITE_OK == sqlite3_bind_int64( insert_query, (TEST_TABLE_ID_COL + 1), model->id ) );
-    }
+// Clean up
+free( row_ids );
+
+return success;
+}
+
+
+/**
+* Insert new model.
+*
+* Inserts the provided model as a new record into the database.
+* This will modify the provided model with the generated insert
+* id.
+*/
+int test_model_insert_new
+    (
+    sqlite3 *       db,
+    test_model_t *  model
+    )
+{
+int             success;
+sqlite3_stmt *  insert_query = NULL;
+
+success = test_model_insert_query_prepare( db, model, INSERT_MODE_NEW_RECORD, &insert_query );
 
-// Set the output or clean up on error
 if( success )
     {
-    *query_out = insert_query;
-    }
-else
-    {
-    sqlite3_finalize( insert_query );
+    success = ( CQLITE_SUCCESS == cqlite_insert_query_execute( db, insert_query, &model->id ) );
     }
 
+// Clean up.
+sqlite3_finalize( insert_query );
+
 return success;
-}    
\ No newline at end of file
+}    
+
+
+/**
+* Insert new model using parameter descriptors.
+*
+* Same as test_model_insert_new(), binding the model's strings in place
+* with descriptors.
+*/
+int test_model_insert_new_mapped
+    (
+    sqlite3 *       db,
+    test_model_t *  model
+    )
+{
+int             success;
+sqlite3_stmt *  insert_query = NULL;
+
+success = ( SQLITE_OK == sqlite3_prepare_v2( db, TEST_TABLE_INSERT, READ_TO_END, &insert_query, NO_TAIL ) ) &&
+          ( CQLITE_SUCCESS == cqlite_mapping_params_bind( insert_query, TEST_TABLE_PARAMS, TEST_TABLE_PARAM_CNT, CQLITE_BIND_STATIC, model ) ) &&
+          ( CQLITE_SUCCESS == cqlite_insert_query_execute( db, insert_query, &model->id ) );
+
+// Clean up
+sqlite3_finalize( insert_query );
+
+return success;
+}
+
+
+/**
+* Create keyset pager over all models.
+*
+* Pages through all models by id. Caller must call cqlite_page_free() on
+* page_out.
+*/
+int test_model_page_create
+    (
+    sqlite3 *           db,
+    int                 page_size,
+    int                 is_descending,
+    cqlite_page_t **    page_out
+    )
+{
+cqlite_rcode_t rcode;
+
+rcode = cqlite_page_create( db, TEST_TABLE_SELECT_PAGED, TEST_TABLE_KEY_COLUMN, is_descending, page_size, page_out );
+
+return ( CQLITE_SUCCESS == rcode );
+}
+
+
+/**
+* Read page of models.
+*
+* Caller must call test_model_list_free() on models_out and
+* cqlite_page_token_free() on token_out.
+*/
+int test_model_page_read
+    (
+    cqlite_page_t *                 page,
+    cqlite_page_token_t const *     token,
+    test_model_list_t *             models_out,
+    cqlite_page_token_t **          token_out
+    )
+{
+cqlite_rcode_t rcode;
+
+test_model_list_init( models_out );
+
+rcode = cqlite_page_read( page, token, test_model_add_to_list, sizeof( test_model_t ), (void**)&models_out->list, &models_out->cnt, token_out );
+
+return ( CQLITE_SUCCESS == rcode );
+}
+
+
+/**
+* Total all models through a pipelined query.
+*
+* Decodes the models on a producer thread into a ring of slot_cnt
+* models. Processing fails once stop_after_cnt models were totaled,
+* unless stop_after_cnt is 0.
+*/
+int test_model_pipeline_totals
+    (
+    sqlite3 *               db,
+    int                     slot_cnt,
+    sqlite3_int64           stop_after_cnt,
+    test_model_totals_t *   totals_out
+    )
+{
+cqlite_rcode_t      rcode;
+pipeline_totals_t   context;
+
+memset( totals_out, 0, sizeof( *totals_out ) );
+
+context.totals = totals_out;
+context.stop_after_cnt = stop_after_cnt;
+
+rcode = cqlite_pipeline_query_execute( db, TEST_TABLE_SELECT_ALL, test_model_from_row_result, test_model_free_func, sizeof( test_model_t ), slot_cnt, test_model_totals_process, &context );
+
+return ( CQLITE_SUCCESS == rcode );
+}
+
+
+/**
+* Find model by id using a connection pool.
+*
+* Caller must call test_model_free() on model_out.
+*/
+int test_model_find_by_id_pooled
+    (
+    cqlite_pool_t * pool,
+    sqlite3_int64   id,
+    int *           found_out,
+    test_model_t *  model_out
+    )
+{
+cqlite_rcode_t rcode;
+
+*found_out = 0;
+test_model_init( model_out );
+
+rcode = cqlite_pool_find_by_id( pool, TEST_TABLE_SELECT_BY_ID, id, test_model_from_row_result, found_out, model_out );
+
+return ( CQLITE_SUCCESS == rcode );
+}    
+
+
+/**
+* Insert many new models.
+*
+* Inserts the provided models as new records into the database in
+* transactions of batch_size models. This will modify the provided
+* models with their generated insert ids.
+*/
+int test_model_insert_many
+    (
+    sqlite3 *           db,
+    test_model_list_t * models,
+    int                 batch_size
+    )
+{
+int             success;
+int             i;
+sqlite_int64 *  row_ids = NULL;
+
+success = ( CQLITE_SUCCESS == cqlite_insert_many( db, TEST_TABLE_INSERT, test_model_bind_fields, models->list, sizeof( test_model_t ), models->cnt, batch_size, &row_ids ) );
+
+for( i = 0; success && ( i < models->cnt ); i++ )
+    {
+    models->list[i].id = row_ids[i];
+    }
+
+// Clean up
+free( row_ids );
+
+return success;
+}    
+
+
+/**
+* Select all models.
+*
+* Selects all models ordered by id, either using a COUNT query to
+* size the result list up front or in a single pass. Caller must call
+* test_model_list_free() on models_out.
+*/
+int test_model_select_all
+    (
+    sqlite3 *           db,
+    select_mode_t       select_mode,
+    test_model_list_t * models_out
+    )
+{
+cqlite_rcode_t      rcode;
+char const *        count_query_str;
+
+test_model_list_init( models_out );
+
+count_query_str = ( SELECT_MODE_COUNTED == select_mode ) ? TEST_TABLE_COUNT_ALL : NULL;
+
+rcode = cqlite_select_query_execute( db, TEST_TABLE_SELECT_ALL, count_query_str, test_model_add_to_list, sizeof( test_model_t ), (void**)&models_out->list, &models_out->cnt );
+
+return ( CQLITE_SUCCESS == rcode );
+}    
+
+
+/**
+* Select all models in parallel.
+*
+* Selects all models ordered by id, splitting the ids into partition_cnt
+* ranges read concurrently on the pool's read connections. Caller must
+* call test_model_list_free() on models_out.
+*/
+int test_model_select_all_parallel
+    (
+    cqlite_pool_t *     pool,
+    select_mode_t       select_mode,
+    int                 partition_cnt,
+    test_model_list_t * models_out
+    )
+{
+cqlite_rcode_t      rcode;
+char const *        count_query_str;
+
+test_model_list_init( models_out );
+
+count_query_str = ( SELECT_MODE_COUNTED == select_mode ) ? TEST_TABLE_COUNT_RANGE : NULL;
+
+rcode = cqlite_parallel_select_query_execute( pool, TEST_TABLE_ID_BOUNDS, TEST_TABLE_SELECT_RANGE, count_query_str, test_model_add_to_list, sizeof( test_model_t ), partition_cnt, (void**)&models_out->list, &models_out->cnt );
+
+return ( CQLITE_SUCCESS == rcode );
+}
+
+
+/**
+* Select all models using a query result cache.
+*
+* Caller must call cqlite_cached_result_release() on result_out.
+*/
+int test_model_select_all_cached
+    (
+    cqlite_result_cache_t *     cache,
+    cqlite_cached_result_t **   result_out
+    )
+{
+cqlite_rcode_t rcode;
+
+rcode = cqlite_result_cache_select_query_execute( cache, TEST_TABLE_SELECT_ALL, TEST_TABLE_COUNT_ALL, NULL, NULL, test_model_add_to_list, test_model_free_func, sizeof( test_model_t ), result_out );
+
+return ( CQLITE_SUCCESS == rcode );
+}
+
+
+/**
+* Select models in id range using a query result cache.
+*
+* Caller must call cqlite_cached_result_release() on result_out.
+*/
+int test_model_select_range_cached
+    (
+    cqlite_result_cache_t *     cache,
+    sqlite3_int64               min_id,
+    sqlite3_int64               max_id,
+    cqlite_cached_result_t **   result_out
+    )
+{
+cqlite_rcode_t  rcode;
+id_range_t      range;
+
+range.min_id = min_id;
+range.max_id = max_id;
+
+rcode = cqlite_result_cache_select_query_execute( cache, TEST_TABLE_SELECT_RANGE, TEST_TABLE_COUNT_RANGE, test_id_range_bind, &range, test_model_add_to_list, test_model_free_func, sizeof( test_model_t ), result_out );
+
+return ( CQLITE_SUCCESS == rcode );
+}
+
+
+/**
+* Select models by real field using a query result cache.
+*
+* Caller must call cqlite_cached_result_release() on result_out.
+*/
+int test_model_select_by_real_cached
+    (
+    cqlite_result_cache_t *     cache,
+    double                      real_field,
+    cqlite_cached_result_t **   result_out
+    )
+{
+cqlite_rcode_t rcode;
+
+rcode = cqlite_result_cache_select_query_execute( cache, TEST_TABLE_SELECT_BY_REAL, NULL, test_real_bind, &real_field, test_model_add_to_list, test_model_free_func, sizeof( test_model_t ), result_out );
+
+return ( CQLITE_SUCCESS == rcode );
+}
+
+
+/**
+* Select all models using a connection pool.
+*
+* Selects all models ordered by id in a single pass on one of the pool's
+* read connections. Caller must call test_model_list_free() on
+* models_out.
+*/
+int test_model_select_all_pooled
+    (
+    cqlite_pool_t *     pool,
+    test_model_list_t * models_out
+    )
+{
+cqlite_rcode_t rcode;
+
+test_model_list_init( models_out );
+
+rcode = cqlite_pool_select_query_execute( pool, TEST_TABLE_SELECT_ALL, NULL, test_model_add_to_list, sizeof( test_model_t ), (void**)&models_out->list, &models_out->cnt );
+
+return ( CQLITE_SUCCESS == rcode );
+}    
+
+
+/**
+* Select all models using column descriptors.
+*
+* Selects all models ordered by id in a single pass, reading them with
+* the test table's column descriptors. Caller must call
+* test_model_list_free() on models_out.
+*/
+int test_model_select_all_mapped
+    (
+    sqlite3 *           db,
+    test_model_list_t * models_out
+    )
+{
+cqlite_rcode_t rcode;
+
+test_model_list_init( models_out );
+
+rcode = cqlite_mapping_select_query_execute( db, TEST_TABLE_SELECT_ALL, NULL, TEST_TABLE_COLUMNS, TEST_TABLE_COLUMN_CNT, sizeof( test_model_t ), (void**)&models_out->list, &models_out->cnt );
+
+return ( CQLITE_SUCCESS == rcode );
+}    
+
+
+/**
+* Select all models using an arena.
+*
+* Selects all models ordered by id in a single pass with their strings
+* allocated from arena_out. Caller must call free() on models_out->list
+* and cqlite_arena_free() on arena_out.
+*/
+int test_model_select_all_arena
+    (
+    sqlite3 *           db,
+    test_model_list_t * models_out,
+    cqlite_arena_t **   arena_out
+    )
+{
+cqlite_rcode_t rcode;
+
+test_model_list_init( models_out );
+
+rcode = cqlite_arena_select_query_execute( db, TEST_TABLE_SELECT_ALL, NULL, test_model_add_to_list_arena, sizeof( test_model_t ), (void**)&models_out->list, &models_out->cnt, arena_out );
+
+return ( CQLITE_SUCCESS == rcode );
+}    
+
+
+/**
+* Select all models into columns.
+*
+* Selects all models ordered by id into one array per column of the
+* test table. Caller must call cqlite_columnar_result_free() on
+* result_out.
+*/
+int test_model_select_all_columnar
+    (
+    sqlite3 *                   db,
+    select_mode_t               select_mode,
+    cqlite_columnar_result_t *  result_out
+    )
+{
+cqlite_rcode_t      rcode;
+char const *        count_query_str;
+
+count_query_str = ( SELECT_MODE_COUNTED == select_mode ) ? TEST_TABLE_COUNT_ALL : NULL;
+
+rcode = cqlite_columnar_select_query_execute( db, TEST_TABLE_SELECT_ALL, count_query_str, TEST_TABLE_COLUMNAR_TYPES, TEST_TABLE_COLUMNAR_TYPE_CNT, result_out );
+
+return ( CQLITE_SUCCESS == rcode );
+}
+
+
+/**
+* Select all models into a segmented list.
+*
+* Selects all models ordered by id in a single pass. Caller must call
+* test_model_segmented_list_free() on list_out.
+*/
+int test_model_select_all_segmented
+    (
+    sqlite3 *                   db,
+    cqlite_segmented_list_t **  list_out
+    )
+{
+cqlite_rcode_t rcode;
+
+rcode = cqlite_segmented_select_query_execute( db, TEST_TABLE_SELECT_ALL, test_model_from_row_result, test_model_free_func, sizeof( test_model_t ), list_out );
+
+return ( CQLITE_SUCCESS == rcode );
+}
+
+
+/**
+* Free segmented list of test models.
+*/
+void test_model_segmented_list_free
+    (
+    cqlite_segmented_list_t *   list
+    )
+{
+cqlite_segmented_list_free( list, test_model_free_func );
+}
+
+
+/**
+* Add test model to result list.
+*/
+static int test_model_add_to_list
+    (
+    sqlite3_stmt *  query,             
+    void *          model_list,        
+    int             next_model_list_idx
+    )
+{
+test_model_t * test_models;
+
+test_models = (test_model_t*)model_list;
+
+return test_model_from_row_result( query, &test_models[next_model_list_idx] );
+}    
+
+
+/**
+* Add test model to result list using an arena.
+*/
+static int test_model_add_to_list_arena
+    (
+    sqlite3_stmt *      query,
+    void *              model_list,
+    int                 next_model_list_idx,
+    cqlite_arena_t *    arena
+    )
+{
+test_model_t * test_models;
+
+test_models = (test_model_t*)model_list;
+
+return test_model_from_row_result_arena( query, arena, &test_models[next_model_list_idx] );
+}
+
+
+/**
+* Read test model from query row result.
+*/
+static int test_model_from_row_result
+    (
+    sqlite3_stmt *  query,   
+    void *          model_out
+    )
+{
+return test_model_from_row_result_arena( query, NULL, (test_model_t*)model_out );
+}
+
+
+/**
+* Read test model from query row result using an arena.
+*
+* If arena is NULL, the dynamic string is allocated with malloc().
+*/
+static int test_model_from_row_result_arena
+    (
+    sqlite3_stmt *      query,
+    cqlite_arena_t *    arena,
+    test_model_t *      test_model
+    )
+{
+int success;
+
+test_model_init( test_model );
+
+test_model->id = sqlite3_column_int64( query, TEST_TABLE_ID_COL );
+test_model->real_field = sqlite3_column_double( query, TEST_TABLE_REAL_FIELD_COL );
+test_model->int_field = sqlite3_column_int( query, TEST_TABLE_INT_FIELD_COL );
+
+if( NULL != arena )
+    {
+    success = ( CQLITE_SUCCESS == cqlite_arena_string_read( query, TEST_TABLE_DYNAMIC_STRING_FIELD_COL, arena, &test_model->dynamic_string_field ) );
+    }
+else
+    {
+    success = ( CQLITE_SUCCESS == cqlite_dynamic_string_read( query, TEST_TABLE_DYNAMIC_STRING_FIELD_COL, &test_model->dynamic_string_field ) );
+    }
+
+if( success )
+    {
+    success = ( CQLITE_SUCCESS == cqlite_fixed_length_string_read( query, TEST_TABLE_FIXED_STRING_FIELD_COL, test_model->fixed_string_field, sizeof( test_model->fixed_string_field ) ) );
+    }
+
+return success;
+}
+
+
+/**
+* Free test model.
+*
+* Adapts test_model_free() to cqlite_model_free_func_t.
+*/
+static void test_model_free_func
+    (
+    void * model
+    )
+{
+test_model_free( (test_model_t*)model );
+}
+
+
+/**
+* Bind test model fields to insert query.
+*
+* Binds every field except for the id so that a new record is inserted.
+*/
+static int test_model_bind_fields
+    (
+    sqlite3_stmt *  insert_query,
+    void const *    model
+    )
+{
+test_model_t const * test_model;
+
+test_model = (test_model_t const*)model;
+
+// Why are query parameters 1-indexed and query results 0-indexed?
+return ( SQLITE_OK == sqlite3_bind_double( insert_query, (TEST_TABLE_REAL_FIELD_COL + 1), test_model->real_field ) ) &&
+       ( SQLITE_OK == sqlite3_bind_int( insert_query, (TEST_TABLE_INT_FIELD_COL + 1), test_model->int_field ) ) &&
+       ( SQLITE_OK == sqlite3_bind_text( insert_query, (TEST_TABLE_DYNAMIC_STRING_FIELD_COL + 1), test_model->dynamic_string_field, READ_TO_END, SQLITE_TRANSIENT ) ) &&
+       ( SQLITE_OK == sqlite3_bind_text( insert_query, (TEST_TABLE_FIXED_STRING_FIELD_COL + 1), test_model->fixed_string_field, READ_TO_END, SQLITE_TRANSIENT ) );
+}
+
+
+/**
+* Fold test model row into totals.
+*
+* Fails if the ids are not in ascending order.
+*/
+static int test_model_totals_fold
+    (
+    sqlite3_stmt *  query,
+    void *          accumulator
+    )
+{
+int                     success;
+sqlite3_int64           id;
+test_model_totals_t *   totals;
+
+totals = (test_model_totals_t*)accumulator;
+id = sqlite3_column_int64( query, TEST_TABLE_ID_COL );
+
+success = ( 0 == totals->row_cnt ) || ( id > totals->last_id );
+
+if( success )
+    {
+    if( 0 == totals->row_cnt )
+        {
+        totals->first_id = id;
+        }
+
+    totals->row_cnt++;
+    totals->int_field_sum += sqlite3_column_int( query, TEST_TABLE_INT_FIELD_COL );
+    totals->last_id = id;
+    }
+
+return success;
+}
+
+
+/**
+* Merge partition totals into totals.
+*
+* Fails if the partitions are not merged in ascending id order.
+*/
+static int test_model_totals_merge
+    (
+    void *          accumulator,
+    void const *    partition_accumulator
+    )
+{
+int                         success;
+test_model_totals_t *       totals;
+test_model_totals_t const * partition_totals;
+
+totals = (test_model_totals_t*)accumulator;
+partition_totals = (test_model_totals_t const*)partition_accumulator;
+
+success = ( 0 == totals->row_cnt ) || ( 0 == partition_totals->row_cnt ) || ( partition_totals->first_id > totals->last_id );
+
+if( success && ( partition_totals->row_cnt > 0 ) )
+    {
+    if( 0 == totals->row_cnt )
+        {
+        totals->first_id = partition_totals->first_id;
+        }
+
+    totals->row_cnt += partition_totals->row_cnt;
+    totals->int_field_sum += partition_totals->int_field_sum;
+    totals->last_id = partition_totals->last_id;
+    }
+
+return success;
+}
+
+
+/**
+* Process decoded test model into totals.
+*
+* Fails if the ids are not in ascending order, or once the context's
+* stop count is reached.
+*/
+static int test_model_totals_process
+    (
+    void *          model,
+    void *          context
+    )
+{
+int                     success;
+test_model_t const *    test_model;
+pipeline_totals_t *     pipeline_totals;
+test_model_totals_t *   totals;
+
+test_model = (test_model_t const*)model;
+pipeline_totals = (pipeline_totals_t*)context;
+totals = pipeline_totals->totals;
+
+success = ( ( 0 == totals->row_cnt ) || ( test_model->id > totals->last_id ) ) &&
+          ( ( 0 == pipeline_totals->stop_after_cnt ) || ( totals->row_cnt < pipeline_totals->stop_after_cnt ) );
+
+if( success )
+    {
+    if( 0 == totals->row_cnt )
+        {
+        totals->first_id = test_model->id;
+        }
+
+    totals->row_cnt++;
+    totals->int_field_sum += test_model->int_field;
+    totals->last_id = test_model->id;
+    }
+
+return success;
+}
+
+
+/**
+* Bind id range to range query.
+*/
+static int test_id_range_bind
+    (
+    sqlite3_stmt *  query,
+    void const *    params
+    )
+{
+id_range_t const * range;
+
+range = (id_range_t const*)params;
+
+return ( SQLITE_OK == sqlite3_bind_int64( query, 1, range->min_id ) ) &&
+       ( SQLITE_OK == sqlite3_bind_int64( query, 2, range->max_id ) );
+}
+
+
+/**
+* Bind real field.
+*
+* Implements cqlite_model_bind_func_t for a single double.
+*/
+static int test_real_bind
+    (
+    sqlite3_stmt *  query,
+    void const *    params
+    )
+{
+return ( SQLITE_OK == sqlite3_bind_double( query, 1, *(double const*)params ) );
+}
+
+
+/**
+* Prepare insert query for test model.
+*
+* The caller must call sqlite3_finalize on query_out.
+*/
+static int test_model_insert_query_prepare
+    (
+    sqlite3 *               db,
+    test_model_t const *    model,
+    insert_mode_t           insert_mode,
+    sqlite3_stmt **         query_out
+    )
+{
+int             success;
+sqlite3_stmt *  insert_query = NULL;
+
+*query_out = NULL;
+
+success = ( SQLITE_OK == sqlite3_prepare_v2( db, TEST_TABLE_INSERT, READ_TO_END, &insert_query, NO_TAIL ) );
+
+if( success )
+    {
+    success = test_model_bind_fields( insert_query, model );
+    }
+
+if( success && ( INSERT_MODE_EXISTING_RECORD == insert_mode ) )
+    {
+    success = ( SQLITE_OK == sqlite3_bind_int64( insert_query, (TEST_TABLE_ID_COL + 1), model->id ) );
+    }
+
+// Set the output or clean up on error
+if( success )
+    {
+    *query_out = insert_query;
+    }
+else
+    {
+    sqlite3_finalize( insert_query );
+    }
+
+return success;
+}    
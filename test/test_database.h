@@ -2,6 +2,26 @@
 #define _TEST_DATABASE_H
 
 #include <sqlite3.h>
+#include <stdint.h>
+
+#include "cqlite_arena.h"
+#include "cqlite_blob.h"
+#include "cqlite_columnar.h"
+#include "cqlite_cursor.h"
+#include "cqlite_fold.h"
+#include "cqlite_import.h"
+#include "cqlite_mapping.h"
+#include "cqlite_open.h"
+#include "cqlite_page.h"
+#include "cqlite_parallel.h"
+#include "cqlite_pipeline.h"
+#include "cqlite_pool.h"
+#include "cqlite_result_cache.h"
+#include "cqlite_segmented.h"
+#include "cqlite_stats.h"
+#include "cqlite_stmt_cache.h"
+#include "cqlite_trace.h"
+#include "cqlite_writer.h"
 
 typedef struct
     {
@@ -12,12 +32,37 @@ typedef struct
     char            fixed_string_field[4];
     } test_model_t;
 
+// Fixed-layout record of a binary import file
+typedef struct
+    {
+    sqlite3_int64   id;
+    double          real_field;
+    int32_t         int_field;
+    char            dynamic_string_field[16];
+    char            fixed_string_field[4];
+    } test_record_t;
+
 typedef struct
     {
     test_model_t *  list;
     int             cnt;
     } test_model_list_t;
 
+// Accumulator of the test model folds
+typedef struct
+    {
+    sqlite3_int64   row_cnt;
+    sqlite3_int64   int_field_sum;
+    sqlite3_int64   first_id;
+    sqlite3_int64   last_id;
+    } test_model_totals_t;
+
+typedef enum
+    {
+    SELECT_MODE_COUNTED,
+    SELECT_MODE_SINGLE_PASS,
+    } select_mode_t;
+
 
 /**********************************************
 Data type functions
@@ -67,6 +112,34 @@ int test_database_init
     sqlite3 * db
     );
 
+int test_model_cursor_open
+    (
+    sqlite3 *           db,
+    int                 batch_size,
+    cqlite_cursor_t **  cursor_out
+    );
+
+int test_model_count_cached
+    (
+    cqlite_result_cache_t * cache,
+    int *                   count_out
+    );
+
+int test_model_fold_totals
+    (
+    sqlite3 *               db,
+    sqlite3_int64           initial_sum,
+    test_model_totals_t *   totals_out
+    );
+
+int test_model_fold_totals_parallel
+    (
+    cqlite_pool_t *         pool,
+    int                     partition_cnt,
+    sqlite3_int64           initial_sum,
+    test_model_totals_t *   totals_out
+    );
+
 int test_model_find_by_id
     (
     sqlite3 *       db,
@@ -75,10 +148,195 @@ int test_model_find_by_id
     test_model_t *  model_out
     );
 
+int test_model_find_by_id_cached
+    (
+    cqlite_stmt_cache_t *   cache,
+    sqlite3_int64           id,
+    int *                   found_out,
+    test_model_t *          model_out
+    );
+
+int test_model_find_many_by_ids
+    (
+    sqlite3 *               db,
+    sqlite3_int64 const *   ids,
+    int                     id_cnt,
+    test_model_list_t *     models_out,
+    unsigned char *         found_bits
+    );
+
+int test_model_find_many_by_ids_cached
+    (
+    cqlite_stmt_cache_t *   cache,
+    sqlite3_int64 const *   ids,
+    int                     id_cnt,
+    test_model_list_t *     models_out,
+    unsigned char *         found_bits
+    );
+
+int test_model_page_create
+    (
+    sqlite3 *           db,
+    int                 page_size,
+    int                 is_descending,
+    cqlite_page_t **    page_out
+    );
+
+int test_model_page_read
+    (
+    cqlite_page_t *                 page,
+    cqlite_page_token_t const *     token,
+    test_model_list_t *             models_out,
+    cqlite_page_token_t **          token_out
+    );
+
+int test_model_pipeline_totals
+    (
+    sqlite3 *               db,
+    int                     slot_cnt,
+    sqlite3_int64           stop_after_cnt,
+    test_model_totals_t *   totals_out
+    );
+
+int test_model_find_by_id_pooled
+    (
+    cqlite_pool_t * pool,
+    sqlite3_int64   id,
+    int *           found_out,
+    test_model_t *  model_out
+    );
+
+int test_model_import_binary
+    (
+    sqlite3 *       db,
+    char const *    path,
+    int             batch_size,
+    int             use_parse_thread,
+    sqlite3_int64 * row_cnt_out
+    );
+
+int test_model_import_csv
+    (
+    sqlite3 *       db,
+    char const *    path,
+    int             batch_size,
+    int             use_parse_thread,
+    sqlite3_int64 * row_cnt_out
+    );
+
+int test_model_insert_many
+    (
+    sqlite3 *           db,
+    test_model_list_t * models,
+    int                 batch_size
+    );
+
+int test_model_insert_async
+    (
+    cqlite_writer_t *               writer,
+    test_model_t const *            model,
+    cqlite_writer_complete_func_t   complete_func,
+    void *                          context,
+    cqlite_writer_job_t **          job_out
+    );
+
+int test_model_insert_many_cached
+    (
+    cqlite_stmt_cache_t *   cache,
+    test_model_list_t *     models,
+    int                     batch_size
+    );
+
+int test_model_insert_many_mapped
+    (
+    sqlite3 *           db,
+    test_model_list_t * models,
+    int                 batch_size
+    );
+
 int test_model_insert_new
     (
     sqlite3 *       db,
     test_model_t *  model
     );
 
+int test_model_insert_new_mapped
+    (
+    sqlite3 *       db,
+    test_model_t *  model
+    );
+
+int test_model_select_all
+    (
+    sqlite3 *           db,
+    select_mode_t       select_mode,
+    test_model_list_t * models_out
+    );
+
+int test_model_select_all_parallel
+    (
+    cqlite_pool_t *     pool,
+    select_mode_t       select_mode,
+    int                 partition_cnt,
+    test_model_list_t * models_out
+    );
+
+int test_model_select_all_cached
+    (
+    cqlite_result_cache_t *     cache,
+    cqlite_cached_result_t **   result_out
+    );
+
+int test_model_select_range_cached
+    (
+    cqlite_result_cache_t *     cache,
+    sqlite3_int64               min_id,
+    sqlite3_int64               max_id,
+    cqlite_cached_result_t **   result_out
+    );
+
+int test_model_select_by_real_cached
+    (
+    cqlite_result_cache_t *     cache,
+    double                      real_field,
+    cqlite_cached_result_t **   result_out
+    );
+
+int test_model_select_all_pooled
+    (
+    cqlite_pool_t *     pool,
+    test_model_list_t * models_out
+    );
+
+int test_model_select_all_mapped
+    (
+    sqlite3 *           db,
+    test_model_list_t * models_out
+    );
+
+int test_model_select_all_arena
+    (
+    sqlite3 *           db,
+    test_model_list_t * models_out,
+    cqlite_arena_t **   arena_out
+    );
+
+int test_model_select_all_columnar
+    (
+    sqlite3 *                   db,
+    select_mode_t               select_mode,
+    cqlite_columnar_result_t *  result_out
+    );
+
+int test_model_select_all_segmented
+    (
+    sqlite3 *                   db,
+    cqlite_segmented_list_t **  list_out
+    );
+
+void test_model_segmented_list_free
+    (
+    cqlite_segmented_list_t *   list
+    );
+
 #endif
\ No newline at end of file
@@ -0,0 +1,1073 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_NAME_LEN        ( 63 )
+#define MAX_FIELD_CNT       ( 64 )
+#define MAX_LINE_LEN        ( 256 )
+#define MAX_PARAMS_LEN      ( 1024 )
+#define NO_KEY              ( -1 )
+#define TAB_WIDTH           ( 4 )
+#define TAB_ALIGN( len )    ( ( ( ( len ) / TAB_WIDTH ) + 1 ) * TAB_WIDTH )
+
+
+/**********************************************
+Types
+**********************************************/
+typedef enum
+    {
+    FIELD_INT,
+    FIELD_INT64,
+    FIELD_DOUBLE,
+    FIELD_DYNAMIC_STRING,
+    FIELD_FIXED_STRING,
+    FIELD_TYPE_CNT,
+    } field_type_t;
+
+typedef struct
+    {
+    char const *    name;           //!< Name of the type in model descriptions
+    char const *    c_type;         //!< C type of fields of the type
+    char const *    column_func;    //!< SQLite function reading a result of the type, NULL for strings
+    char const *    bind_func;      //!< SQLite function binding a parameter of the type, NULL for strings
+    } field_type_info_t;
+
+typedef struct
+    {
+    char            name[MAX_NAME_LEN + 1]; //!< Name of the field and of its column
+    field_type_t    type;                   //!< Type of the field
+    int             size;                   //!< Size of CQLITE_FIELD_FIXED_STRING fields, including the NUL terminator
+    } field_t;
+
+typedef struct
+    {
+    char            name[MAX_NAME_LEN + 1];     //!< Name of the model, prefix of the generated names
+    char            upper[MAX_NAME_LEN + 1];    //!< Upper case name of the model, prefix of the generated macros
+    char            table[MAX_NAME_LEN + 1];    //!< Name of the table the model is stored in
+    field_t         fields[MAX_FIELD_CNT];      //!< Fields of the model in column order
+    int             field_cnt;                  //!< Number of fields
+    int             key_idx;                    //!< Index of the INTEGER PRIMARY KEY field, NO_KEY if none
+    int             has_strings;                //!< Does the model have string fields?
+    } model_t;
+
+
+/**********************************************
+Variables
+**********************************************/
+
+// The type names match the CQLITE_FIELD_* types of cqlite_mapping.h
+static field_type_info_t const FIELD_TYPES[FIELD_TYPE_CNT] =
+    {
+    [FIELD_INT]             = { "int",            "int",          "sqlite3_column_int",    "sqlite3_bind_int"    },
+    [FIELD_INT64]           = { "int64",          "sqlite_int64", "sqlite3_column_int64",  "sqlite3_bind_int64"  },
+    [FIELD_DOUBLE]          = { "double",         "double",       "sqlite3_column_double", "sqlite3_bind_double" },
+    [FIELD_DYNAMIC_STRING]  = { "dynamic_string", "char *",       NULL,                    NULL                  },
+    [FIELD_FIXED_STRING]    = { "fixed_string",   "char",         NULL,                    NULL                  },
+    };
+
+
+/**********************************************
+Functions
+**********************************************/
+static void column_list_write
+    (
+    model_t const * model,
+    int             skip_key,
+    FILE *          out
+    );
+
+static int field_parse
+    (
+    char *      args,
+    model_t *   model
+    );
+
+static void header_write
+    (
+    model_t const * model,
+    char const *    model_path,
+    char const *    header_name,
+    FILE *          out
+    );
+
+static int identifier_is_valid
+    (
+    char const * identifier
+    );
+
+static int model_parse
+    (
+    char const *    model_path,
+    model_t *       model_out
+    );
+
+static void prototype_write
+    (
+    char const *    return_type,
+    char const *    func_name,
+    char const *    params,
+    char const *    terminator,
+    FILE *          out
+    );
+
+static void source_write
+    (
+    model_t const * model,
+    char const *    model_path,
+    char const *    header_name,
+    FILE *          out
+    );
+
+
+int main
+    (
+    int     argc,
+    char ** argv
+    )
+{
+int             success;
+model_t         model;
+char const *    header_name;
+FILE *          source_file = NULL;
+FILE *          header_file = NULL;
+
+success = ( 4 == argc );
+
+if( !success )
+    {
+    fprintf( stderr, "usage: %s <model file> <output source> <output header>\n", argv[0] );
+    }
+
+if( success )
+    {
+    success = model_parse( argv[1], &model );
+    }
+
+if( success )
+    {
+    source_file = fopen( argv[2], "w" );
+    header_file = fopen( argv[3], "w" );
+    success = ( NULL != source_file ) && ( NULL != header_file );
+
+    if( !success )
+        {
+        fprintf( stderr, "%s: failed to open output files\n", argv[1] );
+        }
+    }
+
+// The source includes the header by its name alone, so both must be
+// generated into the same directory.
+if( success )
+    {
+    header_name = strrchr( argv[3], '/' );
+    header_name = ( NULL != header_name ) ? ( header_name + 1 ) : argv[3];
+
+    header_write( &model, argv[1], header_name, header_file );
+    source_write( &model, argv[1], header_name, source_file );
+
+    success = !ferror( source_file ) && !ferror( header_file );
+    }
+
+// Clean up
+if( ( NULL != source_file ) && ( 0 != fclose( source_file ) ) )
+    {
+    success = 0;
+    }
+
+if( ( NULL != header_file ) && ( 0 != fclose( header_file ) ) )
+    {
+    success = 0;
+    }
+
+// Leave no partial output behind for the build to pick up
+if( !success && ( 4 == argc ) )
+    {
+    remove( argv[2] );
+    remove( argv[3] );
+    }
+
+return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/**
+* Write column list.
+*
+* Writes the quoted column names of the model separated by commas,
+* escaped for a C string literal.
+*/
+static void column_list_write
+    (
+    model_t const * model,
+    int             skip_key,
+    FILE *          out
+    )
+{
+int i;
+int is_first = 1;
+
+for( i = 0; i < model->field_cnt; i++ )
+    {
+    if( !skip_key || ( i != model->key_idx ) )
+        {
+        fprintf( out, "%s\\\"%s\\\"", is_first ? "" : ", ", model->fields[i].name );
+        is_first = 0;
+        }
+    }
+}
+
+
+/**
+* Parse field line.
+*
+* Parses the arguments of a field line into the next field of the
+* model: a name, a type, the size of fixed_string fields, and an
+* optional "key" flag. Returns 1 on success, 0 on error.
+*/
+static int field_parse
+    (
+    char *      args,
+    model_t *   model
+    )
+{
+int             success;
+int             i;
+char *          name;
+char *          type;
+char *          token;
+field_t *       field;
+
+name = strtok( args, " \t\r\n" );
+type = strtok( NULL, " \t\r\n" );
+
+success = ( model->field_cnt < MAX_FIELD_CNT ) &&
+          ( NULL != name ) && identifier_is_valid( name ) &&
+          ( NULL != type );
+
+if( success )
+    {
+    field = &model->fields[model->field_cnt];
+    field->size = 0;
+
+    strcpy( field->name, name );
+
+    for( i = 0; ( i < FIELD_TYPE_CNT ) && ( 0 != strcmp( type, FIELD_TYPES[i].name ) ); i++ )
+        {
+        }
+
+    field->type = (field_type_t)i;
+    success = ( i < FIELD_TYPE_CNT );
+    }
+
+// Fixed strings need room for at least one character and the terminator
+if( success && ( FIELD_FIXED_STRING == field->type ) )
+    {
+    token = strtok( NULL, " \t\r\n" );
+    field->size = ( NULL != token ) ? atoi( token ) : 0;
+    success = ( field->size > 1 );
+    }
+
+token = strtok( NULL, " \t\r\n" );
+
+// Only an INTEGER PRIMARY KEY can be the key, since inserts read it
+// back as the row id.
+if( success && ( NULL != token ) )
+    {
+    success = ( 0 == strcmp( token, "key" ) ) &&
+              ( FIELD_INT64 == field->type ) &&
+              ( NO_KEY == model->key_idx ) &&
+              ( NULL == strtok( NULL, " \t\r\n" ) );
+
+    if( success )
+        {
+        model->key_idx = model->field_cnt;
+        }
+    }
+
+if( success )
+    {
+    model->has_strings = model->has_strings || ( FIELD_DYNAMIC_STRING == field->type ) || ( FIELD_FIXED_STRING == field->type );
+    model->field_cnt++;
+    }
+
+return success;
+}
+
+
+/**
+* Write header.
+*
+* Writes the model type, the query strings, the inline decode and bind
+* functions, and the prototypes of the wrappers.
+*/
+static void header_write
+    (
+    model_t const * model,
+    char const *    model_path,
+    char const *    header_name,
+    FILE *          out
+    )
+{
+int             i;
+int             column;
+int             param;
+size_t          type_width = 0;
+char            guard[MAX_LINE_LEN];
+char            func_name[MAX_LINE_LEN];
+char            params[MAX_PARAMS_LEN];
+field_t const * field;
+
+// Guard derived from the header's file name
+for( i = 0; ( '\0' != header_name[i] ) && ( i < (int)sizeof( guard ) - 1 ); i++ )
+    {
+    guard[i] = isalnum( (unsigned char)header_name[i] ) ? (char)toupper( (unsigned char)header_name[i] ) : '_';
+    }
+
+guard[i] = '\0';
+
+for( i = 0; i < model->field_cnt; i++ )
+    {
+    if( strlen( FIELD_TYPES[model->fields[i].type].c_type ) > type_width )
+        {
+        type_width = strlen( FIELD_TYPES[model->fields[i].type].c_type );
+        }
+    }
+
+fprintf( out, "/** @file\n*\n* Generated by cqlite_gen from %s, do not edit.\n*/\n\n", model_path );
+fprintf( out, "#ifndef _%s\n#define _%s\n\n", guard, guard );
+fprintf( out, "#include <sqlite3.h>\n#include <stdlib.h>\n#include <string.h>\n\n#include \"cqlite.h\"\n\n" );
+
+// Query strings
+fprintf( out, "#define %s_SELECT_ALL_QUERY \"SELECT ", model->upper );
+column_list_write( model, 0, out );
+fprintf( out, " FROM \\\"%s\\\";\"\n", model->table );
+
+if( NO_KEY != model->key_idx )
+    {
+    fprintf( out, "#define %s_FIND_BY_ID_QUERY \"SELECT ", model->upper );
+    column_list_write( model, 0, out );
+    fprintf( out, " FROM \\\"%s\\\" WHERE \\\"%s\\\" = ?1;\"\n", model->table, model->fields[model->key_idx].name );
+    }
+
+fprintf( out, "#define %s_INSERT_QUERY \"INSERT INTO \\\"%s\\\" ( ", model->upper, model->table );
+column_list_write( model, 1, out );
+fprintf( out, " ) VALUES ( " );
+
+for( i = 0, param = 1; i < model->field_cnt; i++ )
+    {
+    if( i != model->key_idx )
+        {
+        fprintf( out, "%s?%d", ( param > 1 ) ? ", " : "", param );
+        param++;
+        }
+    }
+
+fprintf( out, " );\"\n\n" );
+
+// Model type
+fprintf( out, "/**\n* %s model.\n*/\ntypedef struct\n    {\n", model->name );
+
+for( i = 0; i < model->field_cnt; i++ )
+    {
+    field = &model->fields[i];
+
+    if( FIELD_FIXED_STRING == field->type )
+        {
+        fprintf( out, "    %-*s%s[%d];\n", (int)TAB_ALIGN( type_width ), FIELD_TYPES[field->type].c_type, field->name, field->size );
+        }
+    else
+        {
+        fprintf( out, "    %-*s%s;\n", (int)TAB_ALIGN( type_width ), FIELD_TYPES[field->type].c_type, field->name );
+        }
+    }
+
+fprintf( out, "    } %s_t;\n\n", model->name );
+
+// Bind function
+fprintf( out,
+         "/**\n"
+         "* Bind %s model to query.\n"
+         "*\n"
+         "* Binds every field except the key to parameters ?1 to ?N in field\n"
+         "* order. Strings are bound without being copied, so the model must\n"
+         "* not change until the query is reset.\n"
+         "*/\n",
+         model->name );
+snprintf( func_name, sizeof( func_name ), "%s_bind", model->name );
+snprintf( params, sizeof( params ), "sqlite3_stmt *, query, Prepared query to bind the model to;%s_t const *, model, Model whose fields are bound", model->name );
+prototype_write( "static inline int", func_name, params, "", out );
+fprintf( out, "{\nint success%s;\n\n", ( model->field_cnt > ( ( NO_KEY != model->key_idx ) ? 1 : 0 ) ) ? "" : " = 1" );
+
+for( i = 0, param = 1; i < model->field_cnt; i++ )
+    {
+    field = &model->fields[i];
+
+    if( i == model->key_idx )
+        {
+        continue;
+        }
+
+    fprintf( out, "%s", ( param > 1 ) ? " &&\n          " : "success = " );
+
+    if( FIELD_DYNAMIC_STRING == field->type )
+        {
+        fprintf( out, "( SQLITE_OK == sqlite3_bind_text( query, %d, model->%s, -1, SQLITE_STATIC ) )", param, field->name );
+        }
+    else if( FIELD_FIXED_STRING == field->type )
+        {
+        fprintf( out, "( SQLITE_OK == sqlite3_bind_text( query, %d, model->%s, (int)strnlen( model->%s, sizeof( model->%s ) ), SQLITE_STATIC ) )", param, field->name, field->name, field->name );
+        }
+    else
+        {
+        fprintf( out, "( SQLITE_OK == %s( query, %d, model->%s ) )", FIELD_TYPES[field->type].bind_func, param, field->name );
+        }
+
+    param++;
+    }
+
+fprintf( out, "%s\nreturn success;\n}\n\n", ( param > 1 ) ? ";\n" : "" );
+
+// Decode function
+fprintf( out,
+         "/**\n"
+         "* Read %s model from row result.\n"
+         "*\n"
+         "* Reads the columns of the row result in field order into model_out,\n"
+         "* which must be all zeros. String fields accept results of any type\n"
+         "* using SQLite's conversion to text. NULL results leave dynamic strings\n"
+         "* NULL and fixed strings empty, and text that does not fit in a fixed\n"
+         "* string is an error.\n"
+         "*/\n",
+         model->name );
+snprintf( func_name, sizeof( func_name ), "%s_from_row_result", model->name );
+snprintf( params, sizeof( params ), "sqlite3_stmt *, query, Query pointing at row result;%s_t *, model_out, (out) Model populated from row result", model->name );
+prototype_write( "static inline int", func_name, params, "", out );
+fprintf( out, "{\n" );
+
+if( model->has_strings )
+    {
+    fprintf( out, "int                     success = 1;\nunsigned char const *   text;\nint                     text_size;\n\n" );
+    }
+else
+    {
+    fprintf( out, "int success = 1;\n\n" );
+    }
+
+for( column = 0; column < model->field_cnt; column++ )
+    {
+    field = &model->fields[column];
+
+    if( NULL != FIELD_TYPES[field->type].column_func )
+        {
+        fprintf( out, "model_out->%s = %s( query, %d );\n", field->name, FIELD_TYPES[field->type].column_func, column );
+        }
+    }
+
+for( column = 0; column < model->field_cnt; column++ )
+    {
+    field = &model->fields[column];
+
+    if( NULL != FIELD_TYPES[field->type].column_func )
+        {
+        continue;
+        }
+
+    // The size must be read after the text to get the size of the UTF-8 text.
+    fprintf( out,
+             "\n"
+             "if( success )\n"
+             "    {\n"
+             "    text = sqlite3_column_text( query, %d );\n"
+             "    text_size = sqlite3_column_bytes( query, %d );\n"
+             "\n"
+             "    // NULL text is either a NULL result or an out of memory error.\n",
+             column, column );
+
+    if( FIELD_DYNAMIC_STRING == field->type )
+        {
+        fprintf( out,
+                 "    success = ( NULL != text ) || ( SQLITE_NULL == sqlite3_column_type( query, %d ) );\n"
+                 "\n"
+                 "    if( success && ( NULL != text ) )\n"
+                 "        {\n"
+                 "        model_out->%s = malloc( text_size + 1 );\n"
+                 "        success = ( NULL != model_out->%s );\n"
+                 "\n"
+                 "        if( success )\n"
+                 "            {\n"
+                 "            memcpy( model_out->%s, text, text_size + 1 );\n"
+                 "            }\n"
+                 "        }\n"
+                 "    }\n",
+                 column, field->name, field->name, field->name );
+        }
+    else
+        {
+        fprintf( out,
+                 "    success = ( ( NULL != text ) || ( SQLITE_NULL == sqlite3_column_type( query, %d ) ) ) &&\n"
+                 "              ( text_size < (int)sizeof( model_out->%s ) );\n"
+                 "\n"
+                 "    if( success && ( NULL != text ) )\n"
+                 "        {\n"
+                 "        memcpy( model_out->%s, text, text_size + 1 );\n"
+                 "        }\n"
+                 "    }\n",
+                 column, field->name, field->name );
+        }
+    }
+
+fprintf( out, "\nreturn success;\n}\n\n" );
+
+// Wrapper prototypes
+if( NO_KEY != model->key_idx )
+    {
+    fprintf( out,
+             "/**\n"
+             "* Find %s model by id.\n"
+             "*\n"
+             "* Sets found_out to 1 and reads the model with the provided id into\n"
+             "* model_out if it exists, otherwise sets found_out to 0. The caller\n"
+             "* must call %s_free() on model_out.\n"
+             "*/\n",
+             model->name, model->name );
+    snprintf( func_name, sizeof( func_name ), "%s_find_by_id", model->name );
+    snprintf( params, sizeof( params ), "sqlite3 *, db, Database on which to execute the query;sqlite_int64, id, Id of the model to find;int *, found_out, (out) Was the model found?;%s_t *, model_out, (out) Model found, caller must free", model->name );
+    prototype_write( "cqlite_rcode_t", func_name, params, ";\n", out );
+    }
+
+fprintf( out, "/**\n* Free memory owned by %s model.\n*\n* Frees the dynamic strings of the model without freeing the model\n* itself, and resets it to all zeros.\n*/\n", model->name );
+snprintf( func_name, sizeof( func_name ), "%s_free", model->name );
+snprintf( params, sizeof( params ), "%s_t *, model, Model whose memory is freed", model->name );
+prototype_write( "void", func_name, params, ";\n", out );
+
+fprintf( out,
+         "/**\n"
+         "* Insert %s model.\n"
+         "*\n"
+         "* Inserts the model into the %s table%s.\n"
+         "*/\n",
+         model->name, model->table, ( NO_KEY != model->key_idx ) ? " and sets its key to the\n* row id of the new record" : "" );
+snprintf( func_name, sizeof( func_name ), "%s_insert", model->name );
+snprintf( params, sizeof( params ), "sqlite3 *, db, Database on which to execute the query;%s_t *, model, Model to insert", model->name );
+prototype_write( "cqlite_rcode_t", func_name, params, ";\n", out );
+
+fprintf( out,
+         "/**\n"
+         "* Insert %s model with prepared query.\n"
+         "*\n"
+         "* The query must be prepared from %s_INSERT_QUERY, and is reset\n"
+         "* afterwards so that it may be executed again.\n"
+         "*\n"
+         "* @see %s_insert()\n"
+         "*/\n",
+         model->name, model->upper, model->name );
+snprintf( func_name, sizeof( func_name ), "%s_insert_prepared", model->name );
+snprintf( params, sizeof( params ), "sqlite3_stmt *, insert_query, Prepared INSERT query;%s_t *, model, Model to insert", model->name );
+prototype_write( "cqlite_rcode_t", func_name, params, ";\n", out );
+
+fprintf( out, "/**\n* Free list of %s models.\n*\n* Frees the memory owned by each model and the list itself.\n*/\n", model->name );
+snprintf( func_name, sizeof( func_name ), "%s_list_free", model->name );
+snprintf( params, sizeof( params ), "%s_t *, model_list, List of models to free, may be NULL;int, model_cnt, Number of models in the list", model->name );
+prototype_write( "void", func_name, params, ";\n", out );
+
+fprintf( out, "/**\n* Select all %s models.\n*\n* @see %s_select_query_execute()\n*/\n", model->name, model->name );
+snprintf( func_name, sizeof( func_name ), "%s_select_all", model->name );
+snprintf( params, sizeof( params ), "sqlite3 *, db, Database on which to execute the query;%s_t **, model_list_out, (out) List of models read from query, caller must free;int *, model_list_cnt_out, (out) Number of models read from query", model->name );
+prototype_write( "cqlite_rcode_t", func_name, params, ";\n", out );
+
+fprintf( out,
+         "/**\n"
+         "* Execute SELECT query into %s models.\n"
+         "*\n"
+         "* Executes the provided parameter-less SELECT query, whose results must\n"
+         "* have the columns of the model in field order, in a single pass. The\n"
+         "* caller must call %s_list_free() on model_list_out.\n"
+         "*/\n",
+         model->name, model->name );
+snprintf( func_name, sizeof( func_name ), "%s_select_query_execute", model->name );
+snprintf( params, sizeof( params ), "sqlite3 *, db, Database on which to execute the query;char const * const, select_query_str, Parameter-less SELECT query string;%s_t **, model_list_out, (out) List of models read from query, caller must free;int *, model_list_cnt_out, (out) Number of models read from query", model->name );
+prototype_write( "cqlite_rcode_t", func_name, params, ";\n", out );
+
+fprintf( out, "/**\n* Execute prepared SELECT query into %s models.\n*\n* @see %s_select_query_execute()\n*/\n", model->name, model->name );
+snprintf( func_name, sizeof( func_name ), "%s_select_query_execute_prepared", model->name );
+snprintf( params, sizeof( params ), "sqlite3_stmt *, select_query, Prepared SELECT query;%s_t **, model_list_out, (out) List of models read from query, caller must free;int *, model_list_cnt_out, (out) Number of models read from query", model->name );
+prototype_write( "cqlite_rcode_t", func_name, params, ";\n", out );
+
+fprintf( out, "#endif\n" );
+}
+
+
+/**
+* Check identifier.
+*
+* Returns 1 if the provided string is a C identifier that fits in a
+* name, 0 otherwise.
+*/
+static int identifier_is_valid
+    (
+    char const * identifier
+    )
+{
+int success;
+int i;
+
+success = ( isalpha( (unsigned char)identifier[0] ) || ( '_' == identifier[0] ) ) &&
+          ( strlen( identifier ) <= MAX_NAME_LEN );
+
+for( i = 1; success && ( '\0' != identifier[i] ); i++ )
+    {
+    success = isalnum( (unsigned char)identifier[i] ) || ( '_' == identifier[i] );
+    }
+
+return success;
+}
+
+
+/**
+* Parse model description.
+*
+* Reads a model description made of a model line followed by one field
+* line per column, in column order:
+*
+*       model <name> <table>
+*       field <name> <type> [<size>] [key]
+*
+* Blank lines and lines starting with '#' are ignored. Returns 1 on
+* success, 0 on error after reporting the offending line.
+*/
+static int model_parse
+    (
+    char const *    model_path,
+    model_t *       model_out
+    )
+{
+int     success;
+int     line_num = 0;
+int     i;
+char    line[MAX_LINE_LEN];
+char *  keyword;
+char *  args;
+char *  name;
+char *  table;
+FILE *  in;
+
+memset( model_out, 0, sizeof( *model_out ) );
+model_out->key_idx = NO_KEY;
+
+in = fopen( model_path, "r" );
+success = ( NULL != in );
+
+if( !success )
+    {
+    fprintf( stderr, "%s: failed to open model file\n", model_path );
+    }
+
+while( success && ( NULL != fgets( line, sizeof( line ), in ) ) )
+    {
+    line_num++;
+
+    keyword = strtok( line, " \t\r\n" );
+    args = strtok( NULL, "\r\n" );
+
+    if( ( NULL == keyword ) || ( '#' == keyword[0] ) )
+        {
+        continue;
+        }
+
+    if( 0 == strcmp( keyword, "model" ) )
+        {
+        name = ( NULL != args ) ? strtok( args, " \t" ) : NULL;
+        table = ( NULL != name ) ? strtok( NULL, " \t" ) : NULL;
+
+        success = ( '\0' == model_out->name[0] ) &&
+                  ( NULL != name ) && identifier_is_valid( name ) &&
+                  ( NULL != table ) && identifier_is_valid( table ) &&
+                  ( NULL == strtok( NULL, " \t" ) );
+
+        if( success )
+            {
+            strcpy( model_out->name, name );
+            strcpy( model_out->table, table );
+
+            for( i = 0; '\0' != name[i]; i++ )
+                {
+                model_out->upper[i] = (char)toupper( (unsigned char)name[i] );
+                }
+            }
+        }
+    else
+        {
+        success = ( 0 == strcmp( keyword, "field" ) ) &&
+                  ( '\0' != model_out->name[0] ) &&
+                  ( NULL != args ) &&
+                  field_parse( args, model_out );
+        }
+
+    if( !success )
+        {
+        fprintf( stderr, "%s:%d: invalid model description line\n", model_path, line_num );
+        }
+    }
+
+if( success )
+    {
+    success = ( model_out->field_cnt > 0 );
+
+    if( !success )
+        {
+        fprintf( stderr, "%s: model has no fields\n", model_path );
+        }
+    }
+
+// Clean up
+if( NULL != in )
+    {
+    fclose( in );
+    }
+
+return success;
+}
+
+
+/**
+* Write function prototype.
+*
+* Writes a function prototype in the style of the library, followed by
+* the provided terminator. The parameters are given as a list of
+* "type, name, description" triples separated by semicolons.
+*/
+static void prototype_write
+    (
+    char const *    return_type,
+    char const *    func_name,
+    char const *    params,
+    char const *    terminator,
+    FILE *          out
+    )
+{
+int             i;
+int             param_cnt = 0;
+size_t          type_width = 0;
+size_t          name_width = 0;
+size_t          len;
+char            buffer[MAX_PARAMS_LEN];
+char            name[MAX_LINE_LEN];
+char *          next;
+char *          types[MAX_FIELD_CNT];
+char *          names[MAX_FIELD_CNT];
+char *          descriptions[MAX_FIELD_CNT];
+
+snprintf( buffer, sizeof( buffer ), "%s", params );
+
+for( next = strtok( buffer, ";" ); ( NULL != next ) && ( param_cnt < MAX_FIELD_CNT ); next = strtok( NULL, ";" ) )
+    {
+    types[param_cnt] = next;
+    param_cnt++;
+    }
+
+for( i = 0; i < param_cnt; i++ )
+    {
+    names[i] = strstr( types[i], ", " );
+    *names[i] = '\0';
+    names[i] += 2;
+
+    descriptions[i] = strstr( names[i], ", " );
+    *descriptions[i] = '\0';
+    descriptions[i] += 2;
+
+    type_width = ( strlen( types[i] ) > type_width ) ? strlen( types[i] ) : type_width;
+    len = strlen( names[i] ) + ( ( i < param_cnt - 1 ) ? 1 : 0 );
+    name_width = ( len > name_width ) ? len : name_width;
+    }
+
+fprintf( out, "%s %s\n    (\n", return_type, func_name );
+
+for( i = 0; i < param_cnt; i++ )
+    {
+    snprintf( name, sizeof( name ), "%s%s", names[i], ( i < param_cnt - 1 ) ? "," : "" );
+    fprintf( out, "    %-*s%-*s//!< %s\n", (int)TAB_ALIGN( type_width ), types[i], (int)TAB_ALIGN( name_width ), name, descriptions[i] );
+    }
+
+fprintf( out, "    )%s\n", terminator );
+}
+
+
+/**
+* Write source.
+*
+* Writes the wrappers, which call the inline decode and bind functions
+* of the header directly so that the compiler can specialize each row
+* loop for the model.
+*/
+static void source_write
+    (
+    model_t const * model,
+    char const *    model_path,
+    char const *    header_name,
+    FILE *          out
+    )
+{
+int             i;
+char            func_name[MAX_LINE_LEN];
+char            params[MAX_PARAMS_LEN];
+char            list_type[MAX_LINE_LEN];
+char const *    name;
+
+name = model->name;
+snprintf( list_type, sizeof( list_type ), "%s_t *", name );
+
+fprintf( out, "/*\n* Generated by cqlite_gen from %s, do not edit.\n*/\n\n", model_path );
+fprintf( out, "#include <limits.h>\n#include <stdint.h>\n#include <stdlib.h>\n#include <string.h>\n\n#include \"%s\"\n\n", header_name );
+fprintf( out, "#define READ_TO_END                 ( -1 )\n#define NO_TAIL                     ( NULL )\n#define MODEL_LIST_INITIAL_CAPACITY ( 16 )\n\n\n" );
+
+// Find by id
+if( NO_KEY != model->key_idx )
+    {
+    fprintf( out, "// Find %s model by id.\n", name );
+    snprintf( func_name, sizeof( func_name ), "%s_find_by_id", name );
+    snprintf( params, sizeof( params ), "sqlite3 *, db, Database on which to execute the query;sqlite_int64, id, Id of the model to find;int *, found_out, (out) Was the model found?;%s_t *, model_out, (out) Model found, caller must free", name );
+    prototype_write( "cqlite_rcode_t", func_name, params, "", out );
+    fprintf( out,
+             "{\n"
+             "cqlite_rcode_t  rcode = CQLITE_ERROR;\n"
+             "int             success;\n"
+             "int             sqlite_rcode = SQLITE_ERROR;\n"
+             "sqlite3_stmt *  find_query = NULL;\n"
+             "\n"
+             "*found_out = 0;\n"
+             "memset( model_out, 0, sizeof( *model_out ) );\n"
+             "\n"
+             "success = ( SQLITE_OK == sqlite3_prepare_v2( db, %s_FIND_BY_ID_QUERY, READ_TO_END, &find_query, NO_TAIL ) ) &&\n"
+             "          ( SQLITE_OK == sqlite3_bind_int64( find_query, 1, id ) );\n"
+             "\n"
+             "if( success )\n"
+             "    {\n"
+             "    sqlite_rcode = sqlite3_step( find_query );\n"
+             "    success = ( SQLITE_ROW == sqlite_rcode ) || ( SQLITE_DONE == sqlite_rcode );\n"
+             "    }\n"
+             "\n"
+             "if( success && ( SQLITE_ROW == sqlite_rcode ) )\n"
+             "    {\n"
+             "    success = %s_from_row_result( find_query, model_out );\n"
+             "    *found_out = success;\n"
+             "    }\n"
+             "\n"
+             "if( success )\n"
+             "    {\n"
+             "    rcode = CQLITE_SUCCESS;\n"
+             "    }\n"
+             "else\n"
+             "    {\n"
+             "    %s_free( model_out );\n"
+             "    }\n"
+             "\n"
+             "// Clean up\n"
+             "sqlite3_finalize( find_query );\n"
+             "\n"
+             "return rcode;\n"
+             "}\n\n\n",
+             model->upper, name, name );
+    }
+
+// Free
+fprintf( out, "// Free memory owned by %s model.\n", name );
+snprintf( func_name, sizeof( func_name ), "%s_free", name );
+snprintf( params, sizeof( params ), "%s_t *, model, Model whose memory is freed", name );
+prototype_write( "void", func_name, params, "", out );
+fprintf( out, "{\n" );
+
+for( i = 0; i < model->field_cnt; i++ )
+    {
+    if( FIELD_DYNAMIC_STRING == model->fields[i].type )
+        {
+        fprintf( out, "free( model->%s );\n", model->fields[i].name );
+        }
+    }
+
+fprintf( out, "\nmemset( model, 0, sizeof( *model ) );\n}\n\n\n" );
+
+// Insert
+fprintf( out, "// Insert %s model.\n", name );
+snprintf( func_name, sizeof( func_name ), "%s_insert", name );
+snprintf( params, sizeof( params ), "sqlite3 *, db, Database on which to execute the query;%s_t *, model, Model to insert", name );
+prototype_write( "cqlite_rcode_t", func_name, params, "", out );
+fprintf( out,
+         "{\n"
+         "cqlite_rcode_t  rcode = CQLITE_ERROR;\n"
+         "sqlite3_stmt *  insert_query = NULL;\n"
+         "\n"
+         "if( SQLITE_OK == sqlite3_prepare_v2( db, %s_INSERT_QUERY, READ_TO_END, &insert_query, NO_TAIL ) )\n"
+         "    {\n"
+         "    rcode = %s_insert_prepared( insert_query, model );\n"
+         "    }\n"
+         "\n"
+         "// Clean up\n"
+         "sqlite3_finalize( insert_query );\n"
+         "\n"
+         "return rcode;\n"
+         "}\n\n\n",
+         model->upper, name );
+
+// Insert prepared
+fprintf( out, "// Insert %s model with prepared query.\n", name );
+snprintf( func_name, sizeof( func_name ), "%s_insert_prepared", name );
+snprintf( params, sizeof( params ), "sqlite3_stmt *, insert_query, Prepared INSERT query;%s_t *, model, Model to insert", name );
+prototype_write( "cqlite_rcode_t", func_name, params, "", out );
+fprintf( out,
+         "{\n"
+         "cqlite_rcode_t  rcode = CQLITE_ERROR;\n"
+         "int             success;\n"
+         "\n"
+         "success = %s_bind( insert_query, model ) &&\n"
+         "          ( SQLITE_DONE == sqlite3_step( insert_query ) );\n"
+         "\n"
+         "if( success )\n"
+         "    {\n"
+         "    rcode = CQLITE_SUCCESS;\n",
+         name );
+
+if( NO_KEY != model->key_idx )
+    {
+    fprintf( out, "    model->%s = sqlite3_last_insert_rowid( sqlite3_db_handle( insert_query ) );\n", model->fields[model->key_idx].name );
+    }
+
+fprintf( out,
+         "    }\n"
+         "\n"
+         "// Clean up, dropping the bindings to the model's strings\n"
+         "sqlite3_reset( insert_query );\n"
+         "sqlite3_clear_bindings( insert_query );\n"
+         "\n"
+         "return rcode;\n"
+         "}\n\n\n" );
+
+// List free
+fprintf( out, "// Free list of %s models.\n", name );
+snprintf( func_name, sizeof( func_name ), "%s_list_free", name );
+snprintf( params, sizeof( params ), "%s_t *, model_list, List of models to free, may be NULL;int, model_cnt, Number of models in the list", name );
+prototype_write( "void", func_name, params, "", out );
+fprintf( out,
+         "{\n"
+         "int i;\n"
+         "\n"
+         "for( i = 0; i < model_cnt; i++ )\n"
+         "    {\n"
+         "    %s_free( &model_list[i] );\n"
+         "    }\n"
+         "\n"
+         "free( model_list );\n"
+         "}\n\n\n",
+         name );
+
+// Select all
+fprintf( out, "// Select all %s models.\n", name );
+snprintf( func_name, sizeof( func_name ), "%s_select_all", name );
+snprintf( params, sizeof( params ), "sqlite3 *, db, Database on which to execute the query;%s_t **, model_list_out, (out) List of models read from query, caller must free;int *, model_list_cnt_out, (out) Number of models read from query", name );
+prototype_write( "cqlite_rcode_t", func_name, params, "", out );
+fprintf( out,
+         "{\n"
+         "return %s_select_query_execute( db, %s_SELECT_ALL_QUERY, model_list_out, model_list_cnt_out );\n"
+         "}\n\n\n",
+         name, model->upper );
+
+// Select
+fprintf( out, "// Execute SELECT query into %s models.\n", name );
+snprintf( func_name, sizeof( func_name ), "%s_select_query_execute", name );
+snprintf( params, sizeof( params ), "sqlite3 *, db, Database on which to execute the query;char const * const, select_query_str, Parameter-less SELECT query string;%s_t **, model_list_out, (out) List of models read from query, caller must free;int *, model_list_cnt_out, (out) Number of models read from query", name );
+prototype_write( "cqlite_rcode_t", func_name, params, "", out );
+fprintf( out,
+         "{\n"
+         "cqlite_rcode_t  rcode = CQLITE_ERROR;\n"
+         "sqlite3_stmt *  select_query = NULL;\n"
+         "\n"
+         "*model_list_out = NULL;\n"
+         "*model_list_cnt_out = 0;\n"
+         "\n"
+         "if( SQLITE_OK == sqlite3_prepare_v2( db, select_query_str, READ_TO_END, &select_query, NO_TAIL ) )\n"
+         "    {\n"
+         "    rcode = %s_select_query_execute_prepared( select_query, model_list_out, model_list_cnt_out );\n"
+         "    }\n"
+         "\n"
+         "// Clean up\n"
+         "sqlite3_finalize( select_query );\n"
+         "\n"
+         "return rcode;\n"
+         "}\n\n\n",
+         name );
+
+// Select prepared
+fprintf( out, "// Execute prepared SELECT query into %s models.\n", name );
+snprintf( func_name, sizeof( func_name ), "%s_select_query_execute_prepared", name );
+snprintf( params, sizeof( params ), "sqlite3_stmt *, select_query, Prepared SELECT query;%s_t **, model_list_out, (out) List of models read from query, caller must free;int *, model_list_cnt_out, (out) Number of models read from query", name );
+prototype_write( "cqlite_rcode_t", func_name, params, "", out );
+fprintf( out,
+         "{\n"
+         "cqlite_rcode_t  rcode = CQLITE_ERROR;\n"
+         "int             success = 1;\n"
+         "int             sqlite_rcode;\n"
+         "int             model_cnt = 0;\n"
+         "int             model_capacity = 0;\n"
+         "%-15s model_list = NULL;\n"
+         "%-15s new_model_list;\n"
+         "\n"
+         "*model_list_out = NULL;\n"
+         "*model_list_cnt_out = 0;\n"
+         "\n"
+         "sqlite_rcode = sqlite3_step( select_query );\n"
+         "\n"
+         "// Read each result into the next model, growing the list as needed\n"
+         "while( success && ( SQLITE_ROW == sqlite_rcode ) )\n"
+         "    {\n"
+         "    if( model_cnt == model_capacity )\n"
+         "        {\n"
+         "        success = ( model_capacity <= ( INT_MAX / 2 ) ) &&\n"
+         "                  ( (size_t)model_capacity <= ( SIZE_MAX / 2 / sizeof( *model_list ) ) );\n"
+         "\n"
+         "        if( success )\n"
+         "            {\n"
+         "            model_capacity = ( model_capacity > 0 ) ? ( model_capacity * 2 ) : MODEL_LIST_INITIAL_CAPACITY;\n"
+         "            new_model_list = realloc( model_list, model_capacity * sizeof( *model_list ) );\n"
+         "            success = ( NULL != new_model_list );\n"
+         "            }\n"
+         "\n"
+         "        if( success )\n"
+         "            {\n"
+         "            model_list = new_model_list;\n"
+         "            }\n"
+         "        }\n"
+         "\n"
+         "    if( success )\n"
+         "        {\n"
+         "        memset( &model_list[model_cnt], 0, sizeof( *model_list ) );\n"
+         "        success = %s_from_row_result( select_query, &model_list[model_cnt] );\n"
+         "        model_cnt++;\n"
+         "        }\n"
+         "\n"
+         "    if( success )\n"
+         "        {\n"
+         "        sqlite_rcode = sqlite3_step( select_query );\n"
+         "        }\n"
+         "    }\n"
+         "\n"
+         "// Ensure all results were successfully read\n"
+         "if( success )\n"
+         "    {\n"
+         "    success = ( SQLITE_DONE == sqlite_rcode );\n"
+         "    }\n"
+         "\n"
+         "if( success )\n"
+         "    {\n"
+         "    rcode = CQLITE_SUCCESS;\n"
+         "    *model_list_out = model_list;\n"
+         "    *model_list_cnt_out = model_cnt;\n"
+         "    }\n"
+         "else\n"
+         "    {\n"
+         "    %s_list_free( model_list, model_cnt );\n"
+         "    }\n"
+         "\n"
+         "return rcode;\n"
+         "}\n",
+         list_type, list_type, name, name );
+}
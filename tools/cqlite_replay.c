@@ -0,0 +1,540 @@
+#include <pthread.h>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cqlite.h"
+#include "cqlite_trace.h"
+
+#define DEFAULT_THREAD_CNT  ( 1 )
+#define MAX_THREAD_CNT      ( 256 )
+#define INITIAL_CAPACITY    ( 1024 )
+#define BUSY_TIMEOUT_MS     ( 10000 )
+#define READ_TO_END         ( -1 )
+#define NO_TAIL             ( NULL )
+#define BACKUP_ALL_PAGES    ( -1 )
+#define NS_PER_SEC          ( 1000000000LL )
+#define NS_PER_US           ( 1000.0 )
+#define API_GROUP_OTHER     ( CQLITE_STATS_API_CNT )
+#define API_GROUP_ALL       ( CQLITE_STATS_API_CNT + 1 )
+#define API_GROUP_CNT       ( CQLITE_STATS_API_CNT + 2 )
+
+
+/**********************************************
+Types
+**********************************************/
+typedef struct
+    {
+    char *          sql;            //!< Expanded SQL of the statement
+    int             api_group;      //!< Function group of the statement, API_GROUP_OTHER if none
+    unsigned int    thread_id;      //!< Thread that executed the statement when it was traced
+    sqlite_int64    recorded_ns;    //!< Duration of the statement when it was traced
+    sqlite_int64    replayed_ns;    //!< Duration of the statement when it was replayed
+    int             failed;         //!< Did replaying the statement fail?
+    } replay_stmt_t;
+
+typedef struct
+    {
+    char const *    path;       //!< Path of the database replayed against
+    replay_stmt_t * stmts;      //!< Statements of the trace in completion order
+    int             stmt_cnt;   //!< Number of statements
+    int             thread_cnt; //!< Number of replay threads
+    } replay_t;
+
+typedef struct
+    {
+    replay_t *  replay;     //!< Replay the thread belongs to
+    int         thread_idx; //!< Index of the replay thread
+    int         success;    //!< Could the thread open its connection?
+    } replay_thread_t;
+
+
+/**********************************************
+Variables
+**********************************************/
+static char const * const API_GROUP_NAMES[API_GROUP_CNT] =
+    {
+    [CQLITE_STATS_API_SELECT]   = "select",
+    [CQLITE_STATS_API_FIND]     = "find",
+    [CQLITE_STATS_API_COUNT]    = "count",
+    [CQLITE_STATS_API_INSERT]   = "insert",
+    [API_GROUP_OTHER]           = "other",
+    [API_GROUP_ALL]             = "all",
+    };
+
+
+/**********************************************
+Functions
+**********************************************/
+static int database_copy
+    (
+    char const * source_path,
+    char const * replay_path
+    );
+
+static int latency_compare
+    (
+    void const * a,
+    void const * b
+    );
+
+static sqlite_int64 now_ns
+    (
+    void
+    );
+
+static void replay_free
+    (
+    replay_t * replay
+    );
+
+static int replay_load
+    (
+    char const *    trace_path,
+    replay_t *      replay
+    );
+
+static void replay_report
+    (
+    replay_t const *    replay,
+    sqlite_int64        elapsed_ns
+    );
+
+static int replay_run
+    (
+    replay_t *      replay,
+    sqlite_int64 *  elapsed_ns_out
+    );
+
+static void * replay_thread
+    (
+    void * args
+    );
+
+
+int main
+    (
+    int     argc,
+    char ** argv
+    )
+{
+int             success;
+int             arg_idx = 1;
+sqlite_int64    elapsed_ns = 0;
+replay_t        replay;
+
+memset( &replay, 0, sizeof( replay ) );
+replay.thread_cnt = DEFAULT_THREAD_CNT;
+
+if( ( argc > 2 ) && ( 0 == strcmp( argv[1], "-t" ) ) )
+    {
+    replay.thread_cnt = atoi( argv[2] );
+    arg_idx = 3;
+    }
+
+success = ( 3 == ( argc - arg_idx ) ) && ( replay.thread_cnt > 0 ) && ( replay.thread_cnt <= MAX_THREAD_CNT );
+
+if( !success )
+    {
+    fprintf( stderr, "usage: %s [-t <thread count>] <trace file> <source database> <replay database>\n", argv[0] );
+    }
+
+// Replaying writes to the database, so it runs against a copy
+if( success )
+    {
+    replay.path = argv[arg_idx + 2];
+
+    success = replay_load( argv[arg_idx], &replay ) &&
+              database_copy( argv[arg_idx + 1], replay.path );
+    }
+
+if( success )
+    {
+    success = replay_run( &replay, &elapsed_ns );
+    }
+
+if( success )
+    {
+    replay_report( &replay, elapsed_ns );
+    }
+
+// Clean up
+replay_free( &replay );
+
+return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/**
+* Copy database.
+*
+* Copies the source database into the replay database with the online
+* backup API, replacing its contents.
+*/
+static int database_copy
+    (
+    char const * source_path,
+    char const * replay_path
+    )
+{
+int                 success;
+sqlite3 *           source_db = NULL;
+sqlite3 *           replay_db = NULL;
+sqlite3_backup *    backup = NULL;
+
+success = ( SQLITE_OK == sqlite3_open_v2( source_path, &source_db, SQLITE_OPEN_READONLY, NULL ) ) &&
+          ( SQLITE_OK == sqlite3_open( replay_path, &replay_db ) );
+
+if( success )
+    {
+    backup = sqlite3_backup_init( replay_db, "main", source_db, "main" );
+    success = ( NULL != backup ) &&
+              ( SQLITE_DONE == sqlite3_backup_step( backup, BACKUP_ALL_PAGES ) );
+    }
+
+if( !success )
+    {
+    fprintf( stderr, "failed to copy %s to %s: %s\n", source_path, replay_path, ( NULL != replay_db ) ? sqlite3_errmsg( replay_db ) : "out of memory" );
+    }
+
+// Clean up
+if( NULL != backup )
+    {
+    sqlite3_backup_finish( backup );
+    }
+
+sqlite3_close( source_db );
+sqlite3_close( replay_db );
+
+return success;
+}
+
+
+/**
+* Compare latencies for qsort().
+*/
+static int latency_compare
+    (
+    void const * a,
+    void const * b
+    )
+{
+sqlite_int64 latency_a = *(sqlite_int64 const*)a;
+sqlite_int64 latency_b = *(sqlite_int64 const*)b;
+
+return ( latency_a > latency_b ) - ( latency_a < latency_b );
+}
+
+
+/**
+* Get monotonic time in nanoseconds.
+*/
+static sqlite_int64 now_ns
+    (
+    void
+    )
+{
+struct timespec now;
+
+clock_gettime( CLOCK_MONOTONIC, &now );
+
+return ( (sqlite_int64)now.tv_sec * NS_PER_SEC ) + now.tv_nsec;
+}
+
+
+/**
+* Free replay.
+*/
+static void replay_free
+    (
+    replay_t * replay
+    )
+{
+int i;
+
+for( i = 0; i < replay->stmt_cnt; i++ )
+    {
+    free( replay->stmts[i].sql );
+    }
+
+free( replay->stmts );
+
+replay->stmts = NULL;
+replay->stmt_cnt = 0;
+}
+
+
+/**
+* Load trace.
+*
+* Reads every record of the trace into the statements of the replay.
+*/
+static int replay_load
+    (
+    char const *    trace_path,
+    replay_t *      replay
+    )
+{
+int                     success;
+int                     found = 0;
+int                     capacity = 0;
+replay_stmt_t *         new_stmts;
+replay_stmt_t *         stmt;
+cqlite_trace_reader_t * reader = NULL;
+cqlite_trace_record_t   record;
+
+success = ( CQLITE_SUCCESS == cqlite_trace_reader_open( trace_path, &reader ) );
+
+if( success )
+    {
+    success = ( CQLITE_SUCCESS == cqlite_trace_reader_next( reader, &record, &found ) );
+    }
+
+while( success && found )
+    {
+    if( replay->stmt_cnt == capacity )
+        {
+        capacity = ( capacity > 0 ) ? ( capacity * 2 ) : INITIAL_CAPACITY;
+        new_stmts = realloc( replay->stmts, capacity * sizeof( *replay->stmts ) );
+        success = ( NULL != new_stmts );
+
+        if( success )
+            {
+            replay->stmts = new_stmts;
+            }
+        }
+
+    if( success )
+        {
+        stmt = &replay->stmts[replay->stmt_cnt];
+        memset( stmt, 0, sizeof( *stmt ) );
+
+        stmt->sql = malloc( record.sql_len + 1 );
+        success = ( NULL != stmt->sql );
+        }
+
+    if( success )
+        {
+        memcpy( stmt->sql, record.sql, record.sql_len + 1 );
+        stmt->api_group = ( CQLITE_TRACE_NO_API == record.api ) ? API_GROUP_OTHER : record.api;
+        stmt->thread_id = record.thread_id;
+        stmt->recorded_ns = record.duration_ns;
+        replay->stmt_cnt++;
+
+        success = ( CQLITE_SUCCESS == cqlite_trace_reader_next( reader, &record, &found ) );
+        }
+    }
+
+if( !success )
+    {
+    fprintf( stderr, "failed to read trace %s\n", trace_path );
+    }
+
+// Clean up
+cqlite_trace_reader_close( reader );
+
+return success;
+}
+
+
+/**
+* Print replay report.
+*
+* Prints the throughput of the replay and, for each function group, the
+* latency percentiles of its statements when they were traced and when
+* they were replayed, as a JSON object.
+*/
+static void replay_report
+    (
+    replay_t const *    replay,
+    sqlite_int64        elapsed_ns
+    )
+{
+int             i;
+int             group;
+int             cnt;
+int             error_cnt = 0;
+int             is_first_group = 1;
+sqlite_int64 *  recorded_ns;
+sqlite_int64 *  replayed_ns;
+
+for( i = 0; i < replay->stmt_cnt; i++ )
+    {
+    error_cnt += replay->stmts[i].failed;
+    }
+
+printf( "{\n\"statements\": %d, \"threads\": %d, \"errors\": %d, \"elapsed_sec\": %.3f, \"statements_per_sec\": %.1f,\n\"apis\": [",
+        replay->stmt_cnt,
+        replay->thread_cnt,
+        error_cnt,
+        (double)elapsed_ns / NS_PER_SEC,
+        ( elapsed_ns > 0 ) ? ( (double)replay->stmt_cnt * NS_PER_SEC / elapsed_ns ) : 0.0 );
+
+recorded_ns = malloc( ( replay->stmt_cnt + 1 ) * sizeof( *recorded_ns ) );
+replayed_ns = malloc( ( replay->stmt_cnt + 1 ) * sizeof( *replayed_ns ) );
+
+for( group = 0; ( NULL != recorded_ns ) && ( NULL != replayed_ns ) && ( group < API_GROUP_CNT ); group++ )
+    {
+    cnt = 0;
+
+    for( i = 0; i < replay->stmt_cnt; i++ )
+        {
+        if( ( API_GROUP_ALL == group ) || ( replay->stmts[i].api_group == group ) )
+            {
+            recorded_ns[cnt] = replay->stmts[i].recorded_ns;
+            replayed_ns[cnt] = replay->stmts[i].replayed_ns;
+            cnt++;
+            }
+        }
+
+    if( cnt > 0 )
+        {
+        qsort( recorded_ns, cnt, sizeof( *recorded_ns ), latency_compare );
+        qsort( replayed_ns, cnt, sizeof( *replayed_ns ), latency_compare );
+
+        printf( "%s\n    {\"api\": \"%s\", \"statements\": %d, \"recorded_p50_us\": %.3f, \"recorded_p99_us\": %.3f, \"replayed_p50_us\": %.3f, \"replayed_p90_us\": %.3f, \"replayed_p99_us\": %.3f, \"replayed_max_us\": %.3f}",
+                is_first_group ? "" : ",",
+                API_GROUP_NAMES[group],
+                cnt,
+                recorded_ns[( ( cnt - 1 ) * 50 ) / 100] / NS_PER_US,
+                recorded_ns[( ( cnt - 1 ) * 99 ) / 100] / NS_PER_US,
+                replayed_ns[( ( cnt - 1 ) * 50 ) / 100] / NS_PER_US,
+                replayed_ns[( ( cnt - 1 ) * 90 ) / 100] / NS_PER_US,
+                replayed_ns[( ( cnt - 1 ) * 99 ) / 100] / NS_PER_US,
+                replayed_ns[cnt - 1] / NS_PER_US );
+
+        is_first_group = 0;
+        }
+    }
+
+printf( "\n]\n}\n" );
+
+// Clean up
+free( recorded_ns );
+free( replayed_ns );
+}
+
+
+/**
+* Run replay.
+*
+* Replays the statements on thread_cnt threads, each on its own
+* connection to the replay database, and measures the total time.
+*/
+static int replay_run
+    (
+    replay_t *      replay,
+    sqlite_int64 *  elapsed_ns_out
+    )
+{
+int                 success;
+int                 i;
+int                 thread_cnt = 0;
+sqlite_int64        start_ns;
+pthread_t *         threads;
+replay_thread_t *   args;
+
+threads = calloc( replay->thread_cnt, sizeof( *threads ) );
+args = calloc( replay->thread_cnt, sizeof( *args ) );
+success = ( NULL != threads ) && ( NULL != args );
+
+start_ns = now_ns();
+
+for( i = 0; success && ( i < replay->thread_cnt ); i++ )
+    {
+    args[i].replay = replay;
+    args[i].thread_idx = i;
+
+    success = ( 0 == pthread_create( &threads[i], NULL, replay_thread, &args[i] ) );
+
+    if( success )
+        {
+        thread_cnt++;
+        }
+    }
+
+for( i = 0; i < thread_cnt; i++ )
+    {
+    pthread_join( threads[i], NULL );
+    success = success && args[i].success;
+    }
+
+*elapsed_ns_out = now_ns() - start_ns;
+
+if( !success )
+    {
+    fprintf( stderr, "failed to start replay of %s\n", replay->path );
+    }
+
+// Clean up
+free( threads );
+free( args );
+
+return success;
+}
+
+
+/**
+* Replay thread.
+*
+* Executes the statements of every traced thread assigned to this
+* replay thread, in the order they completed in the trace, and records
+* how long each took. The statements of one traced thread always run on
+* the same replay thread, so its transactions stay intact. Time spent
+* preparing is excluded, as in the trace.
+*/
+static void * replay_thread
+    (
+    void * args
+    )
+{
+replay_thread_t *   thread;
+replay_t *          replay;
+replay_stmt_t *     stmt;
+sqlite3 *           db = NULL;
+sqlite3_stmt *      query;
+sqlite_int64        start_ns;
+int                 sqlite_rcode;
+int                 i;
+
+thread = (replay_thread_t*)args;
+replay = thread->replay;
+
+thread->success = ( SQLITE_OK == sqlite3_open( replay->path, &db ) ) &&
+                  ( SQLITE_OK == sqlite3_busy_timeout( db, BUSY_TIMEOUT_MS ) );
+
+for( i = 0; thread->success && ( i < replay->stmt_cnt ); i++ )
+    {
+    stmt = &replay->stmts[i];
+
+    if( (int)( ( stmt->thread_id - 1 ) % replay->thread_cnt ) == thread->thread_idx )
+        {
+        query = NULL;
+        sqlite_rcode = sqlite3_prepare_v2( db, stmt->sql, READ_TO_END, &query, NO_TAIL );
+
+        start_ns = now_ns();
+
+        if( ( SQLITE_OK == sqlite_rcode ) && ( NULL != query ) )
+            {
+            sqlite_rcode = sqlite3_step( query );
+
+            while( SQLITE_ROW == sqlite_rcode )
+                {
+                sqlite_rcode = sqlite3_step( query );
+                }
+            }
+
+        stmt->replayed_ns = now_ns() - start_ns;
+        stmt->failed = ( SQLITE_OK != sqlite_rcode ) && ( SQLITE_DONE != sqlite_rcode );
+
+        sqlite3_finalize( query );
+        }
+    }
+
+// Clean up
+sqlite3_close( db );
+
+return NULL;
+}